@@ -0,0 +1,137 @@
+#ifndef MAPNIK_BENCHMARK_HPP
+#define MAPNIK_BENCHMARK_HPP
+
+// mapnik
+#include <mapnik/render_stats.hpp>
+
+// boost
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/ref.hpp>
+
+// stl
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace benchmark {
+
+// where the benchmarks find their data, relative to the source tree by default
+struct config
+{
+    config()
+        : data_dir("demo/data/"),
+          plugins_dir("plugins/input/"),
+          fonts_dir("fonts/dejavu-fonts-ttf-2.33/ttf/") {}
+
+    std::string data_dir;
+    std::string plugins_dir;
+    std::string fonts_dir;
+};
+
+/*
+ * One benchmark. Inputs are built in the constructor, operator() is the
+ * timed part and is called from several threads at once for the
+ * throughput numbers, so it must only read shared state. Styles fill
+ * their rule caches on the first render of a map, cases rendering a
+ * shared map render it once in the constructor.
+ */
+class test_case
+{
+public:
+    test_case(std::string const& name, unsigned iterations)
+        : name_(name),
+          iterations_(iterations) {}
+
+    virtual ~test_case() {}
+
+    std::string const& name() const
+    {
+        return name_;
+    }
+
+    unsigned iterations() const
+    {
+        return iterations_;
+    }
+
+    // checked once before timing, a case that fails is reported and skipped
+    virtual bool validate() const
+    {
+        return true;
+    }
+
+    virtual void operator()() const = 0;
+
+private:
+    std::string name_;
+    unsigned iterations_;
+};
+
+typedef boost::shared_ptr<test_case> test_case_ptr;
+typedef std::vector<test_case_ptr> test_list;
+
+struct result
+{
+    std::string name;
+    unsigned threads;
+    unsigned iterations;  // per thread
+    double elapsed;       // wall clock ms
+};
+
+namespace detail {
+
+struct worker
+{
+    worker(test_case const& test, unsigned iterations)
+        : test_(test),
+          iterations_(iterations) {}
+
+    void operator()() const
+    {
+        for (unsigned i = 0; i < iterations_; ++i)
+        {
+            test_();
+        }
+    }
+
+    test_case const& test_;
+    unsigned iterations_;
+};
+
+}
+
+// runs iterations of the case on each of the threads and times the lot
+inline result run(test_case const& test, unsigned threads, double scale)
+{
+    result r;
+    r.name = test.name();
+    r.threads = threads;
+    r.iterations = std::max(1u, static_cast<unsigned>(test.iterations() * scale));
+    detail::worker work(test, r.iterations);
+    double start = mapnik::stats_clock();
+    if (threads <= 1)
+    {
+        work();
+    }
+    else
+    {
+        boost::thread_group group;
+        for (unsigned i = 0; i < threads; ++i)
+        {
+            group.create_thread(work);
+        }
+        group.join_all();
+    }
+    r.elapsed = mapnik::stats_clock() - start;
+    return r;
+}
+
+// each source file adds its cases
+void add_geometry_cases(test_list & tests, config const& cfg);
+void add_render_cases(test_list & tests, config const& cfg);
+void add_map_cases(test_list & tests, config const& cfg);
+
+}
+
+#endif // MAPNIK_BENCHMARK_HPP
@@ -0,0 +1,23 @@
+import os
+import glob
+from copy import copy
+
+Import ('env')
+
+bench_env = env.Clone()
+
+headers = env['CPPPATH']
+
+libraries =  copy(env['LIBMAPNIK_LIBS'])
+# the throughput runs use threads even in single threaded builds
+boost_thread = 'boost_thread%s' % env['BOOST_APPEND']
+if boost_thread not in libraries:
+    libraries.append(boost_thread)
+libraries.append('mapnik')
+
+bench_program = bench_env.Program('mapnik-bench', glob.glob('*.cpp'), CPPPATH=headers, LIBS=libraries, LINKFLAGS=env['CUSTOM_LDFLAGS'])
+Depends(bench_program, env.subst('../src/%s' % env['MAPNIK_LIB_NAME']))
+
+# SConstruct only reads this for `scons benchmark`, so it is never part
+# of the default build nor installed
+env.Alias('benchmark', bench_program)
@@ -0,0 +1,168 @@
+#include "bench.hpp"
+
+// mapnik
+#include <mapnik/wkb.hpp>
+#include <mapnik/geometry.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/expression.hpp>
+#include <mapnik/expression_evaluator.hpp>
+#include <mapnik/label_collision_detector.hpp>
+
+// boost
+#include <boost/make_shared.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+// stl
+#include <cstring>
+#include <cmath>
+
+namespace benchmark {
+
+namespace {
+
+void append_uint32(std::string & wkb, boost::uint32_t val)
+{
+    wkb.append(reinterpret_cast<char const*>(&val), 4);
+}
+
+void append_double(std::string & wkb, double val)
+{
+    wkb.append(reinterpret_cast<char const*>(&val), 8);
+}
+
+// a polygon of one ring with the given number of points, in host byte order
+std::string make_wkb_polygon(unsigned points)
+{
+    std::string wkb;
+    boost::uint16_t one = 1;
+    char host_order = *reinterpret_cast<char const*>(&one) == 1 ? 1 : 0;
+    wkb += host_order;
+    append_uint32(wkb, 3); // polygon
+    append_uint32(wkb, 1); // rings
+    append_uint32(wkb, points);
+    for (unsigned i = 0; i < points; ++i)
+    {
+        double angle = (i + 1 == points) ? 0 : 2 * M_PI * i / (points - 1);
+        double radius = 100 + 10 * std::sin(angle * 7);
+        append_double(wkb, radius * std::cos(angle));
+        append_double(wkb, radius * std::sin(angle));
+    }
+    return wkb;
+}
+
+class wkb_parse : public test_case
+{
+public:
+    wkb_parse(unsigned points, unsigned iterations, std::string const& name)
+        : test_case(name, iterations),
+          wkb_(make_wkb_polygon(points)),
+          points_(points) {}
+
+    bool validate() const
+    {
+        boost::ptr_vector<mapnik::geometry_type> paths;
+        mapnik::geometry_utils::from_wkb(paths, wkb_.data(), wkb_.size());
+        return paths.size() == 1 && paths[0].num_points() >= points_;
+    }
+
+    void operator()() const
+    {
+        boost::ptr_vector<mapnik::geometry_type> paths;
+        mapnik::geometry_utils::from_wkb(paths, wkb_.data(), wkb_.size());
+    }
+
+private:
+    std::string wkb_;
+    unsigned points_;
+};
+
+class expression_eval : public test_case
+{
+public:
+    expression_eval(std::string const& expr, unsigned iterations)
+        : test_case("expression " + expr, iterations),
+          expr_(mapnik::parse_expression(expr, "utf8"))
+    {
+        mapnik::context_ptr ctx = boost::make_shared<mapnik::context_type>();
+        ctx->push("CLASS");
+        ctx->push("NAME");
+        ctx->push("POP");
+        for (int i = 0; i < 100; ++i)
+        {
+            mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, i));
+            feature->put("CLASS", i % 5);
+            feature->put("NAME", UnicodeString(i % 2 ? "Ottawa" : "Montreal"));
+            feature->put("POP", 1000.0 * i);
+            features_.push_back(feature);
+        }
+    }
+
+    void operator()() const
+    {
+        unsigned matches = 0;
+        for (std::vector<mapnik::feature_ptr>::const_iterator itr = features_.begin();
+             itr != features_.end(); ++itr)
+        {
+            mapnik::value_type result = boost::apply_visitor(
+                mapnik::evaluate<mapnik::Feature, mapnik::value_type>(**itr), *expr_);
+            if (result.to_bool()) ++matches;
+        }
+        sink_ = matches;
+    }
+
+private:
+    mapnik::expression_ptr expr_;
+    std::vector<mapnik::feature_ptr> features_;
+    // keeps the loop from being optimized away, racy writes are harmless
+    mutable volatile unsigned sink_;
+};
+
+// label boxes on a 1024x1024 tile, three in four collide with an earlier one
+class collision_detector : public test_case
+{
+public:
+    explicit collision_detector(unsigned iterations)
+        : test_case("label_collision_detector4 2000 labels", iterations)
+    {
+        std::srand(42);
+        for (unsigned i = 0; i < 2000; ++i)
+        {
+            double x = std::rand() % 1024;
+            double y = std::rand() % 1024;
+            double w = 20 + std::rand() % 80;
+            boxes_.push_back(mapnik::box2d<double>(x, y, x + w, y + 12));
+        }
+    }
+
+    void operator()() const
+    {
+        mapnik::label_collision_detector4 detector(mapnik::box2d<double>(-64, -64, 1088, 1088));
+        for (std::vector<mapnik::box2d<double> >::const_iterator itr = boxes_.begin();
+             itr != boxes_.end(); ++itr)
+        {
+            if (detector.has_placement(*itr))
+            {
+                detector.insert(*itr);
+            }
+        }
+    }
+
+private:
+    std::vector<mapnik::box2d<double> > boxes_;
+};
+
+}
+
+void add_geometry_cases(test_list & tests, config const& /*cfg*/)
+{
+    tests.push_back(boost::make_shared<wkb_parse>(5, 200000, "wkb polygon 5 points"));
+    tests.push_back(boost::make_shared<wkb_parse>(10000, 500, "wkb polygon 10000 points"));
+    tests.push_back(boost::make_shared<expression_eval>("[CLASS] = 2", 20000));
+    tests.push_back(boost::make_shared<expression_eval>("[CLASS] = 1 or [CLASS] = 3 and [POP] > 50000", 20000));
+    tests.push_back(boost::make_shared<expression_eval>("[NAME].match('Mont.*')", 2000));
+    tests.push_back(boost::make_shared<collision_detector>(200));
+}
+
+}
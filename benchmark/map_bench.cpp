@@ -0,0 +1,220 @@
+#include "bench.hpp"
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/rule.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/datasource_cache.hpp>
+#include <mapnik/expression.hpp>
+#include <mapnik/graphics.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/query.hpp>
+
+// boost
+#include <boost/make_shared.hpp>
+#include <boost/lexical_cast.hpp>
+
+namespace benchmark {
+
+namespace {
+
+mapnik::datasource_ptr open_shape(config const& cfg, std::string const& name, bool latin1 = false)
+{
+    mapnik::parameters p;
+    p["type"] = "shape";
+    p["file"] = cfg.data_dir + name;
+    if (latin1) p["encoding"] = "latin1";
+    return mapnik::datasource_cache::instance()->create(p);
+}
+
+// reads every feature of a shapefile with all attributes
+class shape_read : public test_case
+{
+public:
+    shape_read(config const& cfg, std::string const& name, unsigned iterations)
+        : test_case("shape read " + name, iterations),
+          ds_(open_shape(cfg, name)) {}
+
+    bool validate() const
+    {
+        return count() > 0;
+    }
+
+    void operator()() const
+    {
+        count();
+    }
+
+private:
+    unsigned count() const
+    {
+        mapnik::query q(ds_->envelope());
+        std::vector<mapnik::attribute_descriptor> const& attrs = ds_->get_descriptor().get_descriptors();
+        for (std::vector<mapnik::attribute_descriptor>::const_iterator itr = attrs.begin();
+             itr != attrs.end(); ++itr)
+        {
+            q.add_property_name(itr->get_name());
+        }
+        unsigned features = 0;
+        mapnik::featureset_ptr fs = ds_->features(q);
+        while (fs && fs->next())
+        {
+            ++features;
+        }
+        return features;
+    }
+
+    mapnik::datasource_ptr ds_;
+};
+
+void add_line_style(mapnik::Map & m, std::string const& name, std::string const& filter,
+                    mapnik::color const& c, double width)
+{
+    mapnik::feature_type_style style;
+    mapnik::rule r;
+    r.set_filter(mapnik::parse_expression(filter));
+    mapnik::stroke stk(c, width);
+    stk.set_line_cap(mapnik::ROUND_CAP);
+    stk.set_line_join(mapnik::ROUND_JOIN);
+    r.append(mapnik::line_symbolizer(stk));
+    style.add_rule(r);
+    m.insert_style(name, style);
+}
+
+// the map of demo/c++/rundemo.cpp
+mapnik::Map make_demo_map(config const& cfg)
+{
+    using namespace mapnik;
+    Map m(800, 600);
+    m.set_background(color(255, 255, 255));
+
+    feature_type_style provpoly_style;
+    rule provpoly_rule_on;
+    provpoly_rule_on.set_filter(parse_expression("[NAME_EN] = 'Ontario'"));
+    provpoly_rule_on.append(polygon_symbolizer(color(250, 190, 183)));
+    provpoly_style.add_rule(provpoly_rule_on);
+    rule provpoly_rule_qc;
+    provpoly_rule_qc.set_filter(parse_expression("[NOM_FR] = 'Québec'"));
+    provpoly_rule_qc.append(polygon_symbolizer(color(217, 235, 203)));
+    provpoly_style.add_rule(provpoly_rule_qc);
+    m.insert_style("provinces", provpoly_style);
+
+    feature_type_style provlines_style;
+    stroke provlines_stk(color(0, 0, 0), 1.0);
+    provlines_stk.add_dash(8, 4);
+    provlines_stk.add_dash(2, 2);
+    provlines_stk.add_dash(2, 2);
+    rule provlines_rule;
+    provlines_rule.append(line_symbolizer(provlines_stk));
+    provlines_style.add_rule(provlines_rule);
+    m.insert_style("provlines", provlines_style);
+
+    feature_type_style qcdrain_style;
+    rule qcdrain_rule;
+    qcdrain_rule.set_filter(parse_expression("[HYC] = 8"));
+    qcdrain_rule.append(polygon_symbolizer(color(153, 204, 255)));
+    qcdrain_style.add_rule(qcdrain_rule);
+    m.insert_style("drainage", qcdrain_style);
+
+    add_line_style(m, "smallroads", "[CLASS] = 3 or [CLASS] = 4", color(171, 158, 137), 2.0);
+    add_line_style(m, "road-border", "[CLASS] = 2", color(171, 158, 137), 4.0);
+    add_line_style(m, "road-fill", "[CLASS] = 2", color(255, 250, 115), 2.0);
+    add_line_style(m, "highway-border", "[CLASS] = 1", color(188, 149, 28), 7.0);
+    add_line_style(m, "highway-fill", "[CLASS] = 1", color(242, 191, 36), 5.0);
+
+    feature_type_style popplaces_style;
+    rule popplaces_rule;
+    text_symbolizer popplaces_text_symbolizer(parse_expression("[GEONAME]"), "DejaVu Sans Book", 10, color(0, 0, 0));
+    popplaces_text_symbolizer.set_halo_fill(color(255, 255, 200));
+    popplaces_text_symbolizer.set_halo_radius(1);
+    popplaces_rule.append(popplaces_text_symbolizer);
+    popplaces_style.add_rule(popplaces_rule);
+    m.insert_style("popplaces", popplaces_style);
+
+    layer provinces("Provinces");
+    provinces.set_datasource(open_shape(cfg, "boundaries", true));
+    provinces.add_style("provinces");
+    m.addLayer(provinces);
+
+    layer qc_drainage("Quebec Hydrography");
+    qc_drainage.set_datasource(open_shape(cfg, "qcdrainage"));
+    qc_drainage.add_style("drainage");
+    m.addLayer(qc_drainage);
+
+    layer ont_drainage("Ontario Hydrography");
+    ont_drainage.set_datasource(open_shape(cfg, "ontdrainage"));
+    ont_drainage.add_style("drainage");
+    m.addLayer(ont_drainage);
+
+    layer borders("Provincial borders");
+    borders.set_datasource(open_shape(cfg, "boundaries_l"));
+    borders.add_style("provlines");
+    m.addLayer(borders);
+
+    layer roads("Roads");
+    roads.set_datasource(open_shape(cfg, "roads"));
+    roads.add_style("smallroads");
+    roads.add_style("road-border");
+    roads.add_style("road-fill");
+    roads.add_style("highway-border");
+    roads.add_style("highway-fill");
+    m.addLayer(roads);
+
+    layer popplaces("Populated Places");
+    popplaces.set_datasource(open_shape(cfg, "popplaces", true));
+    popplaces.add_style("popplaces");
+    m.addLayer(popplaces);
+
+    return m;
+}
+
+class map_render : public test_case
+{
+public:
+    map_render(mapnik::Map const& m, mapnik::box2d<double> const& extent,
+               std::string const& name, unsigned iterations)
+        : test_case(name, iterations),
+          map_(m)
+    {
+        map_.zoom_to_box(extent);
+        // warm up the rule caches before threads share the map
+        (*this)();
+    }
+
+    void operator()() const
+    {
+        mapnik::image_32 im(map_.width(), map_.height());
+        mapnik::agg_renderer<mapnik::image_32> ren(map_, im);
+        ren.apply();
+    }
+
+private:
+    mapnik::Map map_;
+};
+
+}
+
+void add_map_cases(test_list & tests, config const& cfg)
+{
+    const char* shapes[] = { "roads", "boundaries", "qcdrainage", "popplaces" };
+    for (unsigned i = 0; i < sizeof(shapes) / sizeof(const char*); ++i)
+    {
+        tests.push_back(boost::make_shared<shape_read>(cfg, shapes[i], 20));
+    }
+
+    mapnik::Map m = make_demo_map(cfg);
+    m.zoom_all();
+    mapnik::box2d<double> all = m.get_current_extent();
+    mapnik::box2d<double> demo(1405120.04127408, -247003.813399447,
+                               1706357.31328276, -25098.593149577);
+    // an eighth of the demo extent around its center, most features get clipped
+    mapnik::coord2d center = demo.center();
+    mapnik::box2d<double> city(center.x - demo.width() / 16, center.y - demo.height() / 16,
+                               center.x + demo.width() / 16, center.y + demo.height() / 16);
+    tests.push_back(boost::make_shared<map_render>(m, all, "demo map zoom all 800x600", 10));
+    tests.push_back(boost::make_shared<map_render>(m, demo, "demo map rundemo extent 800x600", 10));
+    tests.push_back(boost::make_shared<map_render>(m, city, "demo map 1/8 extent 800x600", 10));
+}
+
+}
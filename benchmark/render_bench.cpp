@@ -0,0 +1,303 @@
+#include "bench.hpp"
+
+// mapnik
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/rule.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/geometry.hpp>
+#include <mapnik/graphics.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include <mapnik/text_properties.hpp>
+#include <mapnik/text_path.hpp>
+#include <mapnik/raster.hpp>
+#include <mapnik/warp.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+
+// boost
+#include <boost/make_shared.hpp>
+
+// stl
+#include <cmath>
+#include <cstdlib>
+
+namespace benchmark {
+
+namespace {
+
+// a map of one layer holding random lines or polygons over a 256x256 tile
+mapnik::Map make_random_map(mapnik::eGeomType type, unsigned count, unsigned points)
+{
+    mapnik::Map m(256, 256);
+    mapnik::feature_type_style style;
+    mapnik::rule r;
+    if (type == mapnik::Polygon)
+    {
+        r.append(mapnik::polygon_symbolizer(mapnik::color(217, 235, 203, 200)));
+    }
+    else
+    {
+        mapnik::stroke stk(mapnik::color(188, 149, 28), 2.0);
+        stk.set_line_join(mapnik::ROUND_JOIN);
+        r.append(mapnik::line_symbolizer(stk));
+    }
+    style.add_rule(r);
+    m.insert_style("style", style);
+
+    std::srand(type);
+    mapnik::context_ptr ctx = boost::make_shared<mapnik::context_type>();
+    boost::shared_ptr<mapnik::memory_datasource> ds = boost::make_shared<mapnik::memory_datasource>();
+    for (unsigned i = 0; i < count; ++i)
+    {
+        mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, i));
+        mapnik::geometry_type * geom = new mapnik::geometry_type(type);
+        double cx = std::rand() % 256;
+        double cy = std::rand() % 256;
+        double radius = 4 + std::rand() % 60;
+        for (unsigned p = 0; p < points; ++p)
+        {
+            double angle = 2 * M_PI * p / points;
+            double rad = radius * (0.5 + (std::rand() % 100) / 100.0);
+            double x = cx + rad * std::cos(angle);
+            double y = cy + rad * std::sin(angle);
+            if (p == 0) geom->move_to(x, y);
+            else geom->line_to(x, y);
+        }
+        feature->add_geometry(geom);
+        ds->push(feature);
+    }
+    mapnik::layer lyr("random");
+    lyr.set_datasource(ds);
+    lyr.add_style("style");
+    m.addLayer(lyr);
+    m.zoom_to_box(mapnik::box2d<double>(0, 0, 256, 256));
+    return m;
+}
+
+class rasterize : public test_case
+{
+public:
+    rasterize(mapnik::eGeomType type, unsigned count, unsigned points,
+              unsigned iterations, std::string const& name)
+        : test_case(name, iterations),
+          map_(make_random_map(type, count, points))
+    {
+        // the first render fills the styles' rule caches, so the timed
+        // renders from several threads only read them
+        (*this)();
+    }
+
+    void operator()() const
+    {
+        mapnik::image_32 im(map_.width(), map_.height());
+        mapnik::agg_renderer<mapnik::image_32> ren(map_, im);
+        ren.apply();
+    }
+
+private:
+    mapnik::Map map_;
+};
+
+// builds the glyph metrics of a batch of labels like the text placement does
+class text_shaping : public test_case
+{
+public:
+    text_shaping(std::string const& face_name, unsigned iterations)
+        : test_case("text shaping 100 labels " + face_name, iterations),
+          face_name_(face_name)
+    {
+        const char* names[] = { "Ottawa", "Montreal", "Quebec City", "Trois-Rivieres",
+                                "Sherbrooke", "Gatineau", "Kingston", "Rouyn-Noranda",
+                                "Saint-Jean-sur-Richelieu", "Val-d'Or" };
+        for (unsigned i = 0; i < 100; ++i)
+        {
+            labels_.push_back(UnicodeString(names[i % 10]));
+        }
+        props_.face_name = face_name;
+        props_.text_size = 10;
+    }
+
+    bool validate() const
+    {
+        mapnik::freetype_engine engine;
+        mapnik::face_manager<mapnik::freetype_engine> faces(engine);
+        return faces.get_face_set(face_name_)->size() > 0;
+    }
+
+    void operator()() const
+    {
+        mapnik::freetype_engine engine;
+        mapnik::face_manager<mapnik::freetype_engine> faces(engine);
+        mapnik::face_set_ptr face_set = faces.get_face_set(face_name_);
+        face_set->set_character_sizes(props_.text_size);
+        for (std::vector<UnicodeString>::const_iterator itr = labels_.begin();
+             itr != labels_.end(); ++itr)
+        {
+            mapnik::string_info info(*itr);
+            face_set->get_string_info(info, *itr, const_cast<mapnik::char_properties*>(&props_));
+        }
+    }
+
+private:
+    std::string face_name_;
+    std::vector<UnicodeString> labels_;
+    mapnik::char_properties props_;
+};
+
+class png_encoding : public test_case
+{
+public:
+    png_encoding(std::string const& format, unsigned iterations)
+        : test_case("encode 512x512 " + format, iterations),
+          format_(format),
+          image_(512, 512)
+    {
+        // flat areas, gradients and some noise, roughly what map tiles hold
+        std::srand(1);
+        for (unsigned y = 0; y < image_.height(); ++y)
+        {
+            unsigned * row = image_.getRow(y);
+            for (unsigned x = 0; x < image_.width(); ++x)
+            {
+                unsigned r, g, b, a = 255;
+                if (y < image_.height() / 3)
+                {
+                    r = 0xf2; g = 0xef; b = 0xe9;
+                }
+                else if (y < 2 * image_.height() / 3)
+                {
+                    r = x & 0xff; g = y & 0xff; b = (x + y) & 0xff;
+                }
+                else
+                {
+                    r = std::rand() & 0xff; g = std::rand() & 0xff; b = std::rand() & 0xff;
+                    a = std::rand() % 4 ? 255 : 0;
+                }
+                row[x] = (a << 24) | (b << 16) | (g << 8) | r;
+            }
+        }
+    }
+
+    bool validate() const
+    {
+        return !mapnik::save_to_string(image_, format_).empty();
+    }
+
+    void operator()() const
+    {
+        mapnik::save_to_string(image_, format_);
+    }
+
+private:
+    std::string format_;
+    mapnik::image_data_32 image_;
+};
+
+// blends a 512x512 tile with random alpha onto another, as raster
+// symbolizers with a compositing mode do
+class raster_blend : public test_case
+{
+public:
+    raster_blend(std::string const& mode, unsigned iterations)
+        : test_case("blend 512x512 " + mode, iterations),
+          mode_(mode),
+          src_(512, 512),
+          dst_(512, 512)
+    {
+        std::srand(3);
+        for (unsigned y = 0; y < src_.height(); ++y)
+        {
+            unsigned * src_row = src_.getRow(y);
+            unsigned * dst_row = dst_.getRow(y);
+            for (unsigned x = 0; x < src_.width(); ++x)
+            {
+                src_row[x] = (std::rand() & 0xffff) | ((std::rand() & 0xff) << 16) | ((std::rand() & 0xff) << 24);
+                dst_row[x] = 0xff000000 | (std::rand() & 0xffff) | ((std::rand() & 0xff) << 16);
+            }
+        }
+    }
+
+    void operator()() const
+    {
+        mapnik::image_32 im(dst_.width(), dst_.height());
+        im.set_rectangle(0, 0, dst_);
+        if (mode_ == "alpha") im.set_rectangle_alpha2(src_, 0, 0, 0.8f);
+        else if (mode_ == "multiply") im.merge_rectangle<mapnik::Multiply>(src_, 0, 0, 0.8f);
+        else if (mode_ == "multiply2") im.merge_rectangle<mapnik::Multiply2>(src_, 0, 0, 0.8f);
+        else if (mode_ == "divide") im.merge_rectangle<mapnik::Divide>(src_, 0, 0, 0.8f);
+        else if (mode_ == "divide2") im.merge_rectangle<mapnik::Divide2>(src_, 0, 0, 0.8f);
+        else if (mode_ == "screen") im.merge_rectangle<mapnik::Screen>(src_, 0, 0, 0.8f);
+        else if (mode_ == "hard-light") im.merge_rectangle<mapnik::HardLight>(src_, 0, 0, 0.8f);
+        else if (mode_ == "merge-grain") im.merge_rectangle<mapnik::MergeGrain>(src_, 0, 0, 0.8f);
+        else if (mode_ == "merge-grain2") im.merge_rectangle<mapnik::MergeGrain2>(src_, 0, 0, 0.8f);
+    }
+
+private:
+    std::string mode_;
+    mapnik::image_data_32 src_;
+    mapnik::image_data_32 dst_;
+};
+
+class raster_warp : public test_case
+{
+public:
+    raster_warp(std::string const& method, unsigned iterations)
+        : test_case("warp 512x512 wgs84 to mercator " + method, iterations),
+          method_(method),
+          source_(mapnik::box2d<double>(-20, 20, 20, 60), mapnik::image_data_32(512, 512)),
+          src_prj_("+init=epsg:4326"),
+          dst_prj_("+init=epsg:3857")
+    {
+        std::srand(2);
+        for (unsigned y = 0; y < source_.data_.height(); ++y)
+        {
+            unsigned * row = source_.data_.getRow(y);
+            for (unsigned x = 0; x < source_.data_.width(); ++x)
+            {
+                row[x] = 0xff000000 | ((x & 0xff) << 8) | ((y + std::rand() % 8) & 0xff);
+            }
+        }
+    }
+
+    void operator()() const
+    {
+        mapnik::proj_transform prj_trans(dst_prj_, src_prj_);
+        mapnik::raster target(mapnik::box2d<double>(-2226389.8, 2273030.9, 2226389.8, 8399737.9),
+                              mapnik::image_data_32(512, 512));
+        mapnik::reproject_raster(target, source_, prj_trans, 0.0, 0.0, 16, 2.0, 1.0, method_);
+    }
+
+private:
+    std::string method_;
+    mapnik::raster source_;
+    mapnik::projection src_prj_;
+    mapnik::projection dst_prj_;
+};
+
+}
+
+void add_render_cases(test_list & tests, config const& /*cfg*/)
+{
+    tests.push_back(boost::make_shared<rasterize>(mapnik::Polygon, 200, 20, 200, "rasterize 200 polygons"));
+    tests.push_back(boost::make_shared<rasterize>(mapnik::Polygon, 10, 5000, 100, "rasterize 10 polygons 5000 points"));
+    tests.push_back(boost::make_shared<rasterize>(mapnik::LineString, 200, 20, 200, "rasterize 200 lines"));
+    tests.push_back(boost::make_shared<text_shaping>("DejaVu Sans Book", 200));
+    tests.push_back(boost::make_shared<png_encoding>("png", 20));
+    tests.push_back(boost::make_shared<png_encoding>("png256", 20));
+    char const* blend_modes[] = { "alpha", "multiply", "multiply2", "divide", "divide2",
+                                  "screen", "hard-light", "merge-grain", "merge-grain2" };
+    for (unsigned i = 0; i < sizeof(blend_modes) / sizeof(char const*); ++i)
+    {
+        tests.push_back(boost::make_shared<raster_blend>(blend_modes[i], 100));
+    }
+    tests.push_back(boost::make_shared<raster_warp>("bilinear", 20));
+    tests.push_back(boost::make_shared<raster_warp>("bicubic", 20));
+    tests.push_back(boost::make_shared<raster_warp>("lanczos", 10));
+}
+
+}
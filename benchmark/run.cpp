@@ -0,0 +1,188 @@
+#include "bench.hpp"
+
+// mapnik
+#include <mapnik/version.hpp>
+#include <mapnik/datasource_cache.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include <mapnik/image_blend.hpp>
+
+// boost
+#include <boost/lexical_cast.hpp>
+
+// stl
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <exception>
+
+/*
+ * Micro and end to end benchmarks of the core library.
+ *
+ *   mapnik-bench [--threads N] [--scale X] [--json] [--data DIR]
+ *                [--plugins DIR] [--fonts DIR] [--simd LEVEL] [filter]
+ *
+ * Every case runs on one thread and then on N threads at once (the hardware
+ * concurrency by default) so the second run shows how throughput scales.
+ * --scale multiplies the iteration counts, only cases whose name contains
+ * the filter are run. With --json the results are written to stdout as one
+ * json object for tracking regressions across commits. --simd scalar|sse2|avx2
+ * caps the instruction set of the raster kernels, to compare them.
+ */
+
+namespace {
+
+void usage()
+{
+    std::clog << "usage: mapnik-bench [--threads N] [--scale X] [--json] [--data DIR]"
+              << " [--plugins DIR] [--fonts DIR] [--simd LEVEL] [filter]\n";
+}
+
+std::string json_string(std::string const& str)
+{
+    std::string out("\"");
+    for (std::string::const_iterator itr = str.begin(); itr != str.end(); ++itr)
+    {
+        if (*itr == '"' || *itr == '\\') out += '\\';
+        out += *itr;
+    }
+    out += '"';
+    return out;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    benchmark::config cfg;
+    unsigned threads = std::max(1u, boost::thread::hardware_concurrency());
+    double scale = 1.0;
+    bool json = false;
+    std::string filter;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg(argv[i]);
+            bool has_value = i + 1 < argc;
+            if (arg == "--threads" && has_value)
+                threads = std::max(1u, boost::lexical_cast<unsigned>(argv[++i]));
+            else if (arg == "--scale" && has_value)
+                scale = boost::lexical_cast<double>(argv[++i]);
+            else if (arg == "--json")
+                json = true;
+            else if (arg == "--data" && has_value)
+                cfg.data_dir = std::string(argv[++i]) + "/";
+            else if (arg == "--plugins" && has_value)
+                cfg.plugins_dir = std::string(argv[++i]) + "/";
+            else if (arg == "--fonts" && has_value)
+                cfg.fonts_dir = std::string(argv[++i]) + "/";
+            else if (arg == "--simd" && has_value)
+            {
+                std::string level(argv[++i]);
+                if (level == "scalar") mapnik::set_simd_level(mapnik::SIMD_NONE);
+                else if (level == "sse2") mapnik::set_simd_level(mapnik::SIMD_SSE2);
+                else if (level == "avx2") mapnik::set_simd_level(mapnik::SIMD_AVX2);
+                else
+                {
+                    usage();
+                    return EXIT_FAILURE;
+                }
+            }
+            else if (arg.size() > 1 && arg[0] == '-')
+            {
+                usage();
+                return EXIT_FAILURE;
+            }
+            else
+                filter = arg;
+        }
+    }
+    catch (boost::bad_lexical_cast const&)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    benchmark::test_list tests;
+    try
+    {
+        mapnik::datasource_cache::instance()->register_datasources(cfg.plugins_dir);
+        mapnik::freetype_engine::register_fonts(cfg.fonts_dir);
+        benchmark::add_geometry_cases(tests, cfg);
+        benchmark::add_render_cases(tests, cfg);
+        benchmark::add_map_cases(tests, cfg);
+    }
+    catch (std::exception const& ex)
+    {
+        std::clog << "### failed to set up benchmarks: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    char const* simd_names[] = { "scalar", "sse2", "avx2" };
+    char const* simd = simd_names[mapnik::get_simd_level()];
+    if (json)
+    {
+        std::cout << "{\"mapnik\":\"" << MAPNIK_VERSION_STRING << "\",\"threads\":" << threads
+                  << ",\"scale\":" << scale << ",\"simd\":\"" << simd << "\",\"results\":[";
+    }
+    else
+    {
+        std::cout << "raster kernels: " << simd << "\n";
+        std::cout << std::left << std::setw(44) << "benchmark" << std::right
+                  << std::setw(8) << "threads" << std::setw(10) << "iters"
+                  << std::setw(12) << "ms" << std::setw(14) << "per second" << "\n";
+    }
+
+    bool first = true;
+    int failed = 0;
+    for (benchmark::test_list::const_iterator itr = tests.begin(); itr != tests.end(); ++itr)
+    {
+        benchmark::test_case const& test = **itr;
+        if (!filter.empty() && test.name().find(filter) == std::string::npos) continue;
+        try
+        {
+            if (!test.validate())
+            {
+                std::clog << "### " << test.name() << ": validation failed, skipped\n";
+                ++failed;
+                continue;
+            }
+            unsigned thread_counts[] = { 1, threads };
+            for (unsigned t = 0; t < (threads > 1 ? 2u : 1u); ++t)
+            {
+                benchmark::result r = benchmark::run(test, thread_counts[t], scale);
+                double per_second = r.elapsed > 0 ? 1000.0 * r.iterations * r.threads / r.elapsed : 0;
+                if (json)
+                {
+                    if (!first) std::cout << ",";
+                    std::cout << "\n  {\"name\":" << json_string(r.name)
+                              << ",\"threads\":" << r.threads
+                              << ",\"iterations\":" << r.iterations
+                              << ",\"ms\":" << std::fixed << std::setprecision(3) << r.elapsed
+                              << ",\"per_second\":" << per_second << "}";
+                    first = false;
+                }
+                else
+                {
+                    std::cout << std::left << std::setw(44) << r.name << std::right
+                              << std::setw(8) << r.threads << std::setw(10) << r.iterations
+                              << std::setw(12) << std::fixed << std::setprecision(1) << r.elapsed
+                              << std::setw(14) << per_second << std::endl;
+                }
+            }
+        }
+        catch (std::exception const& ex)
+        {
+            std::clog << "### " << test.name() << ": " << ex.what() << "\n";
+            ++failed;
+        }
+    }
+
+    if (json)
+    {
+        std::cout << "\n]}\n";
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
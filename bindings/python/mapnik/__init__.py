@@ -454,6 +454,8 @@ def Ogr(**keywords):
       layer_by_sql -- choose layer by sql query number instead of by layer name or index.
       base -- path prefix (default None)
       encoding -- file encoding (default 'utf-8')
+      build_index -- index the layer in memory on first use when no .ogrindex
+                     file exists (default True)
 
     >>> from mapnik import Ogr, Layer
     >>> datasource = Ogr(base='/home/mapnik/data',file='rivers.geojson',layer='OGRGeoJSON') 
@@ -482,6 +484,8 @@ def SQLite(**keywords):
       row_limit -- specify a custom integer row limit (default 0)
       wkb_format -- specify a wkb type of 'spatialite' (default None)
       use_spatial_index -- boolean, instruct sqlite plugin to use Rtree spatial index (default True)
+      max_size -- maximum number of pooled read connections for concurrent queries, 0 to query through a single connection (default 10)
+      mmap_size -- bytes of the database pooled connections memory map, requires sqlite >= 3.7.17 (default 268435456)
 
     >>> from mapnik import SQLite, Layer
     >>> sqlite = SQLite(base='/home/mapnik/data',file='osm.db',table='osm',extent='-20037508,-19929239,20037508,19929239') 
@@ -522,6 +526,8 @@ def Osm(**keywords):
       encoding -- file encoding (default 'utf-8')
       url -- url to fetch data (default None)
       bbox -- data bounding box for fetching data (default None)
+      cache -- path of a converted, memory mapped copy of `file`; written on
+               first use and whenever `file` is newer (default None)
 
     >>> from mapnik import Osm, Layer
     >>> datasource = Osm(file='test.osm') 
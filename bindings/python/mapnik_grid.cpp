@@ -34,6 +34,7 @@ using namespace boost::python;
 
 // help compiler see template definitions
 static dict (*encode)( mapnik::grid const&, std::string, bool, unsigned int) = mapnik::grid_encode;
+static std::string (*encode_json)( mapnik::grid const&, bool, unsigned int) = mapnik::grid_encode_json;
 
 bool painted(mapnik::grid const& grid)
 {
@@ -57,6 +58,11 @@ void export_grid()
              ( boost::python::arg("encoding")="utf", boost::python::arg("features")=true,boost::python::arg("resolution")=4 ),
              "Encode the grid as as optimized json\n"
             )
+        .def("encode_json",encode_json,
+             ( boost::python::arg("features")=true,boost::python::arg("resolution")=4 ),
+             "Encode the grid as a utf grid json string, without\n"
+             "building python objects for every row and feature\n"
+            )
         .add_property("key",
                       make_function(&mapnik::grid::get_key,return_value_policy<copy_const_reference>()),
                       &mapnik::grid::set_key,
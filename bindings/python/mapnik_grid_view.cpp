@@ -36,6 +36,7 @@ using namespace boost::python;
 
 // help compiler see template definitions
 static dict (*encode)( mapnik::grid_view const&, std::string, bool, unsigned int) = mapnik::grid_encode;
+static std::string (*encode_json)( mapnik::grid_view const&, bool, unsigned int) = mapnik::grid_encode_json;
 
 void export_grid_view()
 {
@@ -48,5 +49,10 @@ void export_grid_view()
              ( boost::python::arg("encoding")="utf",boost::python::arg("add_features")=true,boost::python::arg("resolution")=4 ),
              "Encode the grid as as optimized json\n"
             )
+        .def("encode_json",encode_json,
+             ( boost::python::arg("add_features")=true,boost::python::arg("resolution")=4 ),
+             "Encode the grid as a utf grid json string, without\n"
+             "building python objects for every row and feature\n"
+            )
         ;
 }
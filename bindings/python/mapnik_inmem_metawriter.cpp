@@ -33,6 +33,30 @@ using mapnik::metawriter_inmem;
 using mapnik::metawriter_inmem_ptr;
 
 namespace {
+
+// the writer keeps properties flat with interned keys, python gets
+// each instance with its own box and property map as before
+struct inmem_instance {
+    mapnik::box2d<double> box;
+    std::map<std::string, mapnik::value> properties;
+};
+
+boost::python::object inmem_iter(metawriter_inmem const& writer) {
+    boost::python::list instances;
+    metawriter_inmem::meta_property_list const& props = writer.properties();
+    std::vector<std::string> const& keys = writer.key_names();
+    metawriter_inmem::meta_instance_list::const_iterator itr = writer.inst_begin();
+    for (; itr != writer.inst_end(); ++itr) {
+        inmem_instance inst;
+        inst.box = itr->box;
+        for (unsigned i = itr->first_property; i < itr->last_property; ++i) {
+            inst.properties.insert(std::make_pair(keys[props[i].key], props[i].val));
+        }
+        instances.append(inst);
+    }
+    return instances.attr("__iter__")();
+}
+
 std::map<std::string, mapnik::value>::const_iterator
 mapnik_value_map_begin(const std::map<std::string, mapnik::value> &m) {
     return m.begin();
@@ -42,6 +66,19 @@ std::map<std::string, mapnik::value>::const_iterator
 mapnik_value_map_end(const std::map<std::string, mapnik::value> &m) {
     return m.end();
 }
+
+std::size_t mapnik_value_map_len(const std::map<std::string, mapnik::value> &m) {
+    return m.size();
+}
+
+mapnik::value mapnik_value_map_get(const std::map<std::string, mapnik::value> &m, std::string const& key) {
+    std::map<std::string, mapnik::value>::const_iterator itr = m.find(key);
+    if (itr == m.end()) {
+        PyErr_SetString(PyExc_KeyError, key.c_str());
+        boost::python::throw_error_already_set();
+    }
+    return itr->second;
+}
 }
 
 void export_inmem_metawriter() {
@@ -50,19 +87,20 @@ void export_inmem_metawriter() {
     class_<std::map<std::string, mapnik::value> >
         ("MapnikProperties", "Retarded.", init<>())
         .def("__iter__", range(&mapnik_value_map_begin, &mapnik_value_map_end))
+        .def("__len__", &mapnik_value_map_len)
+        .def("__getitem__", &mapnik_value_map_get)
         ;
 
-    class_<metawriter_inmem::meta_instance>
+    class_<inmem_instance>
         ("MetaInstance", "Single rendered instance of meta-information.", no_init)
-        .def_readonly("box", &metawriter_inmem::meta_instance::box)
-        .def_readonly("properties", &metawriter_inmem::meta_instance::properties)
+        .def_readonly("box", &inmem_instance::box)
+        .def_readonly("properties", &inmem_instance::properties)
         ;
 
     class_<metawriter_inmem, metawriter_inmem_ptr, boost::noncopyable>
         ("MetaWriterInMem",
          "Collects meta-information about elements rendered.",
          no_init)
-        .def("__iter__", range(&metawriter_inmem::inst_begin,
-                               &metawriter_inmem::inst_end))
+        .def("__iter__", &inmem_iter)
         ;
 }
@@ -185,6 +185,30 @@ void export_layer()
                       ">>> lyr.cache_features = True # set to True to enable feature caching\n"
             )
 
+        .add_property("cache_rendering",
+                      &layer::cache_rendering,
+                      &layer::set_cache_rendering,
+                      "Get/Set whether the rendered image of this layer is cached and reused\n"
+                      "for the same map size and extent (agg renderer only)\n"
+                      "\n"
+                      "Usage:\n"
+                      ">>> lyr.cache_rendering\n"
+                      "False # False by default\n"
+                      ">>> lyr.cache_rendering = True # set to True to enable render caching\n"
+            )
+
+        .add_property("min_feature_size",
+                      &layer::min_feature_size,
+                      &layer::set_min_feature_size,
+                      "Get/Set the screen size in pixels below which line and polygon geometries\n"
+                      "are filled as their bounding box instead of being rasterized in full\n"
+                      "\n"
+                      "Usage:\n"
+                      ">>> lyr.min_feature_size\n"
+                      "0.0 # 0 by default, meaning every geometry is rasterized\n"
+                      ">>> lyr.min_feature_size = 1.0 # collapse geometries smaller than a pixel\n"
+            )
+
         .add_property("datasource",
                       &layer::datasource,
                       &layer::set_datasource,
@@ -21,12 +21,19 @@
  *****************************************************************************/
 //$Id$
 
+extern "C"
+{
+#include <png.h>
+}
+
 // boost
 #include <boost/python.hpp>
 #include <boost/make_shared.hpp>
 
 //mapnik
 #include <mapnik/palette.hpp>
+#include <mapnik/graphics.hpp>
+#include <mapnik/png_io.hpp>
 
 static boost::shared_ptr<mapnik::rgba_palette> make_palette( const std::string& palette, const std::string& format )
 {
@@ -40,6 +47,13 @@ static boost::shared_ptr<mapnik::rgba_palette> make_palette( const std::string&
     return boost::make_shared<mapnik::rgba_palette>(palette, type);
 }
 
+// one palette for all tiles of a metatile
+static boost::shared_ptr<mapnik::rgba_palette> make_palette_from_image( mapnik::image_32 const& image, int colors )
+{
+    return boost::make_shared<mapnik::rgba_palette>(mapnik::make_palette_hex(image.data(), colors),
+                                                    mapnik::rgba_palette::PALETTE_RGBA);
+}
+
 void export_palette ()
 {
     using namespace boost::python;
@@ -52,5 +66,8 @@ void export_palette ()
         // "Creates a new color palette from a file\n"
         // )
         .def( "__init__", boost::python::make_constructor(make_palette))
+        .def( "__init__", boost::python::make_constructor(make_palette_from_image,
+                                                          default_call_policies(),
+                                                          (arg("image"), arg("colors")=256)))
         ;
 }
@@ -67,6 +67,7 @@ void export_view_transform();
 void export_raster_colorizer();
 void export_inmem_metawriter();
 void export_label_collision_detector();
+void export_render_stats();
 
 #include <mapnik/version.hpp>
 #include <mapnik/value_error.hpp>
@@ -125,6 +126,19 @@ void render_with_detector(
     ren.apply();
 }
 
+void render_with_stats(const mapnik::Map& map,
+                       mapnik::image_32& image,
+                       mapnik::render_stats& stats,
+                       double scale_factor = 1.0,
+                       unsigned offset_x = 0u,
+                       unsigned offset_y = 0u)
+{
+    python_unblock_auto_block b;
+    mapnik::agg_renderer<mapnik::image_32> ren(map,image,scale_factor,offset_x, offset_y);
+    ren.set_stats(&stats);
+    ren.apply();
+}
+
 void render_layer2(const mapnik::Map& map,
                    mapnik::image_32& image,
                    unsigned layer_idx)
@@ -331,6 +345,7 @@ BOOST_PYTHON_FUNCTION_OVERLOADS(save_map_overloads, save_map, 2, 3)
 BOOST_PYTHON_FUNCTION_OVERLOADS(save_map_to_string_overloads, save_map_to_string, 1, 2)
 BOOST_PYTHON_FUNCTION_OVERLOADS(render_overloads, render, 2, 5)
 BOOST_PYTHON_FUNCTION_OVERLOADS(render_with_detector_overloads, render_with_detector, 3, 6)
+BOOST_PYTHON_FUNCTION_OVERLOADS(render_with_stats_overloads, render_with_stats, 3, 6)
 
 BOOST_PYTHON_MODULE(_mapnik)
 {
@@ -386,6 +401,7 @@ BOOST_PYTHON_MODULE(_mapnik)
     export_raster_colorizer();
     export_inmem_metawriter();
     export_label_collision_detector();
+    export_render_stats();
 
     def("render_grid",&render_grid,
         ( arg("map"),
@@ -475,6 +491,21 @@ BOOST_PYTHON_MODULE(_mapnik)
             ">>> render_with_detector(m, im, detector)\n"
             ));
 
+    def("render_with_stats", &render_with_stats, render_with_stats_overloads(
+            "\n"
+            "Render Map to an AGG image_32, collecting per layer and per style\n"
+            "timings and counts into a RenderStats object.\n"
+            "\n"
+            "Usage:\n"
+            ">>> from mapnik import Map, Image, RenderStats, render_with_stats, load_map\n"
+            ">>> m = Map(256,256)\n"
+            ">>> load_map(m,'mapfile.xml')\n"
+            ">>> im = Image(m.width,m.height)\n"
+            ">>> stats = RenderStats()\n"
+            ">>> render_with_stats(m, im, stats)\n"
+            ">>> [(l.name, l.time) for l in stats.layers]\n"
+            ));
+
     def("render_layer", &render_layer2,
         (arg("map"),arg("image"),args("layer"))
         );
@@ -0,0 +1,132 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+// boost
+#include <boost/python.hpp>
+#include <boost/foreach.hpp>
+
+// mapnik
+#include <mapnik/render_stats.hpp>
+
+// stl
+#include <sstream>
+
+using mapnik::render_stats;
+using mapnik::layer_stats;
+using mapnik::style_stats;
+using mapnik::symbolizer_stats;
+
+namespace
+{
+
+template <typename T>
+boost::python::list to_list(std::vector<T> const& items)
+{
+    boost::python::list result;
+    BOOST_FOREACH(T const& item, items)
+    {
+        result.append(item);
+    }
+    return result;
+}
+
+boost::python::list layers(render_stats const& stats)
+{
+    return to_list(stats.layers);
+}
+
+boost::python::list styles(layer_stats const& stats)
+{
+    return to_list(stats.styles);
+}
+
+boost::python::list symbolizers(style_stats const& stats)
+{
+    return to_list(stats.symbolizers);
+}
+
+std::string report(render_stats const& stats)
+{
+    std::ostringstream s;
+    s << stats;
+    return s.str();
+}
+
+}
+
+void export_render_stats()
+{
+    using namespace boost::python;
+
+    class_<symbolizer_stats>("SymbolizerStats", no_init)
+        .def_readonly("name", &symbolizer_stats::name)
+        .def_readonly("count", &symbolizer_stats::count,
+                      "Number of features the symbolizer was applied to")
+        .def_readonly("time", &symbolizer_stats::time, "Milliseconds")
+        ;
+
+    class_<style_stats>("StyleStats", no_init)
+        .def_readonly("name", &style_stats::name)
+        .def_readonly("features", &style_stats::features,
+                      "Number of features read for the style")
+        .def_readonly("features_rendered", &style_stats::features_rendered,
+                      "Number of features matched by at least one rule")
+        .def_readonly("labels_attempted", &style_stats::labels_attempted)
+        .def_readonly("labels_placed", &style_stats::labels_placed)
+        .def_readonly("query_time", &style_stats::query_time,
+                      "Milliseconds reading features")
+        .def_readonly("filter_time", &style_stats::filter_time,
+                      "Milliseconds evaluating rule filters")
+        .def_readonly("time", &style_stats::time, "Milliseconds")
+        .add_property("symbolizers", &symbolizers)
+        ;
+
+    class_<layer_stats>("LayerStats", no_init)
+        .def_readonly("name", &layer_stats::name)
+        .def_readonly("features", &layer_stats::features,
+                      "Number of features returned by the datasource")
+        .def_readonly("query_time", &layer_stats::query_time,
+                      "Milliseconds in the datasource")
+        .def_readonly("cached", &layer_stats::cached,
+                      "Whether the layer was drawn from the layer render cache")
+        .def_readonly("time", &layer_stats::time, "Milliseconds")
+        .add_property("styles", &styles)
+        ;
+
+    class_<render_stats>("RenderStats",
+                         "Per layer and per style numbers collected by render_with_stats.\n"
+                         "\n"
+                         "Usage:\n"
+                         ">>> stats = mapnik.RenderStats()\n"
+                         ">>> mapnik.render_with_stats(m, im, stats)\n"
+                         ">>> stats.bytes_encoded += len(im.tostring('png'))\n"
+                         ">>> print stats\n",
+                         init<>())
+        .add_property("layers", &layers)
+        .def_readwrite("bytes_encoded", &render_stats::bytes_encoded,
+                       "Left to the caller, who encodes the image")
+        .def_readonly("time", &render_stats::time, "Milliseconds rendering")
+        .def("clear", &render_stats::clear)
+        .def("__str__", &report)
+        ;
+}
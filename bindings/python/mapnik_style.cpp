@@ -102,6 +102,12 @@ void export_style()
                       &feature_type_style::get_filter_mode,
                       &feature_type_style::set_filter_mode,
                       "Set/get the placement of the label")
+        .add_property("batch_polygons",
+                      &feature_type_style::batch_polygons,
+                      &feature_type_style::set_batch_polygons,
+                      "Set/get whether consecutive features sharing a polygon\n"
+                      "symbolizer are filled in one pass (default False).\n"
+                      "Only use for polygons that neither overlap nor touch.\n")
         ;
 
 }
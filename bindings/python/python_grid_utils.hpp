@@ -27,10 +27,14 @@
 #include <boost/scoped_array.hpp>
 #include <boost/foreach.hpp>
 
+// stl
+#include <algorithm>
+
 // mapnik
 #include <mapnik/grid/grid_renderer.hpp>
 #include <mapnik/grid/grid.hpp>
 #include <mapnik/grid/grid_util.hpp>
+#include <mapnik/grid/grid_utf.hpp>
 #include <mapnik/grid/grid_view.hpp>
 #include <mapnik/value_error.hpp>
 #include <mapnik/feature.hpp>
@@ -286,6 +290,14 @@ static void grid_encode_utf(T const& grid_type,
     boost::python::list l;
     std::vector<typename T::lookup_type> key_order;
 
+    // a grid rendered at reduced resolution already holds one
+    // pixel per N map pixels, so only sample what is left over
+    unsigned int grid_resolution = grid_type.get_resolution();
+    if (grid_resolution > 1)
+    {
+        resolution = std::max(1u, resolution / grid_resolution);
+    }
+
     if (resolution != 1) {
         // resample on the fly - faster, less accurate
         mapnik::grid2utf<T>(grid_type,l,key_order,resolution);
@@ -333,8 +345,17 @@ static boost::python::dict grid_encode( T const& grid, std::string format, bool
     }
 }
 
+template <typename T>
+static std::string grid_encode_json( T const& grid, bool add_features, unsigned int resolution)
+{
+    std::string json;
+    mapnik::grid_encode_utf_json<T>(grid,json,add_features,resolution);
+    return json;
+}
+
 /* new approach: key comes from grid object
- * grid size should be same as the map
+ * grid size should be same as the map, or the map size divided by
+ * the grid resolution to render directly at reduced resolution
  * encoding, resizing handled as method on grid object
  * whether features are dumped is determined by argument not 'fields'
  */
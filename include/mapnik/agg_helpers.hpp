@@ -23,11 +23,48 @@
 #ifndef MAPNIK_AGG_HELPERS_HPP
 #define MAPNIK_AGG_HELPERS_HPP
 
+// mapnik
+#include <mapnik/box2d.hpp>
+
+// agg
+#include "agg_basics.h"
 #include "agg_gamma_functions.h"
 #include "agg_math_stroke.h"
 
 namespace mapnik {
 
+// vertex source of a closed rectangle, what a geometry smaller than the
+// layer's min-feature-size is rasterized as
+class box_path
+{
+public:
+    explicit box_path(box2d<double> const& box)
+        : box_(box),
+          pos_(0) {}
+
+    void rewind(unsigned)
+    {
+        pos_ = 0;
+    }
+
+    unsigned vertex(double* x, double* y)
+    {
+        switch (pos_++)
+        {
+        case 0: *x = box_.minx(); *y = box_.miny(); return agg::path_cmd_move_to;
+        case 1: *x = box_.maxx(); *y = box_.miny(); return agg::path_cmd_line_to;
+        case 2: *x = box_.maxx(); *y = box_.maxy(); return agg::path_cmd_line_to;
+        case 3: *x = box_.minx(); *y = box_.maxy(); return agg::path_cmd_line_to;
+        case 4: return agg::path_cmd_end_poly | agg::path_flags_close;
+        default: return agg::path_cmd_stop;
+        }
+    }
+
+private:
+    box2d<double> box_;
+    unsigned pos_;
+};
+
 template <typename T0, typename T1>
 void set_gamma_method(T0 const& obj, T1 & ras_ptr)
 {
@@ -0,0 +1,175 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_AGG_PATTERN_CACHE_HPP
+#define MAPNIK_AGG_PATTERN_CACHE_HPP
+
+// mapnik
+#include <mapnik/marker.hpp>
+#include <mapnik/marker_cache.hpp>
+#include <mapnik/agg_pattern_source.hpp>
+
+// boost
+#include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
+
+// agg
+#include "agg_basics.h"
+#include "agg_pixfmt_rgba.h"
+#include "agg_pattern_filters_rgba.h"
+#include "agg_renderer_outline_image.h"
+
+// stl
+#include <iostream>
+#include <string>
+
+namespace mapnik {
+
+// a bitmap marker with the filter margins the outline image renderer needs
+struct line_pattern : private boost::noncopyable
+{
+    typedef agg::line_image_pattern<agg::pattern_filter_bilinear_rgba8> pattern_type;
+
+    explicit line_pattern(image_data_32 const& image)
+        : filter(),
+          pattern(filter, pattern_source(image)) {}
+
+    agg::pattern_filter_bilinear_rgba8 filter;
+    pattern_type pattern;
+};
+
+// a bitmap marker wrapped in the pixel format the pattern span generator reads
+struct polygon_pattern : private boost::noncopyable
+{
+    typedef agg::pixfmt_alpha_blend_rgba<agg::blender_rgba32_plain,
+        agg::row_accessor<agg::int8u>, agg::pixel32_type> pixfmt_type;
+
+    polygon_pattern(marker_ptr const& marker, image_data_32 const& image)
+        : marker_(marker),
+          rbuf((agg::int8u*)image.getBytes(), image.width(), image.height(), image.width() * 4),
+          pixf(rbuf) {}
+
+    // keeps the image alive while the cache holds the pattern
+    marker_ptr marker_;
+    agg::row_accessor<agg::int8u> rbuf;
+    pixfmt_type pixf;
+};
+
+/*
+ * Patterns of the line and polygon pattern symbolizers prepared on first
+ * use, by symbolizer and image. The cache lives as long as the renderer,
+ * so the symbolizers it is keyed on outlive it. Images that can not be
+ * used are cached too and only warned about once.
+ */
+class pattern_cache : private boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<line_pattern const> line_pattern_ptr;
+    typedef boost::shared_ptr<polygon_pattern const> polygon_pattern_ptr;
+
+    line_pattern_ptr const& line(void const* sym, marker_key const& key)
+    {
+        line_map::const_iterator itr = lines_.find(pattern_key(sym, key));
+        if (itr != lines_.end()) return itr->second;
+        line_pattern_ptr pattern;
+        boost::optional<marker_ptr> mark = load(key, "line_pattern_symbolizer");
+        if (mark)
+        {
+            pattern = boost::make_shared<line_pattern>(**(*mark)->get_bitmap_data());
+        }
+        return lines_.insert(std::make_pair(pattern_key(sym, key), pattern)).first->second;
+    }
+
+    polygon_pattern_ptr const& polygon(void const* sym, marker_key const& key)
+    {
+        polygon_map::const_iterator itr = polygons_.find(pattern_key(sym, key));
+        if (itr != polygons_.end()) return itr->second;
+        polygon_pattern_ptr pattern;
+        boost::optional<marker_ptr> mark = load(key, "polygon_pattern_symbolizer");
+        if (mark)
+        {
+            pattern = boost::make_shared<polygon_pattern>(*mark, **(*mark)->get_bitmap_data());
+        }
+        return polygons_.insert(std::make_pair(pattern_key(sym, key), pattern)).first->second;
+    }
+
+private:
+    struct pattern_key
+    {
+        pattern_key(void const* sym_, marker_key const& marker_)
+            : sym(sym_),
+              marker(marker_) {}
+
+        bool operator==(pattern_key const& rhs) const
+        {
+            return sym == rhs.sym && marker == rhs.marker;
+        }
+
+        void const* sym;
+        marker_key marker;
+    };
+
+    friend std::size_t hash_value(pattern_key const& key)
+    {
+        std::size_t seed = key.marker.hash;
+        boost::hash_combine(seed, key.sym);
+        return seed;
+    }
+
+    // the marker when it is a bitmap with data
+    static boost::optional<marker_ptr> load(marker_key const& key, char const* symbolizer_name)
+    {
+        boost::optional<marker_ptr> mark;
+        if (!key.uri.empty())
+        {
+            mark = marker_cache::instance()->find(key, true);
+        }
+        if (!mark)
+        {
+            std::clog << "### Warning: file not found: " << key.uri << "\n";
+            return mark;
+        }
+        if (!(*mark)->is_bitmap())
+        {
+            std::clog << "### Warning only images (not '" << key.uri << "') are supported in the "
+                      << symbolizer_name << "\n";
+            return boost::optional<marker_ptr>();
+        }
+        if (!(*mark)->get_bitmap_data())
+        {
+            return boost::optional<marker_ptr>();
+        }
+        return mark;
+    }
+
+    typedef boost::unordered_map<pattern_key, line_pattern_ptr> line_map;
+    typedef boost::unordered_map<pattern_key, polygon_pattern_ptr> polygon_map;
+    line_map lines_;
+    polygon_map polygons_;
+};
+
+}
+
+#endif // MAPNIK_AGG_PATTERN_CACHE_HPP
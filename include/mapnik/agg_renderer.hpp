@@ -35,6 +35,9 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
+// stl
+#include <string>
+
 // FIXME
 // forward declare so that
 // apps using mapnik do not
@@ -48,6 +51,9 @@ namespace mapnik {
 class marker;
 
 struct rasterizer;
+class building_batch;
+class pattern_cache;
+struct cached_layer;
 
 template <typename T>
 class MAPNIK_DECL agg_renderer : public feature_style_processor<agg_renderer<T> >,
@@ -65,6 +71,10 @@ public:
     void end_map_processing(Map const& map);
     void start_layer_processing(layer const& lay, box2d<double> const& query_extent);
     void end_layer_processing(layer const& lay);
+    void start_style_processing(feature_type_style const& st);
+    void end_style_processing(feature_type_style const& st);
+    // whether start_layer_processing drew the layer from the layer_render_cache
+    bool layer_cached() const { return layer_cached_; }
     void render_marker(pixel_position const& pos, marker const& marker, agg::trans_affine const& tr, double opacity);
 
     void process(point_symbolizer const& sym,
@@ -97,13 +107,9 @@ public:
     void process(markers_symbolizer const& sym,
                  mapnik::feature_ptr const& feature,
                  proj_transform const& prj_trans);
-    inline bool process(rule::symbolizers const& /*syms*/,
-                        mapnik::feature_ptr const& /*feature*/,
-                        proj_transform const& /*prj_trans*/)
-    {
-        // agg renderer doesn't support processing of multiple symbolizers.
-        return false;
-    };
+    bool process(rule::symbolizers const& syms,
+                 mapnik::feature_ptr const& feature,
+                 proj_transform const& prj_trans);
     void painted(bool painted)
     {
         pixmap_.painted(painted);
@@ -120,7 +126,36 @@ private:
     boost::shared_ptr<label_collision_detector4> detector_;
     boost::scoped_ptr<rasterizer> ras_ptr;
     box2d<double> query_extent_;
+    double min_feature_size_;
+    // polygon fills collected in ras_ptr when the style batches them
+    bool batch_polygons_;
+    polygon_symbolizer const* batch_sym_;
+    // buildings of the current style, drawn back to front when it ends
+    boost::scoped_ptr<building_batch> buildings_;
+    // line and polygon patterns prepared on first use
+    boost::scoped_ptr<pattern_cache> patterns_;
+    // what the rendering of a cached layer depends on besides the layer
+    Map const* map_;
+    std::string map_key_;
+    bool layer_cached_;
+    // a layer rendered into its own image for the layer_render_cache,
+    // holding the map rendered so far in the meantime
+    boost::shared_ptr<cached_layer> layer_capture_;
+    std::string layer_key_;
+    bool painted_before_layer_;
     void setup(Map const &m);
+    bool below_min_size(geometry_type const& geom,
+                        proj_transform const& prj_trans,
+                        box2d<double> & screen_box) const;
+    void add_polygon_paths(polygon_symbolizer const& sym,
+                           mapnik::feature_ptr const& feature,
+                           proj_transform const& prj_trans);
+    void fill_polygon_paths(polygon_symbolizer const& sym);
+    void flush_polygons();
+    void flush_buildings();
+    bool composites_over(layer const& lay) const;
+    std::string layer_cache_key(layer const& lay) const;
+    void draw_cached_layer(cached_layer const& cached);
 };
 }
 
@@ -0,0 +1,262 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_BUILDING_BATCH_HPP
+#define MAPNIK_BUILDING_BATCH_HPP
+
+// mapnik
+#include <mapnik/box2d.hpp>
+#include <mapnik/color.hpp>
+#include <mapnik/vertex.hpp>
+
+// stl
+#include <algorithm>
+#include <vector>
+
+namespace mapnik {
+
+/*
+ * Walls, frames and roofs of the buildings of a style in screen
+ * coordinates. Buildings are drawn back to front across features, and runs
+ * of buildings with the same colors whose boxes do not overlap are drawn
+ * together, one rasterizer pass each for their walls, frames and roofs.
+ * The buffers keep their capacity between styles.
+ */
+class building_batch
+{
+public:
+    struct vertex
+    {
+        vertex(double x_, double y_, unsigned cmd_)
+            : x(x_), y(y_), cmd(cmd_) {}
+        double x;
+        double y;
+        unsigned cmd;
+    };
+
+    typedef std::vector<vertex> path_type;
+
+    struct building
+    {
+        color fill;
+        double opacity;
+        // screen y of the front most footprint vertex, larger is nearer
+        double depth;
+        box2d<double> box;
+        unsigned walls_begin, walls_end;
+        unsigned frame_begin, frame_end;
+        unsigned roof_begin, roof_end;
+    };
+
+    // agg vertex source over a range of one of the paths
+    class path_range
+    {
+    public:
+        path_range(path_type const& path, unsigned begin, unsigned end)
+            : path_(path), begin_(begin), end_(end), pos_(begin) {}
+
+        void rewind(unsigned)
+        {
+            pos_ = begin_;
+        }
+
+        unsigned vertex(double * x, double * y)
+        {
+            if (pos_ >= end_) return SEG_END;
+            building_batch::vertex const& v = path_[pos_++];
+            *x = v.x;
+            *y = v.y;
+            return v.cmd;
+        }
+
+    private:
+        path_type const& path_;
+        unsigned begin_;
+        unsigned end_;
+        unsigned pos_;
+    };
+
+    bool empty() const
+    {
+        return buildings_.empty();
+    }
+
+    void clear()
+    {
+        buildings_.clear();
+        order_.clear();
+        walls_.clear();
+        frame_.clear();
+        roof_.clear();
+    }
+
+    // starts a building, its paths are appended until the next one starts
+    void start(color const& fill, double opacity)
+    {
+        building b;
+        b.fill = fill;
+        b.opacity = opacity;
+        b.depth = 0;
+        b.walls_begin = b.walls_end = walls_.size();
+        b.frame_begin = b.frame_end = frame_.size();
+        b.roof_begin = b.roof_end = roof_.size();
+        buildings_.push_back(b);
+    }
+
+    // a wall quad: the footprint segment (x0,y0)-(x1,y1) and the same
+    // segment raised to (x2,y2)-(x3,y3). Every quad is wound the same way
+    // so overlapping walls drawn in one pass with the non zero rule do not
+    // cancel out.
+    void add_wall(double x0, double y0, double x1, double y1,
+                  double x2, double y2, double x3, double y3)
+    {
+        // twice the signed area of x0,y0 x1,y1 x3,y3 x2,y2
+        double area = (x0 * y1 - x1 * y0) + (x1 * y3 - x3 * y1) +
+            (x3 * y2 - x2 * y3) + (x2 * y0 - x0 * y2);
+        if (area < 0)
+        {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+            std::swap(x2, x3);
+            std::swap(y2, y3);
+        }
+        walls_.push_back(vertex(x0, y0, SEG_MOVETO));
+        walls_.push_back(vertex(x1, y1, SEG_LINETO));
+        walls_.push_back(vertex(x3, y3, SEG_LINETO));
+        walls_.push_back(vertex(x2, y2, SEG_LINETO));
+        building & b = buildings_.back();
+        b.walls_end = walls_.size();
+        expand(b, x0, y0);
+        expand(b, x1, y1);
+        expand(b, x2, y2);
+        expand(b, x3, y3);
+    }
+
+    void add_frame(double x, double y, unsigned cmd)
+    {
+        frame_.push_back(vertex(x, y, cmd));
+        building & b = buildings_.back();
+        b.frame_end = frame_.size();
+        expand(b, x, y);
+    }
+
+    void add_roof(double x, double y, unsigned cmd)
+    {
+        roof_.push_back(vertex(x, y, cmd));
+        buildings_.back().roof_end = roof_.size();
+    }
+
+    void set_depth(double depth)
+    {
+        buildings_.back().depth = depth;
+    }
+
+    // orders buildings back to front, features keep their order at equal depth
+    void sort()
+    {
+        order_.resize(buildings_.size());
+        for (unsigned i = 0; i < order_.size(); ++i)
+        {
+            order_[i] = i;
+        }
+        std::stable_sort(order_.begin(), order_.end(), depth_order(buildings_));
+    }
+
+    unsigned size() const
+    {
+        return order_.size();
+    }
+
+    // the i-th building back to front, after sort()
+    building const& at(unsigned i) const
+    {
+        return buildings_[order_[i]];
+    }
+
+    // End of the run of buildings starting at begin that can share passes:
+    // same colors and no two boxes overlapping, so the order they are drawn
+    // in makes no difference. max_size bounds the overlap checks.
+    unsigned group_end(unsigned begin, unsigned max_size = 256) const
+    {
+        building const& first = at(begin);
+        unsigned end = begin + 1;
+        for (; end < size() && end - begin < max_size; ++end)
+        {
+            building const& b = at(end);
+            if (!(b.fill == first.fill) || b.opacity != first.opacity) break;
+            bool overlaps = false;
+            for (unsigned k = begin; k < end && !overlaps; ++k)
+            {
+                overlaps = b.box.intersects(at(k).box);
+            }
+            if (overlaps) break;
+        }
+        return end;
+    }
+
+    path_range walls(building const& b) const
+    {
+        return path_range(walls_, b.walls_begin, b.walls_end);
+    }
+
+    path_range frame(building const& b) const
+    {
+        return path_range(frame_, b.frame_begin, b.frame_end);
+    }
+
+    path_range roof(building const& b) const
+    {
+        return path_range(roof_, b.roof_begin, b.roof_end);
+    }
+
+private:
+    struct depth_order
+    {
+        explicit depth_order(std::vector<building> const& buildings)
+            : buildings_(buildings) {}
+
+        bool operator() (unsigned a, unsigned b) const
+        {
+            return buildings_[a].depth < buildings_[b].depth;
+        }
+
+        std::vector<building> const& buildings_;
+    };
+
+    static void expand(building & b, double x, double y)
+    {
+        // one pixel of slack for antialiasing and the frame stroke
+        box2d<double> pixel(x - 1, y - 1, x + 1, y + 1);
+        if (b.box.valid()) b.box.expand_to_include(pixel);
+        else b.box = pixel;
+    }
+
+    std::vector<building> buildings_;
+    std::vector<unsigned> order_;
+    path_type walls_;
+    path_type frame_;
+    path_type roof_;
+};
+
+}
+
+#endif // MAPNIK_BUILDING_BATCH_HPP
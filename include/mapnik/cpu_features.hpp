@@ -0,0 +1,39 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_CPU_FEATURES_HPP
+#define MAPNIK_CPU_FEATURES_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+
+namespace mapnik
+{
+
+// Runtime detection of the instruction set extensions used by the
+// raster kernels. Results are computed once and are false on non-x86 cpus.
+MAPNIK_DECL bool cpu_has_sse2();
+MAPNIK_DECL bool cpu_has_avx2();
+
+}
+
+#endif // MAPNIK_CPU_FEATURES_HPP
@@ -0,0 +1,89 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_FEATURE_CACHE_HPP
+#define MAPNIK_FEATURE_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/utils.hpp>
+#include <mapnik/datasource.hpp>
+#include <mapnik/query.hpp>
+#include <mapnik/lru_cache.hpp>
+
+// boost
+#include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
+
+// stl
+#include <string>
+#include <vector>
+
+namespace mapnik
+{
+
+/** Features a datasource returned for one cell, with their envelopes
+ * and a hash of their attributes and geometries.
+ */
+struct feature_cache_cell
+{
+    std::vector<feature_ptr> features;
+    std::vector<box2d<double> > envelopes;
+    std::vector<std::size_t> hashes;
+};
+
+typedef boost::shared_ptr<feature_cache_cell> feature_cache_cell_ptr;
+
+/** Process-wide cache of features read from vector datasources.
+ *
+ * Layers whose datasource has feature_cache=true read their features
+ * through here. Each query is split into the cells of a power of two grid
+ * about half the size of the query, and every cell is read from the
+ * datasource once for a set of attributes and scale. Later queries touching
+ * it, like those of neighbouring metatiles or of other layers on the same
+ * datasource, take its features from memory. A feature returned for
+ * several cells comes out once; it is recognised by its envelope,
+ * attributes and geometry rather than its id, which datasources may
+ * number per query. Features are copied out, so renderers never share
+ * them. The cache is bounded by an estimate of the memory held by the
+ * features, 64MB by default. Changes to the data are not noticed, clear
+ * the cache after making them.
+ */
+class MAPNIK_DECL feature_cache :
+        public singleton <feature_cache, CreateStatic>,
+        private boost::noncopyable
+{
+    friend class CreateStatic<feature_cache>;
+public:
+    featureset_ptr features(datasource const& ds, query const& q);
+    void set_capacity(std::size_t bytes);
+    std::size_t capacity() const;
+    std::size_t size() const;
+    void clear();
+private:
+    feature_cache();
+    lru_cache<std::string, feature_cache_cell_ptr> cache_;
+};
+
+}
+
+#endif // MAPNIK_FEATURE_CACHE_HPP
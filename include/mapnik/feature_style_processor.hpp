@@ -27,6 +27,7 @@
 #include <mapnik/map.hpp>
 #include <mapnik/projection.hpp>
 #include <mapnik/memory_datasource.hpp>
+#include <mapnik/render_stats.hpp>
 
 
 // stl
@@ -57,6 +58,37 @@ public:
      * @return apply renderer to a single layer, providing pre-populated set of query attribute names.
      */
     void apply(mapnik::layer const& lyr, std::set<std::string>& names);
+
+    /*!
+     * @return collect per layer and per style numbers into stats on the
+     * following renders, or stop collecting if null. Not owned.
+     */
+    void set_stats(render_stats * stats);
+    render_stats * stats() const;
+
+protected:
+    /*!
+     * @return whether the processor drew the layer in start_layer_processing
+     * from a cached rendering, so it needs no features. Processors caching
+     * layers hide this.
+     */
+    bool layer_cached() const
+    {
+        return false;
+    }
+
+    /*!
+     * @return count labels for the style being rendered, if stats are collected.
+     */
+    void add_label_stats(unsigned attempted, unsigned placed)
+    {
+        if (current_style_)
+        {
+            current_style_->labels_attempted += attempted;
+            current_style_->labels_placed += placed;
+        }
+    }
+
 private:
     /*!
      * @return initialize metawriters for a given map and projection.
@@ -87,8 +119,24 @@ private:
                       proj_transform const& prj_trans,
                       double scale_denom);
 
+    /*!
+     * @return renders the symbolizers of a matching rule.
+     */
+    void render_symbolizers(Processor & p,
+                            rule::symbolizers const& symbols,
+                            feature_ptr const& feature,
+                            proj_transform const& prj_trans);
+
+    /*!
+     * @return query a datasource, timed if stats are collected.
+     */
+    featureset_ptr query_features(datasource_ptr const& ds, query const& q);
+
     Map const& m_;
     double scale_factor_;
+    render_stats * stats_;
+    layer_stats * current_layer_;
+    style_stats * current_style_;
 };
 }
 
@@ -50,6 +50,7 @@ class MAPNIK_DECL feature_type_style
 private:
     rules  rules_;
     filter_mode_e filter_mode_;
+    bool batch_polygons_;
 
     // The rule_ptrs vectors are only valid for the scale_denom_validity_.
     double scale_denom_validity_;
@@ -76,6 +77,13 @@ public:
 
     filter_mode_e get_filter_mode() const;
 
+    // Fill consecutive features sharing a polygon symbolizer in one
+    // rasterizer pass. Only gives the same image as filling them one by one
+    // when their polygons neither overlap nor share edges.
+    void set_batch_polygons(bool batch);
+
+    bool batch_polygons() const;
+
     ~feature_type_style() {}
 
 private:
@@ -29,6 +29,7 @@
 #include <mapnik/box2d.hpp>
 #include <mapnik/image_view.hpp>
 #include <mapnik/global.hpp>
+#include <mapnik/image_blend.hpp>
 
 // stl
 #include <cmath>
@@ -48,6 +49,8 @@ namespace mapnik
 
 struct Multiply
 {
+    static const blend_mode_e mode = BLEND_MULTIPLY;
+
     inline static void mergeRGB(unsigned const &r0, unsigned const &g0, unsigned const &b0,
                                 unsigned &r1, unsigned &g1, unsigned &b1)
     {
@@ -58,6 +61,8 @@ struct Multiply
 };
 struct Multiply2
 {
+    static const blend_mode_e mode = BLEND_MULTIPLY2;
+
     inline static void mergeRGB(unsigned const &r0, unsigned const &g0, unsigned const &b0,
                                 unsigned &r1, unsigned &g1, unsigned &b1)
     {
@@ -71,6 +76,8 @@ struct Multiply2
 };
 struct Divide
 {
+    static const blend_mode_e mode = BLEND_DIVIDE;
+
     inline static void mergeRGB(unsigned const &r0, unsigned const &g0, unsigned const &b0,
                                 unsigned &r1, unsigned &g1, unsigned &b1)
     {
@@ -81,6 +88,8 @@ struct Divide
 };
 struct Divide2
 {
+    static const blend_mode_e mode = BLEND_DIVIDE2;
+
     inline static void mergeRGB(unsigned const &r0, unsigned const &g0, unsigned const &b0,
                                 unsigned &r1, unsigned &g1, unsigned &b1)
     {
@@ -91,6 +100,8 @@ struct Divide2
 };
 struct Screen
 {
+    static const blend_mode_e mode = BLEND_SCREEN;
+
     inline static void mergeRGB(unsigned const &r0, unsigned const &g0, unsigned const &b0,
                                 unsigned &r1, unsigned &g1, unsigned &b1)
     {
@@ -101,6 +112,8 @@ struct Screen
 };
 struct HardLight
 {
+    static const blend_mode_e mode = BLEND_HARD_LIGHT;
+
     inline static void mergeRGB(unsigned const &r0, unsigned const &g0, unsigned const &b0,
                                 unsigned &r1, unsigned &g1, unsigned &b1)
     {
@@ -111,6 +124,8 @@ struct HardLight
 };
 struct MergeGrain
 {
+    static const blend_mode_e mode = BLEND_MERGE_GRAIN;
+
     inline static void mergeRGB(unsigned const &r0, unsigned const &g0, unsigned const &b0,
                                 unsigned &r1, unsigned &g1, unsigned &b1)
     {
@@ -124,6 +139,8 @@ struct MergeGrain
 };
 struct MergeGrain2
 {
+    static const blend_mode_e mode = BLEND_MERGE_GRAIN2;
+
     inline static void mergeRGB(unsigned const &r0, unsigned const &g0, unsigned const &b0,
                                 unsigned &r1, unsigned &g1, unsigned &b1)
     {
@@ -383,11 +400,18 @@ public:
         if (ext0.intersects(ext1))
         {
             box2d<int> box = ext0.intersect(ext1);
+#ifndef MAPNIK_BIG_ENDIAN
+            simd_level_e level = get_simd_level();
+#endif
             for (int y = box.miny(); y < box.maxy(); ++y)
             {
                 unsigned int* row_to =  data_.getRow(y);
                 unsigned int const * row_from = data.getRow(y-y0);
-                for (int x = box.minx(); x < box.maxx(); ++x)
+                int x = box.minx();
+#ifndef MAPNIK_BIG_ENDIAN
+                x += blend_row(level, BLEND_ALPHA, row_to + x, row_from + (x - x0), box.maxx() - x, opacity);
+#endif
+                for (; x < box.maxx(); ++x)
                 {
                     unsigned rgba0 = row_to[x];
                     unsigned rgba1 = row_from[x-x0];
@@ -460,11 +484,18 @@ public:
         if (ext0.intersects(ext1))
         {
             box2d<int> box = ext0.intersect(ext1);
+#ifndef MAPNIK_BIG_ENDIAN
+            simd_level_e level = get_simd_level();
+#endif
             for (int y = box.miny(); y < box.maxy(); ++y)
             {
                 unsigned int* row_to =  data_.getRow(y);
                 unsigned int const * row_from = data.getRow(y-y0);
-                for (int x = box.minx(); x < box.maxx(); ++x)
+                int x = box.minx();
+#ifndef MAPNIK_BIG_ENDIAN
+                x += blend_row(level, MergeMethod::mode, row_to + x, row_from + (x - x0), box.maxx() - x, opacity);
+#endif
+                for (; x < box.maxx(); ++x)
                 {
                     unsigned rgba0 = row_to[x];
                     unsigned rgba1 = row_from[x-x0];
@@ -0,0 +1,304 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_GRID_UTF_HPP
+#define MAPNIK_GRID_UTF_HPP
+
+// mapnik
+#include <mapnik/grid/grid.hpp>
+#include <mapnik/grid/grid_view.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_kv_iterator.hpp>
+#include <mapnik/value.hpp>
+
+// boost
+#include <boost/cstdint.hpp>
+#include <boost/variant/static_visitor.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+
+// stl
+#include <algorithm>
+#include <locale>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+namespace mapnik {
+
+namespace utf_grid_detail {
+
+inline void append_utf8(std::string & out, unsigned codepoint)
+{
+    if (codepoint < 0x80)
+    {
+        out += static_cast<char>(codepoint);
+    }
+    else if (codepoint < 0x800)
+    {
+        out += static_cast<char>(0xc0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3f));
+    }
+    else if (codepoint < 0x10000)
+    {
+        out += static_cast<char>(0xe0 | (codepoint >> 12));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (codepoint & 0x3f));
+    }
+    else
+    {
+        out += static_cast<char>(0xf0 | (codepoint >> 18));
+        out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (codepoint & 0x3f));
+    }
+}
+
+inline void append_json_string(std::string & out, std::string const& str)
+{
+    out += '"';
+    for (std::string::const_iterator itr = str.begin(); itr != str.end(); ++itr)
+    {
+        unsigned char c = static_cast<unsigned char>(*itr);
+        switch (c)
+        {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        default:
+            if (c < 0x20)
+            {
+                char buf[8];
+                std::sprintf(buf, "\\u%04x", c);
+                out += buf;
+            }
+            else
+            {
+                out += *itr;
+            }
+        }
+    }
+    out += '"';
+}
+
+// writes a feature attribute as the json type matching its value
+struct json_value_writer : public boost::static_visitor<>
+{
+    explicit json_value_writer(std::string & out)
+        : out_(out) {}
+
+    void operator() (value_null const&) const
+    {
+        out_ += "null";
+    }
+
+    void operator() (bool val) const
+    {
+        out_ += val ? "true" : "false";
+    }
+
+    void operator() (int val) const
+    {
+        char buf[32];
+        std::sprintf(buf, "%d", val);
+        out_ += buf;
+    }
+
+    void operator() (double val) const
+    {
+        if (!(boost::math::isfinite)(val))
+        {
+            out_ += "null";
+            return;
+        }
+        // like printf("%.16g") but with a '.' whatever LC_NUMERIC says
+        std::ostringstream s;
+        s.imbue(std::locale::classic());
+        s.precision(16);
+        s << val;
+        out_ += s.str();
+    }
+
+    void operator() (UnicodeString const& val) const
+    {
+        std::string utf8;
+        to_utf8(val, utf8);
+        append_json_string(out_, utf8);
+    }
+
+    std::string & out_;
+};
+
+}
+
+/*
+ * Encode a grid or grid view as UTFGrid json ("grid", "keys" and "data")
+ * into a string. resolution is in map pixels per grid cell, a grid rendered
+ * at reduced resolution is only sampled for the remainder. Unlike the
+ * python bindings this needs no interpreter, so it is what C++ tile servers
+ * should use.
+ */
+template <typename T>
+void grid_encode_utf_json(T const& grid_type,
+                          std::string & json,
+                          bool add_features = true,
+                          unsigned int resolution = 1)
+{
+    typedef typename T::value_type value_type;
+    typedef typename T::lookup_type lookup_type;
+
+    unsigned int grid_resolution = grid_type.get_resolution();
+    if (grid_resolution > 1)
+    {
+        resolution = resolution / grid_resolution;
+    }
+    if (resolution < 1) resolution = 1;
+
+    typename T::feature_key_type const& feature_keys = grid_type.get_feature_keys();
+    // key -> codepoint, and the order keys were first seen in
+    std::map<lookup_type, unsigned> keys;
+    std::vector<lookup_type const*> key_order;
+    // feature id -> codepoint, so each pixel costs one lookup
+    std::map<value_type, unsigned> id_codes;
+    // start counting at utf8 codepoint 32, aka space character
+    unsigned codepoint = 32;
+    lookup_type const empty_key;
+
+    unsigned width = grid_type.width();
+    unsigned height = grid_type.height();
+    unsigned cols = (width + resolution - 1) / resolution;
+    unsigned rows = (height + resolution - 1) / resolution;
+    json.reserve(json.size() + rows * (cols + 4) + 64);
+
+    json += "{\"grid\":[";
+    for (unsigned y = 0; y < height; y += resolution)
+    {
+        if (y > 0) json += ',';
+        json += '"';
+        value_type const* row = grid_type.getRow(y);
+        value_type last_id = 0;
+        unsigned last_code = 0;
+        for (unsigned x = 0; x < width; x += resolution)
+        {
+            value_type id = row[x];
+            if (last_code == 0 || id != last_id)
+            {
+                typename std::map<value_type, unsigned>::const_iterator id_pos = id_codes.find(id);
+                if (id_pos != id_codes.end())
+                {
+                    last_code = id_pos->second;
+                }
+                else
+                {
+                    typename T::feature_key_type::const_iterator feature_pos = feature_keys.find(id);
+                    lookup_type const& val = (feature_pos != feature_keys.end()) ? feature_pos->second : empty_key;
+                    typename std::map<lookup_type, unsigned>::iterator key_pos = keys.find(val);
+                    if (key_pos == keys.end())
+                    {
+                        // Create a new entry for this key. Skip the codepoints that
+                        // can't be encoded directly in JSON.
+                        if (codepoint == 34) ++codepoint;      // Skip "
+                        else if (codepoint == 92) ++codepoint; // Skip backslash
+                        key_pos = keys.insert(std::make_pair(val, codepoint)).first;
+                        key_order.push_back(&key_pos->first);
+                        ++codepoint;
+                    }
+                    last_code = key_pos->second;
+                    id_codes.insert(std::make_pair(id, last_code));
+                }
+                last_id = id;
+            }
+            utf_grid_detail::append_utf8(json, last_code);
+        }
+        json += '"';
+    }
+
+    json += "],\"keys\":[";
+    for (unsigned i = 0; i < key_order.size(); ++i)
+    {
+        if (i > 0) json += ',';
+        utf_grid_detail::append_json_string(json, *key_order[i]);
+    }
+
+    json += "],\"data\":{";
+    if (add_features)
+    {
+        std::string const& key = grid_type.get_key();
+        std::set<std::string> const& attributes = grid_type.property_names();
+        bool include_key = (attributes.find(key) != attributes.end());
+        utf_grid_detail::json_value_writer writer(json);
+        bool first_feature = true;
+        typename T::feature_type const& g_features = grid_type.get_grid_features();
+        typename T::feature_type::const_iterator feat_itr = g_features.begin();
+        typename T::feature_type::const_iterator feat_end = g_features.end();
+        for (; feat_itr != feat_end; ++feat_itr)
+        {
+            // only serialize features visible in the grid, features
+            // are stored by their key so there is no need to rebuild it
+            if (keys.find(feat_itr->first) == keys.end()) continue;
+
+            std::string::size_type mark = json.size();
+            if (!first_feature) json += ',';
+            utf_grid_detail::append_json_string(json, feat_itr->first);
+            json += ":{";
+            // an __id__ key has no attribute, but asking for it keeps the feature
+            bool found = (key == grid_type.key_name() && include_key);
+            bool first_attr = true;
+            feature_kv_iterator itr = feat_itr->second->begin();
+            feature_kv_iterator end = feat_itr->second->end();
+            for ( ;itr!=end; ++itr)
+            {
+                std::string const& key_name = boost::get<0>(*itr);
+                if (key_name == key ? include_key : attributes.find(key_name) != attributes.end())
+                {
+                    if (!first_attr) json += ',';
+                    first_attr = false;
+                    found = true;
+                    utf_grid_detail::append_json_string(json, key_name);
+                    json += ':';
+                    boost::apply_visitor(writer, boost::get<1>(*itr).base());
+                }
+            }
+            if (found)
+            {
+                json += '}';
+                first_feature = false;
+            }
+            else
+            {
+                // nothing requested for this feature, drop it
+                json.resize(mark);
+            }
+        }
+    }
+    json += "}}";
+}
+
+}
+
+#endif // MAPNIK_GRID_UTF_HPP
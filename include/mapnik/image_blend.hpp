@@ -0,0 +1,73 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_IMAGE_BLEND_HPP
+#define MAPNIK_IMAGE_BLEND_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+
+namespace mapnik
+{
+
+// Row blending modes with vectorised kernels. BLEND_ALPHA is the
+// blend done by image_32::set_rectangle_alpha2, the others match the
+// MergeMethod policies used by image_32::merge_rectangle.
+enum blend_mode_e
+{
+    BLEND_ALPHA = 0,
+    BLEND_MULTIPLY,
+    BLEND_MULTIPLY2,
+    BLEND_DIVIDE,
+    BLEND_DIVIDE2,
+    BLEND_SCREEN,
+    BLEND_HARD_LIGHT,
+    BLEND_MERGE_GRAIN,
+    BLEND_MERGE_GRAIN2
+};
+
+enum simd_level_e
+{
+    SIMD_NONE = 0,
+    SIMD_SSE2,
+    SIMD_AVX2
+};
+
+// Instruction set used for raster blending and warping, picked from the
+// cpu features when the library loads. Reading it takes no lock.
+// set_simd_level lets tests and benchmarks force a lower level, requests
+// above what the cpu supports are clamped; call it before starting
+// threads that render.
+MAPNIK_DECL simd_level_e get_simd_level();
+MAPNIK_DECL void set_simd_level(simd_level_e level);
+
+// Blend the leading pixels of src onto dst (little-endian RGBA) with the
+// SIMD kernels of level, bit-exact with the scalar code in graphics.hpp.
+// Returns the number of pixels processed, a multiple of the vector width;
+// the caller finishes the remaining pixels with the scalar code. Returns 0
+// when no SIMD kernel is available or opacity is outside [0,1].
+MAPNIK_DECL unsigned blend_row(simd_level_e level, blend_mode_e mode, unsigned * dst,
+                               unsigned const* src, unsigned len, float opacity);
+
+}
+
+#endif // MAPNIK_IMAGE_BLEND_HPP
@@ -124,6 +124,15 @@ public:
         std::memcpy(pData_+row*width_+x0,buf,(x1-x0)*sizeof(T));
     }
 
+    // exchange the pixels with an image of the same size
+    inline void swap(ImageData<T> & rhs)
+    {
+        assert(width_ == rhs.width_ && height_ == rhs.height_);
+        T * data = pData_;
+        pData_ = rhs.pData_;
+        rhs.pData_ = data;
+    }
+
     inline ~ImageData()
     {
         ::operator delete(pData_),pData_=0;
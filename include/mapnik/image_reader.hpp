@@ -54,6 +54,14 @@ struct MAPNIK_DECL image_reader
     virtual unsigned width() const=0;
     virtual unsigned height() const=0;
     virtual void read(unsigned x,unsigned y,image_data_32& image)=0;
+    // number of reduced resolution versions stored along with the image
+    virtual unsigned overview_count() const { return 0; }
+    // select the image used by width(), height() and read(),
+    // 0 is the full resolution image and 1..overview_count() the overviews
+    virtual void select_overview(unsigned level)
+    {
+        if (level > 0) throw image_reader_exception("image_reader: overviews not supported");
+    }
     virtual ~image_reader() {}
 };
 
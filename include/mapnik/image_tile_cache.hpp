@@ -0,0 +1,121 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_IMAGE_TILE_CACHE_HPP
+#define MAPNIK_IMAGE_TILE_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/utils.hpp>
+#include <mapnik/image_data.hpp>
+#include <mapnik/lru_cache.hpp>
+
+// boost
+#include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/optional.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/cstdint.hpp>
+
+// stl
+#include <string>
+#include <ctime>
+
+namespace mapnik
+{
+
+// identifies a decoded tile: the file, when it was last written and its
+// size (so a file rewritten at the same path doesn't hit old tiles), the
+// image directory (overview level), the tile size and the tile origin
+struct image_tile_key
+{
+    image_tile_key(std::string const& file_, std::time_t mtime_, boost::uintmax_t size_,
+                   unsigned level_, unsigned tile_width_, unsigned tile_height_,
+                   unsigned x_, unsigned y_)
+        : file(file_),
+          mtime(mtime_),
+          size(size_),
+          level(level_),
+          tile_width(tile_width_),
+          tile_height(tile_height_),
+          x(x_),
+          y(y_) {}
+
+    bool operator==(image_tile_key const& rhs) const
+    {
+        return x == rhs.x && y == rhs.y && level == rhs.level &&
+            tile_width == rhs.tile_width && tile_height == rhs.tile_height &&
+            mtime == rhs.mtime && size == rhs.size && file == rhs.file;
+    }
+
+    std::string file;
+    std::time_t mtime;
+    boost::uintmax_t size;
+    unsigned level;
+    unsigned tile_width;
+    unsigned tile_height;
+    unsigned x;
+    unsigned y;
+};
+
+inline std::size_t hash_value(image_tile_key const& key)
+{
+    std::size_t seed = 0;
+    boost::hash_combine(seed, key.file);
+    boost::hash_combine(seed, static_cast<boost::uintmax_t>(key.mtime));
+    boost::hash_combine(seed, key.size);
+    boost::hash_combine(seed, key.level);
+    boost::hash_combine(seed, key.tile_width);
+    boost::hash_combine(seed, key.tile_height);
+    boost::hash_combine(seed, key.x);
+    boost::hash_combine(seed, key.y);
+    return seed;
+}
+
+typedef boost::shared_ptr<image_data_32> image_tile_ptr;
+
+/** Process-wide cache of decoded image tiles.
+ *
+ * Image readers for tiled formats keep decoded tiles here so that
+ * consecutive queries (from any thread) touching the same tiles don't
+ * decode them again. The cache is bounded by the size of the decoded
+ * pixels, 64MB by default. Cached tiles are never modified.
+ */
+class MAPNIK_DECL image_tile_cache :
+        public singleton <image_tile_cache, CreateStatic>,
+        private boost::noncopyable
+{
+    friend class CreateStatic<image_tile_cache>;
+public:
+    boost::optional<image_tile_ptr> find(image_tile_key const& key);
+    void insert(image_tile_key const& key, image_tile_ptr const& tile);
+    void set_capacity(std::size_t bytes);
+    std::size_t capacity() const;
+    void clear();
+private:
+    image_tile_cache();
+    lru_cache<image_tile_key, image_tile_ptr> cache_;
+};
+
+}
+
+#endif // MAPNIK_IMAGE_TILE_CACHE_HPP
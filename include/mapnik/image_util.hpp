@@ -38,6 +38,7 @@
 namespace mapnik {
 
 class Map;
+class colorizer_lut;
 class ImageWriterException : public std::exception
 {
 private:
@@ -208,6 +209,9 @@ scaling_method_e get_scaling_method_by_name (std::string name);
 template <typename Image>
 void scale_image_agg (Image& target,const Image& source, scaling_method_e scaling_method, double scale_factor, double x_off_f=0, double y_off_f=0, double filter_radius=2, double ratio=1);
 
+// scale a float32 raster, colorizing the pixels as they are sampled
+MAPNIK_DECL void scale_image_agg (image_data_32& target,const image_data_32& source, colorizer_lut const& lut, scaling_method_e scaling_method, double scale_factor, double x_off_f=0, double y_off_f=0, double filter_radius=2, double ratio=1);
+
 template <typename Image>
 void scale_image_bilinear_old (Image& target,const Image& source, double x_off_f=0, double y_off_f=0);
 
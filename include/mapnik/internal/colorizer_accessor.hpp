@@ -0,0 +1,106 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_COLORIZER_ACCESSOR_HPP
+#define MAPNIK_COLORIZER_ACCESSOR_HPP
+
+// mapnik
+#include <mapnik/raster_colorizer.hpp>
+
+// agg
+#include "agg_basics.h"
+
+// stl
+#include <cstring>
+
+namespace mapnik {
+
+// AGG image accessor over a float32 raster which colorizes each pixel as
+// it is fetched, so the span generators of the warp and scaling code
+// produce the colorized, resampled image in one pass without writing
+// colors back into the source. Out of range coordinates are clamped to
+// the edges like agg::image_accessor_clone. The returned pointer is only
+// valid until the next fetch, which is how the AGG span generators use it.
+template <typename PixFmt>
+class colorizer_accessor
+{
+public:
+    typedef PixFmt pixfmt_type;
+    typedef typename pixfmt_type::color_type color_type;
+    typedef typename pixfmt_type::order_type order_type;
+    typedef typename pixfmt_type::value_type value_type;
+    enum pix_width_e { pix_width = pixfmt_type::pix_width };
+
+    colorizer_accessor(pixfmt_type const& pixf, colorizer_lut const& lut)
+        : pixf_(pixf),
+          lut_(lut),
+          x_(0),
+          x0_(0),
+          y_(0) {}
+
+    AGG_INLINE agg::int8u const* span(int x, int y, unsigned)
+    {
+        x_ = x0_ = x;
+        y_ = y;
+        return pixel();
+    }
+
+    AGG_INLINE agg::int8u const* next_x()
+    {
+        ++x_;
+        return pixel();
+    }
+
+    AGG_INLINE agg::int8u const* next_y()
+    {
+        ++y_;
+        x_ = x0_;
+        return pixel();
+    }
+
+private:
+    AGG_INLINE agg::int8u const* pixel()
+    {
+        int x = x_;
+        int y = y_;
+        if (x < 0) x = 0;
+        if (y < 0) y = 0;
+        if (x >= (int)pixf_.width()) x = pixf_.width() - 1;
+        if (y >= (int)pixf_.height()) y = pixf_.height() - 1;
+        float value;
+        std::memcpy(&value, pixf_.pix_ptr(x, y), sizeof(float));
+        unsigned rgba = lut_(value);
+        std::memcpy(pixel_, &rgba, sizeof(unsigned));
+        return pixel_;
+    }
+
+    pixfmt_type const& pixf_;
+    colorizer_lut const& lut_;
+    int x_;
+    int x0_;
+    int y_;
+    agg::int8u pixel_[4];
+};
+
+}
+
+#endif // MAPNIK_COLORIZER_ACCESSOR_HPP
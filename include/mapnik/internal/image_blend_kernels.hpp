@@ -0,0 +1,301 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_IMAGE_BLEND_KERNELS_HPP
+#define MAPNIK_IMAGE_BLEND_KERNELS_HPP
+
+// mapnik
+#include <mapnik/image_blend.hpp>
+
+/* Vectorised versions of the scalar blending code in graphics.hpp.
+ *
+ * The kernels are written once against a small traits class V which wraps
+ * the intrinsics of one instruction set (see image_blend_sse2.cpp and
+ * image_blend_avx2.cpp). Channels are unpacked into float lanes: every
+ * intermediate value of the scalar code stays below 2^24, so products,
+ * sums and correctly rounded divisions followed by truncation give exactly
+ * the same integers as the unsigned arithmetic they replace. Packing is
+ * done in 32 bit integer lanes with the same shifts as the scalar code,
+ * including its lack of masking on out of range channels.
+ */
+
+namespace mapnik { namespace detail {
+
+unsigned blend_row_sse2(blend_mode_e mode, unsigned * dst, unsigned const* src,
+                        unsigned len, float opacity);
+unsigned blend_row_avx2(blend_mode_e mode, unsigned * dst, unsigned const* src,
+                        unsigned len, float opacity);
+
+template <typename V>
+struct blend_ops
+{
+    typedef typename V::vi vi;
+    typedef typename V::vf vf;
+
+    static inline vf channel(vi p, int shift)
+    {
+        return V::to_f(V::and_i(V::srl(p, shift), V::set1_i(0xff)));
+    }
+
+    static inline vf alpha(vi p)
+    {
+        return V::to_f(V::srl(p, 24));
+    }
+
+    static inline vf trunc(vf x)
+    {
+        return V::to_f(V::to_i(x));
+    }
+
+    static inline vf div(vf n, vf d)
+    {
+        return trunc(V::div_f(n, d));
+    }
+
+    static inline vf clamp(vf x, float lo, float hi)
+    {
+        return V::min_f(V::max_f(x, V::set1_f(lo)), V::set1_f(hi));
+    }
+
+    static inline vi pack(vf r, vf g, vf b, vf a)
+    {
+        return V::or_i(V::or_i(V::sll(V::to_i(a), 24), V::sll(V::to_i(b), 16)),
+                       V::or_i(V::sll(V::to_i(g), 8), V::to_i(r)));
+    }
+};
+
+// per channel merge functions, c0 is the destination and c1 the source value
+
+template <typename V>
+struct multiply_op
+{
+    typedef typename V::vf vf;
+    static inline vf merge(vf c0, vf c1)
+    {
+        return blend_ops<V>::div(V::mul_f(c1, c0), V::set1_f(255.0f));
+    }
+};
+
+template <typename V>
+struct multiply2_op
+{
+    typedef typename V::vf vf;
+    static inline vf merge(vf c0, vf c1)
+    {
+        return V::min_f(blend_ops<V>::trunc(V::mul_f(V::mul_f(c1, c0), V::set1_f(1.0f / 128.0f))),
+                        V::set1_f(255.0f));
+    }
+};
+
+template <typename V>
+struct divide_op
+{
+    typedef typename V::vf vf;
+    static inline vf merge(vf c0, vf c1)
+    {
+        return blend_ops<V>::div(V::mul_f(c0, V::set1_f(256.0f)), V::add_f(c1, V::set1_f(1.0f)));
+    }
+};
+
+template <typename V>
+struct divide2_op
+{
+    typedef typename V::vf vf;
+    static inline vf merge(vf c0, vf c1)
+    {
+        return blend_ops<V>::div(V::mul_f(c0, V::set1_f(128.0f)), V::add_f(c1, V::set1_f(1.0f)));
+    }
+};
+
+template <typename V>
+struct screen_op
+{
+    typedef typename V::vf vf;
+    static inline vf merge(vf c0, vf c1)
+    {
+        vf full = V::set1_f(255.0f);
+        return V::sub_f(full, blend_ops<V>::div(V::mul_f(V::sub_f(full, c0), V::sub_f(full, c1)), full));
+    }
+};
+
+template <typename V>
+struct hard_light_op
+{
+    typedef typename V::vf vf;
+    static inline vf merge(vf c0, vf c1)
+    {
+        vf full = V::set1_f(255.0f);
+        vf scale = V::set1_f(1.0f / 256.0f);
+        vf half = V::set1_f(128.0f);
+        // c1 > 128: 255 - (255-c0)*(255-2*(c1-128))/256
+        vf hi = V::sub_f(full, blend_ops<V>::trunc(
+                             V::mul_f(V::mul_f(V::sub_f(full, c0),
+                                               V::sub_f(full, V::mul_f(V::set1_f(2.0f), V::sub_f(c1, half)))),
+                                      scale)));
+        // otherwise: c0*c1*2/256
+        vf lo = blend_ops<V>::trunc(V::mul_f(V::mul_f(V::mul_f(c0, c1), V::set1_f(2.0f)), scale));
+        return V::select_f(V::gt_f(c1, half), hi, lo);
+    }
+};
+
+template <typename V>
+struct merge_grain_op
+{
+    typedef typename V::vf vf;
+    static inline vf merge(vf c0, vf c1)
+    {
+        return blend_ops<V>::clamp(V::sub_f(V::add_f(c1, c0), V::set1_f(128.0f)), 0.0f, 255.0f);
+    }
+};
+
+template <typename V>
+struct merge_grain2_op
+{
+    typedef typename V::vf vf;
+    static inline vf merge(vf c0, vf c1)
+    {
+        return blend_ops<V>::clamp(V::sub_f(V::add_f(V::add_f(c1, c1), c0), V::set1_f(256.0f)), 0.0f, 255.0f);
+    }
+};
+
+// image_32::merge_rectangle<MergeMethod>
+template <typename V, template <typename> class Op>
+unsigned merge_row(unsigned * dst, unsigned const* src, unsigned len, float opacity)
+{
+    typedef blend_ops<V> ops;
+    typedef typename V::vi vi;
+    typedef typename V::vf vf;
+    typedef Op<V> op;
+
+    vf full = V::set1_f(255.0f);
+    vf round = V::set1_f(127.0f);
+    vf zero = V::set1_f(0.0f);
+    vf op_opacity = V::set1_f(opacity);
+    unsigned n = len - len % V::width;
+    for (unsigned i = 0; i < n; i += V::width)
+    {
+        vi rgba0 = V::load(dst + i);
+        vi rgba1 = V::load(src + i);
+        vf a1 = ops::trunc(V::mul_f(ops::alpha(rgba1), op_opacity));
+        vf a0 = ops::alpha(rgba0);
+        vf r0 = ops::channel(rgba0, 0);
+        vf g0 = ops::channel(rgba0, 8);
+        vf b0 = ops::channel(rgba0, 16);
+
+        vf inv_a1 = V::sub_f(full, a1);
+        vf a = ops::div(V::add_f(V::add_f(V::mul_f(a1, full), V::mul_f(inv_a1, a0)), round), full);
+        vf k = ops::div(V::add_f(V::mul_f(inv_a1, a0), round), full);
+
+        vf r1 = op::merge(r0, ops::channel(rgba1, 0));
+        vf g1 = op::merge(g0, ops::channel(rgba1, 8));
+        vf b1 = op::merge(b0, ops::channel(rgba1, 16));
+
+        r0 = ops::div(V::add_f(V::add_f(V::mul_f(r1, a1), V::mul_f(k, r0)), round), a);
+        g0 = ops::div(V::add_f(V::add_f(V::mul_f(g1, a1), V::mul_f(k, g0)), round), a);
+        b0 = ops::div(V::add_f(V::add_f(V::mul_f(b1, a1), V::mul_f(k, b0)), round), a);
+
+        vi result = ops::pack(r0, g0, b0, a);
+        V::store(dst + i, V::select_i(V::eq_f(a1, zero), rgba0, result));
+    }
+    return n;
+}
+
+// image_32::set_rectangle_alpha2
+template <typename V>
+unsigned alpha_row(unsigned * dst, unsigned const* src, unsigned len, float opacity)
+{
+    typedef blend_ops<V> ops;
+    typedef typename V::vi vi;
+    typedef typename V::vf vf;
+
+    vf full = V::set1_f(255.0f);
+    vf round = V::set1_f(255.0f);
+    vf scale = V::set1_f(1.0f / 256.0f);
+    vf zero = V::set1_f(0.0f);
+    vf op_opacity = V::set1_f(opacity);
+    unsigned n = len - len % V::width;
+    for (unsigned i = 0; i < n; i += V::width)
+    {
+        vi rgba0 = V::load(dst + i);
+        vi rgba1 = V::load(src + i);
+        vf a1 = ops::trunc(V::mul_f(ops::alpha(rgba1), op_opacity));
+        vf a0 = ops::alpha(rgba0);
+        vf r0 = ops::channel(rgba0, 0);
+        vf g0 = ops::channel(rgba0, 8);
+        vf b0 = ops::channel(rgba0, 16);
+
+        vf atmp = V::sub_f(V::add_f(a1, a0), ops::trunc(V::mul_f(V::add_f(V::mul_f(a1, a0), round), scale)));
+        vf r0a0 = V::mul_f(r0, a0);
+        vf g0a0 = V::mul_f(g0, a0);
+        vf b0a0 = V::mul_f(b0, a0);
+        vf r = ops::div(V::sub_f(V::add_f(V::mul_f(ops::channel(rgba1, 0), a1), r0a0),
+                                 ops::trunc(V::mul_f(V::add_f(V::mul_f(r0a0, a1), round), scale))), atmp);
+        vf g = ops::div(V::sub_f(V::add_f(V::mul_f(ops::channel(rgba1, 8), a1), g0a0),
+                                 ops::trunc(V::mul_f(V::add_f(V::mul_f(g0a0, a1), round), scale))), atmp);
+        vf b = ops::div(V::sub_f(V::add_f(V::mul_f(ops::channel(rgba1, 16), a1), b0a0),
+                                 ops::trunc(V::mul_f(V::add_f(V::mul_f(b0a0, a1), round), scale))), atmp);
+
+        // byte() truncation of the scalar code, channels are left alone when atmp == 0
+        vf no_alpha = V::eq_f(atmp, zero);
+        r = V::select_f(no_alpha, r0, V::to_f(V::and_i(V::to_i(r), V::set1_i(0xff))));
+        g = V::select_f(no_alpha, g0, V::to_f(V::and_i(V::to_i(g), V::set1_i(0xff))));
+        b = V::select_f(no_alpha, b0, V::to_f(V::and_i(V::to_i(b), V::set1_i(0xff))));
+        vf a = V::to_f(V::and_i(V::to_i(atmp), V::set1_i(0xff)));
+
+        vi result = ops::pack(r, g, b, a);
+        result = V::select_i(V::eq_f(a1, full), rgba1, result);
+        V::store(dst + i, V::select_i(V::eq_f(a1, zero), rgba0, result));
+    }
+    return n;
+}
+
+template <typename V>
+unsigned blend_row_impl(blend_mode_e mode, unsigned * dst, unsigned const* src,
+                        unsigned len, float opacity)
+{
+    switch (mode)
+    {
+    case BLEND_ALPHA:
+        return alpha_row<V>(dst, src, len, opacity);
+    case BLEND_MULTIPLY:
+        return merge_row<V, multiply_op>(dst, src, len, opacity);
+    case BLEND_MULTIPLY2:
+        return merge_row<V, multiply2_op>(dst, src, len, opacity);
+    case BLEND_DIVIDE:
+        return merge_row<V, divide_op>(dst, src, len, opacity);
+    case BLEND_DIVIDE2:
+        return merge_row<V, divide2_op>(dst, src, len, opacity);
+    case BLEND_SCREEN:
+        return merge_row<V, screen_op>(dst, src, len, opacity);
+    case BLEND_HARD_LIGHT:
+        return merge_row<V, hard_light_op>(dst, src, len, opacity);
+    case BLEND_MERGE_GRAIN:
+        return merge_row<V, merge_grain_op>(dst, src, len, opacity);
+    case BLEND_MERGE_GRAIN2:
+        return merge_row<V, merge_grain2_op>(dst, src, len, opacity);
+    }
+    return 0;
+}
+
+}}
+
+#endif // MAPNIK_IMAGE_BLEND_KERNELS_HPP
@@ -150,12 +150,14 @@ public:
 private:
     typedef quad_tree< label > tree_t;
     tree_t tree_;
+    std::vector<label> * recorded_;
 
 public:
     typedef tree_t::query_iterator query_iterator;
 
     explicit label_collision_detector4(box2d<double> const& extent)
-        : tree_(extent) {}
+        : tree_(extent),
+          recorded_(0) {}
 
     bool has_placement(box2d<double> const& box)
     {
@@ -210,11 +212,19 @@ public:
     void insert(box2d<double> const& box)
     {
         tree_.insert(label(box), box);
+        if (recorded_) recorded_->push_back(label(box));
     }
 
     void insert(box2d<double> const& box, UnicodeString const& text)
     {
         tree_.insert(label(box, text), box);
+        if (recorded_) recorded_->push_back(label(box, text));
+    }
+
+    // also append labels inserted from now on to labels, stop when null
+    void record(std::vector<label> * labels)
+    {
+        recorded_ = labels;
     }
 
     void clear()
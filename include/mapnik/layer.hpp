@@ -161,6 +161,30 @@ public:
      */
     bool cache_features() const;
 
+    /*!
+     * @param cache_rendering Set whether the agg renderer keeps this layer's rendered
+     *        image (and labels) in the layer_render_cache and reuses it for the same map
+     *        size and extent instead of rendering the layer again.
+     */
+    void set_cache_rendering(bool cache_rendering);
+
+    /*!
+     * @return whether renderings of this layer are cached.
+     */
+    bool cache_rendering() const;
+
+    /*!
+     * @param size Set the screen size in pixels below which the agg renderer
+     *        fills a line or polygon geometry as its bounding box instead of
+     *        clipping, transforming and rasterizing all of its vertices (0 to disable).
+     */
+    void set_min_feature_size(double size);
+
+    /*!
+     * @return the screen size in pixels below which geometries are collapsed.
+     */
+    double min_feature_size() const;
+
     /*!
      * @param group_by Set the field rendering of this layer is grouped by.
      */
@@ -201,6 +225,8 @@ private:
     bool queryable_;
     bool clear_label_cache_;
     bool cache_features_;
+    bool cache_rendering_;
+    double min_feature_size_;
     std::string group_by_;
     std::vector<std::string>  styles_;
     datasource_ptr ds_;
@@ -0,0 +1,103 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_LAYER_RENDER_CACHE_HPP
+#define MAPNIK_LAYER_RENDER_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/utils.hpp>
+#include <mapnik/image_data.hpp>
+#include <mapnik/label_collision_detector.hpp>
+#include <mapnik/lru_cache.hpp>
+
+// boost
+#include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/optional.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#endif
+
+// stl
+#include <string>
+#include <vector>
+
+namespace mapnik
+{
+
+/** A layer rendered on its own: its pixels over a transparent background
+ *  and the labels it added to the collision detector. */
+struct cached_layer
+{
+    cached_layer(unsigned width, unsigned height)
+        : image(width, height),
+          painted(false) {}
+    image_data_32 image;
+    std::vector<label_collision_detector4::label> labels;
+    bool painted;
+};
+
+typedef boost::shared_ptr<cached_layer> cached_layer_ptr;
+
+/** Process-wide cache of rendered layers.
+ *
+ * The AGG renderer keeps layers with cache-rendering set here, keyed by
+ * the layer, its datasource parameters and styles, the size, extent and
+ * scale of the map, and the labels placed before the layer, and
+ * composites them from here instead of rendering them again. Layers with
+ * raster modes blending into the layers below are always rendered. The
+ * cache is bounded by the size of the pixels, 128MB by default. With a
+ * directory set, layers are also written there and read back when they
+ * are not in memory, so they survive restarts and are shared between
+ * processes; damaged files are ignored. Changes to styles or data are not
+ * noticed, clear the cache (and the directory) after making them.
+ * Cached layers are never modified.
+ */
+class MAPNIK_DECL layer_render_cache :
+        public singleton <layer_render_cache, CreateStatic>,
+        private boost::noncopyable
+{
+    friend class CreateStatic<layer_render_cache>;
+public:
+    /** The layer rendered for key, if there is one of width x height. */
+    boost::optional<cached_layer_ptr> find(std::string const& key, unsigned width, unsigned height);
+    void insert(std::string const& key, cached_layer_ptr const& layer);
+    void set_capacity(std::size_t bytes);
+    std::size_t capacity() const;
+    /** Directory to keep rendered layers in as well, empty for memory only. */
+    void set_directory(std::string const& directory);
+    std::string directory() const;
+    /** Drops the layers in memory, files in the directory are left alone. */
+    void clear();
+private:
+    layer_render_cache();
+    lru_cache<std::string, cached_layer_ptr> cache_;
+    std::string directory_;
+#ifdef MAPNIK_THREADSAFE
+    mutable boost::mutex mutex_;
+#endif
+};
+
+}
+
+#endif // MAPNIK_LAYER_RENDER_CACHE_HPP
@@ -0,0 +1,173 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_LRU_CACHE_HPP
+#define MAPNIK_LRU_CACHE_HPP
+
+// boost
+#include <boost/utility.hpp>
+#include <boost/unordered_map.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#endif
+
+// stl
+#include <list>
+#include <utility>
+
+namespace mapnik
+{
+
+/** Thread-safe least recently used cache bounded by the total cost of its entries.
+ *
+ * The cost of an entry is supplied on insert, usually its size in bytes.
+ * When the total cost exceeds the capacity the least recently used entries
+ * are dropped until it fits again. Value is typically a shared_ptr so
+ * evicted entries stay alive for as long as somebody still uses them.
+ */
+template <typename Key, typename Value>
+class lru_cache : private boost::noncopyable
+{
+    struct entry
+    {
+        entry(Key const& key_, Value const& value_, std::size_t cost_)
+            : key(key_),
+              value(value_),
+              cost(cost_) {}
+        Key key;
+        Value value;
+        std::size_t cost;
+    };
+
+    typedef std::list<entry> list_type;
+    typedef boost::unordered_map<Key, typename list_type::iterator> index_type;
+
+public:
+    explicit lru_cache(std::size_t capacity)
+        : capacity_(capacity),
+          cost_(0) {}
+
+    bool find(Key const& key, Value & value)
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        typename index_type::iterator itr = index_.find(key);
+        if (itr == index_.end())
+        {
+            return false;
+        }
+        // move to front, most recently used
+        entries_.splice(entries_.begin(), entries_, itr->second);
+        value = itr->second->value;
+        return true;
+    }
+
+    void insert(Key const& key, Value const& value, std::size_t cost)
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        if (cost > capacity_)
+        {
+            return;
+        }
+        typename index_type::iterator itr = index_.find(key);
+        if (itr != index_.end())
+        {
+            cost_ -= itr->second->cost;
+            entries_.erase(itr->second);
+            index_.erase(itr);
+        }
+        entries_.push_front(entry(key, value, cost));
+        index_.insert(std::make_pair(key, entries_.begin()));
+        cost_ += cost;
+        shrink();
+    }
+
+    void clear()
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        index_.clear();
+        entries_.clear();
+        cost_ = 0;
+    }
+
+    void set_capacity(std::size_t capacity)
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        capacity_ = capacity;
+        shrink();
+    }
+
+    std::size_t capacity() const
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        return capacity_;
+    }
+
+    std::size_t cost() const
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        return cost_;
+    }
+
+    std::size_t size() const
+    {
+#ifdef MAPNIK_THREADSAFE
+        boost::mutex::scoped_lock lock(mutex_);
+#endif
+        return index_.size();
+    }
+
+private:
+    void shrink()
+    {
+        while (cost_ > capacity_ && !entries_.empty())
+        {
+            entry const& last = entries_.back();
+            cost_ -= last.cost;
+            index_.erase(last.key);
+            entries_.pop_back();
+        }
+    }
+
+    std::size_t capacity_;
+    std::size_t cost_;
+    list_type entries_;
+    index_type index_;
+#ifdef MAPNIK_THREADSAFE
+    mutable boost::mutex mutex_;
+#endif
+};
+
+}
+
+#endif // MAPNIK_LRU_CACHE_HPP
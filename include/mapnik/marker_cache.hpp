@@ -32,6 +32,10 @@
 #include <boost/unordered_map.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/optional.hpp>
+#include <boost/functional/hash.hpp>
+
+// stl
+#include <string>
 
 namespace mapnik
 {
@@ -40,6 +44,33 @@ class marker;
 
 typedef boost::shared_ptr<marker> marker_ptr;
 
+/** Marker cache key with the hash of the uri computed once up front.
+ * Symbolizers whose filename doesn't depend on feature attributes keep
+ * one of these around so lookups don't rehash the uri for every feature.
+ */
+struct marker_key
+{
+    marker_key()
+        : uri(),
+          hash(0) {}
+
+    explicit marker_key(std::string const& uri_)
+        : uri(uri_),
+          hash(boost::hash<std::string>()(uri_)) {}
+
+    bool operator==(marker_key const& rhs) const
+    {
+        return hash == rhs.hash && uri == rhs.uri;
+    }
+
+    std::string uri;
+    std::size_t hash;
+};
+
+inline std::size_t hash_value(marker_key const& key)
+{
+    return key.hash;
+}
 
 struct MAPNIK_DECL marker_cache :
         public singleton <marker_cache, CreateStatic>,
@@ -47,9 +78,10 @@ struct MAPNIK_DECL marker_cache :
 {
 
     friend class CreateStatic<marker_cache>;
-    static boost::unordered_map<std::string,marker_ptr> cache_;
+    static boost::unordered_map<marker_key,marker_ptr> cache_;
     static bool insert(std::string const& key, marker_ptr);
     static boost::optional<marker_ptr> find(std::string const& key, bool update_cache = false);
+    static boost::optional<marker_ptr> find(marker_key const& key, bool update_cache = false);
     static void clear();
 };
 
@@ -31,7 +31,8 @@
 #include <boost/shared_ptr.hpp>
 
 // stl
-#include <list>
+#include <string>
+#include <vector>
 
 namespace mapnik {
 
@@ -81,29 +82,55 @@ public:
 
     virtual void start(metawriter_property_map const& properties);
 
+    /**
+     * A kept property of a rendered feature. The key indexes key_names(),
+     * so each property name is stored once per writer.
+     */
+    struct MAPNIK_DECL meta_property {
+        unsigned key;
+        value val;
+    };
+
+    typedef std::vector<meta_property> meta_property_list;
+
     /**
      * An instance of a rendered feature. The box represents the image
      * coordinates of a bounding box around the feature. The properties
      * are the intersection of the features' properties and the "kept"
-     * properties of the metawriter.
+     * properties of the metawriter, stored in properties() from
+     * first_property up to (not including) last_property.
      */
     struct MAPNIK_DECL meta_instance {
         box2d<double> box;
-        std::map<std::string, value> properties;
+        unsigned first_property;
+        unsigned last_property;
     };
 
-    typedef std::list<meta_instance> meta_instance_list;
+    typedef std::vector<meta_instance> meta_instance_list;
 
     // const-only access to the instances.
     const meta_instance_list &instances() const;
 
+    // properties of all instances and the names their keys refer to.
+    const meta_property_list &properties() const;
+    const std::vector<std::string> &key_names() const;
+
     // utility iterators for use in the python bindings.
     meta_instance_list::const_iterator inst_begin() const;
     meta_instance_list::const_iterator inst_end() const;
 
 private:
 
-    std::list<meta_instance> instances_;
+    // all kept in flat vectors which start() clears but does not
+    // release, rendering again with the same writer doesn't allocate.
+    meta_instance_list instances_;
+    meta_property_list properties_;
+    std::vector<std::string> keys_;
+
+    void add_instance(box2d<double> const& box,
+                      Feature const& feature,
+                      metawriter_properties const& properties);
+    unsigned intern_key(std::string const& name);
 
     void add_vertices(path_type & path,
                       Feature const& feature,
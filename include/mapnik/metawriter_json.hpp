@@ -32,6 +32,7 @@
 
 // stl
 #include <fstream>
+#include <string>
 
 namespace mapnik {
 
@@ -86,7 +87,7 @@ protected:
     projection output_srs_;
     bool pixel_coordinates_;
     virtual void write_header();
-    inline void write_feature_header(std::string type) {
+    inline void write_feature_header(char const* type) {
 #ifdef MAPNIK_DEBUG
         if (count_ == STOPPED)
         {
@@ -94,9 +95,11 @@ protected:
         }
 #endif
         if (count_ == HEADER_NOT_WRITTEN) write_header();
-        if (count_++) *f_ << ",\n";
+        if (count_++) buffer_ += ",\n";
 
-        *f_  << "{ \"type\": \"Feature\",\n  \"geometry\": { \"type\": \"" << type << "\",\n    \"coordinates\":";
+        buffer_ += "{ \"type\": \"Feature\",\n  \"geometry\": { \"type\": \"";
+        buffer_ += type;
+        buffer_ += "\",\n    \"coordinates\":";
     }
     void write_properties(Feature const& feature, metawriter_properties const& properties);
     inline void write_point(CoordTransform const& t, double x, double y, bool last = false)
@@ -106,12 +109,25 @@ protected:
             t.backward(&x, &y);
             trans_->forward(x, y, z);
         }
-        *f_ << "[" << x << "," << y << "]";
+        buffer_ += '[';
+        write_number(x);
+        buffer_ += ',';
+        write_number(y);
+        buffer_ += ']';
         if (!last) {
-            *f_ << ",";
+            buffer_ += ',';
         }
     }
     void write_line_polygon(path_type & path, CoordTransform const& t, bool polygon);
+    /** Append a coordinate in fixed notation with precision_ digits. */
+    void write_number(double val);
+    /** Hand the buffered output to the stream, once it is large or at stop(). */
+    void flush(bool force = false);
+    /** Output collected since the last flush. Capacity is kept, so the
+        buffer stops allocating after the first few features. */
+    std::string buffer_;
+    /** Digits after the decimal point, fixed when the header is written. */
+    int precision_;
 
 private:
     std::ostream *f_;
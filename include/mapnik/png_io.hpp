@@ -24,6 +24,7 @@
 #define MAPNIK_PNG_IO_HPP
 
 // mapnik
+#include <mapnik/config.hpp>
 #include <mapnik/global.hpp>
 #include <mapnik/palette.hpp>
 #include <mapnik/octree.hpp>
@@ -37,6 +38,11 @@ extern "C"
 #include <png.h>
 }
 
+// stl
+#include <cstring>
+#include <string>
+#include <vector>
+
 #define MAX_OCTREE_LEVELS 4
 
 namespace mapnik {
@@ -55,9 +61,63 @@ void flush_data (png_structp png_ptr)
     out->flush();
 }
 
+/*
+ * Builds a complete png in out from rows laid out for PNG_FILTER_NONE
+ * (a zero filter byte followed by the packed pixels of each row). The rows
+ * are split into strips which are deflated on up to `threads` threads
+ * (0 for one per core) and joined into a single zlib stream, the way pigz
+ * does it, so the file is built in memory and written out in one go.
+ */
+MAPNIK_DECL void encode_png_strips(std::string & out,
+                                   std::vector<unsigned char> const& raw,
+                                   unsigned width,
+                                   unsigned height,
+                                   unsigned color_depth,
+                                   int color_type,
+                                   std::vector<mapnik::rgb> const& palette,
+                                   std::vector<unsigned> const& alpha,
+                                   int compression,
+                                   int strategy,
+                                   unsigned threads);
+
 template <typename T1, typename T2>
-void save_as_png(T1 & file , T2 const& image, int compression = Z_DEFAULT_COMPRESSION, int strategy = Z_DEFAULT_STRATEGY)
+void save_as_png_strips(T1 & file, T2 const& image,
+                        unsigned width,
+                        unsigned height,
+                        unsigned color_depth,
+                        int color_type,
+                        std::vector<mapnik::rgb> const& palette,
+                        std::vector<unsigned> const& alpha,
+                        int compression,
+                        int strategy,
+                        unsigned threads)
 {
+    unsigned row_bytes = (width * color_depth * (color_type == PNG_COLOR_TYPE_RGB_ALPHA ? 4 : 1) + 7) / 8;
+    std::vector<unsigned char> raw(height * (row_bytes + 1));
+    for (unsigned i = 0; i < height; ++i)
+    {
+        unsigned char * row = &raw[i * (row_bytes + 1)];
+        row[0] = PNG_FILTER_VALUE_NONE;
+        std::memcpy(row + 1, image.getRow(i), row_bytes);
+    }
+    std::string out;
+    encode_png_strips(out, raw, width, height, color_depth, color_type,
+                      palette, alpha, compression, strategy, threads);
+    file.write(out.data(), out.size());
+}
+
+template <typename T1, typename T2>
+void save_as_png(T1 & file , T2 const& image, int compression = Z_DEFAULT_COMPRESSION, int strategy = Z_DEFAULT_STRATEGY,
+                 unsigned threads = 1)
+{
+    if (threads != 1)
+    {
+        save_as_png_strips(file, image, image.width(), image.height(), 8, PNG_COLOR_TYPE_RGB_ALPHA,
+                           std::vector<mapnik::rgb>(), std::vector<unsigned>(),
+                           compression, strategy, threads);
+        return;
+    }
+
     png_voidp error_ptr=0;
     png_structp png_ptr=png_create_write_struct(PNG_LIBPNG_VER_STRING,
                                                 error_ptr,0, 0);
@@ -103,6 +163,87 @@ void save_as_png(T1 & file , T2 const& image, int compression = Z_DEFAULT_COMPRE
     png_destroy_write_struct(&png_ptr, &info_ptr);
 }
 
+/*
+ * Small direct mapped cache of pixel -> palette index in front of a
+ * quantizer's nearest color search, kept for one image. Map tiles are
+ * mostly runs and a few hundred distinct colors, so nearly all pixels hit
+ * either the previous pixel or the 4k table and the exact search (and its
+ * hash map) only runs once per distinct color in the slot.
+ */
+template <typename Quantizer>
+class quantize_cache
+{
+public:
+    explicit quantize_cache(Quantizer const& quantizer)
+        : quantizer_(quantizer),
+          keys_(cache_size, 0),
+          values_(cache_size, quantizer(0)),
+          last_key_(0),
+          last_value_(values_[0]) {}
+
+    inline int operator() (unsigned val)
+    {
+        if (val != last_key_)
+        {
+            unsigned slot = (val * 2654435761u) >> (32 - cache_bits);
+            if (keys_[slot] != val)
+            {
+                keys_[slot] = val;
+                values_[slot] = quantizer_(val);
+            }
+            last_key_ = val;
+            last_value_ = values_[slot];
+        }
+        return last_value_;
+    }
+
+private:
+    enum { cache_bits = 12, cache_size = 1 << cache_bits };
+    Quantizer const& quantizer_;
+    std::vector<unsigned> keys_;
+    std::vector<int> values_;
+    unsigned last_key_;
+    int last_value_;
+};
+
+// palette index of a pixel from a hextree or rgba_palette
+template <typename T>
+struct tree_quantizer
+{
+    explicit tree_quantizer(T const& tree)
+        : tree_(tree) {}
+
+    int operator() (unsigned val) const
+    {
+        return tree_.quantize(val);
+    }
+
+    T const& tree_;
+};
+
+// palette index of a pixel from the octree of its alpha range, -1 if
+// it is fully transparent and has no color of its own
+struct octree_quantizer
+{
+    octree_quantizer(octree<rgb> trees[], unsigned limits[], unsigned levels)
+        : trees_(trees), limits_(limits), levels_(levels) {}
+
+    int operator() (unsigned val) const
+    {
+        mapnik::rgb c(U2RED(val), U2GREEN(val), U2BLUE(val));
+        for(int j=levels_-1; j>0; j--){
+            if (U2ALPHA(val)>=limits_[j] && trees_[j].colors()>0) {
+                return trees_[j].quantize(c);
+            }
+        }
+        return -1;
+    }
+
+    octree<rgb> * trees_;
+    unsigned * limits_;
+    unsigned levels_;
+};
+
 template <typename T>
 void reduce_8  (T const& in, image_data_8 & out, octree<rgb> trees[], unsigned limits[], unsigned levels, std::vector<unsigned> & alpha)
 {
@@ -117,6 +258,8 @@ void reduce_8  (T const& in, image_data_8 & out, octree<rgb> trees[], unsigned l
         alphaCount[i] = 0;
     }
 
+    octree_quantizer quantizer(trees, limits, levels);
+    quantize_cache<octree_quantizer> cache(quantizer);
     for (unsigned y = 0; y < height; ++y)
     {
         mapnik::image_data_32::pixel_type const * row = in.getRow(y);
@@ -124,15 +267,8 @@ void reduce_8  (T const& in, image_data_8 & out, octree<rgb> trees[], unsigned l
         for (unsigned x = 0; x < width; ++x)
         {
             unsigned val = row[x];
-            mapnik::rgb c(U2RED(val), U2GREEN(val), U2BLUE(val));
-            byte index = 0;
-            int idx = -1;
-            for(int j=levels-1; j>0; j--){
-                if (U2ALPHA(val)>=limits[j] && trees[j].colors()>0) {
-                    index = idx = trees[j].quantize(c);
-                    break;
-                }
-            }
+            int idx = cache(val);
+            byte index = idx >= 0 ? idx : 0;
             if (idx>=0 && idx<(int)alpha.size())
             {
                 alpha[idx]+=U2ALPHA(val);
@@ -162,6 +298,8 @@ void reduce_4 (T const& in, image_data_8 & out, octree<rgb> trees[], unsigned li
         alphaCount[i] = 0;
     }
 
+    octree_quantizer quantizer(trees, limits, levels);
+    quantize_cache<octree_quantizer> cache(quantizer);
     for (unsigned y = 0; y < height; ++y)
     {
         mapnik::image_data_32::pixel_type const * row = in.getRow(y);
@@ -170,15 +308,8 @@ void reduce_4 (T const& in, image_data_8 & out, octree<rgb> trees[], unsigned li
         for (unsigned x = 0; x < width; ++x)
         {
             unsigned val = row[x];
-            mapnik::rgb c(U2RED(val), U2GREEN(val), U2BLUE(val));
-            byte index = 0;
-            int idx=-1;
-            for(int j=levels-1; j>0; j--){
-                if (U2ALPHA(val)>=limits[j] && trees[j].colors()>0) {
-                    index = idx = trees[j].quantize(c);
-                    break;
-                }
-            }
+            int idx = cache(val);
+            byte index = idx >= 0 ? idx : 0;
             if (idx>=0 && idx<(int)alpha.size())
             {
                 alpha[idx]+=U2ALPHA(val);
@@ -210,8 +341,16 @@ void save_as_png(T & file, std::vector<mapnik::rgb> const& palette,
                  unsigned color_depth,
                  int compression,
                  int strategy,
-                 std::vector<unsigned> const&alpha)
+                 std::vector<unsigned> const&alpha,
+                 unsigned threads = 1)
 {
+    if (threads != 1)
+    {
+        save_as_png_strips(file, image, width, height, color_depth, PNG_COLOR_TYPE_PALETTE,
+                           palette, alpha, compression, strategy, threads);
+        return;
+    }
+
     png_voidp error_ptr=0;
     png_structp png_ptr=png_create_write_struct(PNG_LIBPNG_VER_STRING,
                                                 error_ptr,0, 0);
@@ -278,7 +417,8 @@ void save_as_png(T & file, std::vector<mapnik::rgb> const& palette,
 
 template <typename T1,typename T2>
 void save_as_png8_oct(T1 & file, T2 const& image, const unsigned max_colors = 256,
-                      int compression = Z_DEFAULT_COMPRESSION, int strategy = Z_DEFAULT_STRATEGY, int trans_mode = -1)
+                      int compression = Z_DEFAULT_COMPRESSION, int strategy = Z_DEFAULT_STRATEGY, int trans_mode = -1,
+                      unsigned threads = 1)
 {
     // number of alpha ranges in png8 format; 2 results in smallest image with binary transparency
     // 3 is minimum for semitransparency, 4 is recommended, anything else is worse
@@ -423,7 +563,7 @@ void save_as_png8_oct(T1 & file, T2 const& image, const unsigned max_colors = 25
         // >16 && <=256 colors -> write 8-bit color depth
         image_data_8 reduced_image(width,height);
         reduce_8(image, reduced_image, trees, limits, TRANSPARENCY_LEVELS, alphaTable);
-        save_as_png(file,palette,reduced_image,width,height,8,compression,strategy,alphaTable);
+        save_as_png(file,palette,reduced_image,width,height,8,compression,strategy,alphaTable,threads);
     }
     else if (palette.size() == 1)
     {
@@ -436,7 +576,7 @@ void save_as_png8_oct(T1 & file, T2 const& image, const unsigned max_colors = 25
             alphaTable.resize(1);
             alphaTable[0] = meanAlpha;
         }
-        save_as_png(file,palette,reduced_image,width,height,1,compression,strategy,alphaTable);
+        save_as_png(file,palette,reduced_image,width,height,1,compression,strategy,alphaTable,threads);
     }
     else
     {
@@ -445,7 +585,7 @@ void save_as_png8_oct(T1 & file, T2 const& image, const unsigned max_colors = 25
         unsigned image_height = height;
         image_data_8 reduced_image(image_width,image_height);
         reduce_4(image, reduced_image, trees, limits, TRANSPARENCY_LEVELS, alphaTable);
-        save_as_png(file,palette,reduced_image,width,height,4,compression,strategy,alphaTable);
+        save_as_png(file,palette,reduced_image,width,height,4,compression,strategy,alphaTable,threads);
     }
 }
 
@@ -453,10 +593,13 @@ void save_as_png8_oct(T1 & file, T2 const& image, const unsigned max_colors = 25
 template <typename T1, typename T2, typename T3>
 void save_as_png8(T1 & file, T2 const& image, T3 const & tree,
                   std::vector<mapnik::rgb> const& palette, std::vector<unsigned> const& alphaTable,
-                  int compression = Z_DEFAULT_COMPRESSION, int strategy = Z_DEFAULT_STRATEGY)
+                  int compression = Z_DEFAULT_COMPRESSION, int strategy = Z_DEFAULT_STRATEGY,
+                  unsigned threads = 1)
 {
     unsigned width = image.width();
     unsigned height = image.height();
+    tree_quantizer<T3> quantizer(tree);
+    quantize_cache<tree_quantizer<T3> > cache(quantizer);
 
     if (palette.size() > 16 )
     {
@@ -470,10 +613,10 @@ void save_as_png8(T1 & file, T2 const& image, T3 const & tree,
 
             for (unsigned x = 0; x < width; ++x)
             {
-                row_out[x] = tree.quantize(row[x]);
+                row_out[x] = cache(row[x]);
             }
         }
-        save_as_png(file, palette, reduced_image, width, height, 8, compression, strategy, alphaTable);
+        save_as_png(file, palette, reduced_image, width, height, 8, compression, strategy, alphaTable, threads);
     }
     else if (palette.size() == 1)
     {
@@ -482,7 +625,7 @@ void save_as_png8(T1 & file, T2 const& image, T3 const & tree,
         unsigned image_height = height;
         image_data_8 reduced_image(image_width, image_height);
         reduced_image.set(0);
-        save_as_png(file, palette, reduced_image, width, height, 1, compression, strategy, alphaTable);
+        save_as_png(file, palette, reduced_image, width, height, 1, compression, strategy, alphaTable, threads);
     }
     else
     {
@@ -499,19 +642,19 @@ void save_as_png8(T1 & file, T2 const& image, T3 const & tree,
             for (unsigned x = 0; x < width; ++x)
             {
 
-                index = tree.quantize(row[x]);
+                index = cache(row[x]);
                 if (x%2 == 0) index = index<<4;
                 row_out[x>>1] |= index;
             }
         }
-        save_as_png(file, palette, reduced_image, width, height, 4, compression, strategy, alphaTable);
+        save_as_png(file, palette, reduced_image, width, height, 4, compression, strategy, alphaTable, threads);
     }
 }
 
 template <typename T1,typename T2>
 void save_as_png8_hex(T1 & file, T2 const& image, int colors = 256,
                       int compression = Z_DEFAULT_COMPRESSION, int strategy = Z_DEFAULT_STRATEGY,
-                      int trans_mode = -1, double gamma = 2.0)
+                      int trans_mode = -1, double gamma = 2.0, unsigned threads = 1)
 {
     unsigned width = image.width();
     unsigned height = image.height();
@@ -546,14 +689,58 @@ void save_as_png8_hex(T1 & file, T2 const& image, int colors = 256,
         alphaTable.push_back(pal[i].a);
     }
 
-    save_as_png8<T1, T2, hextree<mapnik::rgba> >(file, image, tree, palette, alphaTable, compression, strategy);
+    save_as_png8<T1, T2, hextree<mapnik::rgba> >(file, image, tree, palette, alphaTable, compression, strategy, threads);
+}
+
+/*
+ * Quantize an image with the same hextree as save_as_png8_hex and return
+ * the palette as rgba bytes, ready for rgba_palette(pal, PALETTE_RGBA).
+ * Building it once for a metatile and writing every tile with
+ * save_as_png8_pal keeps the colors consistent across tile edges and
+ * does the quantization work once instead of once per tile. The
+ * rgba_palette remembers quantized colors, so share it between threads
+ * only behind a lock.
+ */
+template <typename T>
+std::string make_palette_hex(T const& image, int colors = 256,
+                             int trans_mode = -1, double gamma = 2.0)
+{
+    hextree<mapnik::rgba> tree(colors);
+    if (trans_mode >= 0)
+        tree.setTransMode(trans_mode);
+    if (gamma > 0)
+        tree.setGamma(gamma);
+
+    for (unsigned y = 0; y < image.height(); ++y)
+    {
+        typename T::pixel_type const * row = image.getRow(y);
+        for (unsigned x = 0; x < image.width(); ++x)
+        {
+            unsigned val = row[x];
+            tree.insert(mapnik::rgba(U2RED(val), U2GREEN(val), U2BLUE(val), U2ALPHA(val)));
+        }
+    }
+
+    std::vector<mapnik::rgba> pal;
+    tree.create_palette(pal);
+    std::string out;
+    out.reserve(pal.size() * 4);
+    for (unsigned i = 0; i < pal.size(); ++i)
+    {
+        out += static_cast<char>(pal[i].r);
+        out += static_cast<char>(pal[i].g);
+        out += static_cast<char>(pal[i].b);
+        out += static_cast<char>(pal[i].a);
+    }
+    return out;
 }
 
 template <typename T1, typename T2>
 void save_as_png8_pal(T1 & file, T2 const& image, rgba_palette const& pal,
-                      int compression = Z_DEFAULT_COMPRESSION, int strategy = Z_DEFAULT_STRATEGY)
+                      int compression = Z_DEFAULT_COMPRESSION, int strategy = Z_DEFAULT_STRATEGY,
+                      unsigned threads = 1)
 {
-    save_as_png8<T1, T2, rgba_palette>(file, image, pal, pal.palette(), pal.alphaTable(), compression, strategy);
+    save_as_png8<T1, T2, rgba_palette>(file, image, pal, pal.palette(), pal.alphaTable(), compression, strategy, threads);
 }
 
 }
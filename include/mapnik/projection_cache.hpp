@@ -0,0 +1,70 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+#ifndef MAPNIK_PROJECTION_CACHE_HPP
+#define MAPNIK_PROJECTION_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/utils.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+
+// boost
+#include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
+
+// stl
+#include <string>
+
+namespace mapnik
+{
+
+typedef boost::shared_ptr<projection const> projection_ptr;
+typedef boost::shared_ptr<proj_transform const> proj_transform_ptr;
+
+/** Initialized projections and transforms keyed by their srs strings.
+ *
+ * Initializing a projection runs pj_init_plus, which is slow and, before
+ * proj 4.8, serialized on the global projection mutex. Renderers look up
+ * the map and layer projections here instead of building them for every
+ * layer of every render.
+ *
+ * proj objects (and their contexts) must not be used by two threads at
+ * once, so with MAPNIK_THREADSAFE every thread keeps its own entries and
+ * lookups take no lock. A failed initialization throws proj_init_error
+ * and is not cached.
+ */
+struct MAPNIK_DECL projection_cache :
+        public singleton <projection_cache, CreateStatic>,
+        private boost::noncopyable
+{
+    friend class CreateStatic<projection_cache>;
+    static projection_ptr get(std::string const& params);
+    static proj_transform_ptr get(std::string const& source, std::string const& dest);
+    static void clear();
+};
+
+}
+
+#endif // MAPNIK_PROJECTION_CACHE_HPP
@@ -41,10 +41,12 @@
 #include <mapnik/config.hpp>
 #include <mapnik/color.hpp>
 #include <mapnik/feature.hpp>
+#include <mapnik/image_data.hpp>
 #include <mapnik/enumeration.hpp>
 
 // boost
 #include <boost/shared_ptr.hpp>
+#include <boost/optional.hpp>
 
 // stl
 #include <vector>
@@ -199,6 +201,19 @@ public:
     //! \param[in] feature used to find 'NODATA' information if available
     void colorize(raster_ptr const& raster, Feature const& f) const;
 
+    //! \brief Colorize a raster into another image, leaving the source untouched
+    //!
+    //! \param[in] source A raster stored in float32 single channel format
+    //! \param[out] target Image of the same size receiving the colors, may be the source itself
+    //! \param[in] nodata Value mapped to transparent pixels
+    void colorize(image_data_32 const& source, image_data_32 & target,
+                  boost::optional<float> const& nodata) const;
+
+    //! \brief Get the 'NODATA' value of a raster feature
+    //! \param[in] feature The raster feature
+    //! \return The nodata value, if the feature has one
+    static boost::optional<float> nodata(Feature const& f);
+
 
     //! \brief Perform the translation of input to output
     //!
@@ -227,6 +242,55 @@ private:
 typedef boost::shared_ptr<raster_colorizer> raster_colorizer_ptr;
 
 
+//! \brief The stops of a colorizer resolved for colorizing many values
+//!
+//! Each stop's inherited mode, colors and neighbour are looked up once and
+//! values are located with a binary search instead of a scan over the stops.
+//! The colors are the same as raster_colorizer::get_color returns. The table
+//! is a snapshot, build it again when the colorizer changes.
+class MAPNIK_DECL colorizer_lut
+{
+public:
+    //! \brief Constructor
+    //!
+    //! \param[in] colorizer The colorizer to resolve, must outlive the table
+    //! \param[in] nodata Value mapped to transparent pixels
+    colorizer_lut(raster_colorizer const& colorizer, boost::optional<float> const& nodata);
+
+    //! \brief Perform the translation of input to output
+    //!
+    //! \param[in] value Input value
+    //! \return packed rgba color associated with the value
+    unsigned operator()(float value) const;
+
+    //! \brief Colorize a float32 raster into another image of the same size
+    //!
+    //! \param[in] source A raster stored in float32 single channel format
+    //! \param[out] target Image receiving the colors, may be the source itself
+    void colorize(image_data_32 const& source, image_data_32 & target) const;
+
+private:
+    struct entry
+    {
+        colorizer_mode_enum mode;   //!< The effective mode of the stop
+        unsigned stop_rgba;         //!< Color at the stop
+        color stop_color;           //!< Color at the stop
+        color next_color;           //!< Color at the next stop
+        float value;                //!< The stop value
+        float next_value;           //!< The next stop value
+    };
+
+    raster_colorizer const& colorizer_; //!< Used directly when the stops are not sorted
+    bool sorted_;                   //!< Whether the stop values are in ascending order
+    std::vector<float> values_;     //!< Stop values, searched to locate a value
+    std::vector<entry> entries_;    //!< Resolved stops, parallel to values_
+    unsigned default_rgba_;         //!< The default color
+    float epsilon_;                 //!< The epsilon value for exact mode
+    bool has_nodata_;               //!< Whether nodata_ is set
+    float nodata_;                  //!< Value mapped to transparent pixels
+};
+
+
 } // mapnik namespace
 
 #endif // MAPNIK_RASTER_COLORIZER_HPP
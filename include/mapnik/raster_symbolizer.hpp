@@ -31,12 +31,29 @@
 
 namespace mapnik
 {
+
+// Compositing modes, parsed from the mode string once when it is set.
+// Unrecognised mode strings replace the destination pixels.
+enum raster_mode_enum {
+    RASTER_MODE_NORMAL,
+    RASTER_MODE_GRAIN_MERGE,
+    RASTER_MODE_GRAIN_MERGE2,
+    RASTER_MODE_MULTIPLY,
+    RASTER_MODE_MULTIPLY2,
+    RASTER_MODE_DIVIDE,
+    RASTER_MODE_DIVIDE2,
+    RASTER_MODE_SCREEN,
+    RASTER_MODE_HARD_LIGHT,
+    RASTER_MODE_REPLACE
+};
+
 struct MAPNIK_DECL raster_symbolizer : public symbolizer_base
 {
 
     raster_symbolizer()
         : symbolizer_base(),
         mode_("normal"),
+        mode_enum_(RASTER_MODE_NORMAL),
         scaling_("fast"),
         opacity_(1.0),
         colorizer_(),
@@ -46,6 +63,7 @@ struct MAPNIK_DECL raster_symbolizer : public symbolizer_base
     raster_symbolizer(const raster_symbolizer &rhs)
         : symbolizer_base(rhs),
         mode_(rhs.get_mode()),
+        mode_enum_(rhs.mode_enum_),
         scaling_(rhs.get_scaling()),
         opacity_(rhs.get_opacity()),
         colorizer_(rhs.colorizer_),
@@ -59,6 +77,11 @@ struct MAPNIK_DECL raster_symbolizer : public symbolizer_base
     void set_mode(std::string const& mode)
     {
         mode_ = mode;
+        mode_enum_ = parse_mode(mode);
+    }
+    raster_mode_enum get_mode_enum() const
+    {
+        return mode_enum_;
     }
     std::string const& get_scaling() const
     {
@@ -146,7 +169,22 @@ struct MAPNIK_DECL raster_symbolizer : public symbolizer_base
 
 
 private:
+    static raster_mode_enum parse_mode(std::string const& mode)
+    {
+        if (mode == "normal") return RASTER_MODE_NORMAL;
+        else if (mode == "grain_merge") return RASTER_MODE_GRAIN_MERGE;
+        else if (mode == "grain_merge2") return RASTER_MODE_GRAIN_MERGE2;
+        else if (mode == "multiply") return RASTER_MODE_MULTIPLY;
+        else if (mode == "multiply2") return RASTER_MODE_MULTIPLY2;
+        else if (mode == "divide") return RASTER_MODE_DIVIDE;
+        else if (mode == "divide2") return RASTER_MODE_DIVIDE2;
+        else if (mode == "screen") return RASTER_MODE_SCREEN;
+        else if (mode == "hard_light") return RASTER_MODE_HARD_LIGHT;
+        return RASTER_MODE_REPLACE;
+    }
+
     std::string mode_;
+    raster_mode_enum mode_enum_;
     std::string scaling_;
     float opacity_;
     raster_colorizer_ptr colorizer_;
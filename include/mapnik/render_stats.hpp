@@ -0,0 +1,125 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+#ifndef MAPNIK_RENDER_STATS_HPP
+#define MAPNIK_RENDER_STATS_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+
+// stl
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstddef>
+#include <sys/time.h>
+
+namespace mapnik {
+
+// wall clock in milliseconds, only differences are meaningful
+inline double stats_clock()
+{
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+struct symbolizer_stats
+{
+    explicit symbolizer_stats(std::string const& name_)
+        : name(name_), count(0), time(0.0) {}
+
+    std::string name;
+    unsigned count;   // features the symbolizer was applied to
+    double time;      // ms
+};
+
+struct style_stats
+{
+    explicit style_stats(std::string const& name_)
+        : name(name_),
+          features(0),
+          features_rendered(0),
+          labels_attempted(0),
+          labels_placed(0),
+          query_time(0.0),
+          filter_time(0.0),
+          time(0.0) {}
+
+    std::string name;
+    unsigned features;          // features read for the style
+    unsigned features_rendered; // features matched by at least one rule
+    unsigned labels_attempted;  // features given to text and shield symbolizers
+    unsigned labels_placed;     // label placements drawn
+    double query_time;          // ms reading features
+    double filter_time;         // ms evaluating rule filters
+    double time;                // ms for the whole style
+    std::vector<symbolizer_stats> symbolizers;
+};
+
+struct layer_stats
+{
+    explicit layer_stats(std::string const& name_)
+        : name(name_),
+          features(0),
+          cached(false),
+          query_time(0.0),
+          time(0.0) {}
+
+    std::string name;
+    unsigned features;  // features returned by the datasource
+    bool cached;        // drawn from the layer_render_cache
+    double query_time;  // ms in the datasource, including reading features
+    double time;        // ms for the whole layer
+    std::vector<style_stats> styles;
+};
+
+/*
+ * Per layer and per style numbers of one or more renders. Pass it to a
+ * renderer with set_stats() before apply(); without it nothing is
+ * measured. bytes_encoded is left to the caller, who does the encoding.
+ */
+struct render_stats
+{
+    render_stats()
+        : bytes_encoded(0),
+          time(0.0) {}
+
+    void clear()
+    {
+        layers.clear();
+        bytes_encoded = 0;
+        time = 0.0;
+    }
+
+    std::vector<layer_stats> layers;
+    std::size_t bytes_encoded;
+    double time;  // ms in apply()
+};
+
+// a table like the one printed by builds with RENDERING_STATS
+MAPNIK_DECL std::ostream & operator<<(std::ostream & out, render_stats const& stats);
+
+}
+
+#endif // MAPNIK_RENDER_STATS_HPP
@@ -27,6 +27,7 @@
 #include <mapnik/config.hpp>
 #include <mapnik/parse_path.hpp>
 #include <mapnik/metawriter.hpp>
+#include <mapnik/marker_cache.hpp>
 
 // boost
 #include <boost/array.hpp>
@@ -90,6 +91,12 @@ class MAPNIK_DECL symbolizer_with_image {
 public:
     path_expression_ptr get_filename() const;
     void set_filename(path_expression_ptr filename);
+    /** Evaluate the filename for a feature as a marker_cache key.
+     * Filenames without attribute references are evaluated once in
+     * set_filename() and returned directly, otherwise the evaluated
+     * filename is stored in key and a reference to it returned.
+     */
+    marker_key const& get_filename_key(Feature const& feature, marker_key & key) const;
     void set_transform(transform_type const& );
     transform_type const& get_transform() const;
     std::string const get_transform_string() const;
@@ -99,6 +106,7 @@ protected:
     symbolizer_with_image(path_expression_ptr filename = path_expression_ptr());
     symbolizer_with_image(symbolizer_with_image const& rhs);
     path_expression_ptr image_filename_;
+    boost::optional<marker_key> filename_key_;
     float image_opacity_;
     transform_type matrix_;
 };
@@ -0,0 +1,114 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_THREAD_LOCAL_CACHE_HPP
+#define MAPNIK_THREAD_LOCAL_CACHE_HPP
+
+// boost
+#include <boost/utility.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/detail/atomic_count.hpp>
+
+// stl
+#include <utility>
+
+namespace mapnik
+{
+
+/** Lock-free per-thread front for a process-wide, mutex protected cache.
+ *
+ * Each thread keeps its own copy of the entries it has looked up, so
+ * repeated lookups never touch the shared mutex. Calling invalidate()
+ * bumps a generation counter and every thread drops its copy on the
+ * next access.
+ *
+ * insert() and invalidate() must be called while holding the mutex
+ * that protects the shared cache, so an entry fetched from the shared
+ * cache can never be inserted into a front cache after it was cleared.
+ */
+template <typename Key, typename Value>
+class thread_local_cache : private boost::noncopyable
+{
+public:
+    typedef boost::unordered_map<Key, Value> map_type;
+
+    thread_local_cache()
+        : local_(),
+          generation_(0) {}
+
+    bool find(Key const& key, Value & value) const
+    {
+        map_type & entries = local_entries();
+        typename map_type::const_iterator itr = entries.find(key);
+        if (itr == entries.end())
+        {
+            return false;
+        }
+        value = itr->second;
+        return true;
+    }
+
+    void insert(Key const& key, Value const& value)
+    {
+        local_entries().insert(std::make_pair(key, value));
+    }
+
+    void invalidate()
+    {
+        ++generation_;
+    }
+
+private:
+    struct local_storage
+    {
+        explicit local_storage(long generation)
+            : generation(generation),
+              entries() {}
+        long generation;
+        map_type entries;
+    };
+
+    map_type & local_entries() const
+    {
+        long generation = generation_;
+        local_storage * local = local_.get();
+        if (!local)
+        {
+            local = new local_storage(generation);
+            local_.reset(local);
+        }
+        else if (local->generation != generation)
+        {
+            local->entries.clear();
+            local->generation = generation;
+        }
+        return local->entries;
+    }
+
+    mutable boost::thread_specific_ptr<local_storage> local_;
+    boost::detail::atomic_count generation_;
+};
+
+}
+
+#endif // MAPNIK_THREAD_LOCAL_CACHE_HPP
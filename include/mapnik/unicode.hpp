@@ -46,8 +46,16 @@ public:
     UnicodeString transcode(const char* data, boost::int32_t length = -1) const;
     ~transcoder();
 private:
+    enum fast_path_e {
+        CONVERTER,
+        ASCII,
+        LATIN1,
+        UTF8
+    };
     bool ok_;
     UConverter * conv_;
+    std::string encoding_;
+    fast_path_e fast_path_;
 };
 }
 
@@ -29,6 +29,8 @@
 
 namespace mapnik {
 
+class colorizer_lut;
+
 void reproject_raster(raster &target, raster const& source,
                       proj_transform const& prj_trans,
                       double offset_x, double offset_y,
@@ -37,6 +39,17 @@ void reproject_raster(raster &target, raster const& source,
                       double scale_factor,
                       std::string scaling_method_name);
 
+// Reproject a float32 raster, colorizing the source pixels as they are
+// sampled. The source data is left untouched.
+void reproject_raster(raster &target, raster const& source,
+                      proj_transform const& prj_trans,
+                      double offset_x, double offset_y,
+                      unsigned mesh_size,
+                      double filter_radius,
+                      double scale_factor,
+                      std::string scaling_method_name,
+                      colorizer_lut const& colorizer);
+
 }
 
 #endif // MAPNIK_WARP_HPP
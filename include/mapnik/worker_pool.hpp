@@ -0,0 +1,89 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+#ifndef MAPNIK_WORKER_POOL_HPP
+#define MAPNIK_WORKER_POOL_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/utils.hpp>
+
+// boost
+#include <boost/utility.hpp>
+#include <boost/function.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
+#endif
+
+// stl
+#include <deque>
+#include <vector>
+
+namespace mapnik
+{
+
+/** Threads shared by all renders for work split into parts, like warping
+ * a raster in bands.
+ *
+ * The calling thread runs parts of its own work too and takes back the
+ * parts no pool thread got to, so concurrent renders use at most the pool
+ * threads on top of their own, and a busy pool only makes them serial.
+ * The pool has hardware_concurrency() - 1 threads by default.
+ */
+class MAPNIK_DECL worker_pool :
+        public singleton <worker_pool, CreateStatic>,
+        private boost::noncopyable
+{
+    friend class CreateStatic<worker_pool>;
+public:
+    typedef boost::function<void ()> task;
+
+    // Runs all tasks and returns once they are done. Tasks must not throw.
+    void run(std::vector<task> const& tasks);
+    // 0 runs all tasks on the calling threads
+    void set_threads(unsigned threads);
+    unsigned threads() const;
+private:
+    worker_pool();
+    ~worker_pool();
+#ifdef MAPNIK_THREADSAFE
+    struct batch;
+    void work();
+    bool take(batch & b, std::size_t & index);
+    std::deque<batch*> queue_;
+    mutable boost::mutex queue_mutex_;
+    boost::condition_variable queue_cond_;
+    boost::thread_group workers_;
+    // threads wanted and threads running, extra ones exit when woken
+    unsigned threads_;
+    unsigned running_;
+    bool started_;
+    bool stopping_;
+#endif
+};
+
+}
+
+#endif // MAPNIK_WORKER_POOL_HPP
@@ -40,6 +40,8 @@ plugin_env['LIBS'] = [env['PLUGINS']['gdal']['lib']]
 plugin_env['LIBS'].append('mapnik')
 plugin_env['LIBS'].append('boost_system%s' % env['BOOST_APPEND'])
 plugin_env['LIBS'].append(env['ICU_LIB_NAME'])
+if env['THREADING'] == 'multi':
+    plugin_env['LIBS'].append('boost_thread%s' % env['BOOST_APPEND'])
 
 if env['RUNTIME_LINK'] == 'static':
     cmd = 'gdal-config --dep-libs'
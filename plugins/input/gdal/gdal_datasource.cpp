@@ -30,6 +30,9 @@
 
 #include <gdal_version.h>
 
+// stl
+#include <algorithm>
+
 using mapnik::datasource;
 using mapnik::parameters;
 
@@ -75,11 +78,76 @@ inline GDALDataset* gdal_datasource::open_dataset() const
 }
 
 
+/*
+ * Returns the dataset handle of the current thread, opening it on first use.
+ * GDALDataset handles must not be used by two threads at once, so every
+ * render thread gets its own handle which is then reused by all queries
+ * this datasource gets from that thread. Threads may come and go, so once
+ * there are more handles than max_datasets_ the least recently used ones
+ * no featureset reads from are closed. The rest are closed once the
+ * datasource and the featuresets still reading from them are gone.
+ */
+gdal_dataset_ptr gdal_datasource::thread_dataset() const
+{
+#ifdef MAPNIK_THREADSAFE
+    boost::thread::id const id = boost::this_thread::get_id();
+    {
+        boost::mutex::scoped_lock lock(datasets_mutex_);
+        dataset_map::iterator itr = datasets_.find(id);
+        if (itr != datasets_.end())
+        {
+            itr->second.last_use = ++uses_;
+            return itr->second.dataset;
+        }
+    }
+    // only this thread adds a handle under its id
+    gdal_dataset_ptr dataset(open_dataset(), GDALClose);
+    boost::mutex::scoped_lock lock(datasets_mutex_);
+    thread_handle & handle = datasets_[id];
+    handle.dataset = dataset;
+    handle.last_use = ++uses_;
+    close_idle_datasets();
+    return dataset;
+#else
+    if (! dataset_)
+    {
+        dataset_ = gdal_dataset_ptr(open_dataset(), GDALClose);
+    }
+    return dataset_;
+#endif
+}
+
+#ifdef MAPNIK_THREADSAFE
+// called with datasets_mutex_ held. A handle only the map holds is idle:
+// its thread takes copies under the lock and featuresets keep theirs.
+void gdal_datasource::close_idle_datasets() const
+{
+    while (datasets_.size() > max_datasets_)
+    {
+        dataset_map::iterator oldest = datasets_.end();
+        for (dataset_map::iterator itr = datasets_.begin(); itr != datasets_.end(); ++itr)
+        {
+            if (itr->second.dataset.unique() &&
+                (oldest == datasets_.end() || itr->second.last_use < oldest->second.last_use))
+            {
+                oldest = itr;
+            }
+        }
+        if (oldest == datasets_.end()) break;
+        datasets_.erase(oldest);
+    }
+}
+#endif
+
 gdal_datasource::gdal_datasource(parameters const& params, bool bind)
     : datasource(params),
       desc_(*params.get<std::string>("type"), "utf-8"),
       filter_factor_(*params_.get<double>("filter_factor", 0.0)),
       nodata_value_(params_.get<double>("nodata"))
+#ifdef MAPNIK_THREADSAFE
+    , uses_(0),
+      max_datasets_(std::max(8u, 2 * boost::thread::hardware_concurrency()))
+#endif
 {
 #ifdef MAPNIK_DEBUG
     std::clog << "GDAL Plugin: Initializing..." << std::endl;
@@ -113,7 +181,7 @@ void gdal_datasource::bind() const
     shared_dataset_ = *params_.get<mapnik::boolean>("shared", false);
     band_ = *params_.get<int>("band", -1);
 
-    GDALDataset *dataset = open_dataset();
+    gdal_dataset_ptr dataset = thread_dataset();
 
     nbands_ = dataset->GetRasterCount();
     width_ = dataset->GetRasterXSize();
@@ -186,8 +254,6 @@ void gdal_datasource::bind() const
         extent_.init(x0, y0, x1, y1);
     }
 
-    GDALClose(dataset);
-
 #ifdef MAPNIK_DEBUG
     std::clog << "GDAL Plugin: Raster Size=" << width_ << "," << height_ << std::endl;
     std::clog << "GDAL Plugin: Raster Extent=" << extent_ << std::endl;
@@ -234,7 +300,7 @@ featureset_ptr gdal_datasource::features(query const& q) const
     gdal_query gq = q;
 
     // TODO - move to boost::make_shared, but must reduce # of args to <= 9
-    return featureset_ptr(new gdal_featureset(*open_dataset(),
+    return featureset_ptr(new gdal_featureset(thread_dataset(),
                                               band_,
                                               gq,
                                               extent_,
@@ -254,7 +320,7 @@ featureset_ptr gdal_datasource::features_at_point(coord2d const& pt) const
     gdal_query gq = pt;
 
     // TODO - move to boost::make_shared, but must reduce # of args to <= 9
-    return featureset_ptr(new gdal_featureset(*open_dataset(),
+    return featureset_ptr(new gdal_featureset(thread_dataset(),
                                               band_,
                                               gq,
                                               extent_,
@@ -28,10 +28,19 @@
 
 // boost
 #include <boost/shared_ptr.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#endif
+
+// stl
+#include <map>
 
 // gdal
 #include <gdal_priv.h>
 
+typedef boost::shared_ptr<GDALDataset> gdal_dataset_ptr;
+
 class gdal_datasource : public mapnik::datasource
 {
 public:
@@ -58,7 +67,23 @@ private:
     mutable bool shared_dataset_;
     double filter_factor_;
     boost::optional<double> nodata_value_;
+#ifdef MAPNIK_THREADSAFE
+    struct thread_handle
+    {
+        gdal_dataset_ptr dataset;
+        unsigned long last_use;
+    };
+    typedef std::map<boost::thread::id, thread_handle> dataset_map;
+    mutable dataset_map datasets_;
+    mutable unsigned long uses_;
+    unsigned max_datasets_;
+    mutable boost::mutex datasets_mutex_;
+    void close_idle_datasets() const;
+#else
+    mutable gdal_dataset_ptr dataset_;
+#endif
     inline GDALDataset* open_dataset() const;
+    gdal_dataset_ptr thread_dataset() const;
 };
 
 
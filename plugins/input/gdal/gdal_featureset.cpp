@@ -30,6 +30,10 @@
 // boost
 #include <boost/format.hpp>
 
+// stl
+#include <algorithm>
+#include <cmath>
+
 using mapnik::query;
 using mapnik::coord2d;
 using mapnik::box2d;
@@ -44,7 +48,7 @@ using mapnik::feature_factory;
 using mapnik::rint;
 #endif
 
-gdal_featureset::gdal_featureset(GDALDataset& dataset,
+gdal_featureset::gdal_featureset(gdal_dataset_ptr const& dataset,
                                  int band,
                                  gdal_query q,
                                  mapnik::box2d<double> extent,
@@ -55,7 +59,8 @@ gdal_featureset::gdal_featureset(GDALDataset& dataset,
                                  double dy,
                                  double filter_factor,
                                  boost::optional<double> const& nodata)
-    : dataset_(dataset),
+    : dataset_ptr_(dataset),
+      dataset_(*dataset),
       ctx_(boost::make_shared<mapnik::context_type>()),
       band_(band),
       gquery_(q),
@@ -67,6 +72,7 @@ gdal_featureset::gdal_featureset(GDALDataset& dataset,
       nbands_(nbands),
       filter_factor_(filter_factor),
       nodata_value_(nodata),
+      overview_(-1),
       first_(true)
 {
     ctx_->push("value");
@@ -75,11 +81,7 @@ gdal_featureset::gdal_featureset(GDALDataset& dataset,
 
 gdal_featureset::~gdal_featureset()
 {
-#ifdef MAPNIK_DEBUG
-    std::clog << "GDAL Plugin: closing dataset = " << &dataset_ << std::endl;
-#endif
-
-    GDALClose(&dataset_);
+    // the dataset is owned by the gdal_datasource it came from
 }
 
 feature_ptr gdal_featureset::next()
@@ -228,6 +230,17 @@ feature_ptr gdal_featureset::get_feature(mapnik::query const& q)
             mapnik::image_data_32 image(im_width, im_height);
             image.set(0xffffffff);
 
+            // read from the smallest overview still providing the requested resolution
+            // instead of leaving the choice to the RasterIO resampling heuristics
+            GDALRasterBand * ref_band = dataset_.GetRasterBand(band_ > 0 && band_ <= nbands_ ? band_ : 1);
+            if (ref_band)
+            {
+                overview_ = select_overview(ref_band, width, height, im_width, im_height);
+            }
+#ifdef MAPNIK_DEBUG
+            std::clog << "GDAL Plugin: Using overview " << overview_ << std::endl;
+#endif
+
 #ifdef MAPNIK_DEBUG
             std::clog << "GDAL Plugin: Image Size=(" << im_width << "," << im_height << ")" << std::endl;
             std::clog << "GDAL Plugin: Reading band " << band_ << std::endl;
@@ -254,9 +267,9 @@ feature_ptr gdal_featureset::get_feature(mapnik::query const& q)
                 {
                     nodata = band->GetNoDataValue(&hasNoData);
                 }
-                band->RasterIO(GF_Read, x_off, y_off, width, height,
-                               imageData, image.width(), image.height(),
-                               GDT_Float32, 0, 0);
+                read_band(band, x_off, y_off, width, height,
+                          imageData, image.width(), image.height(),
+                          GDT_Float32, 0, 0);
 
                 feature->set_raster(boost::make_shared<mapnik::raster>(intersect,image));
                 if (hasNoData)
@@ -372,9 +385,9 @@ feature_ptr gdal_featureset::get_feature(mapnik::query const& q)
                     {
                         // first read the data in and create an alpha channel from the nodata values
                         float* imageData = (float*)image.getBytes();
-                        red->RasterIO(GF_Read, x_off, y_off, width, height,
-                                      imageData, image.width(), image.height(),
-                                      GDT_Float32, 0, 0);
+                        read_band(red, x_off, y_off, width, height,
+                                  imageData, image.width(), image.height(),
+                                  GDT_Float32, 0, 0);
 
                         int len = image.width() * image.height();
 
@@ -392,12 +405,12 @@ feature_ptr gdal_featureset::get_feature(mapnik::query const& q)
 
                     }
 
-                    red->RasterIO(GF_Read, x_off, y_off, width, height, image.getBytes() + 0,
-                                  image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
-                    green->RasterIO(GF_Read, x_off, y_off, width, height, image.getBytes() + 1,
-                                    image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
-                    blue->RasterIO(GF_Read, x_off, y_off, width, height, image.getBytes() + 2,
-                                   image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
+                    read_band(red, x_off, y_off, width, height, image.getBytes() + 0,
+                              image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
+                    read_band(green, x_off, y_off, width, height, image.getBytes() + 1,
+                              image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
+                    read_band(blue, x_off, y_off, width, height, image.getBytes() + 2,
+                              image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
                 }
                 else if (grey)
                 {
@@ -428,9 +441,9 @@ feature_ptr gdal_featureset::get_feature(mapnik::query const& q)
 #endif
                         // first read the data in and create an alpha channel from the nodata values
                         float* imageData = (float*)image.getBytes();
-                        grey->RasterIO(GF_Read, x_off, y_off, width, height,
-                                       imageData, image.width(), image.height(),
-                                       GDT_Float32, 0, 0);
+                        read_band(grey, x_off, y_off, width, height,
+                                  imageData, image.width(), image.height(),
+                                  GDT_Float32, 0, 0);
 
                         int len = image.width() * image.height();
 
@@ -447,12 +460,18 @@ feature_ptr gdal_featureset::get_feature(mapnik::query const& q)
                         }
                     }
 
-                    grey->RasterIO(GF_Read, x_off, y_off, width, height, image.getBytes() + 0,
-                                   image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
-                    grey->RasterIO(GF_Read,x_off, y_off, width, height, image.getBytes() + 1,
-                                   image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
-                    grey->RasterIO(GF_Read,x_off, y_off, width, height, image.getBytes() + 2,
-                                   image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
+                    read_band(grey, x_off, y_off, width, height, image.getBytes() + 0,
+                              image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
+
+                    // replicate into green and blue rather than reading the band twice more
+                    for (unsigned y = 0; y < image.height(); ++y)
+                    {
+                        unsigned char * row = reinterpret_cast<unsigned char *>(image.getRow(y));
+                        for (unsigned x = 0; x < image.width(); ++x, row += 4)
+                        {
+                            row[1] = row[2] = row[0];
+                        }
+                    }
 
                     if (color_table)
                     {
@@ -499,8 +518,8 @@ feature_ptr gdal_featureset::get_feature(mapnik::query const& q)
 #ifdef MAPNIK_DEBUG
                     std::clog << "GDAL Plugin: processing alpha band..." << std::endl;
 #endif
-                    alpha->RasterIO(GF_Read, x_off, y_off, width, height, image.getBytes() + 3,
-                                    image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
+                    read_band(alpha, x_off, y_off, width, height, image.getBytes() + 3,
+                              image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
                 }
 
                 feature->set_raster(mapnik::raster_ptr(new mapnik::raster(intersect, image)));
@@ -558,6 +577,53 @@ feature_ptr gdal_featureset::get_feature_at_point(mapnik::coord2d const& pt)
     return feature_ptr();
 }
 
+int gdal_featureset::select_overview(GDALRasterBand * band, int width, int height,
+                                     int im_width, int im_height) const
+{
+    int overview = -1;
+    int overview_width = raster_width_;
+    int count = band->GetOverviewCount();
+    for (int i = 0; i < count; ++i)
+    {
+        GDALRasterBand * ov = band->GetOverview(i);
+        if (! ov) continue;
+        // size of the requested window in overview pixels
+        double ov_window_width = width * double(ov->GetXSize()) / raster_width_;
+        double ov_window_height = height * double(ov->GetYSize()) / raster_height_;
+        if (ov_window_width >= im_width && ov_window_height >= im_height &&
+            ov->GetXSize() < overview_width)
+        {
+            overview = i;
+            overview_width = ov->GetXSize();
+        }
+    }
+    return overview;
+}
+
+CPLErr gdal_featureset::read_band(GDALRasterBand * band, int x_off, int y_off, int width, int height,
+                                  void * data, int buf_width, int buf_height, GDALDataType type,
+                                  int pixel_space, int line_space) const
+{
+    GDALRasterBand * ov = (overview_ >= 0) ? band->GetOverview(overview_) : 0;
+    if (ov)
+    {
+        // map the full resolution window onto the overview
+        double scale_x = double(ov->GetXSize()) / raster_width_;
+        double scale_y = double(ov->GetYSize()) / raster_height_;
+        int ov_x_off = static_cast<int>(x_off * scale_x);
+        int ov_y_off = static_cast<int>(y_off * scale_y);
+        int ov_end_x = std::min(ov->GetXSize(), static_cast<int>(std::ceil((x_off + width) * scale_x)));
+        int ov_end_y = std::min(ov->GetYSize(), static_cast<int>(std::ceil((y_off + height) * scale_y)));
+        if (ov_end_x > ov_x_off && ov_end_y > ov_y_off)
+        {
+            return ov->RasterIO(GF_Read, ov_x_off, ov_y_off, ov_end_x - ov_x_off, ov_end_y - ov_y_off,
+                                data, buf_width, buf_height, type, pixel_space, line_space);
+        }
+    }
+    return band->RasterIO(GF_Read, x_off, y_off, width, height,
+                          data, buf_width, buf_height, type, pixel_space, line_space);
+}
+
 #ifdef MAPNIK_DEBUG
 void gdal_featureset::get_overview_meta(GDALRasterBand* band)
 {
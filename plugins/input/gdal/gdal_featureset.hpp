@@ -30,16 +30,18 @@
 // boost
 #include <boost/variant.hpp>
 #include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
 
-class GDALDataset;
-class GDALRasterBand;
+// gdal
+#include <gdal_priv.h>
 
 typedef boost::variant<mapnik::query, mapnik::coord2d> gdal_query;
+typedef boost::shared_ptr<GDALDataset> gdal_dataset_ptr;
 
 class gdal_featureset : public mapnik::Featureset
 {
 public:
-    gdal_featureset(GDALDataset& dataset,
+    gdal_featureset(gdal_dataset_ptr const& dataset,
                     int band,
                     gdal_query q,
                     mapnik::box2d<double> extent,
@@ -55,9 +57,14 @@ public:
 private:
     mapnik::feature_ptr get_feature(mapnik::query const& q);
     mapnik::feature_ptr get_feature_at_point(mapnik::coord2d const& p);
+    int select_overview(GDALRasterBand * band, int width, int height, int im_width, int im_height) const;
+    CPLErr read_band(GDALRasterBand * band, int x_off, int y_off, int width, int height,
+                     void * data, int buf_width, int buf_height, GDALDataType type,
+                     int pixel_space, int line_space) const;
 #ifdef MAPNIK_DEBUG
     void get_overview_meta(GDALRasterBand * band);
 #endif
+    gdal_dataset_ptr dataset_ptr_;
     GDALDataset & dataset_;
     mapnik::context_ptr ctx_;
     int band_;
@@ -70,6 +77,7 @@ private:
     int nbands_;
     double filter_factor_;
     boost::optional<double> nodata_value_;
+    int overview_;
     bool first_;
 };
 
@@ -36,6 +36,17 @@ using mapnik::feature_ptr;
 using mapnik::geometry_utils;
 using mapnik::geometry_type;
 
+namespace {
+
+bool part_intersects(OGRGeometry* geom, mapnik::box2d<double> const& bbox)
+{
+    OGREnvelope envelope;
+    geom->getEnvelope(&envelope);
+    return bbox.intersects(mapnik::box2d<double>(envelope.MinX, envelope.MinY, envelope.MaxX, envelope.MaxY));
+}
+
+}
+
 void ogr_converter::convert_geometry(OGRGeometry* geom, feature_ptr feature)
 {
     // NOTE: wkbFlatten macro in ogr flattens 2.5d types into base 2d type
@@ -76,6 +87,103 @@ void ogr_converter::convert_geometry(OGRGeometry* geom, feature_ptr feature)
     }
 }
 
+void ogr_converter::convert_geometry(OGRGeometry* geom, feature_ptr feature, mapnik::box2d<double> const& bbox)
+{
+    switch (wkbFlatten(geom->getGeometryType()))
+    {
+    case wkbMultiPoint:
+    case wkbMultiLineString:
+    case wkbMultiPolygon:
+    case wkbGeometryCollection:
+    {
+        OGRGeometryCollection* collection = static_cast<OGRGeometryCollection*>(geom);
+        int num_geometries = collection->getNumGeometries();
+        for (int i = 0; i < num_geometries; i++)
+        {
+            OGRGeometry* g = collection->getGeometryRef(i);
+            if (g != NULL && ! g->IsEmpty() && part_intersects(g, bbox))
+            {
+                convert_geometry(g, feature, bbox);
+            }
+        }
+        break;
+    }
+    default:
+        convert_geometry(geom, feature);
+        break;
+    }
+}
+
+void ogr_converter::convert_fields(OGRFeature* feat, std::vector<ogr_field> const& fields,
+                                   mapnik::transcoder const& tr, feature_ptr feature)
+{
+    std::vector<ogr_field>::const_iterator itr = fields.begin();
+    std::vector<ogr_field>::const_iterator end = fields.end();
+    for (; itr != end; ++itr)
+    {
+        switch (itr->type)
+        {
+        case OFTInteger:
+        {
+            feature->put(itr->name, feat->GetFieldAsInteger(itr->index));
+            break;
+        }
+
+        case OFTReal:
+        {
+            feature->put(itr->name, feat->GetFieldAsDouble(itr->index));
+            break;
+        }
+
+        case OFTString:
+        case OFTWideString:     // deprecated !
+        {
+            UnicodeString ustr = tr.transcode(feat->GetFieldAsString(itr->index));
+            feature->put(itr->name, ustr);
+            break;
+        }
+
+        case OFTIntegerList:
+        case OFTRealList:
+        case OFTStringList:
+        case OFTWideStringList: // deprecated !
+        {
+#ifdef MAPNIK_DEBUG
+            std::clog << "OGR Plugin: unhandled type_oid=" << itr->type << std::endl;
+#endif
+            break;
+        }
+
+        case OFTBinary:
+        {
+#ifdef MAPNIK_DEBUG
+            std::clog << "OGR Plugin: unhandled type_oid=" << itr->type << std::endl;
+#endif
+            //feature->put(name,feat->GetFieldAsBinary (i, size));
+            break;
+        }
+
+        case OFTDate:
+        case OFTTime:
+        case OFTDateTime:       // unhandled !
+        {
+#ifdef MAPNIK_DEBUG
+            std::clog << "OGR Plugin: unhandled type_oid=" << itr->type << std::endl;
+#endif
+            break;
+        }
+
+        default: // unknown
+        {
+#ifdef MAPNIK_DEBUG
+            std::clog << "OGR Plugin: unknown type_oid=" << itr->type << std::endl;
+#endif
+            break;
+        }
+        }
+    }
+}
+
 void ogr_converter::convert_point(OGRPoint* geom, feature_ptr feature)
 {
     geometry_type * point = new geometry_type(mapnik::Point);
@@ -25,15 +25,33 @@
 
 // mapnik
 #include <mapnik/datasource.hpp>
+#include <mapnik/unicode.hpp>
+
+// stl
+#include <string>
+#include <vector>
 
 // ogr
 #include <ogrsf_frmts.h>
 
+// a layer field selected by the query, resolved once per featureset
+struct ogr_field
+{
+    int index;
+    OGRFieldType type;
+    std::string name;
+};
+
 class ogr_converter
 {
 public:
 
     static void convert_geometry (OGRGeometry* geom, mapnik::feature_ptr feature);
+    // as above, but parts of multi geometries and collections outside the
+    // bbox are not converted
+    static void convert_geometry (OGRGeometry* geom, mapnik::feature_ptr feature, mapnik::box2d<double> const& bbox);
+    static void convert_fields (OGRFeature* feat, std::vector<ogr_field> const& fields,
+                                mapnik::transcoder const& tr, mapnik::feature_ptr feature);
     static void convert_collection (OGRGeometryCollection* geom, mapnik::feature_ptr feature);
     static void convert_point (OGRPoint* geom, mapnik::feature_ptr feature);
     static void convert_linestring (OGRLineString* geom, mapnik::feature_ptr feature);
@@ -29,6 +29,7 @@
 #include "ogr_featureset.hpp"
 #include "ogr_index_featureset.hpp"
 #include "ogr_feature_ptr.hpp"
+#include "ogr_index.hpp"
 
 #include <gdal_version.h>
 
@@ -61,7 +62,8 @@ ogr_datasource::ogr_datasource(parameters const& params, bool bind)
       extent_(),
       type_(datasource::Vector),
       desc_(*params_.get<std::string>("type"), *params_.get<std::string>("encoding", "utf-8")),
-      indexed_(false)
+      indexed_(false),
+      build_index_(*params_.get<mapnik::boolean>("build_index", true))
 {
     boost::optional<std::string> file = params.get<std::string>("file");
     boost::optional<std::string> string = params.get<std::string>("string");
@@ -242,7 +244,8 @@ void ogr_datasource::bind() const
     layer->GetExtent(&envelope);
     extent_.init(envelope.MinX, envelope.MinY, envelope.MaxX, envelope.MaxY);
 
-    // scan for index file
+    // scan for index file, without one an index is built in memory on
+    // first use (see memory_index())
     // TODO - layer names don't match dataset name, so this will break for
     // any layer types of ogr than shapefiles, etc
     // fix here and in ogrindex
@@ -259,6 +262,12 @@ void ogr_datasource::bind() const
         indexed_ = true;
         index_file.close();
     }
+
+    // results of sql layers have no stable feature ids
+    if (layer_by_sql)
+    {
+        build_index_ = false;
+    }
 #if 0
     // TODO - enable this warning once the ogrindex tool is a bit more stable/mature
     else
@@ -460,6 +469,66 @@ void validate_attribute_names(query const& q, std::vector<attribute_descriptor>
     }
 }
 
+std::vector<ogr_field> ogr_datasource::select_fields(std::set<std::string> const* names) const
+{
+    // select the fields to convert and let ogr skip reading the rest;
+    // NULL names selects every field
+    std::vector<ogr_field> fields;
+    std::vector<std::string> ignored;
+    OGRFeatureDefn* def = layer_.layer()->GetLayerDefn();
+    const int fld_count = def->GetFieldCount();
+    for (int i = 0; i < fld_count; ++i)
+    {
+        OGRFieldDefn* fld = def->GetFieldDefn(i);
+        ogr_field field;
+        field.index = i;
+        field.type = fld->GetType();
+        field.name = fld->GetNameRef();
+        if (! names || names->find(field.name) != names->end())
+        {
+            fields.push_back(field);
+        }
+        else
+        {
+            ignored.push_back(field.name);
+        }
+    }
+
+#if GDAL_VERSION_NUM >= 1800
+    if (layer_.layer()->TestCapability(OLCIgnoreFields))
+    {
+        std::vector<const char*> list;
+        for (unsigned i = 0; i < ignored.size(); ++i)
+        {
+            list.push_back(ignored[i].c_str());
+        }
+        list.push_back("OGR_STYLE");
+        list.push_back(NULL);
+        layer_.layer()->SetIgnoredFields(&list[0]);
+    }
+#endif
+    return fields;
+}
+
+ogr_memory_index* ogr_datasource::memory_index() const
+{
+    if (build_index_ && ! memory_index_)
+    {
+        // scan once, reading nothing but the geometries
+        build_index_ = false;
+        std::set<std::string> no_fields;
+        select_fields(&no_fields);
+        memory_index_ = ogr_memory_index::build(*layer_.layer(), extent_);
+#ifdef MAPNIK_DEBUG
+        if (memory_index_)
+        {
+            std::clog << "OGR Plugin: indexed " << memory_index_->size() << " features in memory" << std::endl;
+        }
+#endif
+    }
+    return memory_index_.get();
+}
+
 featureset_ptr ogr_datasource::features(query const& q) const
 {
     if (! is_bound_) bind();
@@ -472,24 +541,37 @@ featureset_ptr ogr_datasource::features(query const& q) const
         // feature context (schema)
         mapnik::context_ptr ctx = boost::make_shared<mapnik::context_type>();
 
-        std::vector<attribute_descriptor>::const_iterator itr = desc_ar.begin();
-        std::vector<attribute_descriptor>::const_iterator end = desc_ar.end();
-
-        for (; itr!=end; ++itr) ctx->push(itr->get_name()); // TODO only push query attributes
-
         validate_attribute_names(q, desc_ar);
 
+        std::set<std::string> const& names = q.property_names();
+        std::set<std::string>::const_iterator pos = names.begin();
+        std::set<std::string>::const_iterator end = names.end();
+        for (; pos != end; ++pos) ctx->push(*pos);
+
         OGRLayer* layer = layer_.layer();
+        ogr_memory_index* index = indexed_ ? NULL : memory_index();
+        std::vector<ogr_field> fields = select_fields(&names);
+        filter_in_box filter(q.get_bbox());
 
         if (indexed_)
         {
-            filter_in_box filter(q.get_bbox());
-
             return featureset_ptr(new ogr_index_featureset<filter_in_box>(ctx,
                                                                           *dataset_,
                                                                           *layer,
                                                                           filter,
                                                                           index_name_,
+                                                                          fields,
+                                                                          desc_.get_encoding()
+                                      ));
+        }
+        else if (index)
+        {
+            return featureset_ptr(new ogr_index_featureset<filter_in_box>(ctx,
+                                                                          *dataset_,
+                                                                          *layer,
+                                                                          filter,
+                                                                          *index,
+                                                                          fields,
                                                                           desc_.get_encoding()
                                       ));
         }
@@ -499,6 +581,7 @@ featureset_ptr ogr_datasource::features(query const& q) const
                                                       *dataset_,
                                                       *layer,
                                                       q.get_bbox(),
+                                                      fields,
                                                       desc_.get_encoding()
                                       ));
         }
@@ -522,16 +605,29 @@ featureset_ptr ogr_datasource::features_at_point(coord2d const& pt) const
         for (; itr!=end; ++itr) ctx->push(itr->get_name());
 
         OGRLayer* layer = layer_.layer();
+        ogr_memory_index* index = indexed_ ? NULL : memory_index();
+        std::vector<ogr_field> fields = select_fields(NULL);
+        filter_at_point filter(pt);
 
         if (indexed_)
         {
-            filter_at_point filter(pt);
-
             return featureset_ptr(new ogr_index_featureset<filter_at_point> (ctx,
                                                                              *dataset_,
                                                                              *layer,
                                                                              filter,
                                                                              index_name_,
+                                                                             fields,
+                                                                             desc_.get_encoding()
+                                      ));
+        }
+        else if (index)
+        {
+            return featureset_ptr(new ogr_index_featureset<filter_at_point> (ctx,
+                                                                             *dataset_,
+                                                                             *layer,
+                                                                             filter,
+                                                                             *index,
+                                                                             fields,
                                                                              desc_.get_encoding()
                                       ));
         }
@@ -545,6 +641,7 @@ featureset_ptr ogr_datasource::features_at_point(coord2d const& pt) const
                                                       *dataset_,
                                                       *layer,
                                                       point,
+                                                      fields,
                                                       desc_.get_encoding()
                                       ));
         }
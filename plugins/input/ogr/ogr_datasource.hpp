@@ -31,10 +31,18 @@
 // boost
 #include <boost/shared_ptr.hpp>
 
+// stl
+#include <set>
+#include <string>
+#include <vector>
+
 // ogr
 #include <ogrsf_frmts.h>
 
 #include "ogr_layer_ptr.hpp"
+#include "ogr_converter.hpp"
+
+class ogr_memory_index;
 
 class ogr_datasource : public mapnik::datasource
 {
@@ -60,6 +68,11 @@ private:
     mutable std::string layer_name_;
     mutable mapnik::layer_descriptor desc_;
     mutable bool indexed_;
+    mutable bool build_index_;
+    mutable boost::shared_ptr<ogr_memory_index> memory_index_;
+
+    std::vector<ogr_field> select_fields(std::set<std::string> const* names) const;
+    ogr_memory_index* memory_index() const;
 };
 
 #endif // OGR_DATASOURCE_HPP
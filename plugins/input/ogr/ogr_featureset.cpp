@@ -50,14 +50,18 @@ ogr_featureset::ogr_featureset(mapnik::context_ptr const & ctx,
                                OGRDataSource & dataset,
                                OGRLayer & layer,
                                OGRGeometry & extent,
+                               std::vector<ogr_field> const& fields,
                                std::string const& encoding)
     : ctx_(ctx),
       dataset_(dataset),
       layer_(layer),
       layerdef_(layer.GetLayerDefn()),
+      fields_(fields),
       tr_(new transcoder(encoding)),
       fidcolumn_(layer_.GetFIDColumn ()),
-      count_(0)
+      count_(0),
+      extent_(),
+      filter_parts_(false)
 
 {
     layer_.SetSpatialFilter (&extent);
@@ -67,14 +71,18 @@ ogr_featureset::ogr_featureset(mapnik::context_ptr const& ctx,
                                OGRDataSource & dataset,
                                OGRLayer & layer,
                                mapnik::box2d<double> const& extent,
+                               std::vector<ogr_field> const& fields,
                                std::string const& encoding)
     : ctx_(ctx),
       dataset_(dataset),
       layer_(layer),
       layerdef_(layer.GetLayerDefn()),
+      fields_(fields),
       tr_(new transcoder(encoding)),
       fidcolumn_(layer_.GetFIDColumn()),
-      count_(0)
+      count_(0),
+      extent_(extent),
+      filter_parts_(true)
 {
     layer_.SetSpatialFilterRect (extent.minx(),
                                  extent.miny(),
@@ -100,7 +108,14 @@ feature_ptr ogr_featureset::next()
         OGRGeometry* geom = (*feat)->GetGeometryRef();
         if (geom && ! geom->IsEmpty())
         {
-            ogr_converter::convert_geometry(geom, feature);
+            if (filter_parts_)
+            {
+                ogr_converter::convert_geometry(geom, feature, extent_);
+            }
+            else
+            {
+                ogr_converter::convert_geometry(geom, feature);
+            }
         }
 #ifdef MAPNIK_DEBUG
         else
@@ -111,74 +126,7 @@ feature_ptr ogr_featureset::next()
 #endif
         ++count_;
 
-        int fld_count = layerdef_->GetFieldCount();
-        for (int i = 0; i < fld_count; i++)
-        {
-            OGRFieldDefn* fld = layerdef_->GetFieldDefn(i);
-            const OGRFieldType type_oid = fld->GetType();
-            const std::string fld_name = fld->GetNameRef();
-
-            switch (type_oid)
-            {
-            case OFTInteger:
-            {
-                feature->put( fld_name, (*feat)->GetFieldAsInteger(i));
-                break;
-            }
-
-            case OFTReal:
-            {
-                feature->put( fld_name, (*feat)->GetFieldAsDouble(i));
-                break;
-            }
-
-            case OFTString:
-            case OFTWideString:     // deprecated !
-            {
-                UnicodeString ustr = tr_->transcode((*feat)->GetFieldAsString(i));
-                feature->put( fld_name, ustr);
-                break;
-            }
-
-            case OFTIntegerList:
-            case OFTRealList:
-            case OFTStringList:
-            case OFTWideStringList: // deprecated !
-            {
-#ifdef MAPNIK_DEBUG
-                std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
-#endif
-                break;
-            }
-
-            case OFTBinary:
-            {
-#ifdef MAPNIK_DEBUG
-                std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
-#endif
-                //feature->put(name,feat->GetFieldAsBinary (i, size));
-                break;
-            }
-
-            case OFTDate:
-            case OFTTime:
-            case OFTDateTime:       // unhandled !
-            {
-#ifdef MAPNIK_DEBUG
-                std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
-#endif
-                break;
-            }
-
-            default: // unknown
-            {
-#ifdef MAPNIK_DEBUG
-                std::clog << "OGR Plugin: unknown type_oid=" << type_oid << std::endl;
-#endif
-                break;
-            }
-            }
-        }
+        ogr_converter::convert_fields(*feat, fields_, *tr_, feature);
         return feature;
     }
 
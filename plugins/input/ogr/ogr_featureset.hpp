@@ -34,6 +34,8 @@
 // ogr
 #include <ogrsf_frmts.h>
 
+#include "ogr_converter.hpp"
+
 class ogr_featureset : public mapnik::Featureset
 {
 public:
@@ -41,12 +43,14 @@ public:
                    OGRDataSource & dataset,
                    OGRLayer & layer,
                    OGRGeometry & extent,
+                   std::vector<ogr_field> const& fields,
                    std::string const& encoding);
 
     ogr_featureset(mapnik::context_ptr const& ctx,
                    OGRDataSource & dataset,
                    OGRLayer & layer,
                    mapnik::box2d<double> const& extent,
+                   std::vector<ogr_field> const& fields,
                    std::string const& encoding);
 
     virtual ~ogr_featureset();
@@ -57,9 +61,12 @@ private:
     OGRDataSource& dataset_;
     OGRLayer& layer_;
     OGRFeatureDefn* layerdef_;
+    std::vector<ogr_field> fields_;
     boost::scoped_ptr<mapnik::transcoder> tr_;
     const char* fidcolumn_;
     mutable int count_;
+    mapnik::box2d<double> extent_;
+    bool filter_parts_;
 
 };
 
@@ -26,9 +26,19 @@
 // st
 #include <fstream>
 #include <vector>
+#include <algorithm>
 // mapnik
 #include <mapnik/box2d.hpp>
 #include <mapnik/query.hpp>
+#include <mapnik/quad_tree.hpp>
+#include <mapnik/geom_util.hpp>
+// boost
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+// ogr
+#include <ogrsf_frmts.h>
+
+#include "ogr_feature_ptr.hpp"
 
 using mapnik::box2d;
 using mapnik::query;
@@ -37,7 +47,7 @@ template <typename filterT, typename IStream = std::ifstream>
 class ogr_index
 {
 public:
-    static void query(const filterT& filter, IStream& file, std::vector<int>& pos);
+    static void query(const filterT& filter, IStream& file, std::vector<long>& pos);
 private:
     ogr_index();
     ~ogr_index();
@@ -45,18 +55,18 @@ private:
     ogr_index& operator=(const ogr_index&);
     static int read_ndr_integer(IStream& in);
     static void read_envelope(IStream& in, box2d<double>& envelope);
-    static void query_node(const filterT& filter, IStream& in, std::vector<int>& pos);
+    static void query_node(const filterT& filter, IStream& in, std::vector<long>& pos);
 };
 
 template <typename filterT, typename IStream>
-void ogr_index<filterT, IStream>::query(const filterT& filter,IStream & file,std::vector<int>& pos)
+void ogr_index<filterT, IStream>::query(const filterT& filter,IStream & file,std::vector<long>& pos)
 {
     file.seekg(16,std::ios::beg);
     query_node(filter,file,pos);
 }
 
 template <typename filterT, typename IStream>
-void ogr_index<filterT,IStream>::query_node(const filterT& filter, IStream& file, std::vector<int>& ids)
+void ogr_index<filterT,IStream>::query_node(const filterT& filter, IStream& file, std::vector<long>& ids)
 {
     const int offset = read_ndr_integer(file);
 
@@ -101,4 +111,95 @@ void ogr_index<filterT, IStream>::read_envelope(IStream& file, box2d<double>& en
     file.read(reinterpret_cast<char*>(&envelope), sizeof(envelope));
 }
 
+// In-memory counterpart of the .ogrindex file, built by scanning the layer
+// once when no index file exists. It holds feature ids rather than read
+// positions, so features are fetched with random reads.
+class ogr_memory_index : private boost::noncopyable
+{
+public:
+    static boost::shared_ptr<ogr_memory_index> build(OGRLayer& layer, box2d<double> const& extent)
+    {
+        boost::shared_ptr<ogr_memory_index> index;
+        if (! layer.TestCapability(OLCRandomRead))
+        {
+            return index;
+        }
+
+        index.reset(new ogr_memory_index(extent));
+        layer.SetSpatialFilter(NULL);
+        layer.ResetReading();
+        OGRFeature* next;
+        while ((next = layer.GetNextFeature()) != NULL)
+        {
+            ogr_feature_ptr feat(next);
+            OGRGeometry* geom = (*feat)->GetGeometryRef();
+            if (! geom || geom->IsEmpty())
+            {
+                continue;
+            }
+            if ((*feat)->GetFID() == OGRNullFID)
+            {
+                // no stable ids to read the features back with
+                index.reset();
+                break;
+            }
+            OGREnvelope envelope;
+            geom->getEnvelope(&envelope);
+            entry e;
+            e.fid = (*feat)->GetFID();
+            e.box.init(envelope.MinX, envelope.MinY, envelope.MaxX, envelope.MaxY);
+            index->tree_.insert(e, e.box);
+            ++index->size_;
+        }
+        layer.ResetReading();
+        return index;
+    }
+
+    template <typename filterT>
+    void query(filterT const& filter, std::vector<long>& fids)
+    {
+        fids.clear();
+        box2d<double> box = query_box(filter);
+        mapnik::quad_tree<entry>::query_iterator itr = tree_.query_in_box(box);
+        mapnik::quad_tree<entry>::query_iterator end = tree_.query_end();
+        for (; itr != end; ++itr)
+        {
+            if (filter.pass(itr->box))
+            {
+                fids.push_back(itr->fid);
+            }
+        }
+        std::sort(fids.begin(), fids.end());
+    }
+
+    unsigned size() const
+    {
+        return size_;
+    }
+
+private:
+    struct entry
+    {
+        long fid;
+        box2d<double> box;
+    };
+
+    explicit ogr_memory_index(box2d<double> const& extent)
+        : tree_(extent),
+          size_(0) {}
+
+    static box2d<double> query_box(mapnik::filter_in_box const& filter)
+    {
+        return filter.box_;
+    }
+
+    static box2d<double> query_box(mapnik::filter_at_point const& filter)
+    {
+        return box2d<double>(filter.pt_, filter.pt_);
+    }
+
+    mapnik::quad_tree<entry> tree_;
+    unsigned size_;
+};
+
 #endif // OGR_INDEX_HH
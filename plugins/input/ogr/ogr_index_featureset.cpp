@@ -51,20 +51,37 @@ using mapnik::geometry_utils;
 using mapnik::transcoder;
 using mapnik::feature_factory;
 
+namespace {
+
+void convert_geometry(OGRGeometry* geom, feature_ptr feature, mapnik::filter_in_box const& filter)
+{
+    ogr_converter::convert_geometry(geom, feature, filter.box_);
+}
+
+void convert_geometry(OGRGeometry* geom, feature_ptr feature, mapnik::filter_at_point const&)
+{
+    ogr_converter::convert_geometry(geom, feature);
+}
+
+}
+
 template <typename filterT>
 ogr_index_featureset<filterT>::ogr_index_featureset(mapnik::context_ptr const & ctx,
                                                     OGRDataSource & dataset,
                                                     OGRLayer & layer,
                                                     filterT const& filter,
                                                     std::string const& index_file,
+                                                    std::vector<ogr_field> const& fields,
                                                     std::string const& encoding)
     : ctx_(ctx),
       dataset_(dataset),
       layer_(layer),
       layerdef_(layer.GetLayerDefn()),
+      fields_(fields),
       filter_(filter),
       tr_(new transcoder(encoding)),
-      fidcolumn_(layer_.GetFIDColumn())
+      fidcolumn_(layer_.GetFIDColumn()),
+      by_fid_(false)
 {
 
     boost::optional<mapnik::mapped_region_ptr> memory = mapnik::mapped_memory_cache::find(index_file.c_str(),true);
@@ -82,10 +99,40 @@ ogr_index_featureset<filterT>::ogr_index_featureset(mapnik::context_ptr const &
 
     itr_ = ids_.begin();
 
+    // positions count from the unfiltered layer
+    layer_.SetSpatialFilter(NULL);
+
     // reset reading
     layer_.ResetReading();
 }
 
+template <typename filterT>
+ogr_index_featureset<filterT>::ogr_index_featureset(mapnik::context_ptr const & ctx,
+                                                    OGRDataSource & dataset,
+                                                    OGRLayer & layer,
+                                                    filterT const& filter,
+                                                    ogr_memory_index& index,
+                                                    std::vector<ogr_field> const& fields,
+                                                    std::string const& encoding)
+    : ctx_(ctx),
+      dataset_(dataset),
+      layer_(layer),
+      layerdef_(layer.GetLayerDefn()),
+      fields_(fields),
+      filter_(filter),
+      tr_(new transcoder(encoding)),
+      fidcolumn_(layer_.GetFIDColumn()),
+      by_fid_(true)
+{
+    index.query(filter, ids_);
+
+#ifdef MAPNIK_DEBUG
+    std::clog << "OGR Plugin: query size=" << ids_.size() << std::endl;
+#endif
+
+    itr_ = ids_.begin();
+}
+
 template <typename filterT>
 ogr_index_featureset<filterT>::~ogr_index_featureset() {}
 
@@ -94,10 +141,19 @@ feature_ptr ogr_index_featureset<filterT>::next()
 {
     if (itr_ != ids_.end())
     {
-        int pos = *itr_++;
-        layer_.SetNextByIndex (pos);
+        long pos = *itr_++;
+        OGRFeature* next = NULL;
+        if (by_fid_)
+        {
+            next = layer_.GetFeature(pos);
+        }
+        else
+        {
+            layer_.SetNextByIndex(pos);
+            next = layer_.GetNextFeature();
+        }
 
-        ogr_feature_ptr feat (layer_.GetNextFeature());
+        ogr_feature_ptr feat (next);
         if ((*feat) != NULL)
         {
             // ogr feature ids start at 0, so add one to stay
@@ -108,7 +164,7 @@ feature_ptr ogr_index_featureset<filterT>::next()
             OGRGeometry* geom=(*feat)->GetGeometryRef();
             if (geom && !geom->IsEmpty())
             {
-                ogr_converter::convert_geometry (geom, feature);
+                convert_geometry(geom, feature, filter_);
             }
 #ifdef MAPNIK_DEBUG
             else
@@ -117,66 +173,7 @@ feature_ptr ogr_index_featureset<filterT>::next()
             }
 #endif
 
-            int fld_count = layerdef_->GetFieldCount();
-            for (int i = 0; i < fld_count; i++)
-            {
-                OGRFieldDefn* fld = layerdef_->GetFieldDefn (i);
-                OGRFieldType type_oid = fld->GetType ();
-                std::string fld_name = fld->GetNameRef ();
-
-                switch (type_oid)
-                {
-                case OFTInteger:
-                {
-                    feature->put(fld_name,(*feat)->GetFieldAsInteger (i));
-                    break;
-                }
-
-                case OFTReal:
-                {
-                    feature->put(fld_name,(*feat)->GetFieldAsDouble (i));
-                    break;
-                }
-
-                case OFTString:
-                case OFTWideString:     // deprecated !
-                {
-                    UnicodeString ustr = tr_->transcode((*feat)->GetFieldAsString (i));
-                    feature->put(fld_name,ustr);
-                    break;
-                }
-
-                case OFTIntegerList:
-                case OFTRealList:
-                case OFTStringList:
-                case OFTWideStringList: // deprecated !
-                {
-#ifdef MAPNIK_DEBUG
-                    std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
-#endif
-                    break;
-                }
-
-                case OFTBinary:
-                {
-#ifdef MAPNIK_DEBUG
-                    std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
-#endif
-                    //feature->put(name,feat->GetFieldAsBinary (i, size));
-                    break;
-                }
-
-                case OFTDate:
-                case OFTTime:
-                case OFTDateTime:       // unhandled !
-                {
-#ifdef MAPNIK_DEBUG
-                    std::clog << "OGR Plugin: unhandled type_oid=" << type_oid << std::endl;
-#endif
-                    break;
-                }
-                }
-            }
+            ogr_converter::convert_fields(*feat, fields_, *tr_, feature);
             return feature;
         }
     }
@@ -28,6 +28,8 @@
 #include <boost/scoped_ptr.hpp>
 #include "ogr_featureset.hpp"
 
+class ogr_memory_index;
+
 template <typename filterT>
 class ogr_index_featureset : public mapnik::Featureset
 {
@@ -37,6 +39,15 @@ public:
                          OGRLayer& layer,
                          filterT const& filter,
                          std::string const& index_file,
+                         std::vector<ogr_field> const& fields,
+                         std::string const& encoding);
+
+    ogr_index_featureset(mapnik::context_ptr const& ctx,
+                         OGRDataSource& dataset,
+                         OGRLayer& layer,
+                         filterT const& filter,
+                         ogr_memory_index& index,
+                         std::vector<ogr_field> const& fields,
                          std::string const& encoding);
 
     virtual ~ogr_index_featureset();
@@ -47,11 +58,13 @@ private:
     OGRDataSource& dataset_;
     OGRLayer& layer_;
     OGRFeatureDefn* layerdef_;
+    std::vector<ogr_field> fields_;
     filterT filter_;
-    std::vector<int> ids_;
-    std::vector<int>::iterator itr_;
+    std::vector<long> ids_;
+    std::vector<long>::iterator itr_;
     boost::scoped_ptr<mapnik::transcoder> tr_;
     const char* fidcolumn_;
+    bool by_fid_;
 
 };
 
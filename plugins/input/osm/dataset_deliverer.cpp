@@ -23,71 +23,95 @@
 #include <mapnik/datasource.hpp>
 #include <boost/filesystem/operations.hpp>
 #include "dataset_deliverer.h"
-#include "basiccurl.h"
-#include <sstream>
+#include <iostream>
 
-osm_dataset * dataset_deliverer::dataset = NULL;
-std::string dataset_deliverer::last_bbox = "";
-std::string dataset_deliverer::last_filename = "";
+std::map<std::string, boost::weak_ptr<osm_dataset> > dataset_deliverer::datasets_;
+#ifdef MAPNIK_THREADSAFE
+boost::mutex dataset_deliverer::mutex_;
+#endif
 
-osm_dataset* dataset_deliverer::load_from_file(const string& file, const string& parser)
+dataset_deliverer::dataset_ptr dataset_deliverer::find(const std::string& key)
 {
-    // Only actually load from file if we haven't done so already
-    if (dataset == NULL)
-    {
-        if (!boost::filesystem::exists(file))
-        {
-            throw mapnik::datasource_exception("OSM Plugin: '" + file + "' does not exist");
-        }
-
-        dataset = new osm_dataset;
-        if (dataset->load(file.c_str(), parser) == false)
-        {
-            return NULL;
-        }
-
-        atexit(dataset_deliverer::release);
-        last_filename = file;
-    }
-    else if(file != last_filename)
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex::scoped_lock lock(mutex_);
+#endif
+    std::map<std::string, boost::weak_ptr<osm_dataset> >::iterator itr = datasets_.find(key);
+    if (itr != datasets_.end())
     {
-        dataset = new osm_dataset;
-        if (dataset->load(file.c_str(), parser) == false)
-        {
-            return NULL;
-        }
-        last_filename = file;
+        dataset_ptr dataset = itr->second.lock();
+        if (dataset) return dataset;
+        datasets_.erase(itr);
     }
+    return dataset_ptr();
+}
+
+dataset_deliverer::dataset_ptr dataset_deliverer::insert(const std::string& key, dataset_ptr dataset)
+{
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex::scoped_lock lock(mutex_);
+#endif
+    // datasets are loaded without holding the lock, so another thread may
+    // have finished the same one first
+    boost::weak_ptr<osm_dataset>& entry = datasets_[key];
+    dataset_ptr existing = entry.lock();
+    if (existing) return existing;
+    entry = dataset;
     return dataset;
 }
 
-osm_dataset* dataset_deliverer::load_from_url(const string& url, const string& bbox, const string& parser)
+dataset_deliverer::dataset_ptr dataset_deliverer::load_from_file(const std::string& file,
+                                                                 const std::string& parser,
+                                                                 const std::string& cache)
 {
-    if (dataset == NULL)
+    std::string key = "file:" + file + "|" + cache;
+    dataset_ptr dataset = find(key);
+    if (dataset) return dataset;
+
+    dataset.reset(new osm_dataset);
+
+    // use the converted cache unless the source document is newer
+    bool have_file = !file.empty() && boost::filesystem::exists(file);
+    if (!cache.empty() && boost::filesystem::exists(cache) &&
+        (!have_file || boost::filesystem::last_write_time(cache) >= boost::filesystem::last_write_time(file)))
     {
-        dataset = new osm_dataset;
-        if (dataset->load_from_url(url.c_str(), bbox, parser) == false)
+        if (dataset->load_cache(cache))
         {
-            return NULL;
+            return insert(key, dataset);
         }
+#ifdef MAPNIK_DEBUG
+        std::clog << "OSM Plugin: ignoring unreadable cache '" << cache << "'" << std::endl;
+#endif
+    }
 
-        atexit(dataset_deliverer::release);
-        last_bbox = bbox;
+    if (!have_file)
+    {
+        throw mapnik::datasource_exception("OSM Plugin: '" + file + "' does not exist");
     }
-    else if (bbox != last_bbox)
+
+    if (dataset->load(file.c_str(), parser) == false)
     {
-#ifdef MAPNIK_DEBUG
-        std::cerr << "Osm Plugin: BBOXES ARE DIFFERENT: " << last_bbox << "," << bbox << std::endl;
-#endif
+        return dataset_ptr();
+    }
 
-        // Reload the dataset
-        dataset->clear();
-        if (dataset->load_from_url(url.c_str(), bbox, parser) == false)
-        {
-            return NULL;
-        }
+    if (!cache.empty() && !dataset->save_cache(cache))
+    {
+        std::clog << "OSM Plugin: could not write cache '" << cache << "'" << std::endl;
+    }
+    return insert(key, dataset);
+}
 
-        last_bbox = bbox;
+dataset_deliverer::dataset_ptr dataset_deliverer::load_from_url(const std::string& url,
+                                                                const std::string& bbox,
+                                                                const std::string& parser)
+{
+    std::string key = "url:" + url + "|" + bbox;
+    dataset_ptr dataset = find(key);
+    if (dataset) return dataset;
+
+    dataset.reset(new osm_dataset);
+    if (dataset->load_from_url(url, bbox, parser) == false)
+    {
+        return dataset_ptr();
     }
-    return dataset;
+    return insert(key, dataset);
 }
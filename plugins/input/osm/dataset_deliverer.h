@@ -24,26 +24,40 @@
 #define DATASET_DELIVERER_H
 
 #include "osm.h"
-#include <string>
-#include <iostream>
 
-using  namespace std;
+// boost
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#endif
 
-class dataset_deliverer 
-{
-private:
-    static osm_dataset* dataset; 
-    static std::string last_bbox;
-    static std::string last_filename;
+// stl
+#include <map>
+#include <string>
 
+// Hands out loaded datasets, sharing one instance between all datasources
+// that refer to the same file (or url and bbox) while any of them is alive.
+class dataset_deliverer
+{
 public:
-    static osm_dataset *load_from_file(const string&, const string&);
-    static osm_dataset *load_from_url(const string&, const string&, const string&);
+    typedef boost::shared_ptr<osm_dataset> dataset_ptr;
+
+    static dataset_ptr load_from_file(const std::string& file,
+                                      const std::string& parser,
+                                      const std::string& cache = "");
+    static dataset_ptr load_from_url(const std::string& url,
+                                     const std::string& bbox,
+                                     const std::string& parser);
+
+private:
+    static dataset_ptr find(const std::string& key);
+    static dataset_ptr insert(const std::string& key, dataset_ptr dataset);
 
-    static void release()
-    {
-        delete dataset;
-    }
+    static std::map<std::string, boost::weak_ptr<osm_dataset> > datasets_;
+#ifdef MAPNIK_THREADSAFE
+    static boost::mutex mutex_;
+#endif
 };
 
 #endif // DATASET_DELIVERER_H
@@ -24,19 +24,202 @@
 #include "osmparser.h"
 #include "basiccurl.h"
 
+// boost
+#include <boost/unordered_map.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/make_shared.hpp>
+
 #include <libxml/parser.h>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+
+namespace {
+
+// cache file layout: the header followed by the sections in the order
+// written by save_cache(), each starting on an 8 byte boundary
+const char cache_magic[8] = { 'M', 'A', 'P', 'N', 'I', 'K', 'O', 'S' };
+const boost::uint32_t cache_version = 1;
+const boost::uint32_t cache_byte_order = 0x01020304;
+const unsigned index_fanout = 16;
+
+struct cache_header
+{
+    char magic[8];
+    boost::uint32_t version;
+    boost::uint32_t byte_order;
+    boost::uint32_t node_count;
+    boost::uint32_t way_count;
+    boost::uint32_t way_ref_count;
+    boost::uint32_t tag_count;
+    boost::uint32_t string_count;
+    boost::uint32_t string_bytes;
+    boost::uint32_t index_count;
+    boost::uint32_t reserved;
+    double bounds[4];
+};
+
+inline std::size_t align8(std::size_t size)
+{
+    return (size + 7) & ~std::size_t(7);
+}
+
+class section_reader
+{
+public:
+    section_reader(const char* base, std::size_t size)
+        : base_(base), size_(size), pos_(align8(sizeof(cache_header))), valid_(size >= pos_) {}
+
+    template <typename T>
+    const T* take(std::size_t count)
+    {
+        const T* ptr = reinterpret_cast<const T*>(base_ + pos_);
+        std::size_t bytes = count * sizeof(T);
+        if (!valid_ || bytes > size_ - pos_)
+        {
+            valid_ = false;
+            return 0;
+        }
+        pos_ = std::min(size_, pos_ + align8(bytes));
+        return ptr;
+    }
+
+    bool valid() const { return valid_; }
+
+private:
+    const char* base_;
+    std::size_t size_;
+    std::size_t pos_;
+    bool valid_;
+};
+
+template <typename T>
+void write_section(std::ofstream& out, const T* data, std::size_t count)
+{
+    static const char padding[8] = { 0 };
+    std::size_t bytes = count * sizeof(T);
+    if (bytes > 0) out.write(reinterpret_cast<const char*>(data), bytes);
+    out.write(padding, align8(bytes) - bytes);
+}
+
+struct tag_key_less
+{
+    bool operator()(const osm_dataset::tag& a, const osm_dataset::tag& b) const
+    {
+        return a.key < b.key;
+    }
+};
 
-polygon_types osm_way::ptypes;
+struct index_x_less
+{
+    bool operator()(const osm_dataset::index_node& a, const osm_dataset::index_node& b) const
+    {
+        return a.minx + a.maxx < b.minx + b.maxx;
+    }
+};
+
+struct index_y_less
+{
+    bool operator()(const osm_dataset::index_node& a, const osm_dataset::index_node& b) const
+    {
+        return a.miny + a.maxy < b.miny + b.maxy;
+    }
+};
+
+// sort-tile-recursive ordering: vertical slices by x, then runs of
+// index_fanout entries by y within every slice
+void str_sort(std::vector<osm_dataset::index_node>& entries)
+{
+    std::size_t pages = (entries.size() + index_fanout - 1) / index_fanout;
+    std::size_t slices = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(pages))));
+    std::size_t slice_size = slices * index_fanout;
+    std::sort(entries.begin(), entries.end(), index_x_less());
+    for (std::size_t i = 0; i < entries.size(); i += slice_size)
+    {
+        std::sort(entries.begin() + i,
+                  entries.begin() + std::min(entries.size(), i + slice_size),
+                  index_y_less());
+    }
+}
+
+// offsets into a section of total entries: count + 1 of them, from 0 to
+// total, never decreasing
+bool valid_offsets(const osm_dataset::index_type* offsets, unsigned count,
+                   osm_dataset::index_type total)
+{
+    if (offsets[0] != 0 || offsets[count] != total) return false;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (offsets[i + 1] < offsets[i]) return false;
+    }
+    return true;
+}
+
+const polygon_types osm_ptypes;
+
+}
+
+// parse-time state, dropped once the document is converted
+struct osm_dataset::build_state
+{
+    boost::unordered_map<long, index_type> node_ids;
+    boost::unordered_map<std::string, index_type> string_ids;
+    std::vector<tag> node_tags;
+    std::vector<index_type> node_tag_offsets;
+    std::vector<tag> way_tags;
+    std::vector<index_type> way_tag_offsets;
+    std::vector<tag> item_tags;
+    std::vector<std::pair<index_type, index_type> > polygon_tags;
+    enum { None, Node, Way } item;
+
+    build_state()
+        : node_tag_offsets(1, 0),
+          way_tag_offsets(1, 0),
+          item(None) {}
+
+    index_type intern(const std::string& str, std::vector<index_type>& offsets, std::vector<char>& data)
+    {
+        std::pair<boost::unordered_map<std::string, index_type>::iterator, bool> ret =
+            string_ids.insert(std::make_pair(str, static_cast<index_type>(offsets.size() - 1)));
+        if (ret.second)
+        {
+            data.insert(data.end(), str.begin(), str.end());
+            data.push_back('\0');
+            offsets.push_back(data.size());
+        }
+        return ret.first->second;
+    }
+};
+
+osm_dataset::osm_dataset()
+{
+    clear();
+}
+
+osm_dataset::osm_dataset(const char* name)
+{
+    clear();
+    load(name);
+}
+
+osm_dataset::~osm_dataset()
+{
+}
 
 bool osm_dataset::load(const char* filename,const std::string& parser)
 {
     if (parser == "libxml2")
     {
-        return osmparser::parse(this, filename);
+        clear();
+        build_.reset(new build_state);
+        bool success = osmparser(this).parse(filename);
+        finish();
+        return success;
     }
     return false;
 }
@@ -65,216 +248,522 @@ bool osm_dataset::load_from_url(const std::string& url,
 
         if (resp != NULL)
         {
-            char *blx = new char[resp->nbytes + 1];
-            memcpy(blx, resp->data, resp->nbytes);
-            blx[resp->nbytes] = '\0';
-
 #ifdef MAPNIK_DEBUG
-            std::clog << "Osm Plugin: CURL RESPONSE: " << blx << std::endl;
+            std::clog << "Osm Plugin: CURL RESPONSE: " << std::string(resp->data, resp->nbytes) << std::endl;
 #endif
 
-            delete[] blx;
-            bool success = osmparser::parse(this, resp->data, resp->nbytes);
+            clear();
+            build_.reset(new build_state);
+            bool success = osmparser(this).parse(resp->data, resp->nbytes);
+            finish();
             return success;
         }
     }
     return false;
 }
 
-osm_dataset::~osm_dataset()
+bool osm_dataset::load_cache(const std::string& filename)
 {
     clear();
-}
-
-void osm_dataset::clear()
-{
-#ifdef MAPNIK_DEBUG
-    std::clog << "Osm Plugin: osm_dataset::clear()" << std::endl;
-    std::clog << "Osm Plugin: deleting ways" << std::endl;
-#endif
 
-    for (unsigned int count = 0; count < ways.size(); ++count)
+    // map the file itself rather than going through mapped_memory_cache,
+    // which may hand out a mapping of a cache file since rebuilt
+    if (!boost::filesystem::exists(filename)) return false;
+    region_ptr region;
+    try
     {
-        delete ways[count];
-        ways[count] = NULL;
+        boost::interprocess::file_mapping mapping(filename.c_str(), boost::interprocess::read_only);
+        region = boost::make_shared<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+    }
+    catch (boost::interprocess::interprocess_exception const& ex)
+    {
+        std::cerr << "Osm Plugin: could not map cache " << filename << ": " << ex.what() << std::endl;
+        return false;
     }
 
-#ifdef MAPNIK_DEBUG
-    std::clog << "Osm Plugin: deleting nodes" << std::endl;
-#endif
+    const char* base = static_cast<const char*>(region->get_address());
+    std::size_t size = region->get_size();
+    if (size < sizeof(cache_header)) return false;
 
-    for (unsigned int count = 0; count < nodes.size(); ++count)
+    cache_header header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 ||
+        header.version != cache_version ||
+        header.byte_order != cache_byte_order)
     {
-        delete nodes[count];
-        nodes[count] = NULL;
+        return false;
     }
 
-#ifdef MAPNIK_DEBUG
-    std::clog << "Osm Plugin: clearing ways/nodes" << std::endl;
-#endif
-
-    ways.clear();
-    nodes.clear();
+    section_reader reader(base, size);
+    index_ = reader.take<index_node>(header.index_count);
+    coords_ = reader.take<double>(std::size_t(header.node_count) * 2);
+    way_offsets_ = reader.take<index_type>(std::size_t(header.way_count) + 1);
+    way_refs_ = reader.take<index_type>(header.way_ref_count);
+    tag_offsets_ = reader.take<index_type>(std::size_t(header.node_count) + header.way_count + 1);
+    tags_ = reader.take<tag>(header.tag_count);
+    string_offsets_ = reader.take<index_type>(std::size_t(header.string_count) + 1);
+    strings_ = reader.take<char>(header.string_bytes);
+    way_flags_ = reader.take<unsigned char>(header.way_count);
+    if (!reader.valid() ||
+        std::size_t(header.node_count) + header.way_count > 0xffffffffu ||
+        string_offsets_[header.string_count] != header.string_bytes)
+    {
+        clear();
+        return false;
+    }
 
-#ifdef MAPNIK_DEBUG
-    std::clog << "Osm Plugin: done" << std::endl;
-#endif
+    node_count_ = header.node_count;
+    way_count_ = header.way_count;
+    way_ref_count_ = header.way_ref_count;
+    tag_count_ = header.tag_count;
+    string_count_ = header.string_count;
+    index_count_ = header.index_count;
+    if (!check_sections())
+    {
+        std::cerr << "Osm Plugin: ignoring inconsistent cache " << filename << std::endl;
+        clear();
+        return false;
+    }
+    bounds_ = bounds(header.bounds[0], header.bounds[1], header.bounds[2], header.bounds[3]);
+    region_ = region;
+    build_keys();
+    return true;
 }
 
-std::string osm_dataset::to_string()
+bool osm_dataset::save_cache(const std::string& filename) const
 {
-    std::string result;
-
-    for (unsigned int count = 0; count < nodes.size(); ++count)
+    // write next to the target and rename so processes that still map the
+    // previous cache keep a consistent view
+    std::string tmp = filename + ".tmp";
+    {
+        std::ofstream out(tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+
+        cache_header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+        header.version = cache_version;
+        header.byte_order = cache_byte_order;
+        header.node_count = node_count_;
+        header.way_count = way_count_;
+        header.way_ref_count = way_ref_count_;
+        header.tag_count = tag_count_;
+        header.string_count = string_count_;
+        header.string_bytes = string_offsets_[string_count_];
+        header.index_count = index_count_;
+        header.bounds[0] = bounds_.w;
+        header.bounds[1] = bounds_.s;
+        header.bounds[2] = bounds_.e;
+        header.bounds[3] = bounds_.n;
+
+        write_section(out, &header, 1);
+        write_section(out, index_, index_count_);
+        write_section(out, coords_, node_count_ * 2);
+        write_section(out, way_offsets_, way_count_ + 1);
+        write_section(out, way_refs_, way_ref_count_);
+        write_section(out, tag_offsets_, num_items() + 1);
+        write_section(out, tags_, tag_count_);
+        write_section(out, string_offsets_, string_count_ + 1);
+        write_section(out, strings_, header.string_bytes);
+        write_section(out, way_flags_, way_count_);
+        if (!out) return false;
+    }
+    boost::system::error_code ec;
+    boost::filesystem::rename(tmp, filename, ec);
+    if (ec)
     {
-        result += nodes[count]->to_string();
+        std::remove(tmp.c_str());
+        return false;
     }
+    return true;
+}
 
-    for (unsigned int count = 0; count < ways.size(); ++count)
+// Checks that every offset and index read from a cache file stays within
+// its section, so a damaged or hand-edited file cannot make lookups read
+// past the mapping or queries loop forever.
+bool osm_dataset::check_sections() const
+{
+    // the last string offset was checked against the section size already
+    if (!valid_offsets(way_offsets_, way_count_, way_ref_count_) ||
+        !valid_offsets(tag_offsets_, num_items(), tag_count_) ||
+        !valid_offsets(string_offsets_, string_count_, string_offsets_[string_count_]))
     {
-        result += ways[count]->to_string();
+        return false;
     }
+    for (unsigned i = 0; i < way_ref_count_; ++i)
+    {
+        if (way_refs_[i] >= node_count_) return false;
+    }
+    for (unsigned i = 0; i < tag_count_; ++i)
+    {
+        if (tags_[i].key >= string_count_ || tags_[i].value >= string_count_) return false;
+    }
+    // every string ends before the next one starts
+    for (unsigned i = 0; i < string_count_; ++i)
+    {
+        if (string_offsets_[i + 1] <= string_offsets_[i] ||
+            strings_[string_offsets_[i + 1] - 1] != '\0')
+        {
+            return false;
+        }
+    }
+    // children come after their parent, as build_index() lays them out
+    for (unsigned i = 0; i < index_count_; ++i)
+    {
+        const index_node& n = index_[i];
+        if (n.count == 0)
+        {
+            if (n.first >= num_items()) return false;
+        }
+        else if (n.first <= i || n.first > index_count_ || n.count > index_count_ - n.first)
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
-    return result;
+void osm_dataset::clear()
+{
+    node_count_ = 0;
+    way_count_ = 0;
+    way_ref_count_ = 0;
+    tag_count_ = 0;
+    string_count_ = 0;
+    index_count_ = 0;
+    bounds_ = bounds();
+
+    std::vector<double>().swap(coords_store_);
+    std::vector<index_type>(1, 0).swap(way_offsets_store_);
+    std::vector<index_type>().swap(way_refs_store_);
+    std::vector<unsigned char>().swap(way_flags_store_);
+    std::vector<index_type>(1, 0).swap(tag_offsets_store_);
+    std::vector<tag>().swap(tags_store_);
+    std::vector<index_type>(1, 0).swap(string_offsets_store_);
+    std::vector<char>().swap(strings_store_);
+    std::vector<index_node>().swap(index_store_);
+    region_.reset();
+    keys_.clear();
+    build_.reset();
+    attach();
+}
+
+void osm_dataset::add_node(long id, double lon, double lat)
+{
+    end_item();
+    build_->item = build_state::Node;
+    build_->item_tags.clear();
+    build_->node_ids[id] = node_count_++;
+    coords_store_.push_back(lon);
+    coords_store_.push_back(lat);
 }
 
-bounds osm_dataset::get_bounds()
+void osm_dataset::add_way()
 {
-    bounds b (-180, -90, 180, 90);
-    for (unsigned int count = 0; count < nodes.size(); ++count)
+    end_item();
+    build_->item = build_state::Way;
+    build_->item_tags.clear();
+    ++way_count_;
+
+    // Prevent ways with no name being assigned a name of "0"
+    add_tag("name", "");
+
+    // HACK: allows comparison with "" in the XML file. Otherwise it
+    // doesn't work. Only do for the most crucial tags for Freemap's
+    // purposes.  TODO investigate why this is
+    add_tag("width", "");
+    add_tag("horse", "");
+    add_tag("foot", "");
+    add_tag("bicycle", "");
+}
+
+void osm_dataset::add_way_node(long ref)
+{
+    if (build_->item != build_state::Way) return;
+    boost::unordered_map<long, index_type>::const_iterator itr = build_->node_ids.find(ref);
+    if (itr != build_->node_ids.end())
     {
-        if(nodes[count]->lon > b.w) b.w = nodes[count]->lon;
-        if(nodes[count]->lon < b.e) b.e = nodes[count]->lon;
-        if(nodes[count]->lat > b.s) b.s = nodes[count]->lat;
-        if(nodes[count]->lat < b.n) b.n = nodes[count]->lat;
+        way_refs_store_.push_back(itr->second);
     }
-    return b;
 }
 
-osm_node* osm_dataset::next_node()
+void osm_dataset::add_tag(const char* key, const char* value)
 {
-    if (node_i != nodes.end())
+    if (build_->item == build_state::None) return;
+    tag t;
+    t.key = build_->intern(key, string_offsets_store_, strings_store_);
+    t.value = build_->intern(value, string_offsets_store_, strings_store_);
+    build_->item_tags.push_back(t);
+}
+
+void osm_dataset::end_item()
+{
+    build_state& state = *build_;
+    if (state.item == build_state::None) return;
+
+    // a repeated key keeps its last value
+    std::stable_sort(state.item_tags.begin(), state.item_tags.end(), tag_key_less());
+    std::vector<tag> tags;
+    for (std::size_t i = 0; i < state.item_tags.size(); ++i)
     {
-        return *(node_i++);
+        if (i + 1 < state.item_tags.size() && state.item_tags[i + 1].key == state.item_tags[i].key) continue;
+        tags.push_back(state.item_tags[i]);
     }
-    return NULL;
+
+    if (state.item == build_state::Node)
+    {
+        state.node_tags.insert(state.node_tags.end(), tags.begin(), tags.end());
+        state.node_tag_offsets.push_back(state.node_tags.size());
+    }
+    else
+    {
+        state.way_tags.insert(state.way_tags.end(), tags.begin(), tags.end());
+        state.way_tag_offsets.push_back(state.way_tags.size());
+        way_offsets_store_.push_back(way_refs_store_.size());
+
+        if (state.polygon_tags.empty())
+        {
+            for (unsigned i = 0; i < osm_ptypes.ptypes.size(); ++i)
+            {
+                state.polygon_tags.push_back(std::make_pair(
+                    state.intern(osm_ptypes.ptypes[i].first, string_offsets_store_, strings_store_),
+                    state.intern(osm_ptypes.ptypes[i].second, string_offsets_store_, strings_store_)));
+            }
+        }
+        unsigned char polygon = 0;
+        for (std::size_t i = 0; i < tags.size() && !polygon; ++i)
+        {
+            for (std::size_t j = 0; j < state.polygon_tags.size(); ++j)
+            {
+                if (tags[i].key == state.polygon_tags[j].first && tags[i].value == state.polygon_tags[j].second)
+                {
+                    polygon = 1;
+                    break;
+                }
+            }
+        }
+        way_flags_store_.push_back(polygon);
+    }
+    state.item = build_state::None;
 }
 
-osm_way* osm_dataset::next_way()
+void osm_dataset::finish()
 {
-    if (way_i != ways.end())
+    build_state& state = *build_;
+
+    // an unterminated item from a truncated document
+    end_item();
+
+    tags_store_.swap(state.node_tags);
+    tags_store_.insert(tags_store_.end(), state.way_tags.begin(), state.way_tags.end());
+    tag_offsets_store_.swap(state.node_tag_offsets);
+    index_type way_base = tags_store_.size() - state.way_tags.size();
+    for (std::size_t i = 1; i < state.way_tag_offsets.size(); ++i)
     {
-        return *(way_i++);
+        tag_offsets_store_.push_back(way_base + state.way_tag_offsets[i]);
     }
-    return NULL;
+    build_.reset();
+
+    way_ref_count_ = way_refs_store_.size();
+    tag_count_ = tags_store_.size();
+    string_count_ = string_offsets_store_.size() - 1;
+    attach();
+    build_index();
+    attach();
+    build_keys();
 }
 
-osm_item* osm_dataset::next_item()
+void osm_dataset::build_index()
 {
-    osm_item* item = NULL;
-    if (next_item_mode == Node)
+    std::vector<index_node> entries;
+    entries.reserve(num_items());
+    bool first = true;
+    for (unsigned item = 0; item < num_items(); ++item)
     {
-        item = next_node();
-        if (item == NULL)
+        index_node entry;
+        entry.first = item;
+        entry.count = 0;
+        if (is_node(item))
+        {
+            entry.minx = entry.maxx = node_lon(item);
+            entry.miny = entry.maxy = node_lat(item);
+        }
+        else
+        {
+            unsigned way = item - node_count_;
+            unsigned size = way_size(way);
+            if (size == 0) continue;
+            entry.minx = entry.maxx = node_lon(way_node(way, 0));
+            entry.miny = entry.maxy = node_lat(way_node(way, 0));
+            for (unsigned i = 1; i < size; ++i)
+            {
+                double x = node_lon(way_node(way, i));
+                double y = node_lat(way_node(way, i));
+                entry.minx = std::min(entry.minx, x);
+                entry.miny = std::min(entry.miny, y);
+                entry.maxx = std::max(entry.maxx, x);
+                entry.maxy = std::max(entry.maxy, y);
+            }
+        }
+        if (first)
+        {
+            bounds_ = bounds(entry.minx, entry.miny, entry.maxx, entry.maxy);
+            first = false;
+        }
+        else
         {
-            next_item_mode = Way;
-            rewind_ways();
-            item = next_way();
+            bounds_.w = std::min(bounds_.w, entry.minx);
+            bounds_.s = std::min(bounds_.s, entry.miny);
+            bounds_.e = std::max(bounds_.e, entry.maxx);
+            bounds_.n = std::max(bounds_.n, entry.maxy);
         }
+        entries.push_back(entry);
     }
-    else
+    if (entries.empty()) return;
+
+    // pack bottom-up; every level refers to children by their position in
+    // the level below until the levels are concatenated root first
+    std::vector<std::vector<index_node> > levels;
+    levels.push_back(entries);
+    while (levels.back().size() > 1)
     {
-        item = next_way();
+        std::vector<index_node> children;
+        children.swap(levels.back());
+        str_sort(children);
+        std::vector<index_node> parents;
+        for (std::size_t i = 0; i < children.size(); i += index_fanout)
+        {
+            std::size_t end = std::min(children.size(), i + index_fanout);
+            index_node parent = children[i];
+            parent.first = i;
+            parent.count = end - i;
+            for (std::size_t j = i + 1; j < end; ++j)
+            {
+                parent.minx = std::min(parent.minx, children[j].minx);
+                parent.miny = std::min(parent.miny, children[j].miny);
+                parent.maxx = std::max(parent.maxx, children[j].maxx);
+                parent.maxy = std::max(parent.maxy, children[j].maxy);
+            }
+            parents.push_back(parent);
+        }
+        levels.back().swap(children);
+        levels.push_back(parents);
     }
-    return item;
-}
 
-std::set<std::string> osm_dataset::get_keys()
-{
-    std::set<std::string> keys;
-    for (unsigned int count = 0; count < nodes.size(); ++count)
+    std::vector<index_node> index;
+    for (std::size_t level = levels.size(); level-- > 0;)
     {
-        for (std::map<std::string, std::string>::iterator i = nodes[count]->keyvals.begin();
-             i != nodes[count]->keyvals.end(); i++)
+        std::size_t child_offset = index.size() + levels[level].size();
+        for (std::size_t i = 0; i < levels[level].size(); ++i)
         {
-            keys.insert(i->first);
+            index_node n = levels[level][i];
+            if (n.count > 0) n.first += child_offset;
+            index.push_back(n);
         }
     }
+    index_store_.swap(index);
+    index_count_ = index_store_.size();
+}
 
-    for (unsigned int count = 0; count < ways.size(); ++count)
+void osm_dataset::build_keys()
+{
+    keys_.clear();
+    std::vector<bool> seen(string_count_, false);
+    for (unsigned i = 0; i < tag_count_; ++i)
     {
-        for (std::map<std::string, std::string>::iterator i = ways[count]->keyvals.begin();
-             i != ways[count]->keyvals.end(); i++)
+        index_type key = tags_[i].key;
+        if (key < string_count_ && !seen[key])
         {
-            keys.insert(i->first);
+            seen[key] = true;
+            keys_.insert(std::make_pair(std::string(strings_ + string_offsets_[key]), key));
         }
     }
-    return keys;
 }
 
-
-std::string osm_item::to_string()
+void osm_dataset::attach()
 {
-    std::ostringstream strm;
-    strm << "id=" << id << std::endl << "Keyvals: " << std::endl;
+    coords_ = coords_store_.empty() ? 0 : &coords_store_[0];
+    way_offsets_ = &way_offsets_store_[0];
+    way_refs_ = way_refs_store_.empty() ? 0 : &way_refs_store_[0];
+    way_flags_ = way_flags_store_.empty() ? 0 : &way_flags_store_[0];
+    tag_offsets_ = &tag_offsets_store_[0];
+    tags_ = tags_store_.empty() ? 0 : &tags_store_[0];
+    string_offsets_ = &string_offsets_store_[0];
+    strings_ = strings_store_.empty() ? 0 : &strings_store_[0];
+    index_ = index_store_.empty() ? 0 : &index_store_[0];
+}
 
-    for (std::map<std::string, std::string>::iterator i = keyvals.begin();
-         i != keyvals.end(); i++)
+const char* osm_dataset::tag_value(unsigned item, index_type key) const
+{
+    tag t;
+    t.key = key;
+    const tag* begin = tags_ + tag_offsets_[item];
+    const tag* end = tags_ + tag_offsets_[item + 1];
+    const tag* itr = std::lower_bound(begin, end, t, tag_key_less());
+    if (itr != end && itr->key == key)
     {
-        strm << "Key " << i->first << " Value " << i->second << std::endl;
+        return strings_ + string_offsets_[itr->value];
     }
-
-    return strm.str();
+    return NULL;
 }
 
-std::string osm_node::to_string()
+boost::optional<osm_dataset::index_type> osm_dataset::find_key(const std::string& key) const
 {
-    std::ostringstream strm;
-    strm << "Node: " << osm_item::to_string() << " lat=" << lat <<" lon="  <<lon << std::endl;
-    return strm.str();
+    boost::optional<index_type> result;
+    std::map<std::string, index_type>::const_iterator itr = keys_.find(key);
+    if (itr != keys_.end()) result.reset(itr->second);
+    return result;
 }
 
-std::string osm_way::to_string()
+std::set<std::string> osm_dataset::get_keys() const
 {
-    std::ostringstream strm;
-    strm << "Way: " << osm_item::to_string() << "Nodes in way:";
-
-    for (unsigned int count = 0; count < nodes.size(); ++count)
+    std::set<std::string> keys;
+    for (std::map<std::string, index_type>::const_iterator itr = keys_.begin();
+         itr != keys_.end(); ++itr)
     {
-        if (nodes[count] != NULL)
-        {
-            strm << nodes[count]->id << " ";
-        }
+        keys.insert(itr->first);
     }
-
-    strm << std::endl;
-    return strm.str();
+    return keys;
 }
 
-bounds osm_way::get_bounds()
+bounds osm_dataset::get_bounds() const
 {
-    bounds b (-180, -90, 180, 90);
+    return bounds_;
+}
 
-    for (unsigned int count = 0; count < nodes.size(); ++count)
+std::string osm_dataset::to_string(unsigned item) const
+{
+    std::ostringstream strm;
+    strm << (is_node(item) ? "Node: " : "Way: ") << "item=" << item << std::endl << "Keyvals: " << std::endl;
+    for (index_type i = tag_offsets_[item]; i < tag_offsets_[item + 1]; ++i)
     {
-        if(nodes[count]->lon > b.w) b.w = nodes[count]->lon;
-        if(nodes[count]->lon < b.e) b.e = nodes[count]->lon;
-        if(nodes[count]->lat > b.s) b.s = nodes[count]->lat;
-        if(nodes[count]->lat < b.n) b.n = nodes[count]->lat;
+        strm << "Key " << strings_ + string_offsets_[tags_[i].key]
+             << " Value " << strings_ + string_offsets_[tags_[i].value] << std::endl;
     }
-    return b;
-}
 
-bool osm_way::is_polygon()
-{
-    for (unsigned int count = 0; count < ptypes.ptypes.size(); ++count)
+    if (is_node(item))
     {
-        if (keyvals.find(ptypes.ptypes[count].first) != keyvals.end() &&
-            keyvals[ptypes.ptypes[count].first] == ptypes.ptypes[count].second)
+        strm << " lat=" << node_lat(item) << " lon=" << node_lon(item) << std::endl;
+    }
+    else
+    {
+        unsigned way = item - node_count_;
+        strm << "Nodes in way:";
+        for (unsigned i = 0; i < way_size(way); ++i)
         {
-            return true;
+            strm << way_node(way, i) << " ";
         }
+        strm << std::endl;
     }
+    return strm.str();
+}
 
-    return false;
+std::string osm_dataset::to_string() const
+{
+    std::string result;
+    for (unsigned item = 0; item < num_items(); ++item)
+    {
+        result += to_string(item);
+    }
+    return result;
 }
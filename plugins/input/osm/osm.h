@@ -23,6 +23,19 @@
 #ifndef OSM_H
 #define OSM_H
 
+// mapnik
+#include <mapnik/box2d.hpp>
+
+// boost
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/optional.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+// stl
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <map>
@@ -59,75 +72,136 @@ public:
     }
 };
 
-struct osm_item
-{
-    long id;
-    std::map<std::string, std::string> keyvals;
-    virtual std::string to_string();
-    virtual ~osm_item() {}
-};
-
-struct osm_node : public osm_item
-{
-    double lat, lon;
-    std::string to_string();
-};
-
-struct osm_way : public osm_item
+// A read-only OSM extract in a compact layout: node coordinates live in one
+// flat array, ways are ranges into a shared array of node indices, tags are
+// pairs of interned string ids and the bbox of every item is kept in a packed
+// R-tree so queries only visit items near the requested extent.
+//
+// Items are numbered nodes first, then ways, each in document order. The
+// same layout is written by save_cache() and can be memory mapped again by
+// load_cache() without touching the XML.
+class osm_dataset : private boost::noncopyable
 {
-    std::vector<osm_node*> nodes; 
-    std::string to_string();
-    bounds get_bounds();
-    bool is_polygon();
-    static polygon_types ptypes;
-};
-
-class osm_dataset
-{
-private:
-    int next_item_mode;
-    enum { Node, Way };
-    std::vector<osm_node*>::iterator node_i;
-    std::vector<osm_way*>::iterator way_i;
-    std::vector<osm_node*> nodes;
-    std::vector<osm_way*> ways; 
-
 public:
-    osm_dataset()
+    typedef boost::uint32_t index_type;
+
+    struct tag
     {
-        node_i = nodes.begin();
-        way_i = ways.begin();
-        next_item_mode = Node;
-    }
+        index_type key;
+        index_type value;
+    };
 
-    osm_dataset(const char* name)
+    struct index_node
     {
-        node_i = nodes.begin();
-        way_i = ways.begin();
-        next_item_mode = Node;
-        load(name);
-    }
+        double minx, miny, maxx, maxy;
+        index_type first; // first child, or the item for leaf entries
+        index_type count; // number of children, 0 for leaf entries
+    };
 
+    osm_dataset();
+    explicit osm_dataset(const char* name);
     ~osm_dataset();
 
     bool load(const char* name, const std::string& parser = "libxml2");
     bool load_from_url(const std::string&,
                        const std::string&,
                        const std::string& parser = "libxml2");
+    bool load_cache(const std::string& filename);
+    bool save_cache(const std::string& filename) const;
     void clear();
-    void add_node(osm_node* n) { nodes.push_back(n); }
-    void add_way(osm_way* w) { ways.push_back(w); }
-    std::string to_string();
-    bounds get_bounds();
-    std::set<std::string> get_keys();
-    void rewind_nodes() { node_i = nodes.begin(); }
-    void rewind_ways() { way_i = ways.begin(); }
-    void rewind() { rewind_nodes(); rewind_ways(); next_item_mode = Node; }
-    osm_node * next_node();
-    osm_way * next_way();
-    osm_item * next_item();
-    bool current_item_is_node() { return next_item_mode == Node; }
-    bool current_item_is_way() { return next_item_mode == Way; }
+
+    unsigned num_nodes() const { return node_count_; }
+    unsigned num_ways() const { return way_count_; }
+    unsigned num_items() const { return node_count_ + way_count_; }
+    bool is_node(unsigned item) const { return item < node_count_; }
+
+    double node_lon(unsigned node) const { return coords_[node * 2]; }
+    double node_lat(unsigned node) const { return coords_[node * 2 + 1]; }
+    unsigned way_size(unsigned way) const { return way_offsets_[way + 1] - way_offsets_[way]; }
+    unsigned way_node(unsigned way, unsigned i) const { return way_refs_[way_offsets_[way] + i]; }
+    bool way_is_polygon(unsigned way) const { return way_flags_[way] != 0; }
+
+    // returns the value of the tag or NULL if the item does not carry it
+    const char* tag_value(unsigned item, index_type key) const;
+    boost::optional<index_type> find_key(const std::string& key) const;
+    std::set<std::string> get_keys() const;
+    bounds get_bounds() const;
+    std::string to_string(unsigned item) const;
+    std::string to_string() const;
+
+    // collects the items whose bbox passes the filter, in item order
+    template <typename Filter>
+    void query(const Filter& filter, std::vector<index_type>& items) const
+    {
+        items.clear();
+        if (index_count_ == 0) return;
+        std::vector<index_type> todo(1, 0);
+        while (!todo.empty())
+        {
+            const index_node& n = index_[todo.back()];
+            todo.pop_back();
+            if (!filter.pass(mapnik::box2d<double>(n.minx, n.miny, n.maxx, n.maxy))) continue;
+            if (n.count == 0)
+            {
+                items.push_back(n.first);
+            }
+            else
+            {
+                for (index_type i = 0; i < n.count; ++i) todo.push_back(n.first + i);
+            }
+        }
+        std::sort(items.begin(), items.end());
+    }
+
+private:
+    friend class osmparser;
+    struct build_state;
+
+    // called by osmparser while it streams through the document
+    void add_node(long id, double lon, double lat);
+    void add_way();
+    void add_way_node(long ref);
+    void add_tag(const char* key, const char* value);
+    void end_item();
+    void finish();
+    void build_index();
+    void build_keys();
+    void attach();
+    bool check_sections() const;
+
+    unsigned node_count_;
+    unsigned way_count_;
+    unsigned way_ref_count_;
+    unsigned tag_count_;
+    unsigned string_count_;
+    unsigned index_count_;
+    bounds bounds_;
+
+    // views onto either the vectors below or a mapped cache file
+    const double* coords_;
+    const index_type* way_offsets_;
+    const index_type* way_refs_;
+    const unsigned char* way_flags_;
+    const index_type* tag_offsets_;
+    const tag* tags_;
+    const index_type* string_offsets_;
+    const char* strings_;
+    const index_node* index_;
+
+    std::vector<double> coords_store_;
+    std::vector<index_type> way_offsets_store_;
+    std::vector<index_type> way_refs_store_;
+    std::vector<unsigned char> way_flags_store_;
+    std::vector<index_type> tag_offsets_store_;
+    std::vector<tag> tags_store_;
+    std::vector<index_type> string_offsets_store_;
+    std::vector<char> strings_store_;
+    std::vector<index_node> index_store_;
+    typedef boost::shared_ptr<boost::interprocess::mapped_region> region_ptr;
+    region_ptr region_;
+
+    std::map<std::string, index_type> keys_;
+    boost::scoped_ptr<build_state> build_;
 };
 
 #endif // OSM_H
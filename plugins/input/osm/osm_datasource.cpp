@@ -66,8 +66,8 @@ void osm_datasource::bind() const
 {
     if (is_bound_) return;
 
-    osm_data_ = NULL;
     std::string osm_filename = *params_.get<std::string>("file", "");
+    std::string cache = *params_.get<std::string>("cache", "");
     std::string parser = *params_.get<std::string>("parser", "libxml2");
     std::string url = *params_.get<std::string>("url", "");
     std::string bbox = *params_.get<std::string>("bbox", "");
@@ -80,22 +80,23 @@ void osm_datasource::bind() const
 #ifdef MAPNIK_DEBUG
         std::clog << "Osm Plugin: loading_from_url: url=" << url << " bbox=" << bbox << std::endl;
 #endif
-        if ((osm_data_ = dataset_deliverer::load_from_url(url, bbox, parser)) == NULL)
+        if (!(osm_data_ = dataset_deliverer::load_from_url(url, bbox, parser)))
         {
             throw datasource_exception("Error loading from URL");
         }
     }
-    else if (osm_filename != "")
+    else if (osm_filename != "" || cache != "")
     {
-        // if we supplied a filename, load from file
-        if ((osm_data_ = dataset_deliverer::load_from_file(osm_filename, parser)) == NULL)
+        // if we supplied a filename, load from file, going through the
+        // converted cache if one was given
+        if (!(osm_data_ = dataset_deliverer::load_from_file(osm_filename, parser, cache)))
         {
             std::ostringstream s;
             s << "OSM Plugin: Error loading from file '" << osm_filename << "'";
             throw datasource_exception(s.str());
         }
     } else {
-        throw datasource_exception("OSM Plugin: Neither 'file' nor 'url' and 'bbox' specified");
+        throw datasource_exception("OSM Plugin: Neither 'file' (or 'cache') nor 'url' and 'bbox' specified");
     }
 
 
@@ -103,8 +104,6 @@ void osm_datasource::bind() const
     tagtypes.add_type("maxspeed", mapnik::Integer);
     tagtypes.add_type("z_order", mapnik::Integer);
 
-    osm_data_->rewind();
-
     // Need code to get the attributes of all the data
     std::set<std::string> keys = osm_data_->get_keys();
 
@@ -123,8 +122,6 @@ void osm_datasource::bind() const
 
 osm_datasource::~osm_datasource()
 {
-    // Do not do as is now static variable and cleaned up at exit
-    //delete osm_data_;
 }
 
 std::string osm_datasource::name()
@@ -147,7 +144,6 @@ featureset_ptr osm_datasource::features(const query& q) const
     if (!is_bound_) bind();
 
     filter_in_box filter(q.get_bbox());
-    // so we need to filter osm features by bbox here...
 
     return boost::make_shared<osm_featureset<filter_in_box> >(filter,
                                                               osm_data_,
@@ -27,6 +27,9 @@
 #include <mapnik/datasource.hpp>
 #include <mapnik/box2d.hpp>
 
+// boost
+#include <boost/shared_ptr.hpp>
+
 #include "osm.h"
 
 using mapnik::datasource;
@@ -52,7 +55,7 @@ public:
     void bind() const;
 private:
     mutable box2d<double> extent_;
-    mutable osm_dataset* osm_data_;
+    mutable boost::shared_ptr<osm_dataset> osm_data_;
     mapnik::datasource::datasource_t type_;
     mutable layer_descriptor desc_;
     // no copying
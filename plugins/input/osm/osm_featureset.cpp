@@ -37,88 +37,67 @@ using mapnik::feature_factory;
 
 template <typename filterT>
 osm_featureset<filterT>::osm_featureset(const filterT& filter,
-                                        osm_dataset* dataset,
+                                        boost::shared_ptr<osm_dataset> const& dataset,
                                         const std::set<std::string>&
                                         attribute_names,
                                         std::string const& encoding)
     : filter_(filter),
-      query_ext_(),
       tr_(new transcoder(encoding)),
-      feature_id_(1),
-      dataset_ (dataset),
-      attribute_names_ (attribute_names),
+      dataset_(dataset),
+      pos_(0),
       ctx_(boost::make_shared<mapnik::context_type>())
 {
-    dataset_->rewind();
+    // resolve the attribute names to interned keys once per query
+    std::set<std::string>::const_iterator itr = attribute_names.begin();
+    std::set<std::string>::const_iterator end = attribute_names.end();
+    for (; itr != end; ++itr)
+    {
+        attributes_.push_back(std::make_pair(*itr, dataset_->find_key(*itr)));
+    }
+    dataset_->query(filter_, items_);
 }
 
 template <typename filterT>
 feature_ptr osm_featureset<filterT>::next()
 {
-    feature_ptr feature;
+    if (pos_ >= items_.size()) return feature_ptr();
 
-    osm_item* cur_item = dataset_->next_item();
-    if (!cur_item) return feature_ptr();
-    if (dataset_->current_item_is_node())
+    unsigned item = items_[pos_++];
+    feature_ptr feature = feature_factory::create(ctx_, item + 1);
+    if (dataset_->is_node(item))
     {
-        feature = feature_factory::create(ctx_,feature_id_);
-        ++feature_id_;
-        double lat = static_cast<osm_node*>(cur_item)->lat;
-        double lon = static_cast<osm_node*>(cur_item)->lon;
         geometry_type* point = new geometry_type(mapnik::Point);
-        point->move_to(lon, lat);
+        point->move_to(dataset_->node_lon(item), dataset_->node_lat(item));
         feature->add_geometry(point);
     }
-    else if (dataset_->current_item_is_way())
+    else
     {
-        // Loop until we find a feature which passes the filter
-        while (cur_item)
+        // ways without any resolved node are never indexed
+        unsigned way = item - dataset_->num_nodes();
+        unsigned size = dataset_->way_size(way);
+        geometry_type* geom = new geometry_type(dataset_->way_is_polygon(way) ? mapnik::Polygon : mapnik::LineString);
+        unsigned node = dataset_->way_node(way, 0);
+        geom->move_to(dataset_->node_lon(node), dataset_->node_lat(node));
+        for (unsigned count = 1; count < size; ++count)
         {
-            bounds b = static_cast<osm_way*>(cur_item)->get_bounds();
-            if (filter_.pass(box2d<double>(b.w, b.s, b.e, b.n))) break;
-            cur_item = dataset_->next_item();
-        }
-
-        if (!cur_item) return feature_ptr();
-        if (static_cast<osm_way*>(cur_item)->nodes.size())
-        {
-            feature = feature_factory::create(ctx_,feature_id_);
-            ++feature_id_;
-            geometry_type* geom;
-            if (static_cast<osm_way*>(cur_item)->is_polygon())
-            {
-                geom = new geometry_type(mapnik::Polygon);
-            }
-            else
-            {
-                geom = new geometry_type(mapnik::LineString);
-            }
-
-            geom->move_to(static_cast<osm_way*>(cur_item)->nodes[0]->lon,
-                          static_cast<osm_way*>(cur_item)->nodes[0]->lat);
-
-            for (unsigned int count = 1;
-                 count < static_cast<osm_way*>(cur_item)->nodes.size();
-                 count++)
-            {
-                geom->line_to(static_cast<osm_way*>(cur_item)->nodes[count]->lon,
-                              static_cast<osm_way*>(cur_item)->nodes[count]->lat);
-            }
-            feature->add_geometry(geom);
+            node = dataset_->way_node(way, count);
+            geom->line_to(dataset_->node_lon(node), dataset_->node_lat(node));
         }
+        feature->add_geometry(geom);
     }
 
-    std::set<std::string>::const_iterator itr = attribute_names_.begin();
-    std::set<std::string>::const_iterator end = attribute_names_.end();
-    std::map<std::string,std::string>::iterator end_keyvals = cur_item->keyvals.end();
-
-    for (; itr != end; itr++)
+    attributes_type::const_iterator itr = attributes_.begin();
+    attributes_type::const_iterator end = attributes_.end();
+    for (; itr != end; ++itr)
     {
-        std::map<std::string,std::string>::iterator i = cur_item->keyvals.find(*itr);
-        if (i != end_keyvals) {
-            feature->put_new(i->first,tr_->transcode(i->second.c_str()));
-        } else {
-            feature->put_new(*itr, "");
+        const char* value = itr->second ? dataset_->tag_value(item, *itr->second) : NULL;
+        if (value)
+        {
+            feature->put_new(itr->first, tr_->transcode(value));
+        }
+        else
+        {
+            feature->put_new(itr->first, "");
         }
     }
     return feature;
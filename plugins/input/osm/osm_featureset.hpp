@@ -28,6 +28,8 @@
 
 // boost
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/optional.hpp>
 
 // mapnik
 #include <mapnik/geom_util.hpp>
@@ -48,21 +50,20 @@ class osm_featureset : public Featureset
 {
 public:
     osm_featureset(const filterT& filter,
-                   osm_dataset* dataset,
+                   boost::shared_ptr<osm_dataset> const& dataset,
                    const std::set<std::string>& attribute_names,
                    std::string const& encoding);
     virtual ~osm_featureset();
     feature_ptr next();
 private:
+    typedef std::vector<std::pair<std::string, boost::optional<osm_dataset::index_type> > > attributes_type;
+
     filterT filter_;
-    box2d<double> query_ext_;
     boost::scoped_ptr<transcoder> tr_;
-    std::vector<int> attr_ids_;
-    mutable box2d<double> feature_ext_;
-    mutable int total_geom_size;
-    mutable int feature_id_;
-    osm_dataset *dataset_;
-    std::set<std::string> attribute_names_;
+    boost::shared_ptr<osm_dataset> dataset_;
+    std::vector<osm_dataset::index_type> items_;
+    std::size_t pos_;
+    attributes_type attributes_;
     mapnik::context_ptr ctx_;
     // no copying
     osm_featureset(const osm_featureset&);
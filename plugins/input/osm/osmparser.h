@@ -29,26 +29,23 @@
 #include <iostream>
 #include <string>
 #include "osm.h"
-#include <map>
 
+// Streams an OSM document into an osm_dataset. All parse state lives in the
+// instance so several datasets can be loaded at the same time.
 class osmparser
 {
 public:
-    static void processNode(xmlTextReaderPtr reader);
-    static void startElement(xmlTextReaderPtr reader, const xmlChar* name);
-    static void endElement(const xmlChar* name);
-    static bool parse(osm_dataset* ds, const char* filename);
-    static bool parse(osm_dataset* ds, char* data, int nbytes);
+    explicit osmparser(osm_dataset* ds);
+    bool parse(const char* filename);
+    bool parse(char* data, int nbytes);
 
 private:
-    static osm_item *cur_item;
-    static long curID;
-    static bool in_node, in_way;
-    static osm_dataset* components;
-    static std::string error;
-    static std::map<long, osm_node*> tmp_node_store;
+    void processNode(xmlTextReaderPtr reader);
+    void startElement(xmlTextReaderPtr reader, const xmlChar* name);
+    void endElement(const xmlChar* name);
+    int do_parse(xmlTextReaderPtr);
 
-    static int do_parse(xmlTextReaderPtr);
+    osm_dataset* components;
 };
 
 #endif // OSMPARSER_H
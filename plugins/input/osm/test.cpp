@@ -8,12 +8,9 @@ int main(int argc,char* argv[])
     if(argc>=2)
     {
         osm_dataset dataset(argv[1]);
-        bounds b = dataset.get_bounds();
-        osm_item *item;
-        dataset.rewind();
-        while((item=dataset.next_item())!=NULL)
+        for (unsigned item = 0; item < dataset.num_items(); ++item)
         {
-            std::cerr << item->to_string() << endl;
+            std::cerr << dataset.to_string(item) << endl;
         }
     }
     else
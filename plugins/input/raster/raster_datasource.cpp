@@ -25,6 +25,9 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/make_shared.hpp>
 
+// stl
+#include <algorithm>
+
 // mapnik
 #include <mapnik/image_reader.hpp>
 
@@ -45,6 +48,11 @@ using mapnik::image_reader;
 
 DATASOURCE_PLUGIN(raster_datasource)
 
+static bool larger_overview(raster_info const& lhs, raster_info const& rhs)
+{
+    return lhs.width() > rhs.width();
+}
+
 raster_datasource::raster_datasource(const parameters& params, bool bind)
 : datasource(params),
     desc_(*params.get<std::string>("type"), "utf-8"),
@@ -68,6 +76,7 @@ raster_datasource::raster_datasource(const parameters& params, bool bind)
     tile_stride_ = *params_.get<unsigned>("tile_stride", 1);
 
     format_ = *params_.get<std::string>("format","tiff");
+    use_overviews_ = *params_.get<bool>("use_overviews", true);
 
     boost::optional<double> lox = params_.get<double>("lox");
     boost::optional<double> loy = params_.get<double>("loy");
@@ -133,6 +142,11 @@ void raster_datasource::bind() const
                 width_ = reader->width();
                 height_ = reader->height();
             }
+            overviews_.push_back(raster_info(filename_, format_, extent_, width_, height_));
+            if (use_overviews_)
+            {
+                add_overviews(filename_, 1);
+            }
         }
         catch (mapnik::image_reader_exception const& ex)
         {
@@ -148,13 +162,62 @@ void raster_datasource::bind() const
         }
     }
 
+    // external overviews as written by gdaladdo -ro
+    std::string const ovr_file = filename_ + ".ovr";
+    if (! multi_tiles_ && use_overviews_ && format_ == "tiff" && boost::filesystem::exists(ovr_file))
+    {
+        try
+        {
+            add_overviews(ovr_file, 0);
+        }
+        catch (std::exception const& ex)
+        {
+            std::cerr << "Raster Plugin: ignoring overviews in " << ovr_file << ": " << ex.what() << std::endl;
+        }
+    }
+    std::stable_sort(overviews_.begin(), overviews_.end(), larger_overview);
+
 #ifdef MAPNIK_DEBUG
     std::clog << "Raster Plugin: RASTER SIZE(" << width_ << "," << height_ << ")" << std::endl;
+    std::clog << "Raster Plugin: OVERVIEWS=" << (overviews_.empty() ? 0 : overviews_.size() - 1) << std::endl;
 #endif
 
     is_bound_ = true;
 }
 
+void raster_datasource::add_overviews(std::string const& file, unsigned first_level) const
+{
+    std::auto_ptr<image_reader> reader(mapnik::get_image_reader(file, format_));
+    if (reader.get())
+    {
+        unsigned count = reader->overview_count();
+        for (unsigned level = first_level; level <= count; ++level)
+        {
+            reader->select_overview(level);
+            overviews_.push_back(raster_info(file, format_, extent_, reader->width(), reader->height(), level));
+        }
+    }
+}
+
+raster_info const& raster_datasource::select_overview(query const& q) const
+{
+    // the smallest image that still provides at least one pixel per output pixel
+    double res_x = boost::get<0>(q.resolution());
+    double res_y = boost::get<1>(q.resolution());
+    std::vector<raster_info>::const_iterator best = overviews_.begin();
+    std::vector<raster_info>::const_iterator itr = best;
+    for (++itr; itr != overviews_.end(); ++itr)
+    {
+        if (itr->width() < res_x * extent_.width() ||
+            itr->height() < res_y * extent_.height())
+        {
+            break;
+        }
+        best = itr;
+    }
+    return *best;
+}
+
 raster_datasource::~raster_datasource()
 {
 }
@@ -188,17 +251,6 @@ featureset_ptr raster_datasource::features(query const& q) const
 {
     if (! is_bound_) bind();
 
-    mapnik::CoordTransform t(width_, height_, extent_, 0, 0);
-    mapnik::box2d<double> intersect = extent_.intersect(q.get_bbox());
-    mapnik::box2d<double> ext = t.forward(intersect);
-
-    const int width  = int(ext.maxx() + 0.5) - int(ext.minx() + 0.5);
-    const int height = int(ext.maxy() + 0.5) - int(ext.miny() + 0.5);
-
-#ifdef MAPNIK_DEBUG
-    std::clog << "Raster Plugin: BOX SIZE(" << width << " " << height << ")" << std::endl;
-#endif
-
     if (multi_tiles_)
     {
 #ifdef MAPNIK_DEBUG
@@ -209,13 +261,29 @@ featureset_ptr raster_datasource::features(query const& q) const
 
         return boost::make_shared<raster_featureset<tiled_multi_file_policy> >(policy, extent_, q);
     }
-    else if (width * height > 512*512)
+
+    raster_info const& level = select_overview(q);
+
+    mapnik::CoordTransform t(level.width(), level.height(), extent_, 0, 0);
+    mapnik::box2d<double> intersect = extent_.intersect(q.get_bbox());
+    mapnik::box2d<double> ext = t.forward(intersect);
+
+    const int width  = int(ext.maxx() + 0.5) - int(ext.minx() + 0.5);
+    const int height = int(ext.maxy() + 0.5) - int(ext.miny() + 0.5);
+
+#ifdef MAPNIK_DEBUG
+    std::clog << "Raster Plugin: BOX SIZE(" << width << " " << height << ")" << std::endl;
+    std::clog << "Raster Plugin: LEVEL " << level.file() << ":" << level.overview()
+              << " SIZE(" << level.width() << "," << level.height() << ")" << std::endl;
+#endif
+
+    if (width * height > 512*512)
     {
 #ifdef MAPNIK_DEBUG
         std::clog << "Raster Plugin: TILED policy" << std::endl;
 #endif
 
-        tiled_file_policy policy(filename_, format_, 256, extent_, q.get_bbox(), width_, height_);
+        tiled_file_policy policy(level.file(), format_, 256, extent_, q.get_bbox(), level.width(), level.height(), level.overview());
 
         return boost::make_shared<raster_featureset<tiled_file_policy> >(policy, extent_, q);
     }
@@ -225,8 +293,7 @@ featureset_ptr raster_datasource::features(query const& q) const
         std::clog << "Raster Plugin: SINGLE FILE" << std::endl;
 #endif
 
-        raster_info info(filename_, format_, extent_, width_, height_);
-        single_file_policy policy(info);
+        single_file_policy policy(level);
 
         return boost::make_shared<raster_featureset<single_file_policy> >(policy, extent_, q);
     }
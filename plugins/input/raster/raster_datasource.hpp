@@ -28,6 +28,11 @@
 #include <mapnik/feature.hpp>
 #include <mapnik/datasource.hpp>
 
+// stl
+#include <vector>
+
+class raster_info;
+
 class raster_datasource : public mapnik::datasource
 {
 public:
@@ -42,6 +47,9 @@ public:
     mapnik::layer_descriptor get_descriptor() const;
     void bind() const;
 private:
+    void add_overviews(std::string const& file, unsigned first_level) const;
+    raster_info const& select_overview(mapnik::query const& q) const;
+
     mapnik::layer_descriptor desc_;
     std::string filename_;
     std::string format_;
@@ -50,8 +58,11 @@ private:
     bool multi_tiles_;
     unsigned tile_size_;
     unsigned tile_stride_;
+    bool use_overviews_;
     mutable unsigned width_;
     mutable unsigned height_;
+    // full resolution image followed by its overviews, largest first
+    mutable std::vector<raster_info> overviews_;
     //no copying
     raster_datasource(const raster_datasource&);
     raster_datasource& operator=(const raster_datasource&);
@@ -76,6 +76,11 @@ feature_ptr raster_featureset<LookupPolicy>::next()
 
             if (reader.get())
             {
+                if (curIter_->overview() > 0)
+                {
+                    reader->select_overview(curIter_->overview());
+                }
+
                 int image_width = policy_.img_width(reader->width());
                 int image_height = policy_.img_height(reader->height());
 
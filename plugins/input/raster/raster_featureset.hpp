@@ -126,7 +126,8 @@ public:
                       box2d<double> extent,
                       box2d<double> bbox,
                       unsigned width,
-                      unsigned height)
+                      unsigned height,
+                      unsigned overview = 0)
     {
         double lox = extent.minx();
         double loy = extent.miny();
@@ -155,7 +156,7 @@ public:
                 if (e.intersects(box2d<double>(x0, y0, x1, y1)))
                 {
                     box2d<double> tile_box = e.intersect(box2d<double>(x0,y0,x1,y1));
-                    raster_info info(file,format,tile_box,tile_size,tile_size);
+                    raster_info info(file,format,tile_box,tile_size,tile_size,overview);
                     infos_.push_back(info);
                 }
             }
@@ -26,12 +26,14 @@ raster_info::raster_info(std::string const& file,
                          std::string const& format,
                          mapnik::box2d<double> const& extent,
                          unsigned width,
-                         unsigned height)
+                         unsigned height,
+                         unsigned overview)
     : file_(file),
       format_(format),
       extent_(extent),
       width_(width),
-      height_(height)
+      height_(height),
+      overview_(overview)
 {
 }
 
@@ -40,7 +42,8 @@ raster_info::raster_info(const raster_info& rhs)
       format_(rhs.format_),
       extent_(rhs.extent_),
       width_(rhs.width_),
-      height_(rhs.height_)
+      height_(rhs.height_),
+      overview_(rhs.overview_)
 {
 }
 
@@ -51,6 +54,7 @@ void raster_info::swap(raster_info& other) throw()
     extent_ = other.extent_;
     width_ = other.width_;
     height_ = other.height_;
+    overview_ = other.overview_;
 }
 
 
@@ -37,7 +37,8 @@ public:
                 const std::string& format,
                 const box2d<double>& extent,
                 unsigned width,
-                unsigned height);
+                unsigned height,
+                unsigned overview = 0);
     raster_info(const raster_info& rhs);
     raster_info& operator=(const raster_info& rhs);
     inline box2d<double> const& envelope() const {return extent_;}
@@ -45,6 +46,7 @@ public:
     inline std::string const& format() const {return format_;}
     inline unsigned width() const { return width_;}
     inline unsigned height() const { return height_;}
+    inline unsigned overview() const { return overview_;}
 
 private:
     void swap(raster_info& other) throw();
@@ -54,6 +56,7 @@ private:
     box2d<double> extent_;
     unsigned width_;
     unsigned height_;
+    unsigned overview_;
 };
 
 #endif  // RASTER_INFO_HPP
@@ -25,6 +25,10 @@
 
 // stl
 #include <string.h>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
 
 // mapnik
 #include <mapnik/datasource.hpp>
@@ -35,6 +39,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/utility.hpp>
 
 // sqlite
 extern "C" {
@@ -46,7 +51,7 @@ extern "C" {
 
 //==============================================================================
 
-class sqlite_connection
+class sqlite_connection : private boost::noncopyable
 {
 public:
 
@@ -97,12 +102,18 @@ public:
 
     virtual ~sqlite_connection ()
     {
+        finalize_statements();
         if (db_)
         {
             sqlite3_close (db_);
         }
     }
 
+    bool isOK() const
+    {
+        return db_ != 0;
+    }
+
     void throw_sqlite_error(const std::string& sql)
     {
         std::ostringstream s;
@@ -131,6 +142,31 @@ public:
         return boost::make_shared<sqlite_resultset>(stmt);
     }
 
+    // prepares the sql once per connection; the statement stays owned by
+    // the connection and must be reset before the connection is reused
+    sqlite3_stmt* prepare_cached(const std::string& sql)
+    {
+        std::map<std::string, sqlite3_stmt*>::iterator itr = statements_.find(sql);
+        if (itr != statements_.end())
+        {
+            return itr->second;
+        }
+
+        if (statements_.size() >= max_cached_statements)
+        {
+            finalize_statements();
+        }
+
+        sqlite3_stmt* stmt = 0;
+        const int rc = sqlite3_prepare_v2 (db_, sql.c_str(), -1, &stmt, 0);
+        if (rc != SQLITE_OK)
+        {
+            throw_sqlite_error(sql);
+        }
+        statements_.insert(std::make_pair(sql, stmt));
+        return stmt;
+    }
+
     void execute(const std::string& sql)
     {
         const int rc = sqlite3_exec(db_, sql.c_str(), 0, 0, 0);
@@ -154,8 +190,72 @@ public:
 
 private:
 
+    void finalize_statements()
+    {
+        std::map<std::string, sqlite3_stmt*>::iterator itr = statements_.begin();
+        for (; itr != statements_.end(); ++itr)
+        {
+            sqlite3_finalize (itr->second);
+        }
+        statements_.clear();
+    }
+
+    static const std::size_t max_cached_statements = 32;
+
     sqlite3* db_;
     std::string file_;
+    std::map<std::string, sqlite3_stmt*> statements_;
+};
+
+//==============================================================================
+
+// Opens the read-only connections of a datasource's pool (see
+// mapnik::Pool) and replays the statements that attached databases and
+// indexes on the datasource's own connection.
+template <typename T>
+class sqlite_connection_creator
+{
+public:
+
+    sqlite_connection_creator (std::string const& file,
+                               std::vector<std::string> const& init_statements,
+                               int flags,
+                               int mmap_size)
+        : file_(file),
+          init_statements_(init_statements),
+          flags_(flags),
+          mmap_size_(mmap_size)
+    {
+    }
+
+    T* operator()() const
+    {
+        std::auto_ptr<T> conn(new T(file_, flags_));
+        sqlite3_busy_timeout(*(*conn), 5000);
+
+#if SQLITE_VERSION_NUMBER >= 3007017
+        if (mmap_size_ > 0)
+        {
+            std::ostringstream s;
+            s << "PRAGMA mmap_size=" << mmap_size_;
+            conn->execute_with_code(s.str());
+        }
+#endif
+
+        for (std::vector<std::string>::const_iterator iter = init_statements_.begin();
+             iter != init_statements_.end(); ++iter)
+        {
+            conn->execute(*iter);
+        }
+        return conn.release();
+    }
+
+private:
+
+    std::string file_;
+    std::vector<std::string> init_statements_;
+    int flags_;
+    int mmap_size_;
 };
 
 #endif // MAPNIK_SQLITE_CONNECTION_HPP
@@ -50,6 +50,28 @@ using mapnik::parameters;
 
 DATASOURCE_PLUGIN(sqlite_datasource)
 
+namespace {
+
+// deleter of a pooled connection lease: hands the connection back
+template <typename PoolT>
+struct connection_releaser
+{
+    connection_releaser(boost::shared_ptr<PoolT> const& pool,
+                        boost::shared_ptr<sqlite_connection> const& conn)
+        : pool_(pool),
+          conn_(conn) {}
+
+    void operator()(sqlite_connection*)
+    {
+        pool_->returnObject(conn_);
+    }
+
+    boost::shared_ptr<PoolT> pool_;
+    boost::shared_ptr<sqlite_connection> conn_;
+};
+
+}
+
 sqlite_datasource::sqlite_datasource(parameters const& params, bool bind)
 : datasource(params),
     extent_(),
@@ -66,7 +88,9 @@ sqlite_datasource::sqlite_datasource(parameters const& params, bool bind)
     row_limit_(*params_.get<int>("row_limit", 0)),
     intersects_token_("!intersects!"),
     desc_(*params_.get<std::string>("type"), *params_.get<std::string>("encoding", "utf-8")),
-    format_(mapnik::wkbAuto)
+    format_(mapnik::wkbAuto),
+    pool_max_size_(*params_.get<int>("max_size", 10)),
+    mmap_size_(*params_.get<int>("mmap_size", 268435456))
 {
     /* TODO
        - throw if no primary key but spatial index is present?
@@ -142,7 +166,7 @@ void sqlite_datasource::bind() const
     boost::optional<std::string> initdb = params_.get<std::string>("initdb");
     if (initdb)
     {
-        init_statements_.push_back(*initdb);
+        sqlite_utils::split_statements(*initdb, init_statements_);
     }
 
     // now actually create the connection and start executing setup sql
@@ -280,12 +304,30 @@ void sqlite_datasource::bind() const
 
     std::string index_db = sqlite_utils::index_for_db(dataset_name_);
 
+    // Pooled connections only replay the attach statements, the others
+    // ran once above and may have written to the database. What they made
+    // on connection local databases is only seen by the datasource's own
+    // connection, so then it serves all queries.
+    std::vector<std::string> pool_statements;
+    bool connection_local = false;
+    for (std::vector<std::string>::const_iterator iter = init_statements_.begin();
+         iter != init_statements_.end(); ++iter)
+    {
+        if (sqlite_utils::is_attach(*iter))
+        {
+            pool_statements.push_back(*iter);
+        }
+        connection_local = connection_local || sqlite_utils::is_connection_local(*iter);
+    }
+
     has_spatial_index_ = false;
     if (use_spatial_index_)
     {
+        bool attached = false;
         if (boost::filesystem::exists(index_db))
         {
             dataset_->execute("attach database '" + index_db + "' as " + index_table_);
+            attached = true;
         }
         has_spatial_index_ = sqlite_utils::has_rtree(index_table_,dataset_);
 
@@ -326,6 +368,7 @@ void sqlite_datasource::bind() const
                     if (boost::filesystem::exists(index_db))
                     {
                         dataset_->execute("attach database '" + index_db + "' as " + index_table_);
+                        attached = true;
                     }
                 }
             }
@@ -339,6 +382,23 @@ void sqlite_datasource::bind() const
                 throw datasource_exception(s.str());
             }
         }
+
+        if (attached)
+        {
+            pool_statements.push_back("attach database '" + index_db + "' as " + index_table_);
+        }
+    }
+
+    // every ':memory:' connection is a separate database, so those keep
+    // querying the datasource's own connection
+    if (dataset_name_.compare(":memory:") != 0 && !connection_local && pool_max_size_ > 0)
+    {
+        int flags = SQLITE_OPEN_READONLY;
+#if SQLITE_VERSION_NUMBER >= 3006018
+        flags |= SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_SHAREDCACHE;
+#endif
+        creator_.reset(new creator_type(dataset_name_, pool_statements, flags, mmap_size_));
+        pool_ = boost::make_shared<pool_type>(*creator_, 0, pool_max_size_);
     }
 
     if (! extent_initialized_)
@@ -380,6 +440,98 @@ std::string sqlite_datasource::populate_tokens(const std::string& sql) const
     return populated_sql;
 }
 
+std::string sqlite_datasource::prepare_query(mapnik::context_ptr & ctx,
+                                             std::vector<std::string> const& fields,
+                                             bool & bind_bbox) const
+{
+    std::ostringstream s;
+
+    s << "SELECT " << geometry_field_;
+    if (!key_field_.empty())
+    {
+        s << "," << key_field_;
+        ctx->push(key_field_);
+    }
+
+    std::vector<std::string>::const_iterator pos = fields.begin();
+    std::vector<std::string>::const_iterator end = fields.end();
+    for ( ;pos != end;++pos)
+    {
+        s << ",[" << *pos << "]";
+        ctx->push(*pos);
+    }
+    s << " FROM ";
+
+    std::string query(table_);
+
+    bind_bbox = false;
+    if (! key_field_.empty() && has_spatial_index_)
+    {
+        // the extent is bound to the statement so the sql stays the same
+        // from query to query and can be prepared once per connection
+        // TODO - debug warn if fails
+        bind_bbox = sqlite_utils::apply_spatial_filter(query,
+                                                       table_,
+                                                       key_field_,
+                                                       index_table_,
+                                                       geometry_table_,
+                                                       intersects_token_);
+    }
+    else
+    {
+        query = populate_tokens(table_);
+    }
+
+    s << query ;
+
+    if (row_limit_ > 0)
+    {
+        s << " LIMIT " << row_limit_;
+    }
+
+    if (row_offset_ > 0)
+    {
+        s << " OFFSET " << row_offset_;
+    }
+
+    return s.str();
+}
+
+boost::shared_ptr<sqlite_resultset> sqlite_datasource::execute_query(std::string const& sql,
+                                                                     box2d<double> const& e,
+                                                                     bool bind_bbox) const
+{
+    boost::shared_ptr<sqlite_resultset> rs;
+    if (pool_)
+    {
+        boost::shared_ptr<sqlite_connection> conn = pool_->borrowObject();
+        if (conn)
+        {
+            // the lease goes back to the pool once the resultset is done with it
+            boost::shared_ptr<sqlite_connection> lease(conn.get(),
+                                                       connection_releaser<pool_type>(pool_, conn));
+            rs = boost::make_shared<sqlite_resultset>(lease->prepare_cached(sql), lease);
+        }
+        else
+        {
+            // all pooled connections are busy: use one for this query only
+            boost::shared_ptr<sqlite_connection> transient((*creator_)());
+            rs = boost::make_shared<sqlite_resultset>(transient->prepare_cached(sql), transient);
+        }
+    }
+    else
+    {
+        rs = dataset_->execute_query(sql);
+    }
+
+    if (bind_bbox)
+    {
+        rs->bind_bbox(e);
+    }
+
+    return rs;
+}
+
 sqlite_datasource::~sqlite_datasource()
 {
 }
@@ -545,64 +697,21 @@ featureset_ptr sqlite_datasource::features(query const& q) const
     if (dataset_)
     {
         mapnik::box2d<double> const& e = q.get_bbox();
-
-        std::ostringstream s;
         mapnik::context_ptr ctx = boost::make_shared<mapnik::context_type>();
 
-        s << "SELECT " << geometry_field_;
-        if (!key_field_.empty())
-        {
-            s << "," << key_field_;
-            ctx->push(key_field_);
-        }
+        // TODO - should we restrict duplicate key query?
         std::set<std::string> const& props = q.property_names();
-        std::set<std::string>::const_iterator pos = props.begin();
-        std::set<std::string>::const_iterator end = props.end();
-
-        for ( ;pos != end;++pos)
-        {
-            // TODO - should we restrict duplicate key query?
-            //if (*pos != key_field_)
-            s << ",[" << *pos << "]";
-            ctx->push(*pos);
-        }
-        s << " FROM ";
-
-        std::string query(table_);
-
-        if (! key_field_.empty() && has_spatial_index_)
-        {
-            // TODO - debug warn if fails
-            sqlite_utils::apply_spatial_filter(query,
-                                               e,
-                                               table_,
-                                               key_field_,
-                                               index_table_,
-                                               geometry_table_,
-                                               intersects_token_);        }
-        else
-        {
-            query = populate_tokens(table_);
-        }
-
-        s << query ;
+        std::vector<std::string> fields(props.begin(), props.end());
 
-        if (row_limit_ > 0)
-        {
-            s << " LIMIT " << row_limit_;
-        }
-
-        if (row_offset_ > 0)
-        {
-            s << " OFFSET " << row_offset_;
-        }
+        bool bind_bbox;
+        std::string sql = prepare_query(ctx, fields, bind_bbox);
 
 #ifdef MAPNIK_DEBUG
         std::clog << "Sqlite Plugin: table: " << table_ << "\n\n";
-        std::clog << "Sqlite Plugin: query: " << s.str() << "\n\n";
+        std::clog << "Sqlite Plugin: query: " << sql << "\n\n";
 #endif
 
-        boost::shared_ptr<sqlite_resultset> rs(dataset_->execute_query(s.str()));
+        boost::shared_ptr<sqlite_resultset> rs(execute_query(sql, e, bind_bbox));
 
         return boost::make_shared<sqlite_featureset>(rs,
                                                      ctx,
@@ -622,17 +731,9 @@ featureset_ptr sqlite_datasource::features_at_point(coord2d const& pt) const
     {
         // TODO - need tolerance
         mapnik::box2d<double> const e(pt.x, pt.y, pt.x, pt.y);
-
-        std::ostringstream s;
         mapnik::context_ptr ctx = boost::make_shared<mapnik::context_type>();
 
-        s << "SELECT " << geometry_field_;
-        if (!key_field_.empty())
-        {
-            s << "," << key_field_;
-            ctx->push(key_field_);
-        }
-
+        std::vector<std::string> fields;
         std::vector<attribute_descriptor>::const_iterator itr = desc_.get_descriptors().begin();
         std::vector<attribute_descriptor>::const_iterator end = desc_.get_descriptors().end();
 
@@ -641,48 +742,18 @@ featureset_ptr sqlite_datasource::features_at_point(coord2d const& pt) const
             std::string fld_name = itr->get_name();
             if (fld_name != key_field_)
             {
-                s << ",[" << itr->get_name() << "]";
-                ctx->push(itr->get_name());
+                fields.push_back(fld_name);
             }
         }
 
-        s << " FROM ";
-
-        std::string query(table_);
-
-        if (! key_field_.empty() && has_spatial_index_)
-        {
-            // TODO - debug warn if fails
-            sqlite_utils::apply_spatial_filter(query,
-                                               e,
-                                               table_,
-                                               key_field_,
-                                               index_table_,
-                                               geometry_table_,
-                                               intersects_token_);
-        }
-        else
-        {
-            query = populate_tokens(table_);
-        }
-
-        s << query ;
-
-        if (row_limit_ > 0)
-        {
-            s << " LIMIT " << row_limit_;
-        }
-
-        if (row_offset_ > 0)
-        {
-            s << " OFFSET " << row_offset_;
-        }
+        bool bind_bbox;
+        std::string sql = prepare_query(ctx, fields, bind_bbox);
 
 #ifdef MAPNIK_DEBUG
-        std::clog << "Sqlite Plugin: " << s.str() << std::endl;
+        std::clog << "Sqlite Plugin: " << sql << std::endl;
 #endif
 
-        boost::shared_ptr<sqlite_resultset> rs(dataset_->execute_query(s.str()));
+        boost::shared_ptr<sqlite_resultset> rs(execute_query(sql, e, bind_bbox));
 
         return boost::make_shared<sqlite_featureset>(rs,
                                                      ctx,
@@ -28,6 +28,7 @@
 #include <mapnik/feature.hpp>
 #include <mapnik/feature_layer_desc.hpp>
 #include <mapnik/wkb.hpp>
+#include <mapnik/pool.hpp>
 
 // boost
 #include <boost/shared_ptr.hpp>
@@ -39,6 +40,9 @@
 
 class sqlite_datasource : public mapnik::datasource
 {
+    typedef sqlite_connection_creator<sqlite_connection> creator_type;
+    typedef mapnik::Pool<sqlite_connection, sqlite_connection_creator> pool_type;
+
 public:
     sqlite_datasource(mapnik::parameters const& params, bool bind = true);
     virtual ~sqlite_datasource ();
@@ -79,11 +83,23 @@ private:
     mutable bool has_spatial_index_;
     mutable bool using_subquery_;
     mutable std::vector<std::string> init_statements_;
+    // read-only connections shared by concurrent queries, each
+    // caching the statements it has prepared
+    mutable boost::scoped_ptr<creator_type> creator_;
+    mutable boost::shared_ptr<pool_type> pool_;
+    int pool_max_size_;
+    int mmap_size_;
 
     // Fill init_statements with any statements
     // needed to attach auxillary databases
     void parse_attachdb(std::string const& attachdb) const;
     std::string populate_tokens(const std::string& sql) const;
+    std::string prepare_query(mapnik::context_ptr & ctx,
+                              std::vector<std::string> const& fields,
+                              bool & bind_bbox) const;
+    boost::shared_ptr<sqlite_resultset> execute_query(std::string const& sql,
+                                                      mapnik::box2d<double> const& e,
+                                                      bool bind_bbox) const;
 };
 
 #endif // MAPNIK_SQLITE_DATASOURCE_HPP
@@ -25,6 +25,10 @@
 
 // mapnik
 #include <mapnik/datasource.hpp>
+#include <mapnik/box2d.hpp>
+
+// boost
+#include <boost/shared_ptr.hpp>
 
 // stl
 #include <string.h>
@@ -36,6 +40,8 @@ extern "C" {
 
 
 
+class sqlite_connection;
+
 //==============================================================================
 
 class sqlite_resultset
@@ -47,11 +53,39 @@ public:
     {
     }
 
+    // a statement cached by its connection: it is only reset when done and
+    // the connection is held (and released back to its pool) afterwards
+    sqlite_resultset (sqlite3_stmt* stmt, boost::shared_ptr<sqlite_connection> const& owner)
+        : stmt_(stmt),
+          owner_(owner)
+    {
+    }
+
     ~sqlite_resultset ()
     {
         if (stmt_)
         {
-            sqlite3_finalize (stmt_);
+            if (owner_)
+            {
+                sqlite3_reset (stmt_);
+                sqlite3_clear_bindings (stmt_);
+            }
+            else
+            {
+                sqlite3_finalize (stmt_);
+            }
+        }
+    }
+
+    // binds the ?1..?4 placeholders of a spatial filter
+    void bind_bbox (mapnik::box2d<double> const& bbox)
+    {
+        if ((sqlite3_bind_double(stmt_, 1, bbox.minx()) != SQLITE_OK) ||
+            (sqlite3_bind_double(stmt_, 2, bbox.maxx()) != SQLITE_OK) ||
+            (sqlite3_bind_double(stmt_, 3, bbox.miny()) != SQLITE_OK) ||
+            (sqlite3_bind_double(stmt_, 4, bbox.maxy()) != SQLITE_OK))
+        {
+            throw mapnik::datasource_exception("SQLite Plugin: invalid value for query extent");
         }
     }
 
@@ -138,6 +172,7 @@ public:
 private:
 
     sqlite3_stmt* stmt_;
+    boost::shared_ptr<sqlite_connection> owner_;
 };
 
 #endif // MAPNIK_SQLITE_RESULTSET_HPP
@@ -26,6 +26,8 @@
 // stl
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <cctype>
 
 // mapnik
 #include <mapnik/datasource.hpp>
@@ -39,6 +41,10 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/cstdint.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/thread.hpp>
+#endif
 
 // sqlite
 extern "C" {
@@ -108,6 +114,59 @@ public:
         //}
     }
 
+    // splits sql into its statements, sqlite tells where one is complete
+    static void split_statements(std::string const& sql, std::vector<std::string> & statements)
+    {
+        std::string statement;
+        for (std::string::const_iterator itr = sql.begin(); itr != sql.end(); ++itr)
+        {
+            statement += *itr;
+            if (*itr == ';' && sqlite3_complete(statement.c_str()))
+            {
+                boost::algorithm::trim(statement);
+                statements.push_back(statement);
+                statement.clear();
+            }
+        }
+        boost::algorithm::trim(statement);
+        if (! statement.empty())
+        {
+            statements.push_back(statement);
+        }
+    }
+
+    static bool is_attach(std::string const& statement)
+    {
+        return statement.size() > 6 &&
+            boost::algorithm::istarts_with(statement, "attach") &&
+            std::isspace(static_cast<unsigned char>(statement[6]));
+    }
+
+    // whether what the statement creates exists only on the connection it
+    // runs on: databases attached in memory or as temporary files, and
+    // temporary tables, views and triggers
+    static bool is_connection_local(std::string const& statement)
+    {
+        std::string upper = boost::algorithm::to_upper_copy(statement);
+        if (is_attach(statement))
+        {
+            std::string file = boost::algorithm::trim_copy(upper.substr(6));
+            if (boost::algorithm::starts_with(file, "DATABASE") &&
+                (file.size() == 8 || std::isspace(static_cast<unsigned char>(file[8]))))
+            {
+                boost::algorithm::trim(file.erase(0, 8));
+            }
+            return boost::algorithm::starts_with(file, "''") ||
+                boost::algorithm::starts_with(file, "\"\"") ||
+                file.find(":MEMORY:") != std::string::npos ||
+                file.find("MODE=MEMORY") != std::string::npos;
+        }
+        std::vector<std::string> words;
+        boost::algorithm::split(words, upper, !boost::algorithm::is_alnum() && !boost::algorithm::is_any_of("_"));
+        return std::find(words.begin(), words.end(), "TEMP") != words.end() ||
+            std::find(words.begin(), words.end(), "TEMPORARY") != words.end();
+    }
+
     static bool apply_spatial_filter(std::string & query,
                                      mapnik::box2d<double> const& e,
                                      std::string const& table,
@@ -121,9 +180,34 @@ public:
         spatial_sql << key_field << " IN (SELECT pkid FROM " << index_table;
         spatial_sql << " WHERE xmax>=" << e.minx() << " AND xmin<=" << e.maxx() ;
         spatial_sql << " AND ymax>=" << e.miny() << " AND ymin<=" << e.maxy() << ")";
+        return insert_spatial_filter(query, spatial_sql.str(), table, geometry_table, intersects_token);
+    }
+
+    // as above, but leaves ?1..?4 placeholders for minx, maxx, miny and
+    // maxy so the statement does not change with the query extent
+    // (see sqlite_resultset::bind_bbox)
+    static bool apply_spatial_filter(std::string & query,
+                                     std::string const& table,
+                                     std::string const& key_field,
+                                     std::string const& index_table,
+                                     std::string const& geometry_table,
+                                     std::string const& intersects_token)
+    {
+        std::ostringstream spatial_sql;
+        spatial_sql << key_field << " IN (SELECT pkid FROM " << index_table;
+        spatial_sql << " WHERE xmax>=?1 AND xmin<=?2 AND ymax>=?3 AND ymin<=?4)";
+        return insert_spatial_filter(query, spatial_sql.str(), table, geometry_table, intersects_token);
+    }
+
+    static bool insert_spatial_filter(std::string & query,
+                                      std::string const& spatial_sql,
+                                      std::string const& table,
+                                      std::string const& geometry_table,
+                                      std::string const& intersects_token)
+    {
         if (boost::algorithm::ifind_first(query,  intersects_token))
         {
-            boost::algorithm::ireplace_all(query, intersects_token, spatial_sql.str());
+            boost::algorithm::ireplace_all(query, intersects_token, spatial_sql);
             return true;
         }
         // substitute first WHERE found if not using JOIN
@@ -131,14 +215,14 @@ public:
         else if (boost::algorithm::ifind_first(query, "WHERE")
                  && !boost::algorithm::ifind_first(query, "JOIN"))
         {
-            std::string replace(" WHERE " + spatial_sql.str() + " AND ");
+            std::string replace(" WHERE " + spatial_sql + " AND ");
             boost::algorithm::ireplace_first(query, "WHERE", replace);
             return true;
         }
         // fallback to appending spatial filter at end of query
         else if (boost::algorithm::ifind_first(query, geometry_table))
         {
-            query = table + " WHERE " + spatial_sql.str();
+            query = table + " WHERE " + spatial_sql;
             return true;
         }
         return false;
@@ -213,198 +297,140 @@ public:
         }
     }
 
+    // Reads the bboxes of all rows of (geometry, key) from rs and writes
+    // them to a fresh rtree in Hilbert order of their centers, so that
+    // neighbouring features end up in the same rtree nodes.
     static bool create_spatial_index(std::string const& index_db,
                                      std::string const& index_table,
-                                     boost::shared_ptr<sqlite_resultset> rs)
+                                     boost::shared_ptr<sqlite_resultset> rs,
+                                     unsigned threads = 0)
     {
-        /* TODO
-           - speedups
-           - return early/recover from failure
-           - allow either in db or in separate
-        */
-
         if (!rs->is_valid())
             return false;
 
-#if SQLITE_VERSION_NUMBER >= 3005000
-        int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX;
-#else
-        int flags;
-#endif
+        std::vector<rtree_type> rtree_list;
+        build_tree(rs, rtree_list, threads);
+        sort_tree(rtree_list);
+        return create_spatial_index2(index_db, index_table, rtree_list);
+    }
 
-        bool existed = boost::filesystem::exists(index_db);
-        boost::shared_ptr<sqlite_connection> ds = boost::make_shared<sqlite_connection>(index_db,flags);
+    typedef struct {
+        sqlite_int64 pkid;
+        mapnik::box2d<double> bbox;
+    } rtree_type;
 
-        bool one_success = false;
-        try
+    // Rows are copied out of sqlite in batches whose WKB is then decoded
+    // on up to `threads` threads (0 for one per core). Every row with
+    // geometries yields one entry covering all of its parts.
+    static void build_tree(boost::shared_ptr<sqlite_resultset> rs,
+                           std::vector<sqlite_utils::rtree_type> & rtree_list,
+                           unsigned threads = 0)
+    {
+#ifdef MAPNIK_THREADSAFE
+        if (threads == 0)
         {
+            threads = std::max(1u, boost::thread::hardware_concurrency());
+        }
+#else
+        threads = 1;
+#endif
 
-            ds->execute("PRAGMA synchronous=OFF");
-            ds->execute("BEGIN IMMEDIATE TRANSACTION");
-
-            /*
-              ds->execute("PRAGMA journal_mode=WAL");
-              ds->execute("PRAGMA fullfsync=1");
-              ds->execute("PRAGMA locking_mode = EXCLUSIVE");
-              ds->execute("BEGIN EXCLUSIVE TRANSACTION");
-            */
-
-            // first drop the index if it already exists
-            std::ostringstream spatial_index_drop_sql;
-            spatial_index_drop_sql << "DROP TABLE IF EXISTS " << index_table;
-            ds->execute(spatial_index_drop_sql.str());
-
-            // create the spatial index
-            std::ostringstream create_idx;
-            create_idx << "create virtual table "
-                       << index_table
-                       << " using rtree(pkid, xmin, xmax, ymin, ymax)";
-
-            // insert for prepared statement
-            std::ostringstream insert_idx;
-            insert_idx << "insert into "
-                       << index_table
-                       << " values (?,?,?,?,?)";
-
-            ds->execute(create_idx.str());
-
-            prepared_index_statement ps(ds,insert_idx.str());
-
-            while (rs->is_valid() && rs->step_next())
+        wkb_batch batch;
+        bool more = rs->is_valid();
+        while (more)
+        {
+            batch.clear();
+            while (batch.pkids.size() < batch_size)
             {
+                // stepping a finished statement would restart it
+                if (! rs->step_next())
+                {
+                    more = false;
+                    break;
+                }
                 int size;
-                const char* data = (const char*) rs->column_blob(0, size);
+                const char* data = static_cast<const char*>(rs->column_blob(0, size));
                 if (data)
                 {
-                    boost::ptr_vector<mapnik::geometry_type> paths;
-                    mapnik::geometry_utils::from_wkb(paths, data, size, mapnik::wkbAuto);
-                    mapnik::box2d<double> bbox;
-                    for (unsigned i=0; i<paths.size(); ++i)
-                    {
-                        if (i==0)
-                        {
-                            bbox = paths[i].envelope();
-                        }
-                        else
-                        {
-                            bbox.expand_to_include(paths[i].envelope());
-                        }
-                    }
-                    if (bbox.valid())
-                    {
-
-                        ps.bind(bbox);
-
-                        const int type_oid = rs->column_type(1);
-                        if (type_oid != SQLITE_INTEGER)
-                        {
-                            std::ostringstream error_msg;
-                            error_msg << "Sqlite Plugin: invalid type for key field '"
-                                      << rs->column_name(1) << "' when creating index '" << index_table
-                                      << "' type was: " << type_oid << "";
-                            throw mapnik::datasource_exception(error_msg.str());
-                        }
-
-                        const sqlite_int64 pkid = rs->column_integer64(1);
-                        ps.bind(pkid);
-                    }
-                    else
+                    const int type_oid = rs->column_type(1);
+                    if (type_oid != SQLITE_INTEGER)
                     {
                         std::ostringstream error_msg;
-                        error_msg << "SQLite Plugin: encountered invalid bbox at '"
-                                  << rs->column_name(1) << "' == " << rs->column_integer64(1);
+                        error_msg << "Sqlite Plugin: invalid type for key field '"
+                                  << rs->column_name(1) << "' when creating index "
+                                  << "type was: " << type_oid << "";
                         throw mapnik::datasource_exception(error_msg.str());
                     }
-
-                    ps.step_next();
-                    one_success = true;
+                    batch.add(rs->column_integer64(1), data, size);
                 }
             }
-        }
-        catch (mapnik::datasource_exception const& ex)
-        {
-            if (!existed)
+            if (batch.pkids.empty())
             {
-                try
-                {
-                    boost::filesystem::remove(index_db);
-                }
-                catch (...) {};
+                break;
             }
-            throw mapnik::datasource_exception(ex.what());
-        }
 
-        if (one_success)
-        {
-            ds->execute("COMMIT");
-            return true;
-        }
-        else if (!existed)
-        {
-            try
+            batch.decode(threads);
+
+            for (std::size_t i = 0; i < batch.pkids.size(); ++i)
             {
-                boost::filesystem::remove(index_db);
+                // like rows whose geometry is NULL, rows without any
+                // geometry in their WKB are not indexed
+                if (batch.parts[i] == 0)
+                {
+                    continue;
+                }
+                if (! batch.boxes[i].valid())
+                {
+                    std::ostringstream error_msg;
+                    error_msg << "SQLite Plugin: encountered invalid bbox at '"
+                              << rs->column_name(1) << "' == " << batch.pkids[i];
+                    throw mapnik::datasource_exception(error_msg.str());
+                }
+                rtree_type entry = rtree_type();
+                entry.pkid = batch.pkids[i];
+                entry.bbox = batch.boxes[i];
+                rtree_list.push_back(entry);
             }
-            catch (...) {};
         }
-        return false;
     }
 
-    typedef struct {
-        sqlite_int64 pkid;
-        mapnik::box2d<double> bbox;
-    } rtree_type;
-
-    static void build_tree(boost::shared_ptr<sqlite_resultset> rs,
-                           std::vector<sqlite_utils::rtree_type> & rtree_list)
+    // orders entries along a Hilbert curve through their bbox centers
+    static void sort_tree(std::vector<rtree_type> & rtree_list)
     {
+        if (rtree_list.size() < 2)
+            return;
 
-        while (rs->is_valid() && rs->step_next())
+        mapnik::box2d<double> extent(rtree_list[0].bbox);
+        std::vector<rtree_type>::const_iterator itr = rtree_list.begin();
+        for (; itr != rtree_list.end(); ++itr)
         {
-            int size;
-            const char* data = static_cast<const char*>(rs->column_blob(0, size));
-            if (data)
-            {
-                boost::ptr_vector<mapnik::geometry_type> paths;
-                mapnik::geometry_utils::from_wkb(paths, data, size, mapnik::wkbAuto);
-                for (unsigned i=0; i<paths.size(); ++i)
-                {
-                    mapnik::box2d<double> const& bbox = paths[i].envelope();
-                    if (bbox.valid())
-                    {
-
-                        const int type_oid = rs->column_type(1);
-                        if (type_oid != SQLITE_INTEGER)
-                        {
-                            std::ostringstream error_msg;
-                            error_msg << "Sqlite Plugin: invalid type for key field '"
-                                      << rs->column_name(1) << "' when creating index "
-                                      << "type was: " << type_oid << "";
-                            throw mapnik::datasource_exception(error_msg.str());
-                        }
+            extent.expand_to_include(itr->bbox);
+        }
 
-                        const sqlite_int64 pkid = rs->column_integer64(1);
+        const double side = 65535.0;
+        double sx = extent.width() > 0 ? side / extent.width() : 0.0;
+        double sy = extent.height() > 0 ? side / extent.height() : 0.0;
 
-                        rtree_type entry = rtree_type();
-                        entry.pkid = pkid;
-                        entry.bbox = bbox;
-                        rtree_list.push_back(entry);
+        std::vector<std::pair<boost::uint32_t, std::size_t> > order;
+        order.reserve(rtree_list.size());
+        for (std::size_t i = 0; i < rtree_list.size(); ++i)
+        {
+            mapnik::coord2d c = rtree_list[i].bbox.center();
+            boost::uint32_t x = static_cast<boost::uint32_t>((c.x - extent.minx()) * sx);
+            boost::uint32_t y = static_cast<boost::uint32_t>((c.y - extent.miny()) * sy);
+            order.push_back(std::make_pair(hilbert_index(x, y), i));
+        }
+        std::sort(order.begin(), order.end());
 
-                    }
-                    else
-                    {
-                        std::ostringstream error_msg;
-                        error_msg << "SQLite Plugin: encountered invalid bbox at '"
-                                  << rs->column_name(1) << "' == " << rs->column_integer64(1);
-                        throw mapnik::datasource_exception(error_msg.str());
-                    }
-                }
-            }
+        std::vector<rtree_type> sorted;
+        sorted.reserve(rtree_list.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+        {
+            sorted.push_back(rtree_list[order[i].second]);
         }
+        rtree_list.swap(sorted);
     }
 
-
-
     static bool create_spatial_index2(std::string const& index_db,
                                       std::string const& index_table,
                                       std::vector<rtree_type> const& rtree_list)
@@ -724,6 +750,126 @@ public:
 
         return found_table;
     }
+
+private:
+
+    static const std::size_t batch_size = 16384;
+
+    // position of (x, y) on a 16 bit Hilbert curve
+    static boost::uint32_t hilbert_index(boost::uint32_t x, boost::uint32_t y)
+    {
+        const boost::uint32_t n = 1 << 16;
+        boost::uint32_t d = 0;
+        for (boost::uint32_t s = n >> 1; s > 0; s >>= 1)
+        {
+            boost::uint32_t rx = (x & s) > 0;
+            boost::uint32_t ry = (y & s) > 0;
+            d += s * s * ((3 * rx) ^ ry);
+            if (ry == 0)
+            {
+                if (rx == 1)
+                {
+                    x = n - 1 - x;
+                    y = n - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return d;
+    }
+
+    struct wkb_batch
+    {
+        std::vector<char> data;
+        std::vector<std::size_t> offsets;
+        std::vector<sqlite_int64> pkids;
+        std::vector<mapnik::box2d<double> > boxes;
+        std::vector<unsigned> parts;
+
+        void clear()
+        {
+            data.clear();
+            offsets.assign(1, 0);
+            pkids.clear();
+        }
+
+        void add(sqlite_int64 pkid, const char* wkb, int size)
+        {
+            data.insert(data.end(), wkb, wkb + size);
+            offsets.push_back(data.size());
+            pkids.push_back(pkid);
+        }
+
+        void decode(unsigned threads)
+        {
+            boxes.assign(pkids.size(), mapnik::box2d<double>());
+            parts.assign(pkids.size(), 0);
+            std::size_t count = pkids.size();
+            // not worth a thread below a few hundred rows each
+            std::size_t chunks = std::min<std::size_t>(threads, (count + 255) / 256);
+#ifdef MAPNIK_THREADSAFE
+            if (chunks > 1)
+            {
+                boost::thread_group group;
+                for (std::size_t i = 0; i < chunks; ++i)
+                {
+                    group.create_thread(decoder(*this, count * i / chunks, count * (i + 1) / chunks));
+                }
+                group.join_all();
+                return;
+            }
+#endif
+            decoder(*this, 0, count)();
+        }
+    };
+
+    struct decoder
+    {
+        decoder(wkb_batch & batch, std::size_t begin, std::size_t end)
+            : batch_(batch),
+              begin_(begin),
+              end_(end) {}
+
+        void operator()()
+        {
+            for (std::size_t i = begin_; i < end_; ++i)
+            {
+                std::size_t offset = batch_.offsets[i];
+                std::size_t size = batch_.offsets[i + 1] - offset;
+                if (size == 0)
+                {
+                    continue;
+                }
+                boost::ptr_vector<mapnik::geometry_type> paths;
+                mapnik::geometry_utils::from_wkb(paths, &batch_.data[offset], size, mapnik::wkbAuto);
+                mapnik::box2d<double> & bbox = batch_.boxes[i];
+                bool valid = true;
+                for (unsigned j = 0; j < paths.size(); ++j)
+                {
+                    mapnik::box2d<double> const& envelope = paths[j].envelope();
+                    valid = valid && envelope.valid();
+                    if (j == 0)
+                    {
+                        bbox = envelope;
+                    }
+                    else
+                    {
+                        bbox.expand_to_include(envelope);
+                    }
+                }
+                // a part without a valid bbox makes the row fail
+                if (! valid)
+                {
+                    bbox = mapnik::box2d<double>();
+                }
+                batch_.parts[i] = paths.size();
+            }
+        }
+
+        wkb_batch & batch_;
+        std::size_t begin_;
+        std::size_t end_;
+    };
 };
 
 #endif // MAPNIK_SQLITE_UTILS_HPP
@@ -24,6 +24,11 @@
 // mapnik
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_rasterizer.hpp>
+#include <mapnik/building_batch.hpp>
+#include <mapnik/agg_pattern_cache.hpp>
+#include <mapnik/layer_render_cache.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/datasource.hpp>
 #include <mapnik/marker.hpp>
 #include <mapnik/marker_cache.hpp>
 #include <mapnik/unicode.hpp>
@@ -73,6 +78,8 @@
 // boost
 #include <boost/utility.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/foreach.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/math/special_functions/round.hpp>
 
 // stl
@@ -81,35 +88,10 @@
 #endif
 
 #include <cmath>
+#include <sstream>
 
 namespace mapnik
 {
-class pattern_source : private boost::noncopyable
-{
-public:
-    pattern_source(image_data_32 const& pattern)
-        : pattern_(pattern) {}
-
-    unsigned int width() const
-    {
-        return pattern_.width();
-    }
-    unsigned int height() const
-    {
-        return pattern_.height();
-    }
-    agg::rgba8 pixel(int x, int y) const
-    {
-        unsigned c = pattern_(x,y);
-        return agg::rgba8(c & 0xff,
-                          (c >> 8) & 0xff,
-                          (c >> 16) & 0xff,
-                          (c >> 24) & 0xff);
-    }
-private:
-    image_data_32 const& pattern_;
-};
-
 
 template <typename T>
 agg_renderer<T>::agg_renderer(Map const& m, T & pixmap, double scale_factor, unsigned offset_x, unsigned offset_y)
@@ -122,7 +104,15 @@ agg_renderer<T>::agg_renderer(Map const& m, T & pixmap, double scale_factor, uns
       font_engine_(),
       font_manager_(font_engine_),
       detector_(boost::make_shared<label_collision_detector4>(box2d<double>(-m.buffer_size(), -m.buffer_size(), m.width() + m.buffer_size() ,m.height() + m.buffer_size()))),
-      ras_ptr(new rasterizer)
+      ras_ptr(new rasterizer),
+      min_feature_size_(0.0),
+      batch_polygons_(false),
+      batch_sym_(0),
+      buildings_(new building_batch),
+      patterns_(new pattern_cache),
+      map_(0),
+      layer_cached_(false),
+      painted_before_layer_(false)
 {
     setup(m);
 }
@@ -139,7 +129,15 @@ agg_renderer<T>::agg_renderer(Map const& m, T & pixmap, boost::shared_ptr<label_
       font_engine_(),
       font_manager_(font_engine_),
       detector_(detector),
-      ras_ptr(new rasterizer)
+      ras_ptr(new rasterizer),
+      min_feature_size_(0.0),
+      batch_polygons_(false),
+      batch_sym_(0),
+      buildings_(new building_batch),
+      patterns_(new pattern_cache),
+      map_(0),
+      layer_cached_(false),
+      painted_before_layer_(false)
 {
     setup(m);
 }
@@ -180,7 +178,16 @@ void agg_renderer<T>::setup(Map const &m)
 }
 
 template <typename T>
-agg_renderer<T>::~agg_renderer() {}
+agg_renderer<T>::~agg_renderer()
+{
+    // a layer that threw while rendered for the cache still
+    // holds the map rendered before it
+    if (layer_capture_)
+    {
+        detector_->record(0);
+        pixmap_.data().swap(layer_capture_->image);
+    }
+}
 
 template <typename T>
 void agg_renderer<T>::start_map_processing(Map const& map)
@@ -190,6 +197,17 @@ void agg_renderer<T>::start_map_processing(Map const& map)
               << map.get_current_extent() << "\n";
 #endif
     ras_ptr->clip_box(0,0,width_,height_);
+    map_ = &map;
+
+    // a cached layer is only reused by a render of the same area at the
+    // same size and scale, the screen box accounts for metatile offsets
+    std::ostringstream s;
+    s.precision(17);
+    s << map.srs() << "\n" << map.width() << "x" << map.height()
+      << " " << width_ << "x" << height_ << " buffer " << map.buffer_size()
+      << " scale " << scale_factor_ << "\n" << map.get_current_extent()
+      << "\n" << t_.forward(map.get_current_extent());
+    map_key_ = s.str();
 }
 
 template <typename T>
@@ -213,6 +231,28 @@ void agg_renderer<T>::start_layer_processing(layer const& lay, box2d<double> con
         detector_->clear();
     }
     query_extent_ = query_extent;
+    min_feature_size_ = lay.min_feature_size();
+
+    layer_cached_ = false;
+    if (lay.cache_rendering() && composites_over(lay))
+    {
+        std::string key = layer_cache_key(lay);
+        boost::optional<cached_layer_ptr> cached = layer_render_cache::instance()->find(key, width_, height_);
+        if (cached)
+        {
+            draw_cached_layer(**cached);
+            layer_cached_ = true;
+            return;
+        }
+        // render the layer on its own: the map so far goes into the
+        // capture and the pixmap starts out transparent
+        layer_key_ = key;
+        layer_capture_ = boost::make_shared<cached_layer>(width_, height_);
+        pixmap_.data().swap(layer_capture_->image);
+        painted_before_layer_ = pixmap_.painted();
+        pixmap_.painted(false);
+        detector_->record(&layer_capture_->labels);
+    }
 }
 
 template <typename T>
@@ -221,6 +261,137 @@ void agg_renderer<T>::end_layer_processing(layer const&)
 #ifdef MAPNIK_DEBUG
     std::clog << "end layer processing\n";
 #endif
+    if (layer_capture_)
+    {
+        detector_->record(0);
+        // swap back, the capture now holds the layer alone
+        pixmap_.data().swap(layer_capture_->image);
+        layer_capture_->painted = pixmap_.painted();
+        pixmap_.painted(painted_before_layer_);
+        // labels are in the detector already
+        pixmap_.set_rectangle_alpha2(layer_capture_->image, 0, 0, 1.0f);
+        if (layer_capture_->painted) pixmap_.painted(true);
+        layer_render_cache::instance()->insert(layer_key_, layer_capture_);
+        layer_capture_.reset();
+    }
+}
+
+// Whether lay renders the same onto a transparent image composited over
+// the map as onto the map itself. Raster modes other than normal blend
+// with what is below, the layer is then rendered uncached.
+template <typename T>
+bool agg_renderer<T>::composites_over(layer const& lay) const
+{
+    BOOST_FOREACH(std::string const& style_name, lay.styles())
+    {
+        boost::optional<feature_type_style const&> style = map_->find_style(style_name);
+        if (!style) continue;
+        BOOST_FOREACH(rule const& r, style->get_rules())
+        {
+            BOOST_FOREACH(symbolizer const& sym, r.get_symbolizers())
+            {
+                raster_symbolizer const* raster = boost::get<raster_symbolizer>(&sym);
+                if (raster && raster->get_mode_enum() != RASTER_MODE_NORMAL)
+                {
+#ifdef MAPNIK_DEBUG
+                    std::clog << "Mapnik LOG> layer " << lay.name() << " not cached, raster mode "
+                              << raster->get_mode() << " blends with the layers below\n";
+#endif
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Identifies a rendering of lay in the layer_render_cache. Styles are
+// named, not compared, so changing them needs the cache cleared. Labels
+// placed before the layer decide where its labels go, so the labels in
+// the collision detector are part of the key.
+template <typename T>
+std::string agg_renderer<T>::layer_cache_key(layer const& lay) const
+{
+    std::ostringstream s;
+    s << lay.name() << "\n" << lay.srs() << "\n";
+    BOOST_FOREACH(std::string const& style, lay.styles())
+    {
+        s << style << ",";
+    }
+    s << "\n";
+    datasource_ptr ds = lay.datasource();
+    if (ds)
+    {
+        parameters const& params = ds->params();
+        for (parameters::const_iterator itr = params.begin(); itr != params.end(); ++itr)
+        {
+            s << itr->first << "=" << *params.get<std::string>(itr->first, "") << ",";
+        }
+    }
+    s << "\n" << map_key_;
+
+    // FNV-1a of the label boxes and texts, in quad tree order
+    boost::uint64_t hash = 14695981039346656037ULL;
+    unsigned count = 0;
+    for (label_collision_detector4::query_iterator itr = detector_->begin(); itr != detector_->end(); ++itr, ++count)
+    {
+        double coords[4] = { itr->box.minx(), itr->box.miny(), itr->box.maxx(), itr->box.maxy() };
+        unsigned char const* bytes = reinterpret_cast<unsigned char const*>(coords);
+        for (unsigned i = 0; i < sizeof(coords); ++i)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+        for (int32_t i = 0; i < itr->text.length(); ++i)
+        {
+            hash = (hash ^ itr->text.charAt(i)) * 1099511628211ULL;
+        }
+        hash = (hash ^ 0xff) * 1099511628211ULL;
+    }
+    s << "\nlabels " << count << " " << std::hex << hash;
+    return s.str();
+}
+
+// the same compositing as a layer rendered into the capture, and the
+// labels the layer placed back into the collision detector
+template <typename T>
+void agg_renderer<T>::draw_cached_layer(cached_layer const& cached)
+{
+    pixmap_.set_rectangle_alpha2(cached.image, 0, 0, 1.0f);
+    if (cached.painted) pixmap_.painted(true);
+    BOOST_FOREACH(label_collision_detector4::label const& lbl, cached.labels)
+    {
+        detector_->insert(lbl.box, lbl.text);
+    }
+}
+
+// Whether geom covers less than the layer's min-feature-size on screen in
+// both directions; screen_box is then its screen extent.
+template <typename T>
+bool agg_renderer<T>::below_min_size(geometry_type const& geom,
+                                     proj_transform const& prj_trans,
+                                     box2d<double> & screen_box) const
+{
+    if (min_feature_size_ <= 0.0)
+    {
+        return false;
+    }
+    screen_box = t_.forward(geom.envelope(), prj_trans);
+    return screen_box.width() < min_feature_size_ &&
+        screen_box.height() < min_feature_size_;
+}
+
+template <typename T>
+void agg_renderer<T>::start_style_processing(feature_type_style const& st)
+{
+    batch_polygons_ = st.batch_polygons();
+}
+
+template <typename T>
+void agg_renderer<T>::end_style_processing(feature_type_style const&)
+{
+    flush_polygons();
+    flush_buildings();
+    batch_polygons_ = false;
 }
 
 template <typename T>
@@ -24,12 +24,9 @@
 // mapnik
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_rasterizer.hpp>
-#include <mapnik/segment.hpp>
+#include <mapnik/building_batch.hpp>
 #include <mapnik/expression_evaluator.hpp>
 
-// boost
-#include <boost/scoped_ptr.hpp>
-
 // agg
 #include "agg_basics.h"
 #include "agg_rendering_buffer.h"
@@ -42,30 +39,25 @@
 namespace mapnik
 {
 
+namespace {
+
+// map to screen, false when the point does not project
+inline bool to_screen(CoordTransform const& t, proj_transform const& prj_trans,
+                      double & x, double & y)
+{
+    double z = 0;
+    if (!prj_trans.backward(x, y, z)) return false;
+    t.forward(&x, &y);
+    return true;
+}
+
+}
+
 template <typename T>
 void agg_renderer<T>::process(building_symbolizer const& sym,
                               mapnik::feature_ptr const& feature,
                               proj_transform const& prj_trans)
 {
-    typedef coord_transform2<CoordTransform,geometry_type> path_type;
-    typedef agg::renderer_base<agg::pixfmt_rgba32_plain> ren_base;
-    typedef agg::renderer_scanline_aa_solid<ren_base> renderer;
-
-    agg::rendering_buffer buf(pixmap_.raw_data(),width_,height_, width_ * 4);
-    agg::pixfmt_rgba32_plain pixf(buf);
-    ren_base renb(pixf);
-
-    color const& fill_  = sym.get_fill();
-    unsigned r=fill_.red();
-    unsigned g=fill_.green();
-    unsigned b=fill_.blue();
-    unsigned a=fill_.alpha();
-    renderer ren(renb);
-    agg::scanline_u8 sl;
-
-    ras_ptr->reset();
-    ras_ptr->gamma(agg::gamma_power());
-
     double height = 0.0;
     expression_ptr height_expr = sym.height();
     if (height_expr)
@@ -74,91 +66,137 @@ void agg_renderer<T>::process(building_symbolizer const& sym,
         height = result.to_double() * scale_factor_;
     }
 
+    // walls, frame and roof are collected in screen coordinates and drawn
+    // back to front with the other buildings of the style in flush_buildings
+    building_batch & batch = *buildings_;
     for (unsigned i=0;i<feature->num_geometries();++i)
     {
         geometry_type const& geom = feature->get_geometry(i);
         if (geom.num_points() > 2)
         {
-            boost::scoped_ptr<geometry_type> frame(new geometry_type(LineString));
-            boost::scoped_ptr<geometry_type> roof(new geometry_type(Polygon));
-            std::deque<segment_t> face_segments;
-            double x0(0);
-            double y0(0);
+            batch.start(sym.get_fill(), sym.get_opacity());
+            double depth = 0;
+            bool first = true;
+            bool has_prev = false;
+            double px0(0), py0(0), px1(0), py1(0);
 
             geom.rewind(0);
-            unsigned cm = geom.vertex(&x0,&y0);
-            for (unsigned j=1;j<geom.num_points();++j)
+            for (unsigned j=0;j<geom.num_points();++j)
             {
                 double x(0);
                 double y(0);
-                cm = geom.vertex(&x,&y);
-                if (cm == SEG_MOVETO)
+                unsigned cm = geom.vertex(&x,&y);
+                double x0(x), y0(y), x1(x), y1(y + height);
+                if (!to_screen(t_, prj_trans, x0, y0) ||
+                    !to_screen(t_, prj_trans, x1, y1))
                 {
-                    frame->move_to(x,y);
+                    has_prev = false;
+                    continue;
                 }
-                else if (cm == SEG_LINETO)
+                if (cm == SEG_LINETO && has_prev)
                 {
-                    frame->line_to(x,y);
-                    face_segments.push_back(segment_t(x0,y0,x,y));
+                    batch.add_wall(px0, py0, x0, y0, px1, py1, x1, y1);
                 }
-
-                x0 = x;
-                y0 = y;
-            }
-            std::sort(face_segments.begin(),face_segments.end(), y_order);
-            std::deque<segment_t>::const_iterator itr=face_segments.begin();
-            for (;itr!=face_segments.end();++itr)
-            {
-                boost::scoped_ptr<geometry_type> faces(new geometry_type(Polygon));
-                faces->move_to(itr->get<0>(),itr->get<1>());
-                faces->line_to(itr->get<2>(),itr->get<3>());
-                faces->line_to(itr->get<2>(),itr->get<3>() + height);
-                faces->line_to(itr->get<0>(),itr->get<1>() + height);
-
-                path_type faces_path (t_,*faces,prj_trans);
-                ras_ptr->add_path(faces_path);
-                ren.color(agg::rgba8(int(r*0.8), int(g*0.8), int(b*0.8), int(a * sym.get_opacity())));
-                agg::render_scanlines(*ras_ptr, sl, ren);
-                ras_ptr->reset();
-
-                frame->move_to(itr->get<0>(),itr->get<1>());
-                frame->line_to(itr->get<0>(),itr->get<1>()+height);
+                // footprint and the vertical edges
+                batch.add_frame(x0, y0, (cm == SEG_LINETO && has_prev) ? SEG_LINETO : SEG_MOVETO);
+                batch.add_frame(x1, y1, SEG_MOVETO);
+                batch.add_frame(x0, y0, SEG_LINETO);
+                batch.add_frame(x0, y0, SEG_MOVETO);
+                if (first || y0 > depth) depth = y0;
+                first = false;
+                has_prev = (cm == SEG_MOVETO || cm == SEG_LINETO);
+                px0 = x0; py0 = y0;
+                px1 = x1; py1 = y1;
             }
+            batch.set_depth(depth);
 
+            // roof and its outline
             geom.rewind(0);
+            bool roof_started = false;
             for (unsigned j=0;j<geom.num_points();++j)
             {
                 double x,y;
                 unsigned cm = geom.vertex(&x,&y);
-                if (cm == SEG_MOVETO)
-                {
-                    frame->move_to(x,y+height);
-                    roof->move_to(x,y+height);
-                }
-                else if (cm == SEG_LINETO)
-                {
-                    frame->line_to(x,y+height);
-                    roof->line_to(x,y+height);
-                }
+                y += height;
+                if (!to_screen(t_, prj_trans, x, y)) continue;
+                unsigned cmd = (cm == SEG_LINETO && roof_started) ? SEG_LINETO : SEG_MOVETO;
+                batch.add_frame(x, y, cmd);
+                batch.add_roof(x, y, cmd);
+                roof_started = true;
             }
+        }
+    }
+}
+
+template <typename T>
+void agg_renderer<T>::flush_buildings()
+{
+    building_batch & batch = *buildings_;
+    if (batch.empty()) return;
+
+    typedef agg::renderer_base<agg::pixfmt_rgba32_plain> ren_base;
+    typedef agg::renderer_scanline_aa_solid<ren_base> renderer;
+
+    agg::rendering_buffer buf(pixmap_.raw_data(),width_,height_, width_ * 4);
+    agg::pixfmt_rgba32_plain pixf(buf);
+    ren_base renb(pixf);
+    renderer ren(renb);
+    agg::scanline_u8 sl;
+
+    ras_ptr->reset();
+    ras_ptr->gamma(agg::gamma_power());
+
+    batch.sort();
+    for (unsigned begin = 0; begin < batch.size(); )
+    {
+        // buildings of a group do not overlap, so all their walls, then all
+        // frames, then all roofs look the same as drawing them one by one
+        unsigned end = batch.group_end(begin);
+        building_batch::building const& first = batch.at(begin);
+        color const& fill = first.fill;
+        unsigned r=fill.red();
+        unsigned g=fill.green();
+        unsigned b=fill.blue();
+        unsigned a=fill.alpha();
+        double opacity = first.opacity;
+
+        for (unsigned k = begin; k < end; ++k)
+        {
+            building_batch::path_range walls = batch.walls(batch.at(k));
+            ras_ptr->add_path(walls);
+        }
+        ren.color(agg::rgba8(int(r*0.8), int(g*0.8), int(b*0.8), int(a * opacity)));
+        agg::render_scanlines(*ras_ptr, sl, ren);
+        ras_ptr->reset();
 
-            path_type path(t_,*frame,prj_trans);
-            agg::conv_stroke<path_type> stroke(path);
+        for (unsigned k = begin; k < end; ++k)
+        {
+            building_batch::path_range frame = batch.frame(batch.at(k));
+            agg::conv_stroke<building_batch::path_range> stroke(frame);
             ras_ptr->add_path(stroke);
-            ren.color(agg::rgba8(int(r*0.8), int(g*0.8), int(b*0.8), int(255 * sym.get_opacity())));
-            agg::render_scanlines(*ras_ptr, sl, ren);
-            ras_ptr->reset();
-
-            path_type roof_path (t_,*roof,prj_trans);
-            ras_ptr->add_path(roof_path);
-            ren.color(agg::rgba8(r, g, b, int(a * sym.get_opacity())));
-            agg::render_scanlines(*ras_ptr, sl, ren);
         }
+        ren.color(agg::rgba8(int(r*0.8), int(g*0.8), int(b*0.8), int(255 * opacity)));
+        agg::render_scanlines(*ras_ptr, sl, ren);
+        ras_ptr->reset();
+
+        for (unsigned k = begin; k < end; ++k)
+        {
+            building_batch::path_range roof = batch.roof(batch.at(k));
+            ras_ptr->add_path(roof);
+        }
+        ren.color(agg::rgba8(r, g, b, int(a * opacity)));
+        agg::render_scanlines(*ras_ptr, sl, ren);
+        ras_ptr->reset();
+
+        begin = end;
     }
+    batch.clear();
 }
 
 template void agg_renderer<image_32>::process(building_symbolizer const&,
                                               mapnik::feature_ptr const&,
                                               proj_transform const&);
 
+template void agg_renderer<image_32>::flush_buildings();
+
 }
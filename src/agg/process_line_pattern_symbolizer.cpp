@@ -24,10 +24,8 @@
 // mapnik
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_rasterizer.hpp>
-#include <mapnik/agg_pattern_source.hpp>
+#include <mapnik/agg_pattern_cache.hpp>
 #include <mapnik/expression_evaluator.hpp>
-#include <mapnik/marker.hpp>
-#include <mapnik/marker_cache.hpp>
 #include <mapnik/line_pattern_symbolizer.hpp>
 
 // agg
@@ -54,35 +52,22 @@ void  agg_renderer<T>::process(line_pattern_symbolizer const& sym,
 {
     typedef agg::conv_clip_polyline<geometry_type> clipped_geometry_type;
     typedef coord_transform2<CoordTransform,clipped_geometry_type> path_type;
-    typedef agg::line_image_pattern<agg::pattern_filter_bilinear_rgba8> pattern_type;
+    typedef line_pattern::pattern_type pattern_type;
     typedef agg::renderer_base<agg::pixfmt_rgba32_plain> renderer_base;
     typedef agg::renderer_outline_image<renderer_base, pattern_type> renderer_type;
     typedef agg::rasterizer_outline_aa<renderer_type> rasterizer_type;
 
+    marker_key key_buffer;
+    marker_key const& filename_key = sym.get_filename_key(*feature, key_buffer);
+    pattern_cache::line_pattern_ptr const& pat = patterns_->line(&sym, filename_key);
+    if (!pat) return;
+
     agg::rendering_buffer buf(pixmap_.raw_data(),width_,height_, width_ * 4);
     agg::pixfmt_rgba32_plain pixf(buf);
 
-    std::string filename = path_processor_type::evaluate( *sym.get_filename(), *feature);
-
-    boost::optional<marker_ptr> mark = marker_cache::instance()->find(filename,true);
-    if (!mark) return;
-
-    if (!(*mark)->is_bitmap())
-    {
-        std::clog << "### Warning only images (not '" << filename << "') are supported in the line_pattern_symbolizer\n";
-        return;
-    }
-
-    boost::optional<image_ptr> pat = (*mark)->get_bitmap_data();
-
-    if (!pat) return;
-
     box2d<double> ext = query_extent_ * 1.1;
     renderer_base ren_base(pixf);
-    agg::pattern_filter_bilinear_rgba8 filter;
-    pattern_source source(*(*pat));
-    pattern_type pattern (filter,source);
-    renderer_type ren(ren_base, pattern);
+    renderer_type ren(ren_base, pat->pattern);
     // TODO - should be sensitive to buffer size
     ren.clip_box(0,0,width_,height_);
     rasterizer_type ras(ren);
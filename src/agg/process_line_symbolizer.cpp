@@ -81,11 +81,18 @@ void agg_renderer<T>::process(line_symbolizer const& sym,
         ras.line_join(agg::outline_miter_accurate_join);
         ras.round_cap(true);
 
+        box2d<double> screen_box;
         for (unsigned i=0;i<feature->num_geometries();++i)
         {
             geometry_type & geom = feature->get_geometry(i);
             if (geom.num_points() > 1)
             {
+                if (below_min_size(geom, prj_trans, screen_box))
+                {
+                    box_path collapsed(screen_box);
+                    ras.add_path(collapsed);
+                    continue;
+                }
                 clipped_geometry_type clipped(geom);
                 clipped.clip_box(ext.minx(),ext.miny(),ext.maxx(),ext.maxy());
                 path_type path(t_,clipped,prj_trans);
@@ -106,12 +113,23 @@ void agg_renderer<T>::process(line_symbolizer const& sym,
         set_gamma_method(stroke_, ras_ptr);
 
         //metawriter_with_properties writer = sym.get_metawriter();
+        box2d<double> screen_box;
+        double half_width = 0.5 * stroke_.get_width() * scale_factor_;
         for (unsigned i=0;i<feature->num_geometries();++i)
         {
             geometry_type & geom = feature->get_geometry(i);
             if (geom.num_points() > 1)
             {
-                if (stroke_.has_dash())
+                if (below_min_size(geom, prj_trans, screen_box))
+                {
+                    // the area the stroke would have covered
+                    box_path collapsed(box2d<double>(screen_box.minx() - half_width,
+                                                     screen_box.miny() - half_width,
+                                                     screen_box.maxx() + half_width,
+                                                     screen_box.maxy() + half_width));
+                    ras_ptr->add_path(collapsed);
+                }
+                else if (stroke_.has_dash())
                 {
                     if (sym.smooth() > 0.0)
                     {
@@ -70,14 +70,16 @@ void agg_renderer<T>::process(markers_symbolizer const& sym,
     boost::array<double,6> const& m = sym.get_transform();
     tr.load_from(&m[0]);
     tr = agg::trans_affine_scaling(scale_factor_) * tr;
-    std::string filename = path_processor_type::evaluate(*sym.get_filename(), *feature);
+    marker_key key_buffer;
+    marker_key const& filename_key = sym.get_filename_key(*feature, key_buffer);
+    std::string const& filename = filename_key.uri;
     marker_placement_e placement_method = sym.get_marker_placement();
     marker_type_e marker_type = sym.get_marker_type();
     metawriter_with_properties writer = sym.get_metawriter();
 
     if (!filename.empty())
     {
-        boost::optional<marker_ptr> mark = mapnik::marker_cache::instance()->find(filename, true);
+        boost::optional<marker_ptr> mark = mapnik::marker_cache::instance()->find(filename_key, true);
         if (mark && *mark)
         {
             if (!(*mark)->is_vector()) {
@@ -49,12 +49,14 @@ void agg_renderer<T>::process(point_symbolizer const& sym,
                               mapnik::feature_ptr const& feature,
                               proj_transform const& prj_trans)
 {
-    std::string filename = path_processor_type::evaluate(*sym.get_filename(), *feature);
+    marker_key key_buffer;
+    marker_key const& filename_key = sym.get_filename_key(*feature, key_buffer);
+    std::string const& filename = filename_key.uri;
 
     boost::optional<mapnik::marker_ptr> marker;
     if ( !filename.empty() )
     {
-        marker = marker_cache::instance()->find(filename, true);
+        marker = marker_cache::instance()->find(filename_key, true);
     }
     else
     {
@@ -25,8 +25,7 @@
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/agg_helpers.hpp>
 #include <mapnik/agg_rasterizer.hpp>
-#include <mapnik/marker.hpp>
-#include <mapnik/marker_cache.hpp>
+#include <mapnik/agg_pattern_cache.hpp>
 #include <mapnik/expression_evaluator.hpp>
 
 // agg
@@ -54,9 +53,7 @@ void agg_renderer<T>::process(polygon_pattern_symbolizer const& sym,
     typedef agg::renderer_base<agg::pixfmt_rgba32_plain> ren_base;
     typedef agg::wrap_mode_repeat wrap_x_type;
     typedef agg::wrap_mode_repeat wrap_y_type;
-    typedef agg::pixfmt_alpha_blend_rgba<agg::blender_rgba32_plain,
-        agg::row_accessor<agg::int8u>, agg::pixel32_type> rendering_buffer;
-    typedef agg::image_accessor_wrap<rendering_buffer,
+    typedef agg::image_accessor_wrap<polygon_pattern::pixfmt_type,
         wrap_x_type,
         wrap_y_type> img_source_type;
 
@@ -66,6 +63,10 @@ void agg_renderer<T>::process(polygon_pattern_symbolizer const& sym,
         agg::span_allocator<agg::rgba8>,
         span_gen_type> renderer_type;
 
+    marker_key key_buffer;
+    marker_key const& filename_key = sym.get_filename_key(*feature, key_buffer);
+    pattern_cache::polygon_pattern_ptr const& pat = patterns_->polygon(&sym, filename_key);
+    if (!pat) return;
 
     agg::rendering_buffer buf(pixmap_.raw_data(),width_,height_, width_ * 4);
     agg::pixfmt_rgba32_plain pixf(buf);
@@ -75,37 +76,8 @@ void agg_renderer<T>::process(polygon_pattern_symbolizer const& sym,
     ras_ptr->reset();
     set_gamma_method(sym,ras_ptr);
 
-    std::string filename = path_processor_type::evaluate( *sym.get_filename(), *feature);
-    boost::optional<mapnik::marker_ptr> marker;
-    if ( !filename.empty() )
-    {
-        marker = marker_cache::instance()->find(filename, true);
-    }
-    else
-    {
-        std::clog << "### Warning: file not found: " << filename << "\n";
-    }
-
-    if (!marker) return;
-
-    if (!(*marker)->is_bitmap())
-    {
-        std::clog << "### Warning only images (not '" << filename << "') are supported in the polygon_pattern_symbolizer\n";
-        return;
-    }
-
-
-    boost::optional<image_ptr> pat = (*marker)->get_bitmap_data();
-
-    if (!pat) return;
-
-    unsigned w=(*pat)->width();
-    unsigned h=(*pat)->height();
-    agg::row_accessor<agg::int8u> pattern_rbuf((agg::int8u*)(*pat)->getBytes(),w,h,w*4);
     agg::span_allocator<agg::rgba8> sa;
-    agg::pixfmt_alpha_blend_rgba<agg::blender_rgba32_plain,
-        agg::row_accessor<agg::int8u>, agg::pixel32_type> pixf_pattern(pattern_rbuf);
-    img_source_type img_src(pixf_pattern);
+    img_source_type img_src(pat->pixf);
 
     unsigned num_geometries = feature->num_geometries();
 
@@ -26,6 +26,10 @@
 #include <mapnik/agg_helpers.hpp>
 #include <mapnik/agg_rasterizer.hpp>
 #include <mapnik/polygon_symbolizer.hpp>
+#include <mapnik/building_batch.hpp>
+
+// boost
+#include <boost/foreach.hpp>
 
 // agg
 #include "agg_basics.h"
@@ -42,40 +46,100 @@
 
 namespace mapnik {
 
+namespace {
+
+// whether fills with both symbolizers rasterize the same way
+bool same_fill(polygon_symbolizer const& a, polygon_symbolizer const& b)
+{
+    return a.get_fill() == b.get_fill() &&
+        a.get_opacity() == b.get_opacity() &&
+        a.get_gamma() == b.get_gamma() &&
+        a.get_gamma_method() == b.get_gamma_method();
+}
+
+}
+
 template <typename T>
 void agg_renderer<T>::process(polygon_symbolizer const& sym,
                               mapnik::feature_ptr const& feature,
                               proj_transform const& prj_trans)
 {
-    typedef agg::renderer_base<agg::pixfmt_rgba32_plain> ren_base;
-    typedef agg::renderer_scanline_aa_solid<ren_base> renderer;
-
-    color const& fill_ = sym.get_fill();
-    agg::scanline_u8 sl;
+    ras_ptr->reset();
+    set_gamma_method(sym,ras_ptr);
+    add_polygon_paths(sym, feature, prj_trans);
+    fill_polygon_paths(sym);
+}
 
-    agg::rendering_buffer buf(pixmap_.raw_data(),width_,height_, width_ * 4);
-    agg::pixfmt_rgba32_plain pixf(buf);
+template <typename T>
+bool agg_renderer<T>::process(rule::symbolizers const& syms,
+                              mapnik::feature_ptr const& feature,
+                              proj_transform const& prj_trans)
+{
+    if (!buildings_->empty())
+    {
+        // anything but more buildings is drawn over the buildings so far
+        BOOST_FOREACH(symbolizer const& sym, syms)
+        {
+            if (!boost::get<building_symbolizer>(&sym))
+            {
+                flush_buildings();
+                break;
+            }
+        }
+    }
 
-    ren_base renb(pixf);
-    unsigned r=fill_.red();
-    unsigned g=fill_.green();
-    unsigned b=fill_.blue();
-    unsigned a=fill_.alpha();
-    //renb.clip_box(0,0,width_,height_);
-    renderer ren(renb);
+    if (batch_polygons_ && syms.size() == 1)
+    {
+        polygon_symbolizer const* sym = boost::get<polygon_symbolizer>(&syms.front());
+        if (sym)
+        {
+            if (! batch_sym_ || ! same_fill(*batch_sym_, *sym))
+            {
+                flush_polygons();
+                ras_ptr->reset();
+                set_gamma_method(*sym,ras_ptr);
+                batch_sym_ = sym;
+            }
+            add_polygon_paths(*sym, feature, prj_trans);
+            return true;
+        }
+    }
+    // anything else is drawn over the polygons batched so far
+    flush_polygons();
 
-    ras_ptr->reset();
+    // agg renderer doesn't support processing of multiple symbolizers.
+    return false;
+}
 
-    set_gamma_method(sym,ras_ptr);
+template <typename T>
+void agg_renderer<T>::flush_polygons()
+{
+    if (batch_sym_)
+    {
+        fill_polygon_paths(*batch_sym_);
+        batch_sym_ = 0;
+    }
+}
 
+template <typename T>
+void agg_renderer<T>::add_polygon_paths(polygon_symbolizer const& sym,
+                                        mapnik::feature_ptr const& feature,
+                                        proj_transform const& prj_trans)
+{
     //metawriter_with_properties writer = sym.get_metawriter();
     box2d<double> inflated_extent = query_extent_ * 1.1;
+    box2d<double> screen_box;
     for (unsigned i=0;i<feature->num_geometries();++i)
     {
         geometry_type & geom=feature->get_geometry(i);
         if (geom.num_points() > 2)
         {
-            if (sym.smooth() > 0.0)
+            if (below_min_size(geom, prj_trans, screen_box))
+            {
+                box_path collapsed(screen_box);
+                ras_ptr->add_path(collapsed);
+            }
+            else if (sym.smooth() > 0.0)
             {
                 typedef agg::conv_clip_polygon<geometry_type> clipped_geometry_type;
                 typedef coord_transform2<CoordTransform,clipped_geometry_type> path_type;
@@ -99,6 +163,28 @@ void agg_renderer<T>::process(polygon_symbolizer const& sym,
             //if (writer.first) writer.first->add_polygon(path, *feature, t_, writer.second);
         }
     }
+}
+
+template <typename T>
+void agg_renderer<T>::fill_polygon_paths(polygon_symbolizer const& sym)
+{
+    typedef agg::renderer_base<agg::pixfmt_rgba32_plain> ren_base;
+    typedef agg::renderer_scanline_aa_solid<ren_base> renderer;
+
+    color const& fill_ = sym.get_fill();
+    agg::scanline_u8 sl;
+
+    agg::rendering_buffer buf(pixmap_.raw_data(),width_,height_, width_ * 4);
+    agg::pixfmt_rgba32_plain pixf(buf);
+
+    ren_base renb(pixf);
+    unsigned r=fill_.red();
+    unsigned g=fill_.green();
+    unsigned b=fill_.blue();
+    unsigned a=fill_.alpha();
+    //renb.clip_box(0,0,width_,height_);
+    renderer ren(renb);
+
     ren.color(agg::rgba8(r, g, b, int(a * sym.get_opacity())));
     agg::render_scanlines(*ras_ptr, sl, ren);
 }
@@ -107,6 +193,9 @@ void agg_renderer<T>::process(polygon_symbolizer const& sym,
 template void agg_renderer<image_32>::process(polygon_symbolizer const&,
                                               mapnik::feature_ptr const&,
                                               proj_transform const&);
+template bool agg_renderer<image_32>::process(rule::symbolizers const&,
+                                              mapnik::feature_ptr const&,
+                                              proj_transform const&);
+template void agg_renderer<image_32>::flush_polygons();
 
 }
-
@@ -46,11 +46,6 @@ void agg_renderer<T>::process(raster_symbolizer const& sym,
     raster_ptr const& source=feature->get_raster();
     if (source)
     {
-        // If there's a colorizer defined, use it to color the raster in-place
-        raster_colorizer_ptr colorizer = sym.get_colorizer();
-        if (colorizer)
-            colorizer->colorize(source,*feature);
-
         box2d<double> target_ext = box2d<double>(source->ext_);
         prj_trans.backward(target_ext, PROJ_ENVELOPE_POINTS);
 
@@ -70,40 +65,68 @@ void agg_renderer<T>::process(raster_symbolizer const& sym,
             image_data_32 target_data(raster_width,raster_height);
             raster target(target_ext, target_data);
 
-            reproject_raster(target, *source, prj_trans, err_offs_x, err_offs_y,
-                             sym.get_mesh_size(),
-                             sym.calculate_filter_factor(),
-                             scale_factor,
-                             sym.get_scaling());
+            // If there's a colorizer defined, colorize the source pixels while
+            // warping them, the feature's raster itself is left untouched
+            raster_colorizer_ptr const& colorizer = sym.get_colorizer();
+            if (colorizer)
+            {
+                colorizer_lut lut(*colorizer, raster_colorizer::nodata(*feature));
+                reproject_raster(target, *source, prj_trans, err_offs_x, err_offs_y,
+                                 sym.get_mesh_size(),
+                                 sym.calculate_filter_factor(),
+                                 scale_factor,
+                                 sym.get_scaling(),
+                                 lut);
+            }
+            else
+            {
+                reproject_raster(target, *source, prj_trans, err_offs_x, err_offs_y,
+                                 sym.get_mesh_size(),
+                                 sym.calculate_filter_factor(),
+                                 scale_factor,
+                                 sym.get_scaling());
+            }
 
-            if (sym.get_mode() == "normal"){
+            switch (sym.get_mode_enum())
+            {
+            case RASTER_MODE_NORMAL:
                 if (sym.get_opacity() == 1.0) {
                     pixmap_.set_rectangle_alpha(start_x,start_y,target.data_);
                 } else {
                     pixmap_.set_rectangle_alpha2(target.data_,start_x,start_y, sym.get_opacity());
                 }
-            } else if (sym.get_mode() == "grain_merge"){
+                break;
+            case RASTER_MODE_GRAIN_MERGE:
                 pixmap_.template merge_rectangle<MergeGrain> (target.data_,start_x,start_y, sym.get_opacity());
-            } else if (sym.get_mode() == "grain_merge2"){
+                break;
+            case RASTER_MODE_GRAIN_MERGE2:
                 pixmap_.template merge_rectangle<MergeGrain2> (target.data_,start_x,start_y, sym.get_opacity());
-            } else if (sym.get_mode() == "multiply"){
+                break;
+            case RASTER_MODE_MULTIPLY:
                 pixmap_.template merge_rectangle<Multiply> (target.data_,start_x,start_y, sym.get_opacity());
-            } else if (sym.get_mode() == "multiply2"){
+                break;
+            case RASTER_MODE_MULTIPLY2:
                 pixmap_.template merge_rectangle<Multiply2> (target.data_,start_x,start_y, sym.get_opacity());
-            } else if (sym.get_mode() == "divide"){
+                break;
+            case RASTER_MODE_DIVIDE:
                 pixmap_.template merge_rectangle<Divide> (target.data_,start_x,start_y, sym.get_opacity());
-            } else if (sym.get_mode() == "divide2"){
+                break;
+            case RASTER_MODE_DIVIDE2:
                 pixmap_.template merge_rectangle<Divide2> (target.data_,start_x,start_y, sym.get_opacity());
-            } else if (sym.get_mode() == "screen"){
+                break;
+            case RASTER_MODE_SCREEN:
                 pixmap_.template merge_rectangle<Screen> (target.data_,start_x,start_y, sym.get_opacity());
-            } else if (sym.get_mode() == "hard_light"){
+                break;
+            case RASTER_MODE_HARD_LIGHT:
                 pixmap_.template merge_rectangle<HardLight> (target.data_,start_x,start_y, sym.get_opacity());
-            } else {
+                break;
+            case RASTER_MODE_REPLACE:
                 if (sym.get_opacity() == 1.0){
                     pixmap_.set_rectangle(start_x,start_y,target.data_);
                 } else {
                     pixmap_.set_rectangle_alpha2(target.data_,start_x,start_y, sym.get_opacity());
                 }
+                break;
             }
             // TODO: other modes? (add,diff,sub,...)
         }
@@ -50,8 +50,10 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
 
     text_renderer<T> ren(pixmap_, font_manager_, *(font_manager_.get_stroker()));
 
+    unsigned placed = 0;
     while (helper.next()) {
         placements_type &placements = helper.placements();
+        placed += placements.size();
         for (unsigned int ii = 0; ii < placements.size(); ++ii)
         {
             render_marker(helper.get_marker_position(placements[ii]),
@@ -63,6 +65,7 @@ void  agg_renderer<T>::process(shield_symbolizer const& sym,
             ren.render(placements[ii].center);
         }
     }
+    this->add_label_stats(1, placed);
 }
 
 
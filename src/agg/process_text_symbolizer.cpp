@@ -42,14 +42,17 @@ void agg_renderer<T>::process(text_symbolizer const& sym,
 
     text_renderer<T> ren(pixmap_, font_manager_, *(font_manager_.get_stroker()));
 
+    unsigned placed = 0;
     while (helper.next()) {
         placements_type &placements = helper.placements();
+        placed += placements.size();
         for (unsigned int ii = 0; ii < placements.size(); ++ii)
         {
             ren.prepare_glyphs(&(placements[ii]));
             ren.render(placements[ii].center);
         }
     }
+    this->add_label_stats(1, placed);
 }
 
 template void agg_renderer<image_32>::process(text_symbolizer const&,
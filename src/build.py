@@ -23,6 +23,7 @@
 import os
 import sys
 import glob
+import platform
 from copy import copy
 from subprocess import Popen, PIPE
 
@@ -106,7 +107,10 @@ source = Split(
     """
     color.cpp
     conversions.cpp
+    cpu_features.cpp
     image_compositing.cpp
+    image_blend.cpp
+    image_blend_sse2.cpp
     box2d.cpp
     building_symbolizer.cpp
     datasource_cache.cpp
@@ -121,6 +125,10 @@ source = Split(
     gradient.cpp
     graphics.cpp
     image_reader.cpp
+    image_tile_cache.cpp
+    layer_render_cache.cpp
+    feature_cache.cpp
+    worker_pool.cpp
     image_util.cpp
     layer.cpp
     line_symbolizer.cpp
@@ -133,6 +141,7 @@ source = Split(
     placement_finder.cpp
     plugin.cpp
     png_reader.cpp
+    png_io.cpp
     point_symbolizer.cpp
     polygon_pattern_symbolizer.cpp
     polygon_symbolizer.cpp
@@ -143,6 +152,8 @@ source = Split(
     wkb.cpp
     projection.cpp
     proj_transform.cpp
+    projection_cache.cpp
+    render_stats.cpp
     distance.cpp
     scale_denominator.cpp
     memory_datasource.cpp
@@ -218,6 +229,21 @@ if env['RENDERING_STATS']:
 else:
     source.insert(0,processor_cpp);
 
+# the AVX2 blending kernels are only called after runtime cpu detection,
+# so only that translation unit is built with -mavx2
+simd_cpp = 'image_blend_avx2.cpp'
+if env['SIMD'] and platform.machine() in ('x86_64','AMD64','i386','i686') and not env['SUNCC']:
+    env5 = lib_env.Clone()
+    env5.Append(CXXFLAGS = '-mavx2')
+    if env['LINKING'] == 'static':
+        source.insert(0,env5.StaticObject(simd_cpp))
+    else:
+        source.insert(0,env5.SharedObject(simd_cpp))
+else:
+    if not env['SIMD']:
+        lib_env.Append(CXXFLAGS = '-DMAPNIK_NO_SIMD')
+    source.insert(0,simd_cpp)
+
 if env.get('BOOST_LIB_VERSION_FROM_HEADER'):
     boost_version_from_header = int(env['BOOST_LIB_VERSION_FROM_HEADER'].split('_')[1])
     if boost_version_from_header < 46:
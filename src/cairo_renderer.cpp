@@ -1025,12 +1025,14 @@ void cairo_renderer_base::start_map_processing(Map const& map)
                                       mapnik::feature_ptr const& feature,
                                       proj_transform const& prj_trans)
     {
-        std::string filename = path_processor_type::evaluate( *sym.get_filename(), *feature);
+        marker_key key_buffer;
+        marker_key const& filename_key = sym.get_filename_key(*feature, key_buffer);
+        std::string const& filename = filename_key.uri;
 
         boost::optional<marker_ptr> marker;
         if ( !filename.empty() )
         {
-            marker = marker_cache::instance()->find(filename, true);
+            marker = marker_cache::instance()->find(filename_key, true);
         }
         else
         {
@@ -1113,8 +1115,9 @@ void cairo_renderer_base::start_map_processing(Map const& map)
         typedef agg::conv_clip_polyline<geometry_type> clipped_geometry_type;
         typedef coord_transform2<CoordTransform,clipped_geometry_type> path_type;
 
-        std::string filename = path_processor_type::evaluate( *sym.get_filename(), *feature);
-        boost::optional<mapnik::marker_ptr> marker = mapnik::marker_cache::instance()->find(filename,true);
+        marker_key key_buffer;
+        marker_key const& filename_key = sym.get_filename_key(*feature, key_buffer);
+        boost::optional<mapnik::marker_ptr> marker = mapnik::marker_cache::instance()->find(filename_key, true);
         if (!marker && !(*marker)->is_bitmap()) return;
 
         unsigned width((*marker)->width());
@@ -1187,8 +1190,9 @@ void cairo_renderer_base::start_map_processing(Map const& map)
         typedef coord_transform2<CoordTransform,clipped_geometry_type> path_type;
 
         cairo_context context(context_);
-        std::string filename = path_processor_type::evaluate( *sym.get_filename(), *feature);
-        boost::optional<mapnik::marker_ptr> marker = mapnik::marker_cache::instance()->find(filename,true);
+        marker_key key_buffer;
+        marker_key const& filename_key = sym.get_filename_key(*feature, key_buffer);
+        boost::optional<mapnik::marker_ptr> marker = mapnik::marker_cache::instance()->find(filename_key, true);
         if (!marker && !(*marker)->is_bitmap()) return;
 
         cairo_pattern pattern(**((*marker)->get_bitmap_data()));
@@ -1219,11 +1223,6 @@ void cairo_renderer_base::start_map_processing(Map const& map)
         raster_ptr const& source = feature->get_raster();
         if (source)
         {
-            // If there's a colorizer defined, use it to color the raster in-place
-            raster_colorizer_ptr colorizer = sym.get_colorizer();
-            if (colorizer)
-                colorizer->colorize(source,*feature);
-
             box2d<double> target_ext = box2d<double>(source->ext_);
             prj_trans.backward(target_ext, PROJ_ENVELOPE_POINTS);
 
@@ -1243,11 +1242,27 @@ void cairo_renderer_base::start_map_processing(Map const& map)
                 image_data_32 target_data(raster_width,raster_height);
                 raster target(target_ext, target_data);
 
-                reproject_raster(target, *source, prj_trans, err_offs_x, err_offs_y,
-                                 sym.get_mesh_size(),
-                                 sym.calculate_filter_factor(),
-                                 scale_factor,
-                                 sym.get_scaling());
+                // If there's a colorizer defined, colorize the source pixels while
+                // warping them, the feature's raster itself is left untouched
+                raster_colorizer_ptr const& colorizer = sym.get_colorizer();
+                if (colorizer)
+                {
+                    colorizer_lut lut(*colorizer, raster_colorizer::nodata(*feature));
+                    reproject_raster(target, *source, prj_trans, err_offs_x, err_offs_y,
+                                     sym.get_mesh_size(),
+                                     sym.calculate_filter_factor(),
+                                     scale_factor,
+                                     sym.get_scaling(),
+                                     lut);
+                }
+                else
+                {
+                    reproject_raster(target, *source, prj_trans, err_offs_x, err_offs_y,
+                                     sym.get_mesh_size(),
+                                     sym.calculate_filter_factor(),
+                                     scale_factor,
+                                     sym.get_scaling());
+                }
 
                 cairo_context context(context_);
                 //TODO -- support for advanced image merging
@@ -1272,14 +1287,16 @@ void cairo_renderer_base::start_map_processing(Map const& map)
         tr.load_from(&m[0]);
         // TODO - use this?
         //tr = agg::trans_affine_scaling(scale_factor_) * tr;
-        std::string filename = path_processor_type::evaluate(*sym.get_filename(), *feature);
+        marker_key key_buffer;
+        marker_key const& filename_key = sym.get_filename_key(*feature, key_buffer);
+        std::string const& filename = filename_key.uri;
         marker_placement_e placement_method = sym.get_marker_placement();
         marker_type_e marker_type = sym.get_marker_type();
         metawriter_with_properties writer = sym.get_metawriter();
 
         if (!filename.empty())
         {
-            boost::optional<marker_ptr> mark = mapnik::marker_cache::instance()->find(filename, true);
+            boost::optional<marker_ptr> mark = mapnik::marker_cache::instance()->find(filename_key, true);
             if (mark && *mark)
             {
                 if (!(*mark)->is_vector()) {
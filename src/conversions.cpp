@@ -25,6 +25,12 @@
 
 // boost
 #include <boost/spirit/include/qi.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/math/special_functions/sign.hpp>
+
+// stl
+#include <cmath>
+#include <cstdio>
 
 #define BOOST_SPIRIT_AUTO(domain_, name, expr)                  \
     typedef boost::proto::result_of::                           \
@@ -42,6 +48,12 @@ BOOST_SPIRIT_AUTO(qi, INTEGER, qi::int_)
 BOOST_SPIRIT_AUTO(qi, FLOAT, qi::float_)
 BOOST_SPIRIT_AUTO(qi, DOUBLE, qi::double_)
 
+namespace {
+
+const double powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8 };
+
+}
+
 bool string2int(const char * value, int & result)
 {
     size_t length = strlen(value);
@@ -105,5 +117,42 @@ bool string2float(const char * value, float & result)
     return r && (iter == end);
 }
 
+// Below 2^42 the scaled value is off by less than 1/2048, so unless it is
+// that close to a tie it rounds the same way as the exact binary value and
+// plain integer formatting is enough.
+void append_fixed(std::string & out, double val, int precision)
+{
+    char buf[400];
+    double scaled = std::fabs(val) * powers_of_ten[precision];
+    if (scaled < 4398046511104.0)
+    {
+        double whole = std::floor(scaled);
+        double frac = scaled - whole;
+        if (std::fabs(frac - 0.5) > 0.001)
+        {
+            boost::uint64_t digits = static_cast<boost::uint64_t>(whole) + (frac > 0.5 ? 1 : 0);
+            char * end = buf + sizeof(buf);
+            char * pos = end;
+            for (int i = 0; i < precision; ++i)
+            {
+                *--pos = static_cast<char>('0' + digits % 10);
+                digits /= 10;
+            }
+            if (precision > 0) *--pos = '.';
+            do
+            {
+                *--pos = static_cast<char>('0' + digits % 10);
+                digits /= 10;
+            } while (digits);
+            if ((boost::math::signbit)(val)) *--pos = '-';
+            out.append(pos, end - pos);
+            return;
+        }
+    }
+    // near ties, huge values, inf and nan
+    int len = std::sprintf(buf, "%.*f", precision, val);
+    if (len > 0) out.append(buf, len);
+}
+
 }
 }
@@ -0,0 +1,119 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/cpu_features.hpp>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define MAPNIK_CPUID_MSVC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+#define MAPNIK_CPUID_GNUC
+#endif
+
+namespace mapnik
+{
+
+namespace {
+
+struct cpu_features
+{
+    bool sse2;
+    bool avx2;
+
+    cpu_features()
+        : sse2(false),
+          avx2(false)
+    {
+        unsigned regs[4] = {0, 0, 0, 0};
+        if (!cpuid(0, regs)) return;
+        unsigned max_leaf = regs[0];
+        if (max_leaf < 1) return;
+        cpuid(1, regs);
+        sse2 = (regs[3] & (1u << 26)) != 0;
+        // AVX2 needs OS support for saving the ymm registers (OSXSAVE + XCR0)
+        bool osxsave = (regs[2] & (1u << 27)) != 0;
+        bool avx = (regs[2] & (1u << 28)) != 0;
+        if (max_leaf >= 7 && osxsave && avx && (xgetbv0() & 0x6) == 0x6)
+        {
+            cpuid(7, regs);
+            avx2 = (regs[1] & (1u << 5)) != 0;
+        }
+    }
+
+    static bool cpuid(unsigned leaf, unsigned regs[4])
+    {
+#if defined(MAPNIK_CPUID_MSVC)
+        int info[4];
+        __cpuidex(info, leaf, 0);
+        for (unsigned i = 0; i < 4; ++i) regs[i] = static_cast<unsigned>(info[i]);
+        return true;
+#elif defined(MAPNIK_CPUID_GNUC)
+        if (leaf == 0) return __get_cpuid(0, &regs[0], &regs[1], &regs[2], &regs[3]) != 0;
+        __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+        return true;
+#else
+        (void)leaf;
+        (void)regs;
+        return false;
+#endif
+    }
+
+    static unsigned xgetbv0()
+    {
+#if defined(MAPNIK_CPUID_MSVC)
+        return static_cast<unsigned>(_xgetbv(0));
+#elif defined(MAPNIK_CPUID_GNUC)
+        unsigned eax, edx;
+        // xgetbv, spelled out for assemblers that predate the mnemonic
+        __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+        return eax;
+#else
+        return 0;
+#endif
+    }
+};
+
+cpu_features const& features()
+{
+    static cpu_features const f;
+    return f;
+}
+
+// force detection during static initialisation so that later
+// lookups from rendering threads never race on the function static
+cpu_features const& features_init = features();
+
+}
+
+bool cpu_has_sse2()
+{
+    return features().sse2;
+}
+
+bool cpu_has_avx2()
+{
+    return features().avx2;
+}
+
+}
@@ -0,0 +1,293 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/feature_cache.hpp>
+#include <mapnik/feature.hpp>
+
+// boost
+#include <boost/cstdint.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/functional/hash.hpp>
+
+// stl
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+
+namespace mapnik
+{
+
+namespace {
+
+// features are handed out as copies, reading a cached feature (and so
+// its geometries' vertex iterators) from several threads is not safe
+feature_ptr clone_feature(Feature & feature)
+{
+    context_ptr ctx = feature.context();
+    feature_ptr copy = boost::make_shared<Feature>(ctx, feature.id());
+    for (context_type::const_iterator itr = ctx->begin(); itr != ctx->end(); ++itr)
+    {
+        if (itr->second < feature.size())
+        {
+            copy->put(itr->first, feature.get(itr->second));
+        }
+    }
+    for (unsigned i = 0; i < feature.num_geometries(); ++i)
+    {
+        geometry_type const& geom = feature.get_geometry(i);
+        geometry_type * geom_copy = new geometry_type(geom.type());
+        double x, y;
+        for (unsigned pos = 0; pos < geom.num_points(); ++pos)
+        {
+            unsigned cmd = geom.get_vertex(pos, &x, &y);
+            geom_copy->push_vertex(x, y, static_cast<CommandType>(cmd));
+        }
+        copy->add_geometry(geom_copy);
+    }
+    copy->set_raster(feature.get_raster());
+    return copy;
+}
+
+// a rough figure of the memory held by a feature
+std::size_t feature_cost(Feature const& feature)
+{
+    std::size_t cost = sizeof(Feature) + 64 + feature.size() * sizeof(value);
+    for (unsigned i = 0; i < feature.num_geometries(); ++i)
+    {
+        cost += sizeof(geometry_type) + feature.get_geometry(i).num_points() * (2 * sizeof(double) + 1);
+    }
+    return cost;
+}
+
+// Hashes what a feature is made of, its attributes and vertices, but
+// not its id: datasources like postgis without a key_field number the
+// features of every query from 1, so a feature read for two cells can
+// come with two ids.
+std::size_t feature_hash(Feature const& feature)
+{
+    std::size_t seed = 0;
+    for (std::size_t i = 0; i < feature.size(); ++i)
+    {
+        value const& val = feature.get(i);
+        boost::hash_combine(seed, val.base().which());
+        boost::hash_combine(seed, val.to_string());
+    }
+    for (unsigned i = 0; i < feature.num_geometries(); ++i)
+    {
+        geometry_type const& geom = feature.get_geometry(i);
+        boost::hash_combine(seed, static_cast<int>(geom.type()));
+        double x, y;
+        for (unsigned pos = 0; pos < geom.num_points(); ++pos)
+        {
+            boost::hash_combine(seed, geom.get_vertex(pos, &x, &y));
+            boost::hash_combine(seed, x);
+            boost::hash_combine(seed, y);
+        }
+    }
+    return seed;
+}
+
+// What tells features apart across cells: datasources may return
+// a feature for cells its envelope does not meet (index boxes rounded
+// outward, whole index nodes) or leave it out of cells it does meet
+// (exact geometry tests), so the cells that hold a feature are known
+// only from what they returned.
+struct feature_key
+{
+    std::size_t hash;
+    double minx, miny, maxx, maxy;
+
+    feature_key(std::size_t hash_, box2d<double> const& box)
+        : hash(hash_), minx(box.minx()), miny(box.miny()), maxx(box.maxx()), maxy(box.maxy()) {}
+
+    bool operator<(feature_key const& other) const
+    {
+        if (hash != other.hash) return hash < other.hash;
+        if (minx != other.minx) return minx < other.minx;
+        if (miny != other.miny) return miny < other.miny;
+        if (maxx != other.maxx) return maxx < other.maxx;
+        return maxy < other.maxy;
+    }
+};
+
+// Returns each feature once even if several cells returned it: the n-th
+// copy of a feature in a cell comes out only if no earlier cell held n
+// copies, so features the datasource itself returns twice stay twice.
+class cached_featureset : public Featureset
+{
+    typedef std::map<feature_key, unsigned> count_map;
+public:
+    cached_featureset(box2d<double> const& bbox,
+                      std::vector<feature_cache_cell_ptr> const& cells)
+        : bbox_(bbox),
+          cells_(cells),
+          cell_(0),
+          index_(0) {}
+
+    feature_ptr next()
+    {
+        while (cell_ < cells_.size())
+        {
+            feature_cache_cell const& cell = *cells_[cell_];
+            while (index_ < cell.features.size())
+            {
+                box2d<double> const& envelope = cell.envelopes[index_];
+                std::size_t hash = cell.hashes[index_];
+                feature_ptr const& feature = cell.features[index_++];
+                // features without geometry have no envelope to test
+                if (feature->num_geometries() > 0 && !envelope.intersects(bbox_)) continue;
+                if (cells_.size() == 1)
+                {
+                    return clone_feature(*feature);
+                }
+                feature_key key(hash, envelope);
+                unsigned copies = ++current_[key];
+                count_map::const_iterator itr = emitted_.find(key);
+                if (itr == emitted_.end() || copies > itr->second)
+                {
+                    return clone_feature(*feature);
+                }
+            }
+            for (count_map::const_iterator itr = current_.begin(); itr != current_.end(); ++itr)
+            {
+                unsigned & emitted = emitted_[itr->first];
+                emitted = std::max(emitted, itr->second);
+            }
+            current_.clear();
+            ++cell_;
+            index_ = 0;
+        }
+        return feature_ptr();
+    }
+
+private:
+    box2d<double> bbox_;
+    std::vector<feature_cache_cell_ptr> cells_;
+    unsigned cell_;
+    unsigned index_;
+    // copies of each feature seen in the current cell, and the most
+    // copies any earlier cell held
+    count_map current_;
+    count_map emitted_;
+};
+
+}
+
+feature_cache::feature_cache()
+    : cache_(64 * 1024 * 1024) {}
+
+featureset_ptr feature_cache::features(datasource const& ds, query const& q)
+{
+    box2d<double> const& bbox = q.get_bbox();
+    double size = std::max(bbox.width(), bbox.height());
+    if (!(size > 0.0) || !(size < 1e300))
+    {
+        return ds.features(q);
+    }
+    // powers of two keep cell edges exact, cells of neighbouring
+    // queries of the same size line up
+    double cell_size = std::pow(2.0, std::ceil(std::log(size) / std::log(2.0))) / 2.0;
+    boost::int64_t x0 = static_cast<boost::int64_t>(std::floor(bbox.minx() / cell_size));
+    boost::int64_t y0 = static_cast<boost::int64_t>(std::floor(bbox.miny() / cell_size));
+    boost::int64_t x1 = static_cast<boost::int64_t>(std::floor(bbox.maxx() / cell_size));
+    boost::int64_t y1 = static_cast<boost::int64_t>(std::floor(bbox.maxy() / cell_size));
+
+    // what else decides which features and attributes a query returns
+    std::ostringstream s;
+    s.precision(17);
+    parameters const& params = ds.params();
+    for (parameters::const_iterator itr = params.begin(); itr != params.end(); ++itr)
+    {
+        s << itr->first << "=" << *params.get<std::string>(itr->first, "") << ",";
+    }
+    s << "\n";
+    std::set<std::string> const& names = q.property_names();
+    for (std::set<std::string>::const_iterator itr = names.begin(); itr != names.end(); ++itr)
+    {
+        s << *itr << ",";
+    }
+    s << "\n" << q.scale_denominator() << " " << q.resolution().get<0>()
+      << " " << q.resolution().get<1>() << " " << cell_size << " ";
+    std::string prefix = s.str();
+
+    std::vector<feature_cache_cell_ptr> cells;
+    for (boost::int64_t y = y0; y <= y1; ++y)
+    {
+        for (boost::int64_t x = x0; x <= x1; ++x)
+        {
+            box2d<double> box(x * cell_size, y * cell_size, (x + 1) * cell_size, (y + 1) * cell_size);
+            std::ostringstream key;
+            key << prefix << x << " " << y;
+            feature_cache_cell_ptr cell;
+            if (!cache_.find(key.str(), cell))
+            {
+                query cell_query(box, q.resolution(), q.scale_denominator());
+                cell_query.set_filter_factor(q.get_filter_factor());
+                for (std::set<std::string>::const_iterator itr = names.begin(); itr != names.end(); ++itr)
+                {
+                    cell_query.add_property_name(*itr);
+                }
+                cell = boost::make_shared<feature_cache_cell>();
+                std::size_t cost = sizeof(feature_cache_cell);
+                featureset_ptr fs = ds.features(cell_query);
+                if (fs)
+                {
+                    feature_ptr feature;
+                    while ((feature = fs->next()))
+                    {
+                        cell->features.push_back(feature);
+                        cell->envelopes.push_back(feature->envelope());
+                        cell->hashes.push_back(feature_hash(*feature));
+                        cost += feature_cost(*feature) + sizeof(box2d<double>) + sizeof(std::size_t);
+                    }
+                }
+                cache_.insert(key.str(), cell, cost);
+            }
+            cells.push_back(cell);
+        }
+    }
+    return boost::make_shared<cached_featureset>(bbox, cells);
+}
+
+void feature_cache::set_capacity(std::size_t bytes)
+{
+    cache_.set_capacity(bytes);
+}
+
+std::size_t feature_cache::capacity() const
+{
+    return cache_.capacity();
+}
+
+std::size_t feature_cache::size() const
+{
+    return cache_.cost();
+}
+
+void feature_cache::clear()
+{
+    cache_.clear();
+}
+
+}
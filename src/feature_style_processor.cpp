@@ -29,12 +29,18 @@
 #include <mapnik/expression_evaluator.hpp>
 #include <mapnik/utils.hpp>
 #include <mapnik/scale_denominator.hpp>
+#include <mapnik/projection_cache.hpp>
+#include <mapnik/render_stats.hpp>
+#include <mapnik/feature_cache.hpp>
+#include <mapnik/boolean.hpp>
 
 #include <mapnik/agg_renderer.hpp>
 #include <mapnik/grid/grid_renderer.hpp>
 
 // boost
 #include <boost/foreach.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/mpl/size.hpp>
 
 //stl
 #include <vector>
@@ -48,14 +54,60 @@
 #endif
 
 #if defined(RENDERING_STATS)
-#include <mapnik/timer.hpp>
-#include <iomanip>
-#include <sstream>
+#include <iostream>
 #endif
 
 namespace mapnik
 {
 
+namespace {
+
+// in the order of the symbolizer variant
+const char * symbolizer_names[] = {
+    "PointSymbolizer",
+    "LineSymbolizer",
+    "LinePatternSymbolizer",
+    "PolygonSymbolizer",
+    "PolygonPatternSymbolizer",
+    "RasterSymbolizer",
+    "ShieldSymbolizer",
+    "TextSymbolizer",
+    "BuildingSymbolizer",
+    "MarkersSymbolizer"
+};
+
+BOOST_STATIC_ASSERT(sizeof(symbolizer_names) / sizeof(const char *) ==
+                    boost::mpl::size<symbolizer::types>::value);
+
+void add_symbolizer_time(style_stats & stats, symbolizer const& sym, double time)
+{
+    const char * name = symbolizer_names[sym.which()];
+    BOOST_FOREACH(symbolizer_stats & sym_stats, stats.symbolizers)
+    {
+        if (sym_stats.name == name)
+        {
+            ++sym_stats.count;
+            sym_stats.time += time;
+            return;
+        }
+    }
+    stats.symbolizers.push_back(symbolizer_stats(name));
+    stats.symbolizers.back().count = 1;
+    stats.symbolizers.back().time = time;
+}
+
+// reads the next feature, adding the time it took to query_time if not null
+inline feature_ptr next_feature(featureset_ptr const& features, double * query_time)
+{
+    if (!query_time) return features->next();
+    double start = stats_clock();
+    feature_ptr feature = features->next();
+    *query_time += stats_clock() - start;
+    return feature;
+}
+
+}
+
 /** Calls the renderer's process function,
  * \param output     Renderer
  * \param f          Feature to process
@@ -85,25 +137,45 @@ struct feature_style_processor<Processor>::symbol_dispatch : public boost::stati
 
 template <typename Processor>
 feature_style_processor<Processor>::feature_style_processor(Map const& m, double scale_factor)
-    : m_(m), scale_factor_(scale_factor)
+    : m_(m),
+      scale_factor_(scale_factor),
+      stats_(0),
+      current_layer_(0),
+      current_style_(0)
 {
 }
 
+template <typename Processor>
+void feature_style_processor<Processor>::set_stats(render_stats * stats)
+{
+    stats_ = stats;
+}
+
+template <typename Processor>
+render_stats * feature_style_processor<Processor>::stats() const
+{
+    return stats_;
+}
+
 template <typename Processor>
 void feature_style_processor<Processor>::apply()
 {
 
 #if defined(RENDERING_STATS)
-    std::clog << "\n//-- starting rendering timer...\n";
-    mapnik::progress_timer t(std::clog, "total map rendering");
+    // builds with RENDERING_STATS report every render to std::clog
+    render_stats local_stats;
+    bool report = (stats_ == 0);
+    if (report) stats_ = &local_stats;
 #endif
+    double start = stats_ ? stats_clock() : 0.0;
 
     Processor & p = static_cast<Processor&>(*this);
     p.start_map_processing(m_);
 
     try
     {
-        projection proj(m_.srs());
+        projection_ptr proj_ptr = projection_cache::get(m_.srs());
+        projection const& proj = *proj_ptr;
 
         start_metawriters(m_,proj);
 
@@ -128,21 +200,26 @@ void feature_style_processor<Processor>::apply()
 
     p.end_map_processing(m_);
 
+    if (stats_) stats_->time += stats_clock() - start;
 #if defined(RENDERING_STATS)
-    t.stop();
-    std::clog << "//-- rendering timer stopped...\n\n";
+    if (report)
+    {
+        std::clog << local_stats;
+        stats_ = 0;
+    }
 #endif
-
 }
 
 template <typename Processor>
 void feature_style_processor<Processor>::apply(mapnik::layer const& lyr, std::set<std::string>& names)
 {
+    double start = stats_ ? stats_clock() : 0.0;
     Processor & p = static_cast<Processor&>(*this);
     p.start_map_processing(m_);
     try
     {
-        projection proj(m_.srs());
+        projection_ptr proj_ptr = projection_cache::get(m_.srs());
+        projection const& proj = *proj_ptr;
         double scale_denom = mapnik::scale_denominator(m_,proj.is_geographic());
         scale_denom *= scale_factor_;
 
@@ -156,6 +233,7 @@ void feature_style_processor<Processor>::apply(mapnik::layer const& lyr, std::se
         std::clog << "proj_init_error:" << ex.what() << "\n";
     }
     p.end_map_processing(m_);
+    if (stats_) stats_->time += stats_clock() - start;
 }
 
 template <typename Processor>
@@ -203,19 +281,10 @@ void feature_style_processor<Processor>::apply_to_layer(layer const& lay, Proces
         return;
     }
 
-#if defined(RENDERING_STATS)
-    progress_timer layer_timer(std::clog, "rendering total for layer: '" + lay.name() + "'");
-#endif
-
-    projection proj1(lay.srs());
-    proj_transform prj_trans(proj0,proj1);
+    double layer_start = stats_ ? stats_clock() : 0.0;
 
-#if defined(RENDERING_STATS)
-    if (!prj_trans.equal())
-        std::clog << "notice: reprojecting layer: '" << lay.name() << "' from/to:\n\t'"
-                  << lay.srs() << "'\n\t'"
-                  << m_.srs() << "'\n";
-#endif
+    proj_transform_ptr prj_trans_ptr = projection_cache::get(proj0.params(), lay.srs());
+    proj_transform const& prj_trans = *prj_trans_ptr;
 
     box2d<double> buffered_query_ext = m_.get_buffered_extent(); // buffered
 
@@ -237,9 +306,6 @@ void feature_style_processor<Processor>::apply_to_layer(layer const& lay, Proces
     // if no intersection and projections are also equal, early return
     else if (prj_trans.equal())
     {
-#if defined(RENDERING_STATS)
-        layer_timer.discard();
-#endif
         return;
     }
     // next try intersection of layer extent back projected into map srs
@@ -257,9 +323,6 @@ void feature_style_processor<Processor>::apply_to_layer(layer const& lay, Proces
     else
     {
         // if no intersection then nothing to do for layer
-#if defined(RENDERING_STATS)
-        layer_timer.discard();
-#endif
         return;
     }
 
@@ -286,7 +349,21 @@ void feature_style_processor<Processor>::apply_to_layer(layer const& lay, Proces
         }
     }
 
+    // layers outside of the map are left out of the stats
+    current_layer_ = 0;
+    if (stats_)
+    {
+        stats_->layers.push_back(layer_stats(lay.name()));
+        current_layer_ = &stats_->layers.back();
+    }
+    double * query_time = current_layer_ ? &current_layer_->query_time : 0;
+
     p.start_layer_processing(lay, layer_ext2);
+    bool cached = p.layer_cached();
+    if (cached && current_layer_)
+    {
+        current_layer_->cached = true;
+    }
 
     double qw = query_ext.width()>0 ? query_ext.width() : 1;
     double qh = query_ext.height()>0 ? query_ext.height() : 1;
@@ -331,8 +408,9 @@ void feature_style_processor<Processor>::apply_to_layer(layer const& lay, Proces
         }
     }
 
-    // Don't even try to do more work if there are no active styles.
-    if (active_styles.size() > 0)
+    // Don't even try to do more work if there are no active styles,
+    // or if the renderer drew the layer from its cache.
+    if (active_styles.size() > 0 && !cached)
     {
         // push all property names
         BOOST_FOREACH(std::string const& name, names)
@@ -376,14 +454,15 @@ void feature_style_processor<Processor>::apply_to_layer(layer const& lay, Proces
         // changes value.
         if (group_by != "")
         {
-            featureset_ptr features = ds->features(q);
+            featureset_ptr features = query_features(ds, q);
             if (features) {
                 // Cache all features into the memory_datasource before rendering.
                 memory_datasource cache;
                 feature_ptr feature, prev;
 
-                while ((feature = features->next()))
+                while ((feature = next_feature(features, query_time)))
                 {
+                    if (current_layer_) ++current_layer_->features;
                     if (prev && prev->get(group_by) != feature->get(group_by))
                     {
                         // We're at a value boundary, so render what we have
@@ -410,13 +489,14 @@ void feature_style_processor<Processor>::apply_to_layer(layer const& lay, Proces
         }
         else if (cache_features)
         {
-            featureset_ptr features = ds->features(q);
+            featureset_ptr features = query_features(ds, q);
             if (features) {
                 // Cache all features into the memory_datasource before rendering.
                 memory_datasource cache;
                 feature_ptr feature;
-                while ((feature = features->next()))
+                while ((feature = next_feature(features, query_time)))
                 {
+                    if (current_layer_) ++current_layer_->features;
                     cache.push(feature);
                 }
 
@@ -434,20 +514,89 @@ void feature_style_processor<Processor>::apply_to_layer(layer const& lay, Proces
             int i = 0;
             BOOST_FOREACH (feature_type_style * style, active_styles)
             {
-                featureset_ptr features = ds->features(q);
+                featureset_ptr features = query_features(ds, q);
                 if (features) {
                     render_style(lay, p, style, style_names[i++],
                                  features, prj_trans, scale_denom);
                 }
             }
+            if (current_layer_)
+            {
+                // every style read its own features from the datasource
+                BOOST_FOREACH(style_stats const& stats, current_layer_->styles)
+                {
+                    current_layer_->features += stats.features;
+                    current_layer_->query_time += stats.query_time;
+                }
+            }
         }
     }
 
-#if defined(RENDERING_STATS)
-    layer_timer.stop();
-#endif
-
     p.end_layer_processing(lay);
+
+    if (current_layer_)
+    {
+        current_layer_->time += stats_clock() - layer_start;
+        current_layer_ = 0;
+    }
+}
+
+template <typename Processor>
+featureset_ptr feature_style_processor<Processor>::query_features(datasource_ptr const& ds, query const& q)
+{
+    double start = current_layer_ ? stats_clock() : 0.0;
+    featureset_ptr features;
+    // vector datasources can have their features kept for later queries
+    if (ds->type() == datasource::Vector &&
+        *ds->params().get<mapnik::boolean>("feature_cache", false))
+    {
+        features = feature_cache::instance()->features(*ds, q);
+    }
+    else
+    {
+        features = ds->features(q);
+    }
+    if (current_layer_) current_layer_->query_time += stats_clock() - start;
+    return features;
+}
+
+template <typename Processor>
+void feature_style_processor<Processor>::render_symbolizers(Processor & p,
+                                                            rule::symbolizers const& symbols,
+                                                            feature_ptr const& feature,
+                                                            proj_transform const& prj_trans)
+{
+    if (!current_style_)
+    {
+        // if the underlying renderer is not able to process the complete set of symbolizers,
+        // process one by one.
+        if(!p.process(symbols,feature,prj_trans))
+        {
+            BOOST_FOREACH (symbolizer const& sym, symbols)
+            {
+                boost::apply_visitor(symbol_dispatch(p,feature,prj_trans),sym);
+            }
+        }
+        return;
+    }
+
+    double start = stats_clock();
+    if (p.process(symbols,feature,prj_trans))
+    {
+        // the renderer took the whole set, count it as its first symbolizer
+        if (!symbols.empty())
+        {
+            add_symbolizer_time(*current_style_, symbols.front(), stats_clock() - start);
+        }
+        return;
+    }
+    BOOST_FOREACH (symbolizer const& sym, symbols)
+    {
+        boost::apply_visitor(symbol_dispatch(p,feature,prj_trans),sym);
+        double end = stats_clock();
+        add_symbolizer_time(*current_style_, sym, end - start);
+        start = end;
+    }
 }
 
 
@@ -461,53 +610,48 @@ void feature_style_processor<Processor>::render_style(
     proj_transform const& prj_trans,
     double scale_denom)
 {
-#if defined(RENDERING_STATS)
-    std::ostringstream s1;
-    s1 << "rendering style for layer: '" << lay.name()
-       << "' and style '" << style_name << "'";
-    mapnik::progress_timer style_timer(std::clog, s1.str());
+    double style_start = 0.0;
+    current_style_ = 0;
+    if (current_layer_)
+    {
+        style_start = stats_clock();
+        // grouped layers render a style once per group
+        BOOST_FOREACH(style_stats & stats, current_layer_->styles)
+        {
+            if (stats.name == style_name) current_style_ = &stats;
+        }
+        if (!current_style_)
+        {
+            current_layer_->styles.push_back(style_stats(style_name));
+            current_style_ = &current_layer_->styles.back();
+        }
+    }
+    double * query_time = current_style_ ? &current_style_->query_time : 0;
 
-    int feature_processed_count = 0;
-    int feature_count = 0;
-#endif
+    p.start_style_processing(*style);
 
     feature_ptr feature;
-    while ((feature = features->next()))
+    while ((feature = next_feature(features, query_time)))
     {
-#if defined(RENDERING_STATS)
-        feature_count++;
         bool feat_processed = false;
-#endif
-
         bool do_else = true;
         bool do_also = false;
 
         BOOST_FOREACH(rule * r, style->get_if_rules(scale_denom) )
         {
             expression_ptr const& expr=r->get_filter();
+            double filter_start = current_style_ ? stats_clock() : 0.0;
             value_type result = boost::apply_visitor(evaluate<Feature,value_type>(*feature),*expr);
+            if (current_style_) current_style_->filter_time += stats_clock() - filter_start;
             if (result.to_bool())
             {
-#if defined(RENDERING_STATS)
                 feat_processed = true;
-#endif
 
                 p.painted(true);
 
                 do_else=false;
                 do_also=true;
-                rule::symbolizers const& symbols = r->get_symbolizers();
-
-                // if the underlying renderer is not able to process the complete set of symbolizers,
-                // process one by one.
-                if(!p.process(symbols,feature,prj_trans))
-                {
-
-                    BOOST_FOREACH (symbolizer const& sym, symbols)
-                    {
-                        boost::apply_visitor(symbol_dispatch(p,feature,prj_trans),sym);
-                    }
-                }
+                render_symbolizers(p, r->get_symbolizers(), feature, prj_trans);
                 if (style->get_filter_mode() == FILTER_FIRST)
                 {
                     // Stop iterating over rules and proceed with next feature.
@@ -519,72 +663,38 @@ void feature_style_processor<Processor>::render_style(
         {
             BOOST_FOREACH( rule * r, style->get_else_rules(scale_denom) )
             {
-#if defined(RENDERING_STATS)
                 feat_processed = true;
-#endif
 
                 p.painted(true);
 
-                rule::symbolizers const& symbols = r->get_symbolizers();
-                // if the underlying renderer is not able to process the complete set of symbolizers,
-                // process one by one.
-                if(!p.process(symbols,feature,prj_trans))
-                {
-                    BOOST_FOREACH (symbolizer const& sym, symbols)
-                    {
-                        boost::apply_visitor(symbol_dispatch(p,feature,prj_trans),sym);
-                    }
-                }
+                render_symbolizers(p, r->get_symbolizers(), feature, prj_trans);
             }
         }
         if (do_also)
         {
             BOOST_FOREACH( rule * r, style->get_also_rules(scale_denom) )
             {
-#if defined(RENDERING_STATS)
                 feat_processed = true;
-#endif
 
                 p.painted(true);
 
-                rule::symbolizers const& symbols = r->get_symbolizers();
-                // if the underlying renderer is not able to process the complete set of symbolizers,
-                // process one by one.
-                if(!p.process(symbols,feature,prj_trans))
-                {
-                    BOOST_FOREACH (symbolizer const& sym, symbols)
-                    {
-                        boost::apply_visitor(symbol_dispatch(p,feature,prj_trans),sym);
-                    }
-                }
+                render_symbolizers(p, r->get_symbolizers(), feature, prj_trans);
             }
         }
-#if defined(RENDERING_STATS)
-        if (feat_processed)
-            feature_processed_count++;
-#endif
+        if (current_style_)
+        {
+            ++current_style_->features;
+            if (feat_processed) ++current_style_->features_rendered;
+        }
     }
 
-#if defined(RENDERING_STATS)
-    style_timer.stop();
+    p.end_style_processing(*style);
 
-    // done with style
-    std::ostringstream s;
-    if (feature_count > 0)
+    if (current_style_)
     {
-        double perc_processed = ((double)feature_processed_count/(double)feature_count)*100.0;
-
-        s << "percent rendered: " << perc_processed << "% - " << feature_processed_count
-          << " rendered for " << feature_count << " queried for ";
-        s << std::setw(15 - (int)s.tellp()) << " layer '" << lay.name() << "' and style '" << style_name << "'\n";
+        current_style_->time += stats_clock() - style_start;
+        current_style_ = 0;
     }
-    else
-    {
-        s << "" << std::setw(15) << "- no features returned from query for layer '" << lay.name() << "' and style '" << style_name << "'\n";
-    }
-    std::clog << s.str();
-    style_timer.discard();
-#endif
 }
 
 
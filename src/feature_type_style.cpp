@@ -36,10 +36,12 @@ IMPLEMENT_ENUM( filter_mode_e, filter_mode_strings )
 
 feature_type_style::feature_type_style()
 : filter_mode_(FILTER_ALL),
+    batch_polygons_(false),
     scale_denom_validity_(-1) {}
 
 feature_type_style::feature_type_style(feature_type_style const& rhs, bool deep_copy)
     : filter_mode_(rhs.filter_mode_),
+      batch_polygons_(rhs.batch_polygons_),
       scale_denom_validity_(-1)
 {
     if (!deep_copy) {
@@ -57,6 +59,8 @@ feature_type_style& feature_type_style::operator=(feature_type_style const& rhs)
 {
     if (this == &rhs) return *this;
     rules_=rhs.rules_;
+    filter_mode_ = rhs.filter_mode_;
+    batch_polygons_ = rhs.batch_polygons_;
     scale_denom_validity_ = -1;
     return *this;
 }
@@ -87,6 +91,16 @@ filter_mode_e feature_type_style::get_filter_mode() const
     return filter_mode_;
 }
 
+void feature_type_style::set_batch_polygons(bool batch)
+{
+    batch_polygons_ = batch;
+}
+
+bool feature_type_style::batch_polygons() const
+{
+    return batch_polygons_;
+}
+
 
 void feature_type_style::update_rule_cache(double scale_denom)
 {
@@ -64,10 +64,16 @@ grid_renderer<T>::grid_renderer(Map const& m, T & pixmap, double scale_factor, u
       width_(pixmap_.width()),
       height_(pixmap_.height()),
       scale_factor_(scale_factor),
-      t_(pixmap_.width(),pixmap_.height(),m.get_current_extent(),offset_x,offset_y),
+      // a grid with resolution N covers the map at 1/N of its size, so the
+      // transform and the label buffer are scaled down to render into it directly
+      t_(pixmap_.width(),pixmap_.height(),m.get_current_extent(),
+         offset_x*(1.0/pixmap_.get_resolution()),offset_y*(1.0/pixmap_.get_resolution())),
       font_engine_(),
       font_manager_(font_engine_),
-      detector_(box2d<double>(-m.buffer_size(), -m.buffer_size(), pixmap_.width() + m.buffer_size(), pixmap_.height() + m.buffer_size())),
+      detector_(box2d<double>(-m.buffer_size()*(1.0/pixmap_.get_resolution()),
+                              -m.buffer_size()*(1.0/pixmap_.get_resolution()),
+                              pixmap_.width() + m.buffer_size()*(1.0/pixmap_.get_resolution()),
+                              pixmap_.height() + m.buffer_size()*(1.0/pixmap_.get_resolution()))),
       ras_ptr(new grid_rasterizer)
 {
 #ifdef MAPNIK_DEBUG
@@ -60,6 +60,8 @@ void grid_renderer<T>::process(line_symbolizer const& sym,
     ras_ptr->reset();
 
     stroke const&  stroke_ = sym.get_stroke();
+    // widths are given in map pixels, the grid may be smaller
+    double scale = scale_factor_ * (1.0/pixmap_.get_resolution());
 
     for (unsigned i=0;i<feature->num_geometries();++i)
     {
@@ -76,8 +78,8 @@ void grid_renderer<T>::process(line_symbolizer const& sym,
                 dash_array::const_iterator end = d.end();
                 for (;itr != end;++itr)
                 {
-                    dash.add_dash(itr->first * scale_factor_,
-                                  itr->second * scale_factor_);
+                    dash.add_dash(itr->first * scale,
+                                  itr->second * scale);
                 }
 
                 agg::conv_stroke<agg::conv_dash<path_type > > stroke(dash);
@@ -101,7 +103,7 @@ void grid_renderer<T>::process(line_symbolizer const& sym,
                     stroke.generator().line_cap(agg::round_cap);
 
                 stroke.generator().miter_limit(4.0);
-                stroke.generator().width(stroke_.get_width() * scale_factor_);
+                stroke.generator().width(stroke_.get_width() * scale);
 
                 ras_ptr->add_path(stroke);
 
@@ -128,7 +130,7 @@ void grid_renderer<T>::process(line_symbolizer const& sym,
                     stroke.generator().line_cap(agg::round_cap);
 
                 stroke.generator().miter_limit(4.0);
-                stroke.generator().width(stroke_.get_width() * scale_factor_);
+                stroke.generator().width(stroke_.get_width() * scale);
                 ras_ptr->add_path(stroke);
             }
         }
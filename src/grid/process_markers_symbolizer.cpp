@@ -73,14 +73,17 @@ void grid_renderer<T>::process(markers_symbolizer const& sym,
     agg::trans_affine tr;
     boost::array<double,6> const& m = sym.get_transform();
     tr.load_from(&m[0]);
-    tr = agg::trans_affine_scaling(scale_factor_*(1.0/pixmap_.get_resolution())) * tr;
-    std::string filename = path_processor_type::evaluate(*sym.get_filename(), *feature);
+    double scale = scale_factor_ * (1.0/pixmap_.get_resolution());
+    tr = agg::trans_affine_scaling(scale) * tr;
+    marker_key key_buffer;
+    marker_key const& filename_key = sym.get_filename_key(*feature, key_buffer);
+    std::string const& filename = filename_key.uri;
     marker_placement_e placement_method = sym.get_marker_placement();
     marker_type_e marker_type = sym.get_marker_type();
 
     if (!filename.empty())
     {
-        boost::optional<marker_ptr> mark = mapnik::marker_cache::instance()->find(filename, true);
+        boost::optional<marker_ptr> mark = mapnik::marker_cache::instance()->find(filename_key, true);
         if (mark && *mark && (*mark)->is_vector())
         {
             boost::optional<path_ptr> marker = (*mark)->get_vector_data();
@@ -114,7 +117,7 @@ void grid_renderer<T>::process(markers_symbolizer const& sym,
 
                 path_type path(t_,geom,prj_trans);
                 markers_placement<path_type, label_collision_detector4> placement(path, extent, detector_,
-                                                                                  sym.get_spacing() * scale_factor_,
+                                                                                  sym.get_spacing() * scale,
                                                                                   sym.get_max_error(),
                                                                                   sym.get_allow_overlap());
                 double x, y, angle;
@@ -223,7 +226,7 @@ void grid_renderer<T>::process(markers_symbolizer const& sym,
 
                 path_type path(t_,geom,prj_trans);
                 markers_placement<path_type, label_collision_detector4> placement(path, extent, detector_,
-                                                                                  sym.get_spacing() * scale_factor_,
+                                                                                  sym.get_spacing() * scale,
                                                                                   sym.get_max_error(),
                                                                                   sym.get_allow_overlap());
                 double x_t, y_t, angle;
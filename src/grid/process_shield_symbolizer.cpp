@@ -49,7 +49,7 @@ void  grid_renderer<T>::process(shield_symbolizer const& sym,
         label_collision_detector4> helper(
             sym, *feature, prj_trans,
             width_, height_,
-            scale_factor_,
+            scale_factor_ * (1.0/pixmap_.get_resolution()),
             t_, font_manager_, detector_, query_extent);
 
     bool placement_found = false;
@@ -57,9 +57,11 @@ void  grid_renderer<T>::process(shield_symbolizer const& sym,
     text_renderer<T> ren(pixmap_, font_manager_, *(font_manager_.get_stroker()));
 
     text_placement_info_ptr placement;
+    unsigned placed = 0;
     while (helper.next()) {
         placement_found = true;
         placements_type &placements = helper.placements();
+        placed += placements.size();
         for (unsigned int ii = 0; ii < placements.size(); ++ii)
         {
             render_marker(feature, pixmap_.get_resolution(),
@@ -73,6 +75,7 @@ void  grid_renderer<T>::process(shield_symbolizer const& sym,
     }
     if (placement_found)
         pixmap_.add_feature(feature);
+    this->add_label_stats(1, placed);
 }
 
 template void grid_renderer<grid>::process(shield_symbolizer const&,
@@ -44,9 +44,11 @@ void grid_renderer<T>::process(text_symbolizer const& sym,
 
     text_renderer<T> ren(pixmap_, font_manager_, *(font_manager_.get_stroker()));
 
+    unsigned placed = 0;
     while (helper.next()) {
         placement_found = true;
         placements_type &placements = helper.placements();
+        placed += placements.size();
         for (unsigned int ii = 0; ii < placements.size(); ++ii)
         {
             ren.prepare_glyphs(&(placements[ii]));
@@ -54,6 +56,7 @@ void grid_renderer<T>::process(text_symbolizer const& sym,
         }
     }
     if (placement_found) pixmap_.add_feature(feature);
+    this->add_label_stats(1, placed);
 
 }
 
@@ -0,0 +1,84 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/image_blend.hpp>
+#include <mapnik/cpu_features.hpp>
+#include <mapnik/internal/image_blend_kernels.hpp>
+
+namespace mapnik
+{
+
+namespace {
+
+simd_level_e detect_simd_level()
+{
+#ifdef MAPNIK_BIG_ENDIAN
+    // the kernels assume the little-endian pixel layout
+    return SIMD_NONE;
+#else
+    if (cpu_has_avx2()) return SIMD_AVX2;
+    if (cpu_has_sse2()) return SIMD_SSE2;
+    return SIMD_NONE;
+#endif
+}
+
+// picked while the library loads, before any thread can blend, and then
+// only read, so every blend call reads it without a lock
+simd_level_e const detected_level = detect_simd_level();
+simd_level_e current_level = detected_level;
+
+}
+
+simd_level_e get_simd_level()
+{
+    return current_level;
+}
+
+void set_simd_level(simd_level_e level)
+{
+    current_level = (level < detected_level) ? level : detected_level;
+}
+
+unsigned blend_row(simd_level_e level, blend_mode_e mode, unsigned * dst,
+                   unsigned const* src, unsigned len, float opacity)
+{
+    // above 1.0 the scaled alpha leaves the 8 bit range the kernels assume
+    if (!(opacity >= 0.0f && opacity <= 1.0f)) return 0;
+    switch ((level < detected_level) ? level : detected_level)
+    {
+    case SIMD_AVX2:
+    {
+        // finish the tail that does not fill a 256 bit vector with SSE2; when
+        // built without AVX2 support the first call processes nothing
+        unsigned n = detail::blend_row_avx2(mode, dst, src, len, opacity);
+        return n + detail::blend_row_sse2(mode, dst + n, src + n, len - n, opacity);
+    }
+    case SIMD_SSE2:
+        return detail::blend_row_sse2(mode, dst, src, len, opacity);
+    case SIMD_NONE:
+        break;
+    }
+    return 0;
+}
+
+}
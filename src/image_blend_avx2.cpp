@@ -0,0 +1,87 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// This file is compiled with -mavx2 (see src/build.py). Nothing in it may
+// run before cpu_has_avx2() has been checked by the dispatcher in
+// image_blend.cpp, so keep everything else out of this translation unit.
+
+// mapnik
+#include <mapnik/internal/image_blend_kernels.hpp>
+
+#if !defined(MAPNIK_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace mapnik { namespace detail {
+
+#if !defined(MAPNIK_NO_SIMD) && defined(__AVX2__)
+
+struct avx2_traits
+{
+    typedef __m256i vi;
+    typedef __m256 vf;
+    enum { width = 8 };
+
+    static inline vi load(unsigned const* p) { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)); }
+    static inline void store(unsigned * p, vi v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static inline vi set1_i(int v) { return _mm256_set1_epi32(v); }
+    static inline vf set1_f(float v) { return _mm256_set1_ps(v); }
+    static inline vi and_i(vi a, vi b) { return _mm256_and_si256(a, b); }
+    static inline vi or_i(vi a, vi b) { return _mm256_or_si256(a, b); }
+    static inline vi srl(vi a, int n) { return _mm256_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+    static inline vi sll(vi a, int n) { return _mm256_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+    static inline vf to_f(vi a) { return _mm256_cvtepi32_ps(a); }
+    static inline vi to_i(vf a) { return _mm256_cvttps_epi32(a); }
+    static inline vf add_f(vf a, vf b) { return _mm256_add_ps(a, b); }
+    static inline vf sub_f(vf a, vf b) { return _mm256_sub_ps(a, b); }
+    static inline vf mul_f(vf a, vf b) { return _mm256_mul_ps(a, b); }
+    static inline vf div_f(vf a, vf b) { return _mm256_div_ps(a, b); }
+    static inline vf min_f(vf a, vf b) { return _mm256_min_ps(a, b); }
+    static inline vf max_f(vf a, vf b) { return _mm256_max_ps(a, b); }
+    static inline vf eq_f(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static inline vf gt_f(vf a, vf b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static inline vf select_f(vf mask, vf a, vf b) { return _mm256_blendv_ps(b, a, mask); }
+    static inline vi select_i(vf mask, vi a, vi b)
+    {
+        return _mm256_blendv_epi8(b, a, _mm256_castps_si256(mask));
+    }
+};
+
+unsigned blend_row_avx2(blend_mode_e mode, unsigned * dst, unsigned const* src,
+                        unsigned len, float opacity)
+{
+    unsigned n = blend_row_impl<avx2_traits>(mode, dst, src, len, opacity);
+    // avoid the AVX/SSE transition penalty in the caller's scalar tail
+    _mm256_zeroupper();
+    return n;
+}
+
+#else
+
+unsigned blend_row_avx2(blend_mode_e, unsigned *, unsigned const*, unsigned, float)
+{
+    return 0;
+}
+
+#endif
+
+}}
@@ -0,0 +1,85 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/internal/image_blend_kernels.hpp>
+
+#if !defined(MAPNIK_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define MAPNIK_HAVE_SSE2_KERNELS
+#endif
+
+namespace mapnik { namespace detail {
+
+#ifdef MAPNIK_HAVE_SSE2_KERNELS
+
+struct sse2_traits
+{
+    typedef __m128i vi;
+    typedef __m128 vf;
+    enum { width = 4 };
+
+    static inline vi load(unsigned const* p) { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p)); }
+    static inline void store(unsigned * p, vi v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static inline vi set1_i(int v) { return _mm_set1_epi32(v); }
+    static inline vf set1_f(float v) { return _mm_set1_ps(v); }
+    static inline vi and_i(vi a, vi b) { return _mm_and_si128(a, b); }
+    static inline vi or_i(vi a, vi b) { return _mm_or_si128(a, b); }
+    static inline vi srl(vi a, int n) { return _mm_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+    static inline vi sll(vi a, int n) { return _mm_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+    static inline vf to_f(vi a) { return _mm_cvtepi32_ps(a); }
+    static inline vi to_i(vf a) { return _mm_cvttps_epi32(a); }
+    static inline vf add_f(vf a, vf b) { return _mm_add_ps(a, b); }
+    static inline vf sub_f(vf a, vf b) { return _mm_sub_ps(a, b); }
+    static inline vf mul_f(vf a, vf b) { return _mm_mul_ps(a, b); }
+    static inline vf div_f(vf a, vf b) { return _mm_div_ps(a, b); }
+    static inline vf min_f(vf a, vf b) { return _mm_min_ps(a, b); }
+    static inline vf max_f(vf a, vf b) { return _mm_max_ps(a, b); }
+    static inline vf eq_f(vf a, vf b) { return _mm_cmpeq_ps(a, b); }
+    static inline vf gt_f(vf a, vf b) { return _mm_cmpgt_ps(a, b); }
+    static inline vf select_f(vf mask, vf a, vf b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+    static inline vi select_i(vf mask, vi a, vi b)
+    {
+        vi m = _mm_castps_si128(mask);
+        return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+    }
+};
+
+unsigned blend_row_sse2(blend_mode_e mode, unsigned * dst, unsigned const* src,
+                        unsigned len, float opacity)
+{
+    return blend_row_impl<sse2_traits>(mode, dst, src, len, opacity);
+}
+
+#else
+
+unsigned blend_row_sse2(blend_mode_e, unsigned *, unsigned const*, unsigned, float)
+{
+    return 0;
+}
+
+#endif
+
+}}
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/image_tile_cache.hpp>
+
+namespace mapnik
+{
+
+image_tile_cache::image_tile_cache()
+    : cache_(64 * 1024 * 1024) {}
+
+boost::optional<image_tile_ptr> image_tile_cache::find(image_tile_key const& key)
+{
+    boost::optional<image_tile_ptr> result;
+    image_tile_ptr tile;
+    if (cache_.find(key, tile))
+    {
+        result.reset(tile);
+    }
+    return result;
+}
+
+void image_tile_cache::insert(image_tile_key const& key, image_tile_ptr const& tile)
+{
+    cache_.insert(key, tile, tile->width() * tile->height() * sizeof(image_data_32::pixel_type));
+}
+
+void image_tile_cache::set_capacity(std::size_t bytes)
+{
+    cache_.set_capacity(bytes);
+}
+
+std::size_t image_tile_cache::capacity() const
+{
+    return cache_.capacity();
+}
+
+void image_tile_cache::clear()
+{
+    cache_.clear();
+}
+
+}
@@ -37,6 +37,8 @@ extern "C"
 #include <mapnik/palette.hpp>
 #include <mapnik/map.hpp>
 #include <mapnik/util/conversions.hpp>
+#include <mapnik/raster_colorizer.hpp>
+#include <mapnik/internal/colorizer_accessor.hpp>
 
 // jpeg
 #if defined(HAVE_JPEG)
@@ -126,7 +128,8 @@ void handle_png_options(std::string const& type,
                         int * strategy,
                         int * trans_mode,
                         double * gamma,
-                        bool * use_octree)
+                        bool * use_octree,
+                        unsigned * threads)
 {
     if (type == "png" || type == "png24" || type == "png32")
     {
@@ -193,6 +196,16 @@ void handle_png_options(std::string const& type,
                     throw ImageWriterException("invalid compression parameter: " + t.substr(2) + " (only -1 through 9 are valid)");
                 }
             }
+            else if (boost::algorithm::starts_with(t, "p="))
+            {
+                // deflate in strips on this many threads, 0 for one per core
+                int val = 1;
+                if (!mapnik::util::string2int(t.substr(2),val) || val < 0)
+                {
+                    throw ImageWriterException("invalid parallel strips parameter: " + t.substr(2));
+                }
+                *threads = val;
+            }
             else if (boost::algorithm::starts_with(t, "s="))
             {
                 std::string const& s = t.substr(2);
@@ -239,6 +252,7 @@ void save_to_stream(T const& image,
             int trans_mode = -1;
             double gamma = -1;
             bool use_octree = true;
+            unsigned threads = 1;
 
             handle_png_options(t,
                                &colors,
@@ -246,16 +260,17 @@ void save_to_stream(T const& image,
                                &strategy,
                                &trans_mode,
                                &gamma,
-                               &use_octree);
+                               &use_octree,
+                               &threads);
 
             if (palette.valid())
-                save_as_png8_pal(stream, image, palette, compression, strategy);
+                save_as_png8_pal(stream, image, palette, compression, strategy, threads);
             else if (colors < 0)
-                save_as_png(stream, image, compression, strategy);
+                save_as_png(stream, image, compression, strategy, threads);
             else if (use_octree)
-                save_as_png8_oct(stream, image, colors, compression, strategy);
+                save_as_png8_oct(stream, image, colors, compression, strategy, -1, threads);
             else
-                save_as_png8_hex(stream, image, colors, compression, strategy, trans_mode, gamma);
+                save_as_png8_hex(stream, image, colors, compression, strategy, trans_mode, gamma, threads);
         }
         else if (boost::algorithm::starts_with(t, "tif"))
         {
@@ -290,6 +305,7 @@ void save_to_stream(T const& image,
             int trans_mode = -1;
             double gamma = -1;
             bool use_octree = true;
+            unsigned threads = 1;
 
             handle_png_options(t,
                                &colors,
@@ -297,14 +313,15 @@ void save_to_stream(T const& image,
                                &strategy,
                                &trans_mode,
                                &gamma,
-                               &use_octree);
+                               &use_octree,
+                               &threads);
 
             if (colors < 0)
-                save_as_png(stream, image, compression, strategy);
+                save_as_png(stream, image, compression, strategy, threads);
             else if (use_octree)
-                save_as_png8_oct(stream, image, colors, compression, strategy);
+                save_as_png8_oct(stream, image, colors, compression, strategy, -1, threads);
             else
-                save_as_png8_hex(stream, image, colors, compression, strategy, trans_mode, gamma);
+                save_as_png8_hex(stream, image, colors, compression, strategy, trans_mode, gamma, threads);
         }
         else if (boost::algorithm::starts_with(t, "tif"))
         {
@@ -686,11 +703,12 @@ void scale_image_bilinear8 (Image& target,const Image& source, double x_off_f, d
     }
 }
 
-template <typename Image>
-void scale_image_agg (Image& target,const Image& source, scaling_method_e scaling_method, double scale_factor, double x_off_f, double y_off_f, double filter_radius, double ratio)
+template <typename Image, typename Accessor>
+void scale_image_agg_impl (Image& target, unsigned source_width, unsigned source_height, Accessor & img_src, scaling_method_e scaling_method, double scale_factor, double x_off_f, double y_off_f, double filter_radius, double ratio)
 {
     typedef agg::pixfmt_rgba32_plain pixfmt;
     typedef agg::renderer_base<pixfmt> renderer_base;
+    typedef Accessor img_src_type;
 
     // define some stuff we'll use soon
     agg::rasterizer_scanline_aa<> ras;
@@ -698,13 +716,6 @@ void scale_image_agg (Image& target,const Image& source, scaling_method_e scalin
     agg::span_allocator<agg::rgba8> sa;
     agg::image_filter_lut filter;
 
-    // initialize source AGG buffer
-    agg::rendering_buffer rbuf_src((unsigned char*)source.getBytes(), source.width(), source.height(), source.width() * 4);
-    pixfmt pixf_src(rbuf_src);
-
-    typedef agg::image_accessor_clone<pixfmt> img_src_type;
-    img_src_type img_src(pixf_src);
-
     // initialise destination AGG buffer (with transparency)
     agg::rendering_buffer rbuf_dst((unsigned char*)target.getBytes(), target.width(), target.height(), target.width() * 4);
     pixfmt pixf_dst(rbuf_dst);
@@ -720,8 +731,8 @@ void scale_image_agg (Image& target,const Image& source, scaling_method_e scalin
     interpolator_type interpolator(img_mtx);
 
     // draw an anticlockwise polygon to render our image into
-    double scaled_width = source.width() * scale_factor;
-    double scaled_height = source.height() * scale_factor;
+    double scaled_width = source_width * scale_factor;
+    double scaled_height = source_height * scale_factor;
     ras.reset();
     ras.move_to_d(x_off_f,                y_off_f);
     ras.line_to_d(x_off_f + scaled_width, y_off_f);
@@ -775,6 +786,32 @@ void scale_image_agg (Image& target,const Image& source, scaling_method_e scalin
     agg::render_scanlines_aa(ras, sl, rb_dst, sa, sg);
 }
 
+template <typename Image>
+void scale_image_agg (Image& target,const Image& source, scaling_method_e scaling_method, double scale_factor, double x_off_f, double y_off_f, double filter_radius, double ratio)
+{
+    typedef agg::pixfmt_rgba32_plain pixfmt;
+
+    // initialize source AGG buffer
+    agg::rendering_buffer rbuf_src((unsigned char*)source.getBytes(), source.width(), source.height(), source.width() * 4);
+    pixfmt pixf_src(rbuf_src);
+
+    typedef agg::image_accessor_clone<pixfmt> img_src_type;
+    img_src_type img_src(pixf_src);
+    scale_image_agg_impl(target, source.width(), source.height(), img_src, scaling_method, scale_factor, x_off_f, y_off_f, filter_radius, ratio);
+}
+
+void scale_image_agg (image_data_32& target,const image_data_32& source, colorizer_lut const& lut, scaling_method_e scaling_method, double scale_factor, double x_off_f, double y_off_f, double filter_radius, double ratio)
+{
+    typedef agg::pixfmt_rgba32_plain pixfmt;
+
+    agg::rendering_buffer rbuf_src((unsigned char*)source.getBytes(), source.width(), source.height(), source.width() * 4);
+    pixfmt pixf_src(rbuf_src);
+
+    typedef colorizer_accessor<pixfmt> img_src_type;
+    img_src_type img_src(pixf_src, lut);
+    scale_image_agg_impl(target, source.width(), source.height(), img_src, scaling_method, scale_factor, x_off_f, y_off_f, filter_radius, ratio);
+}
+
 template void scale_image_agg<image_data_32> (image_data_32& target,const image_data_32& source, scaling_method_e scaling_method, double scale_factor, double x_off_f, double y_off_f, double filter_radius, double ratio);
 
 template void scale_image_bilinear_old<image_data_32> (image_data_32& target,const image_data_32& source, double x_off_f, double y_off_f);
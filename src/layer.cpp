@@ -44,6 +44,8 @@ layer::layer(std::string const& name, std::string const& srs)
       queryable_(false),
       clear_label_cache_(false),
       cache_features_(false),
+      cache_rendering_(false),
+      min_feature_size_(0.0),
       group_by_(""),
       ds_() {}
 
@@ -56,6 +58,8 @@ layer::layer(const layer& rhs)
       queryable_(rhs.queryable_),
       clear_label_cache_(rhs.clear_label_cache_),
       cache_features_(rhs.cache_features_),
+      cache_rendering_(rhs.cache_rendering_),
+      min_feature_size_(rhs.min_feature_size_),
       group_by_(rhs.group_by_),
       styles_(rhs.styles_),
       ds_(rhs.ds_) {}
@@ -82,6 +86,8 @@ void layer::swap(const layer& rhs)
     queryable_=rhs.queryable_;
     clear_label_cache_ = rhs.clear_label_cache_;
     cache_features_ = rhs.cache_features_;
+    cache_rendering_ = rhs.cache_rendering_;
+    min_feature_size_ = rhs.min_feature_size_;
     group_by_ = rhs.group_by_;
     styles_=rhs.styles_;
     ds_=rhs.ds_;
@@ -205,6 +211,26 @@ bool layer::cache_features() const
     return cache_features_;
 }
 
+void layer::set_cache_rendering(bool cache_rendering)
+{
+    cache_rendering_ = cache_rendering;
+}
+
+bool layer::cache_rendering() const
+{
+    return cache_rendering_;
+}
+
+void layer::set_min_feature_size(double size)
+{
+    min_feature_size_ = size;
+}
+
+double layer::min_feature_size() const
+{
+    return min_feature_size_;
+}
+
 void layer::set_group_by(std::string column)
 {
     group_by_ = column;
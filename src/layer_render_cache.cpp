@@ -0,0 +1,249 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/layer_render_cache.hpp>
+
+// boost
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/make_shared.hpp>
+
+// stl
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+namespace mapnik
+{
+
+namespace {
+
+// "MLC" and a format version
+const boost::uint32_t file_magic = 0x01434c4d;
+
+std::string file_name(std::string const& directory, std::string const& key)
+{
+    std::ostringstream s;
+    s << directory << "/" << std::hex << std::setfill('0') << std::setw(16)
+      << static_cast<unsigned long long>(boost::hash_value(key)) << ".layer";
+    return s.str();
+}
+
+template <typename T>
+void write_value(std::ostream & out, T val)
+{
+    out.write(reinterpret_cast<char const*>(&val), sizeof(T));
+}
+
+template <typename T>
+bool read_value(std::istream & in, T & val)
+{
+    return bool(in.read(reinterpret_cast<char*>(&val), sizeof(T)));
+}
+
+// written in host byte order, the files are a local cache
+void write_layer(std::ostream & out, std::string const& key, cached_layer const& layer)
+{
+    write_value<boost::uint32_t>(out, file_magic);
+    write_value<boost::uint32_t>(out, key.size());
+    out.write(key.data(), key.size());
+    write_value<boost::uint32_t>(out, layer.image.width());
+    write_value<boost::uint32_t>(out, layer.image.height());
+    write_value<boost::uint32_t>(out, layer.painted ? 1 : 0);
+    write_value<boost::uint32_t>(out, layer.labels.size());
+    for (unsigned i = 0; i < layer.labels.size(); ++i)
+    {
+        label_collision_detector4::label const& lbl = layer.labels[i];
+        write_value(out, lbl.box.minx());
+        write_value(out, lbl.box.miny());
+        write_value(out, lbl.box.maxx());
+        write_value(out, lbl.box.maxy());
+        write_value<boost::uint32_t>(out, lbl.text.length());
+        out.write(reinterpret_cast<char const*>(lbl.text.getBuffer()), lbl.text.length() * sizeof(UChar));
+    }
+    out.write(reinterpret_cast<char const*>(layer.image.getBytes()),
+              layer.image.width() * layer.image.height() * sizeof(image_data_32::pixel_type));
+}
+
+// the bytes a label takes in the file besides its text
+const boost::uint64_t label_bytes = 4 * sizeof(double) + sizeof(boost::uint32_t);
+
+// Files may be damaged or written by another version, so every size read
+// from one is checked against what is left of the file (length bytes in
+// all) before anything is allocated for it.
+cached_layer_ptr read_layer(std::istream & in, boost::uint64_t length, std::string const& key,
+                            unsigned expected_width, unsigned expected_height)
+{
+    boost::uint32_t magic, size, width, height, painted, count;
+    if (!read_value(in, magic) || magic != file_magic) return cached_layer_ptr();
+    // the name is a hash, the key tells collisions apart
+    if (!read_value(in, size) || size != key.size()) return cached_layer_ptr();
+    std::string file_key(size, '\0');
+    if (!in.read(&file_key[0], size) || file_key != key) return cached_layer_ptr();
+    if (!read_value(in, width) || !read_value(in, height) ||
+        !read_value(in, painted) || !read_value(in, count))
+    {
+        return cached_layer_ptr();
+    }
+    if (width != expected_width || height != expected_height) return cached_layer_ptr();
+    boost::uint64_t pixel_bytes = boost::uint64_t(width) * height * sizeof(image_data_32::pixel_type);
+    boost::uint64_t left = length - static_cast<boost::uint64_t>(in.tellg());
+    if (pixel_bytes > left || count > (left - pixel_bytes) / label_bytes) return cached_layer_ptr();
+
+    cached_layer_ptr layer = boost::make_shared<cached_layer>(width, height);
+    layer->painted = (painted != 0);
+    layer->labels.reserve(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        double minx, miny, maxx, maxy;
+        boost::uint32_t text_length;
+        if (!read_value(in, minx) || !read_value(in, miny) ||
+            !read_value(in, maxx) || !read_value(in, maxy) || !read_value(in, text_length))
+        {
+            return cached_layer_ptr();
+        }
+        left = length - static_cast<boost::uint64_t>(in.tellg());
+        if (left < pixel_bytes || boost::uint64_t(text_length) * sizeof(UChar) > left - pixel_bytes)
+        {
+            return cached_layer_ptr();
+        }
+        UnicodeString text;
+        if (text_length > 0)
+        {
+            UChar * buf = text.getBuffer(text_length);
+            if (!buf) return cached_layer_ptr();
+            bool ok = bool(in.read(reinterpret_cast<char*>(buf), text_length * sizeof(UChar)));
+            text.releaseBuffer(ok ? text_length : 0);
+            if (!ok) return cached_layer_ptr();
+        }
+        layer->labels.push_back(label_collision_detector4::label(box2d<double>(minx, miny, maxx, maxy), text));
+    }
+    if (!in.read(reinterpret_cast<char*>(layer->image.getBytes()), pixel_bytes))
+    {
+        return cached_layer_ptr();
+    }
+    return layer;
+}
+
+std::size_t layer_cost(cached_layer const& layer)
+{
+    return layer.image.width() * layer.image.height() * sizeof(image_data_32::pixel_type) +
+        layer.labels.size() * sizeof(label_collision_detector4::label);
+}
+
+}
+
+layer_render_cache::layer_render_cache()
+    : cache_(128 * 1024 * 1024) {}
+
+boost::optional<cached_layer_ptr> layer_render_cache::find(std::string const& key,
+                                                           unsigned width, unsigned height)
+{
+    boost::optional<cached_layer_ptr> result;
+    cached_layer_ptr layer;
+    if (cache_.find(key, layer))
+    {
+        if (layer->image.width() == width && layer->image.height() == height)
+        {
+            result.reset(layer);
+        }
+        return result;
+    }
+    std::string dir = directory();
+    if (dir.empty()) return result;
+
+    std::ifstream file(file_name(dir, key).c_str(), std::ios::in | std::ios::binary);
+    if (!file) return result;
+    file.seekg(0, std::ios::end);
+    std::streamoff length = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (length <= 0 || !file) return result;
+    layer = read_layer(file, static_cast<boost::uint64_t>(length), key, width, height);
+    if (layer)
+    {
+        cache_.insert(key, layer, layer_cost(*layer));
+        result.reset(layer);
+    }
+    return result;
+}
+
+void layer_render_cache::insert(std::string const& key, cached_layer_ptr const& layer)
+{
+    cache_.insert(key, layer, layer_cost(*layer));
+    std::string dir = directory();
+    if (dir.empty()) return;
+
+    // written under a unique name and renamed, so readers in other
+    // threads and processes never see a partial file
+    std::string name = file_name(dir, key);
+    boost::filesystem::path tmp = boost::filesystem::unique_path(name + ".%%%%-%%%%-%%%%");
+    {
+        std::ofstream file(tmp.string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        write_layer(file, key, *layer);
+        if (!file)
+        {
+            file.close();
+            boost::system::error_code ec;
+            boost::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+    boost::system::error_code ec;
+    boost::filesystem::rename(tmp, name, ec);
+    if (ec) boost::filesystem::remove(tmp, ec);
+}
+
+void layer_render_cache::set_capacity(std::size_t bytes)
+{
+    cache_.set_capacity(bytes);
+}
+
+std::size_t layer_render_cache::capacity() const
+{
+    return cache_.capacity();
+}
+
+void layer_render_cache::set_directory(std::string const& directory)
+{
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex::scoped_lock lock(mutex_);
+#endif
+    directory_ = directory;
+}
+
+std::string layer_render_cache::directory() const
+{
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex::scoped_lock lock(mutex_);
+#endif
+    return directory_;
+}
+
+void layer_render_cache::clear()
+{
+    cache_.clear();
+}
+
+}
@@ -413,6 +413,9 @@ void map_parser::parse_style(Map & map, xml_node const& sty)
         filter_mode_e filter_mode = sty.get_attr<filter_mode_e>("filter-mode", FILTER_ALL);
         style.set_filter_mode(filter_mode);
 
+        optional<boolean> batch_polygons = sty.get_opt_attr<boolean>("batch-polygons");
+        if (batch_polygons) style.set_batch_polygons(*batch_polygons);
+
         xml_node::const_iterator ruleIter = sty.begin();
         xml_node::const_iterator endRule = sty.end();
 
@@ -543,6 +546,20 @@ void map_parser::parse_layer(Map & map, xml_node const& lay)
             lyr.set_cache_features(* cache_features);
         }
 
+        optional<boolean> cache_rendering =
+            lay.get_opt_attr<boolean>("cache-rendering");
+        if (cache_rendering)
+        {
+            lyr.set_cache_rendering(* cache_rendering);
+        }
+
+        optional<double> min_feature_size =
+            lay.get_opt_attr<double>("min-feature-size");
+        if (min_feature_size)
+        {
+            lyr.set_min_feature_size(* min_feature_size);
+        }
+
         optional<std::string> group_by =
             lay.get_opt_attr<std::string>("group-by");
         if (group_by)
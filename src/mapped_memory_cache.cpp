@@ -24,6 +24,9 @@
 
 // mapnik
 #include <mapnik/mapped_memory_cache.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <mapnik/thread_local_cache.hpp>
+#endif
 
 // boost
 #include <boost/assert.hpp>
@@ -36,10 +39,15 @@ namespace mapnik
 
 boost::unordered_map<std::string, mapped_region_ptr> mapped_memory_cache::cache_;
 
+#ifdef MAPNIK_THREADSAFE
+static thread_local_cache<std::string, mapped_region_ptr> front_cache_;
+#endif
+
 void mapped_memory_cache::clear()
 {
 #ifdef MAPNIK_THREADSAFE
     mutex::scoped_lock lock(mutex_);
+    front_cache_.invalidate();
 #endif
     return cache_.clear();
 }
@@ -54,17 +62,30 @@ bool mapped_memory_cache::insert(std::string const& uri, mapped_region_ptr mem)
 
 boost::optional<mapped_region_ptr> mapped_memory_cache::find(std::string const& uri, bool update_cache)
 {
-#ifdef MAPNIK_THREADSAFE
-    mutex::scoped_lock lock(mutex_);
-#endif
     typedef boost::unordered_map<std::string, mapped_region_ptr>::const_iterator iterator_type;
     boost::optional<mapped_region_ptr> result;
-    iterator_type itr = cache_.find(uri);
-    if (itr != cache_.end())
+#ifdef MAPNIK_THREADSAFE
+    mapped_region_ptr region;
+    if (front_cache_.find(uri, region))
     {
-        result.reset(itr->second);
+        result.reset(region);
         return result;
     }
+#endif
+    {
+#ifdef MAPNIK_THREADSAFE
+        mutex::scoped_lock lock(mutex_);
+#endif
+        iterator_type itr = cache_.find(uri);
+        if (itr != cache_.end())
+        {
+#ifdef MAPNIK_THREADSAFE
+            front_cache_.insert(uri, itr->second);
+#endif
+            result.reset(itr->second);
+            return result;
+        }
+    }
 
     boost::filesystem::path path(uri);
     if (exists(path))
@@ -78,7 +99,16 @@ boost::optional<mapped_region_ptr> mapped_memory_cache::find(std::string const&
 
             if (update_cache)
             {
-                cache_.insert(std::make_pair(uri,*result));
+#ifdef MAPNIK_THREADSAFE
+                mutex::scoped_lock lock(mutex_);
+#endif
+                // another thread may have mapped the same file in the meantime
+                std::pair<boost::unordered_map<std::string, mapped_region_ptr>::iterator, bool> ret =
+                    cache_.insert(std::make_pair(uri,*result));
+                result.reset(ret.first->second);
+#ifdef MAPNIK_THREADSAFE
+                front_cache_.insert(uri, *result);
+#endif
             }
             return result;
         }
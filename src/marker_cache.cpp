@@ -32,6 +32,9 @@
 #include <mapnik/svg/svg_path_attributes.hpp>
 #include <mapnik/image_util.hpp>
 #include <mapnik/image_reader.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <mapnik/thread_local_cache.hpp>
+#endif
 
 // boost
 #include <boost/assert.hpp>
@@ -42,12 +45,17 @@
 namespace mapnik
 {
 
-boost::unordered_map<std::string, marker_ptr> marker_cache::cache_;
+boost::unordered_map<marker_key, marker_ptr> marker_cache::cache_;
+
+#ifdef MAPNIK_THREADSAFE
+static thread_local_cache<marker_key, marker_ptr> front_cache_;
+#endif
 
 void marker_cache::clear()
 {
 #ifdef MAPNIK_THREADSAFE
     mutex::scoped_lock lock(mutex_);
+    front_cache_.invalidate();
 #endif
     return cache_.clear();
 }
@@ -57,22 +65,17 @@ bool marker_cache::insert(std::string const& uri, marker_ptr path)
 #ifdef MAPNIK_THREADSAFE
     mutex::scoped_lock lock(mutex_);
 #endif
-    return cache_.insert(std::make_pair(uri,path)).second;
+    return cache_.insert(std::make_pair(marker_key(uri),path)).second;
 }
 
 boost::optional<marker_ptr> marker_cache::find(std::string const& uri, bool update_cache)
 {
-#ifdef MAPNIK_THREADSAFE
-    mutex::scoped_lock lock(mutex_);
-#endif
-    typedef boost::unordered_map<std::string, marker_ptr>::const_iterator iterator_type;
+    return find(marker_key(uri), update_cache);
+}
+
+static boost::optional<marker_ptr> load_marker(std::string const& uri)
+{
     boost::optional<marker_ptr> result;
-    iterator_type itr = cache_.find(uri);
-    if (itr != cache_.end())
-    {
-        result.reset(itr->second);
-        return result;
-    }
 
     // we can't find marker in cache, lets try to load it from filesystem
     boost::filesystem::path path(uri);
@@ -97,11 +100,6 @@ boost::optional<marker_ptr> marker_cache::find(std::string const& uri, bool upda
 
                 marker_ptr mark(boost::make_shared<marker>(marker_path));
                 result.reset(mark);
-                if (update_cache)
-                {
-                    cache_.insert(std::make_pair(uri,*result));
-                }
-                return result;
             }
             catch (...)
             {
@@ -122,10 +120,6 @@ boost::optional<marker_ptr> marker_cache::find(std::string const& uri, bool upda
                     reader->read(0,0,*image);
                     marker_ptr mark(boost::make_shared<marker>(image));
                     result.reset(mark);
-                    if (update_cache)
-                    {
-                        cache_.insert(std::make_pair(uri,*result));
-                    }
                 }
             }
 
@@ -142,4 +136,49 @@ boost::optional<marker_ptr> marker_cache::find(std::string const& uri, bool upda
     return result;
 }
 
+boost::optional<marker_ptr> marker_cache::find(marker_key const& key, bool update_cache)
+{
+    typedef boost::unordered_map<marker_key, marker_ptr>::const_iterator iterator_type;
+    boost::optional<marker_ptr> result;
+#ifdef MAPNIK_THREADSAFE
+    marker_ptr mark;
+    if (front_cache_.find(key, mark))
+    {
+        result.reset(mark);
+        return result;
+    }
+#endif
+    {
+#ifdef MAPNIK_THREADSAFE
+        mutex::scoped_lock lock(mutex_);
+#endif
+        iterator_type itr = cache_.find(key);
+        if (itr != cache_.end())
+        {
+#ifdef MAPNIK_THREADSAFE
+            front_cache_.insert(key, itr->second);
+#endif
+            result.reset(itr->second);
+            return result;
+        }
+    }
+
+    // loading happens outside the lock so a slow file doesn't stall other threads
+    result = load_marker(key.uri);
+    if (result && update_cache)
+    {
+#ifdef MAPNIK_THREADSAFE
+        mutex::scoped_lock lock(mutex_);
+#endif
+        // another thread may have loaded the same marker in the meantime
+        std::pair<boost::unordered_map<marker_key, marker_ptr>::iterator, bool> ret =
+            cache_.insert(std::make_pair(key,*result));
+        result.reset(ret.first->second);
+#ifdef MAPNIK_THREADSAFE
+        front_cache_.insert(key, *result);
+#endif
+    }
+    return result;
+}
+
 }
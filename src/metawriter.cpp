@@ -25,17 +25,24 @@
 #include <mapnik/metawriter_json.hpp>
 #include <mapnik/text_placements/base.hpp>
 #include <mapnik/text_path.hpp>
+#include <mapnik/util/conversions.hpp>
 
 // Boost
 #include <boost/foreach.hpp>
 #include <boost/algorithm/string.hpp>
 
 // STL
-#include <iomanip>
-#include <cstdio>
+#include <cmath>
 
 namespace mapnik {
 
+namespace {
+
+// hand the buffer to the stream in chunks of about this size
+const std::size_t flush_size = 65536;
+
+}
+
 UnicodeString const& metawriter_property_map::operator[](std::string const& key) const
 {
     std::map<std::string, UnicodeString>::const_iterator it;
@@ -71,18 +78,36 @@ void metawriter_json_stream::start(metawriter_property_map const& /*properties*/
 void metawriter_json_stream::write_header()
 {
     assert(f_);
-    *f_ << "{ \"type\": \"FeatureCollection\", \"features\": [\n" << std::fixed << std::setprecision(pixel_coordinates_ ? 0 : 8);
+    buffer_.clear();
+    buffer_ += "{ \"type\": \"FeatureCollection\", \"features\": [\n";
+    precision_ = pixel_coordinates_ ? 0 : 8;
     count_ = STARTED;
 }
 
 void metawriter_json_stream::stop()
 {
     if (count_ >= STARTED && f_) {
-        *f_ << " ] }\n";
+        buffer_ += " ] }\n";
+        flush(true);
     }
+    buffer_.clear();
     count_ = STOPPED;
 }
 
+void metawriter_json_stream::write_number(double val)
+{
+    util::append_fixed(buffer_, val, precision_);
+}
+
+void metawriter_json_stream::flush(bool force)
+{
+    if (force || buffer_.size() >= flush_size)
+    {
+        f_->write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+}
+
 metawriter_json_stream::~metawriter_json_stream()
 {
     if (count_ >= STARTED) {
@@ -98,14 +123,14 @@ metawriter_json_stream::~metawriter_json_stream()
 metawriter_json_stream::metawriter_json_stream(metawriter_properties dflt_properties)
     : metawriter(dflt_properties), count_(-1), output_empty_(true),
       trans_(0), output_srs_("+proj=longlat +ellps=WGS84 +datum=WGS84 +no_defs"),
-      pixel_coordinates_(false), f_(0)
+      pixel_coordinates_(false), precision_(8), f_(0)
 {
 }
 
 void metawriter_json_stream::write_properties(Feature const& feature, metawriter_properties const& properties)
 {
-    *f_ << "}," << //Close coordinates object
-        "\n  \"properties\": {";
+    buffer_ += "},"; //Close coordinates object
+    buffer_ += "\n  \"properties\": {";
 
     int i = 0;
     BOOST_FOREACH(std::string const& p, properties)
@@ -117,13 +142,21 @@ void metawriter_json_stream::write_properties(Feature const& feature, metawriter
             if (str.size() == 0) continue; // ignore empty attributes
 
             //Property found
-            std::string text = boost::replace_all_copy(boost::replace_all_copy(str, "\\", "\\\\"), "\"", "\\\"");
-            if (i++) *f_ << ",";
-            *f_ << "\n    \"" << p << "\":\"" << text << "\"";
+            if (i++) buffer_ += ',';
+            buffer_ += "\n    \"";
+            buffer_ += p;
+            buffer_ += "\":\"";
+            for (std::string::const_iterator c = str.begin(); c != str.end(); ++c)
+            {
+                if (*c == '\\' || *c == '"') buffer_ += '\\';
+                buffer_ += *c;
+            }
+            buffer_ += '"';
         }
     }
 
-    *f_ << "\n} }";
+    buffer_ += "\n} }";
+    flush();
 }
 
 /* Coordinate transform in renderer:
@@ -165,11 +198,17 @@ void metawriter_json_stream::add_box(box2d<double> const &box, Feature const& fe
 
     write_feature_header("Polygon");
 
-    *f_ << " [ [ [" <<
-        minx << ", " << miny << "], [" <<
-        maxx << ", " << miny << "], [" <<
-        maxx << ", " << maxy << "], [" <<
-        minx << ", " << maxy << "] ] ]";
+    double xs[4] = { minx, maxx, maxx, minx };
+    double ys[4] = { miny, miny, maxy, maxy };
+    buffer_ += " [ [ [";
+    for (int i = 0; i < 4; ++i)
+    {
+        if (i) buffer_ += "], [";
+        write_number(xs[i]);
+        buffer_ += ", ";
+        write_number(ys[i]);
+    }
+    buffer_ += "] ] ]";
 
     write_properties(feature, properties);
 
@@ -231,11 +270,11 @@ void metawriter_json_stream::add_text(
         }
 
         write_feature_header("MultiPolygon");
-        *f_ << "[";
+        buffer_ += '[';
         for (int i = 0; i < current_placement.num_nodes(); ++i) {
             current_placement.vertex(&c, &x, &y, &angle);
             if (c->c == ' ') continue;
-            *f_ << ",";
+            buffer_ += ',';
 
             double x0, y0, x1, y1, x2, y2, x3, y3;
             double sina = sin(angle);
@@ -249,14 +288,14 @@ void metawriter_json_stream::add_text(
             x3 = x0 - c->height() * sina;
             y3 = y0 - c->height() * cosa;
 
-            *f_ << "\n     [[";
+            buffer_ += "\n     [[";
             write_point(t, x0, y0);
             write_point(t, x1, y1);
             write_point(t, x2, y2);
             write_point(t, x3, y3, true);
-            *f_ << "]]";
+            buffer_ += "]]";
         }
-        *f_ << "]";
+        buffer_ += ']';
         write_properties(feature, properties);
     }
 }
@@ -282,7 +321,7 @@ void metawriter_json_stream::add_line(path_type & path,
 }
 
 void metawriter_json_stream::write_line_polygon(path_type & path, CoordTransform const& t, bool /*polygon*/){
-    *f_ << " [";
+    buffer_ += " [";
     double x, y, last_x=0.0, last_y=0.0;
     unsigned cmd, last_cmd = SEG_END;
     path.rewind(0);
@@ -292,18 +331,18 @@ void metawriter_json_stream::write_line_polygon(path_type & path, CoordTransform
         if (cmd == SEG_LINETO) {
             if (last_cmd == SEG_MOVETO) {
                 //Start new polygon/line
-                if (polygon_count++) *f_ << "], ";
-                *f_ << "[";
+                if (polygon_count++) buffer_ += "], ";
+                buffer_ += '[';
                 write_point(t, last_x, last_y, true);
             }
-            *f_ << ",";
+            buffer_ += ',';
             write_point(t, x, y, true);
         }
         last_x = x;
         last_y = y;
         last_cmd = cmd;
     }
-    *f_ << "]]";
+    buffer_ += "]]";
 }
 
 
@@ -28,28 +28,8 @@
 // Boost
 #include <boost/foreach.hpp>
 
-using std::map;
 using std::string;
 
-namespace {
-
-using mapnik::value;
-using mapnik::Feature;
-using mapnik::metawriter_properties;
-
-// intersect a set of properties with those in the feature descriptor
-map<string,value> intersect_properties(Feature const& feature, metawriter_properties const& properties) {
-
-    map<string,value> nprops;
-    BOOST_FOREACH(string p, properties)
-    {
-        if (feature.has_key(p))
-            nprops.insert(std::make_pair(p,feature.get(p)));
-    }
-
-    return nprops;
-}} // end anonymous namespace
-
 namespace mapnik {
 
 metawriter_inmem::metawriter_inmem(metawriter_properties dflt_properties)
@@ -63,10 +43,7 @@ void
 metawriter_inmem::add_box(box2d<double> const& box, Feature const& feature,
                           CoordTransform const& /*t*/,
                           metawriter_properties const& properties) {
-    meta_instance inst;
-    inst.box = box;
-    inst.properties = intersect_properties(feature, properties);
-    instances_.push_back(inst);
+    add_instance(box, feature, properties);
 }
 
 void
@@ -79,10 +56,7 @@ metawriter_inmem::add_text(
 {
     if (extents.valid())
     {
-        meta_instance inst;
-        inst.properties = intersect_properties(feature, properties);
-        inst.box = extents;
-        instances_.push_back(inst);
+        add_instance(extents, feature, properties);
     }
 }
 
@@ -117,23 +91,63 @@ metawriter_inmem::add_vertices(path_type & path,
     }
 
     if ((box.width() >= 0.0) && (box.height() >= 0.0)) {
-        meta_instance inst;
-        inst.properties = intersect_properties(feature, properties);
-        inst.box = box;
-        instances_.push_back(inst);
+        add_instance(box, feature, properties);
     }
 }
 
+// intersect a set of properties with those in the feature descriptor
+void
+metawriter_inmem::add_instance(box2d<double> const& box,
+                               Feature const& feature,
+                               metawriter_properties const& properties) {
+    meta_instance inst;
+    inst.box = box;
+    inst.first_property = properties_.size();
+    BOOST_FOREACH(string const& p, properties)
+    {
+        if (feature.has_key(p))
+        {
+            meta_property prop;
+            prop.key = intern_key(p);
+            prop.val = feature.get(p);
+            properties_.push_back(prop);
+        }
+    }
+    inst.last_property = properties_.size();
+    instances_.push_back(inst);
+}
+
+unsigned
+metawriter_inmem::intern_key(string const& name) {
+    // a writer keeps a handful of properties, a scan beats a map
+    for (unsigned i = 0; i < keys_.size(); ++i) {
+        if (keys_[i] == name) return i;
+    }
+    keys_.push_back(name);
+    return keys_.size() - 1;
+}
+
 void
 metawriter_inmem::start(metawriter_property_map const& /*properties*/) {
     instances_.clear();
+    properties_.clear();
 }
 
-const std::list<metawriter_inmem::meta_instance> &
+const metawriter_inmem::meta_instance_list &
 metawriter_inmem::instances() const {
     return instances_;
 }
 
+const metawriter_inmem::meta_property_list &
+metawriter_inmem::properties() const {
+    return properties_;
+}
+
+const std::vector<std::string> &
+metawriter_inmem::key_names() const {
+    return keys_;
+}
+
 metawriter_inmem::meta_instance_list::const_iterator
 metawriter_inmem::inst_begin() const {
     return instances_.begin();
@@ -23,6 +23,9 @@
 #include <mapnik/palette.hpp>
 #include <mapnik/config_error.hpp>
 
+// boost
+#include <boost/cstdint.hpp>
+
 namespace mapnik
 {
 
@@ -45,8 +48,11 @@ bool rgba::mean_sort_cmp::operator() (const rgba& x, const rgba& y) const
 
 std::size_t rgba::hash_func::operator()(rgba const& p) const
 {
-    return ((std::size_t)p.r * 33023 + (std::size_t)p.g * 30013 +
-            (std::size_t)p.b * 27011 + (std::size_t)p.a * 24007) % 21001;
+    // multiplicative mix of the packed color, the old sum modulo 21001
+    // put many colors of a tile into the same few buckets
+    boost::uint32_t val = ((boost::uint32_t)p.r << 24) | ((boost::uint32_t)p.g << 16) |
+        ((boost::uint32_t)p.b << 8) | (boost::uint32_t)p.a;
+    return (std::size_t)(val * 2654435761u);
 }
 
 
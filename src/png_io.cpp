@@ -0,0 +1,251 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/image_util.hpp>
+#include <mapnik/png_io.hpp>
+
+// boost
+#include <boost/cstdint.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/thread.hpp>
+#include <boost/ref.hpp>
+#endif
+
+// stl
+#include <algorithm>
+
+namespace mapnik {
+
+namespace {
+
+// pigz keeps strips at 128k, png tiles are smaller and the
+// dictionary carries over, so smaller strips cost little
+const std::size_t min_strip_size = 32768;
+const std::size_t window_size = 32768;
+
+struct png_strip
+{
+    unsigned char const* data;
+    std::size_t size;
+    std::size_t dict_size;
+    bool last;
+    int compression;
+    int strategy;
+    std::vector<unsigned char> out;
+    uLong adler;
+    bool ok;
+
+    void operator() ()
+    {
+        ok = false;
+        adler = adler32(adler32(0L, Z_NULL, 0), data, size);
+        z_stream stream;
+        stream.zalloc = Z_NULL;
+        stream.zfree = Z_NULL;
+        stream.opaque = Z_NULL;
+        // raw deflate, the zlib header and checksum are written once for all strips
+        if (deflateInit2(&stream, compression, Z_DEFLATED, -15, 8, strategy) != Z_OK) return;
+        if (dict_size > 0)
+        {
+            // prime the window with the end of the previous strip, the
+            // decoder has those bytes in its window when it gets here
+            deflateSetDictionary(&stream, data - dict_size, dict_size);
+        }
+        // a sync flush marker or the end of stream on top of the bound
+        out.resize(deflateBound(&stream, size) + 16);
+        stream.next_in = const_cast<unsigned char*>(data);
+        stream.avail_in = size;
+        stream.next_out = &out[0];
+        stream.avail_out = out.size();
+        // non final strips end byte aligned with an empty stored block
+        // and no final bit, so the next strip just continues the stream
+        int ret = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+        ok = last ? (ret == Z_STREAM_END) : (ret == Z_OK && stream.avail_in == 0);
+        out.resize(out.size() - stream.avail_out);
+        deflateEnd(&stream);
+    }
+};
+
+void write_uint32(std::string & out, boost::uint32_t val)
+{
+    out += static_cast<char>((val >> 24) & 0xff);
+    out += static_cast<char>((val >> 16) & 0xff);
+    out += static_cast<char>((val >> 8) & 0xff);
+    out += static_cast<char>(val & 0xff);
+}
+
+void begin_chunk(std::string & out, char const* type, std::size_t length)
+{
+    write_uint32(out, length);
+    out.append(type, 4);
+}
+
+void end_chunk(std::string & out, std::size_t start)
+{
+    // crc covers the chunk type and data but not the length
+    unsigned char const* bytes = reinterpret_cast<unsigned char const*>(out.data()) + start + 4;
+    write_uint32(out, crc32(crc32(0L, Z_NULL, 0), bytes, out.size() - start - 4));
+}
+
+}
+
+void encode_png_strips(std::string & out,
+                       std::vector<unsigned char> const& raw,
+                       unsigned width,
+                       unsigned height,
+                       unsigned color_depth,
+                       int color_type,
+                       std::vector<mapnik::rgb> const& palette,
+                       std::vector<unsigned> const& alpha,
+                       int compression,
+                       int strategy,
+                       unsigned threads)
+{
+    if (raw.empty()) throw ImageWriterException("png: no image data to encode");
+
+#ifdef MAPNIK_THREADSAFE
+    if (threads == 0) threads = std::max(1u, boost::thread::hardware_concurrency());
+#else
+    threads = 1;
+#endif
+    // strips hold whole rows
+    std::size_t row_size = raw.size() / height;
+    std::size_t num_strips = std::min<std::size_t>(threads, std::max<std::size_t>(1, raw.size() / min_strip_size));
+    num_strips = std::min<std::size_t>(num_strips, height);
+    std::size_t rows_per_strip = (height + num_strips - 1) / num_strips;
+    num_strips = (height + rows_per_strip - 1) / rows_per_strip;
+
+    std::vector<png_strip> strips(num_strips);
+    for (std::size_t i = 0; i < num_strips; ++i)
+    {
+        png_strip & strip = strips[i];
+        std::size_t begin = i * rows_per_strip * row_size;
+        std::size_t end = std::min(raw.size(), (i + 1) * rows_per_strip * row_size);
+        strip.data = &raw[0] + begin;
+        strip.size = end - begin;
+        strip.dict_size = std::min(begin, window_size);
+        strip.last = (i + 1 == num_strips);
+        strip.compression = compression;
+        strip.strategy = strategy;
+        strip.ok = false;
+    }
+
+#ifdef MAPNIK_THREADSAFE
+    if (num_strips > 1)
+    {
+        boost::thread_group workers;
+        for (std::size_t i = 1; i < num_strips; ++i)
+        {
+            workers.create_thread(boost::ref(strips[i]));
+        }
+        strips[0]();
+        workers.join_all();
+    }
+    else
+#endif
+    {
+        for (std::size_t i = 0; i < num_strips; ++i)
+        {
+            strips[i]();
+        }
+    }
+
+    std::size_t idat_size = 2 + 4;
+    for (std::size_t i = 0; i < num_strips; ++i)
+    {
+        if (!strips[i].ok) throw ImageWriterException("png: failed to compress image data");
+        idat_size += strips[i].out.size();
+    }
+
+    out.reserve(out.size() + 8 + 25 + 12 + palette.size() * 3 + 12 + alpha.size() + 12 + idat_size + 12);
+    static const char signature[8] = { '\211', 'P', 'N', 'G', '\r', '\n', '\032', '\n' };
+    out.append(signature, 8);
+
+    std::size_t start = out.size();
+    begin_chunk(out, "IHDR", 13);
+    write_uint32(out, width);
+    write_uint32(out, height);
+    out += static_cast<char>(color_depth);
+    out += static_cast<char>(color_type);
+    out += '\0'; // deflate
+    out += '\0'; // adaptive filtering, every row uses none
+    out += '\0'; // not interlaced
+    end_chunk(out, start);
+
+    if (color_type == PNG_COLOR_TYPE_PALETTE)
+    {
+        start = out.size();
+        begin_chunk(out, "PLTE", palette.size() * 3);
+        for (unsigned i = 0; i < palette.size(); ++i)
+        {
+            out += static_cast<char>(palette[i].r);
+            out += static_cast<char>(palette[i].g);
+            out += static_cast<char>(palette[i].b);
+        }
+        end_chunk(out, start);
+
+        // same truncation to non opaque entries as the libpng writer
+        unsigned alpha_size = 0;
+        for (unsigned i = 0; i < alpha.size(); ++i)
+        {
+            if (alpha[i] < 255) alpha_size = i + 1;
+        }
+        if (alpha_size > 0)
+        {
+            start = out.size();
+            begin_chunk(out, "tRNS", alpha_size);
+            for (unsigned i = 0; i < alpha_size; ++i)
+            {
+                out += static_cast<char>(alpha[i]);
+            }
+            end_chunk(out, start);
+        }
+    }
+
+    start = out.size();
+    begin_chunk(out, "IDAT", idat_size);
+    // zlib header for a 32k window, FLEVEL picked like deflate does
+    int level = (compression == Z_DEFAULT_COMPRESSION) ? 6 : compression;
+    unsigned flevel = 2;
+    if (strategy >= Z_HUFFMAN_ONLY || level < 2) flevel = 0;
+    else if (level < 6) flevel = 1;
+    else if (level > 6) flevel = 3;
+    unsigned header = (0x78 << 8) | (flevel << 6);
+    header += 31 - (header % 31);
+    out += static_cast<char>(header >> 8);
+    out += static_cast<char>(header & 0xff);
+    uLong adler = strips[0].adler;
+    for (std::size_t i = 0; i < num_strips; ++i)
+    {
+        out.append(reinterpret_cast<char const*>(&strips[i].out[0]), strips[i].out.size());
+        if (i > 0) adler = adler32_combine(adler, strips[i].adler, strips[i].size);
+    }
+    write_uint32(out, adler);
+    end_chunk(out, start);
+
+    start = out.size();
+    begin_chunk(out, "IEND", 0);
+    end_chunk(out, start);
+}
+
+}
@@ -31,18 +31,147 @@
 // proj4
 #include <proj_api.h>
 
+// boost
+#include <boost/tokenizer.hpp>
+#include <boost/algorithm/string.hpp>
+
 // stl
 #include <vector>
+#include <cstdlib>
 
-static const float MAXEXTENT = 20037508.34;
-static const float M_PI_by2 = M_PI / 2;
-static const float D2R = M_PI / 180;
-static const float R2D = 180 / M_PI;
-static const float M_PIby360 = M_PI / 360;
-static const float MAXEXTENTby180 = MAXEXTENT/180;
+// doubles, in float the spherical mercator shortcuts were off by meters
+static const double MAXEXTENT = M_PI * 6378137;
+static const double M_PI_by2 = M_PI / 2;
+static const double D2R = M_PI / 180;
+static const double R2D = 180 / M_PI;
+static const double M_PIby360 = M_PI / 360;
+static const double MAXEXTENTby180 = MAXEXTENT/180;
 
 namespace mapnik {
 
+static void merc_to_lonlat(double * x, double * y, int point_count)
+{
+    int i;
+    for(i=0; i<point_count; i++) {
+        x[i] = (x[i] / MAXEXTENT) * 180;
+        y[i] = (y[i] / MAXEXTENT) * 180;
+        y[i] = R2D * (2 * atan(exp(y[i] * D2R)) - M_PI_by2);
+        if (x[i] > 180) x[i] = 180;
+        if (x[i] < -180) x[i] = -180;
+        if (y[i] > 85.0511) y[i] = 85.0511;
+        if (y[i] < -85.0511) y[i] = -85.0511;
+    }
+}
+
+static void lonlat_to_merc(double * x, double * y, int point_count)
+{
+    int i;
+    for(i=0; i<point_count; i++) {
+        x[i] = x[i] * MAXEXTENTby180;
+        y[i] = log(tan((90 + y[i]) * M_PIby360)) / D2R;
+        y[i] = y[i] * MAXEXTENTby180;
+        if (x[i] > MAXEXTENT) x[i] = MAXEXTENT;
+        if (x[i] < -MAXEXTENT) x[i] = -MAXEXTENT;
+        if (y[i] > MAXEXTENT) y[i] = MAXEXTENT;
+        if (y[i] < -MAXEXTENT) y[i] = -MAXEXTENT;
+    }
+}
+
+namespace {
+
+// definitions handled by the spherical mercator formulas below
+enum well_known_srs_e
+{
+    SRS_UNKNOWN = 0,
+    SRS_WGS84,
+    SRS_MERC
+};
+
+bool is_number(std::string const& str, double val)
+{
+    char * end = 0;
+    double parsed = std::strtod(str.c_str(), &end);
+    return end != str.c_str() && *end == '\0' && parsed == val;
+}
+
+// Recognizes the common spellings of wgs84 longlat and spherical mercator
+// (epsg:3857 and its aliases) so they are not sent through proj4. Anything
+// with a parameter not listed here, like +over or a +towgs84 shift, is left
+// to proj4.
+well_known_srs_e well_known_srs(std::string const& params)
+{
+    typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
+    boost::char_separator<char> sep(" \t\n");
+    tokenizer tokens(params, sep);
+    std::string init, proj, ellps, datum, a, b, r;
+    for (tokenizer::iterator itr = tokens.begin(); itr != tokens.end(); ++itr)
+    {
+        std::string token = boost::algorithm::to_lower_copy(*itr);
+        if (token.empty() || token[0] != '+') return SRS_UNKNOWN;
+        std::string::size_type pos = token.find('=');
+        std::string key = token.substr(1, pos == std::string::npos ? std::string::npos : pos - 1);
+        std::string val = (pos == std::string::npos) ? std::string() : token.substr(pos + 1);
+        if (key == "no_defs" || key == "wktext") continue;
+        else if (key == "init") init = val;
+        else if (key == "proj") proj = val;
+        else if (key == "ellps") ellps = val;
+        else if (key == "datum") datum = val;
+        else if (key == "a") a = val;
+        else if (key == "b") b = val;
+        else if (key == "r") r = val;
+        else if (key == "towgs84")
+        {
+            if (val != "0,0,0" && val != "0,0,0,0,0,0,0") return SRS_UNKNOWN;
+        }
+        else if (key == "nadgrids")
+        {
+            if (val != "@null") return SRS_UNKNOWN;
+        }
+        else if (key == "units")
+        {
+            if (val != "m") return SRS_UNKNOWN;
+        }
+        else if (key == "lat_ts" || key == "lon_0" || key == "x_0" || key == "y_0")
+        {
+            if (!is_number(val, 0.0)) return SRS_UNKNOWN;
+        }
+        else if (key == "k" || key == "k_0")
+        {
+            if (!is_number(val, 1.0)) return SRS_UNKNOWN;
+        }
+        else return SRS_UNKNOWN;
+    }
+
+    if (!init.empty())
+    {
+        if (!proj.empty()) return SRS_UNKNOWN;
+        if (init == "epsg:4326") return SRS_WGS84;
+        if (init == "epsg:3857" || init == "epsg:900913" || init == "epsg:3785") return SRS_MERC;
+        return SRS_UNKNOWN;
+    }
+    if (proj == "longlat" || proj == "latlong")
+    {
+        if (!a.empty() || !b.empty() || !r.empty()) return SRS_UNKNOWN;
+        if ((datum == "wgs84" && (ellps.empty() || ellps == "wgs84")) ||
+            (datum.empty() && ellps == "wgs84"))
+        {
+            return SRS_WGS84;
+        }
+    }
+    else if (proj == "merc")
+    {
+        if (!ellps.empty() || !datum.empty()) return SRS_UNKNOWN;
+        if ((is_number(a, 6378137) && is_number(b, 6378137) && r.empty()) ||
+            (a.empty() && b.empty() && is_number(r, 6378137)))
+        {
+            return SRS_MERC;
+        }
+    }
+    return SRS_UNKNOWN;
+}
+
+}
+
 proj_transform::proj_transform(projection const& source,
                                projection const& dest)
     : source_(source),
@@ -51,13 +180,25 @@ proj_transform::proj_transform(projection const& source,
     is_source_longlat_ = source_.is_geographic();
     is_dest_longlat_ = dest_.is_geographic();
     is_source_equal_dest_ = (source_ == dest_);
-    if (source.params() == "+init=epsg:3857" && dest.params() == "+init=epsg:4326")
-    {
-        wgs84_to_merc_ = true;
-    }
-    else
+    merc_to_wgs84_ = false;
+    wgs84_to_merc_ = false;
+    if (!is_source_equal_dest_)
     {
-        wgs84_to_merc_ = false;
+        well_known_srs_e source_srs = well_known_srs(source_.params());
+        well_known_srs_e dest_srs = well_known_srs(dest_.params());
+        if (source_srs != SRS_UNKNOWN && source_srs == dest_srs)
+        {
+            // different spellings of the same definition
+            is_source_equal_dest_ = true;
+        }
+        else if (source_srs == SRS_MERC && dest_srs == SRS_WGS84)
+        {
+            merc_to_wgs84_ = true;
+        }
+        else if (source_srs == SRS_WGS84 && dest_srs == SRS_MERC)
+        {
+            wgs84_to_merc_ = true;
+        }
     }
 }
 
@@ -78,17 +219,13 @@ bool proj_transform::forward (double * x, double * y , double * z, int point_cou
     if (is_source_equal_dest_)
         return true;
 
+    if (merc_to_wgs84_) {
+        merc_to_lonlat(x, y, point_count);
+        return true;
+    }
+
     if (wgs84_to_merc_) {
-        int i;
-        for(i=0; i<point_count; i++) {
-            x[i] = (x[i] / MAXEXTENT) * 180;
-            y[i] = (y[i] / MAXEXTENT) * 180;
-            y[i] = R2D * (2 * atan(exp(y[i] * D2R)) - M_PI_by2);
-            if (x[i] > 180) x[i] = 180;
-            if (x[i] < -180) x[i] = -180;
-            if (y[i] > 85.0511) y[i] = 85.0511;
-            if (y[i] < -85.0511) y[i] = -85.0511;
-        }
+        lonlat_to_merc(x, y, point_count);
         return true;
     }
 
@@ -129,17 +266,13 @@ bool proj_transform::backward (double * x, double * y , double * z, int point_co
     if (is_source_equal_dest_)
         return true;
 
+    if (merc_to_wgs84_) {
+        lonlat_to_merc(x, y, point_count);
+        return true;
+    }
+
     if (wgs84_to_merc_) {
-        int i;
-        for(i=0; i<point_count; i++) {
-            x[i] = x[i] * MAXEXTENTby180;
-            y[i] = log(tan((90 + y[i]) * M_PIby360)) / D2R;
-            y[i] = y[i] * MAXEXTENTby180;
-            if (x[i] > MAXEXTENT) x[i] = MAXEXTENT;
-            if (x[i] < -MAXEXTENT) x[i] = -MAXEXTENT;
-            if (y[i] > MAXEXTENT) y[i] = MAXEXTENT;
-            if (y[i] < -MAXEXTENT) y[i] = -MAXEXTENT;
-        }
+        merc_to_lonlat(x, y, point_count);
         return true;
     }
 
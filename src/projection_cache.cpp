@@ -0,0 +1,107 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+// mapnik
+#include <mapnik/projection_cache.hpp>
+#ifdef MAPNIK_THREADSAFE
+#include <mapnik/thread_local_cache.hpp>
+#endif
+
+// boost
+#include <boost/unordered_map.hpp>
+#include <boost/make_shared.hpp>
+
+// stl
+#include <utility>
+
+namespace mapnik
+{
+
+typedef std::pair<std::string, std::string> transform_key;
+
+#ifdef MAPNIK_THREADSAFE
+static thread_local_cache<std::string, projection_ptr> projections_;
+static thread_local_cache<transform_key, proj_transform_ptr> transforms_;
+#else
+static boost::unordered_map<std::string, projection_ptr> projections_;
+static boost::unordered_map<transform_key, proj_transform_ptr> transforms_;
+#endif
+
+void projection_cache::clear()
+{
+#ifdef MAPNIK_THREADSAFE
+    mutex::scoped_lock lock(mutex_);
+    projections_.invalidate();
+    transforms_.invalidate();
+#else
+    projections_.clear();
+    transforms_.clear();
+#endif
+}
+
+projection_ptr projection_cache::get(std::string const& params)
+{
+    projection_ptr proj;
+#ifdef MAPNIK_THREADSAFE
+    if (projections_.find(params, proj))
+    {
+        return proj;
+    }
+    proj = boost::make_shared<projection>(params);
+    projections_.insert(params, proj);
+#else
+    boost::unordered_map<std::string, projection_ptr>::const_iterator itr = projections_.find(params);
+    if (itr != projections_.end())
+    {
+        return itr->second;
+    }
+    proj = boost::make_shared<projection>(params);
+    projections_.insert(std::make_pair(params, proj));
+#endif
+    return proj;
+}
+
+proj_transform_ptr projection_cache::get(std::string const& source, std::string const& dest)
+{
+    transform_key key(source, dest);
+    proj_transform_ptr trans;
+#ifdef MAPNIK_THREADSAFE
+    if (transforms_.find(key, trans))
+    {
+        return trans;
+    }
+    trans = boost::make_shared<proj_transform>(*get(source), *get(dest));
+    transforms_.insert(key, trans);
+#else
+    boost::unordered_map<transform_key, proj_transform_ptr>::const_iterator itr = transforms_.find(key);
+    if (itr != transforms_.end())
+    {
+        return itr->second;
+    }
+    trans = boost::make_shared<proj_transform>(*get(source), *get(dest));
+    transforms_.insert(std::make_pair(key, trans));
+#endif
+    return trans;
+}
+
+}
@@ -23,7 +23,12 @@
 //$Id:  $
 
 #include <mapnik/raster_colorizer.hpp>
+
+// stl
 #include <limits>
+#include <algorithm>
+#include <functional>
+#include <cmath>
 
 namespace mapnik
 {
@@ -116,29 +121,23 @@ bool raster_colorizer::add_stop(colorizer_stop const& stop)
 
 void raster_colorizer::colorize(raster_ptr const& raster, Feature const& f) const
 {
-    unsigned *imageData = raster->data_.getData();
-
-    int len = raster->data_.width() * raster->data_.height();
+    colorize(raster->data_, raster->data_, nodata(f));
+}
 
-    bool hasNoData = false;
-    float noDataValue = 0;
+void raster_colorizer::colorize(image_data_32 const& source, image_data_32 & target,
+                                boost::optional<float> const& nodata) const
+{
+    colorizer_lut(*this, nodata).colorize(source, target);
+}
 
-    //std::map<std::string,value>::const_iterator fi = Props.find("NODATA");
+boost::optional<float> raster_colorizer::nodata(Feature const& f)
+{
+    boost::optional<float> result;
     if (f.has_key("NODATA"))
     {
-        hasNoData = true;
-        noDataValue = static_cast<float>(f.get("NODATA").to_double());
-    }
-
-    for (int i=0; i<len; ++i)
-    {
-        // the GDAL plugin reads single bands as floats
-        float value = *reinterpret_cast<float *> (&imageData[i]);
-        if (hasNoData && noDataValue == value)
-            imageData[i] = color(0,0,0,0).rgba();
-        else
-            imageData[i] = get_color(value).rgba();
+        result.reset(static_cast<float>(f.get("NODATA").to_double()));
     }
+    return result;
 }
 
 inline unsigned interpolate(unsigned start, unsigned end, float fraction)
@@ -280,5 +279,98 @@ color raster_colorizer::get_color(float value) const
 }
 
 
+
+
+colorizer_lut::colorizer_lut(raster_colorizer const& colorizer, boost::optional<float> const& nodata)
+    : colorizer_(colorizer),
+      sorted_(true),
+      default_rgba_(colorizer.get_default_color().rgba()),
+      epsilon_(colorizer.get_epsilon()),
+      has_nodata_(nodata),
+      nodata_(nodata ? *nodata : 0.0f)
+{
+    colorizer_stops const& stops = colorizer.get_stops();
+    int stopCount = stops.size();
+    values_.reserve(stopCount);
+    entries_.reserve(stopCount);
+    for (int i = 0; i < stopCount; ++i)
+    {
+        int next = (i + 1 < stopCount) ? i + 1 : i;
+        colorizer_mode_enum mode = stops[i].get_mode();
+        if (mode == COLORIZER_INHERIT)
+        {
+            mode = colorizer.get_default_mode();
+        }
+        entry e;
+        e.mode = mode;
+        e.stop_color = stops[i].get_color();
+        e.stop_rgba = e.stop_color.rgba();
+        e.next_color = stops[next].get_color();
+        e.value = stops[i].get_value();
+        e.next_value = stops[next].get_value();
+        values_.push_back(e.value);
+        entries_.push_back(e);
+    }
+    // set_stops() does not enforce the order add_stop() does
+    sorted_ = std::adjacent_find(values_.begin(), values_.end(), std::greater<float>()) == values_.end();
 }
 
+unsigned colorizer_lut::operator()(float value) const
+{
+    if (has_nodata_ && nodata_ == value)
+    {
+        return color(0,0,0,0).rgba();
+    }
+    if (!sorted_)
+    {
+        return colorizer_.get_color(value).rgba();
+    }
+
+    // the stop the value is in is the last one not above it (add_stop keeps
+    // stops in ascending order); values before the first stop, or any value
+    // without stops, get the default color
+    std::vector<float>::const_iterator itr = std::upper_bound(values_.begin(), values_.end(), value);
+    if (itr == values_.begin())
+    {
+        return default_rgba_;
+    }
+    entry const& e = entries_[(itr - values_.begin()) - 1];
+
+    switch (e.mode)
+    {
+    case COLORIZER_LINEAR:
+    {
+        if (e.next_value == e.value)
+        {
+            return e.stop_rgba;
+        }
+        float fraction = (value - e.value) / (e.next_value - e.value);
+        return color(interpolate(e.stop_color.red(), e.next_color.red(), fraction),
+                     interpolate(e.stop_color.green(), e.next_color.green(), fraction),
+                     interpolate(e.stop_color.blue(), e.next_color.blue(), fraction),
+                     interpolate(e.stop_color.alpha(), e.next_color.alpha(), fraction)).rgba();
+    }
+    case COLORIZER_DISCRETE:
+        return e.stop_rgba;
+    case COLORIZER_EXACT:
+    default:
+        //approximately equal (within epsilon)
+        return (fabs(value - e.value) < epsilon_) ? e.stop_rgba : default_rgba_;
+    }
+}
+
+void colorizer_lut::colorize(image_data_32 const& source, image_data_32 & target) const
+{
+    unsigned const* sourceData = source.getData();
+    unsigned *targetData = target.getData();
+
+    int len = source.width() * source.height();
+
+    for (int i=0; i<len; ++i)
+    {
+        // the GDAL plugin reads single bands as floats
+        targetData[i] = (*this)(*reinterpret_cast<float const*> (&sourceData[i]));
+    }
+}
+
+}
@@ -0,0 +1,75 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2011 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+// mapnik
+#include <mapnik/render_stats.hpp>
+
+// boost
+#include <boost/foreach.hpp>
+
+// stl
+#include <iostream>
+#include <iomanip>
+
+namespace mapnik
+{
+
+std::ostream & operator<<(std::ostream & out, render_stats const& stats)
+{
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2);
+    BOOST_FOREACH(layer_stats const& layer, stats.layers)
+    {
+        out << "layer '" << layer.name << "': " << layer.time << "ms, query "
+            << layer.query_time << "ms, " << layer.features << " features"
+            << (layer.cached ? ", cached\n" : "\n");
+        BOOST_FOREACH(style_stats const& style, layer.styles)
+        {
+            out << "  style '" << style.name << "': " << style.time << "ms, "
+                << style.features_rendered << " of " << style.features << " features rendered, read "
+                << style.query_time << "ms, filters " << style.filter_time << "ms";
+            if (style.labels_attempted > 0)
+            {
+                out << ", " << style.labels_placed << " labels placed for "
+                    << style.labels_attempted << " features";
+            }
+            out << "\n";
+            BOOST_FOREACH(symbolizer_stats const& sym, style.symbolizers)
+            {
+                out << "    " << sym.name << ": " << sym.time << "ms, " << sym.count << " features\n";
+            }
+        }
+    }
+    out << "total: " << stats.time << "ms";
+    if (stats.bytes_encoded > 0)
+    {
+        out << ", " << stats.bytes_encoded << " bytes encoded";
+    }
+    out << "\n";
+    out.flags(flags);
+    out.precision(precision);
+    return out;
+}
+
+}
@@ -530,6 +530,11 @@ void serialize_style( ptree & map_node, Map::const_style_iterator style_it, bool
         set_attr(style_node, "filter-mode", filter_mode);
     }
 
+    if (style.batch_polygons() != dfl.batch_polygons() || explicit_defaults)
+    {
+        set_attr(style_node, "batch-polygons", style.batch_polygons());
+    }
+
     rules::const_iterator it = style.get_rules().begin();
     rules::const_iterator end = style.get_rules().end();
     for (; it != end; ++it)
@@ -673,6 +678,16 @@ void serialize_layer( ptree & map_node, const layer & layer, bool explicit_defau
         set_attr/*<bool>*/( layer_node, "cache-features", layer.cache_features() );
     }
 
+    if ( layer.cache_rendering() || explicit_defaults )
+    {
+        set_attr/*<bool>*/( layer_node, "cache-rendering", layer.cache_rendering() );
+    }
+
+    if ( layer.min_feature_size() > 0.0 || explicit_defaults )
+    {
+        set_attr( layer_node, "min-feature-size", layer.min_feature_size() );
+    }
+
     if ( layer.group_by() != "" || explicit_defaults )
     {
         set_attr( layer_node, "group-by", layer.group_by() );
@@ -25,6 +25,9 @@
 #include <mapnik/symbolizer.hpp>
 #include <mapnik/map.hpp>
 
+// stl
+#include <set>
+
 namespace mapnik {
 
 void symbolizer_base::add_metawriter(std::string const& name, metawriter_properties const& properties)
@@ -70,8 +73,24 @@ metawriter_with_properties symbolizer_base::get_metawriter() const
     return metawriter_with_properties(writer_ptr_, properties_complete_);
 }
 
+static boost::optional<marker_key> constant_filename_key(path_expression_ptr const& filename)
+{
+    boost::optional<marker_key> key;
+    if (filename)
+    {
+        std::set<std::string> names;
+        path_processor_type::collect_attributes(*filename, names);
+        if (names.empty())
+        {
+            key.reset(marker_key(path_processor_type::to_string(*filename)));
+        }
+    }
+    return key;
+}
+
 symbolizer_with_image::symbolizer_with_image(path_expression_ptr file)
     : image_filename_( file ),
+      filename_key_(constant_filename_key(file)),
       image_opacity_(1.0f)
 
 {
@@ -85,6 +104,7 @@ symbolizer_with_image::symbolizer_with_image(path_expression_ptr file)
 
 symbolizer_with_image::symbolizer_with_image( symbolizer_with_image const& rhs)
     : image_filename_(rhs.image_filename_),
+      filename_key_(rhs.filename_key_),
       image_opacity_(rhs.image_opacity_),
       matrix_(rhs.matrix_) {}
 
@@ -96,6 +116,17 @@ path_expression_ptr symbolizer_with_image::get_filename() const
 void symbolizer_with_image::set_filename(path_expression_ptr image_filename)
 {
     image_filename_ = image_filename;
+    filename_key_ = constant_filename_key(image_filename);
+}
+
+marker_key const& symbolizer_with_image::get_filename_key(Feature const& feature, marker_key & key) const
+{
+    if (filename_key_)
+    {
+        return *filename_key_;
+    }
+    key = marker_key(path_processor_type::evaluate(*image_filename_, feature));
+    return key;
 }
 
 void symbolizer_with_image::set_transform(transform_type const& matrix)
@@ -351,13 +351,15 @@ bool shield_symbolizer_helper<FaceManagerT, DetectorT>::next_line_placement()
 template <typename FaceManagerT, typename DetectorT>
 void shield_symbolizer_helper<FaceManagerT, DetectorT>::init_marker()
 {
-    std::string filename = path_processor_type::evaluate(*sym_.get_filename(), this->feature_);
+    marker_key key_buffer;
+    marker_key const& filename_key = sym_.get_filename_key(this->feature_, key_buffer);
+    std::string const& filename = filename_key.uri;
     boost::array<double,6> const& m = sym_.get_transform();
     transform_.load_from(&m[0]);
     marker_.reset();
     if (!filename.empty())
     {
-        marker_ = marker_cache::instance()->find(filename, true);
+        marker_ = marker_cache::instance()->find(filename_key, true);
     }
     if (!marker_) {
         marker_w_ = 0;
@@ -23,7 +23,10 @@
 //$Id: tiff_reader.cpp 17 2005-03-08 23:58:43Z pavlenko $
 // mapnik
 #include <mapnik/image_reader.hpp>
+#include <mapnik/image_tile_cache.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/cstdint.hpp>
 
 extern "C"
 {
@@ -31,6 +34,8 @@ extern "C"
 }
 // stl
 #include <iostream>
+#include <vector>
+#include <ctime>
 
 namespace mapnik
 {
@@ -41,7 +46,21 @@ using std::max;
 class tiff_reader : public image_reader
 {
 private:
+    struct tiff_level
+    {
+        tdir_t directory;
+        int read_method;
+        unsigned width;
+        unsigned height;
+        int rows_per_strip;
+        int tile_width;
+        int tile_height;
+    };
     std::string file_name_;
+    std::time_t file_mtime_;
+    boost::uintmax_t file_size_;
+    std::vector<tiff_level> levels_;
+    tdir_t directory_;
     int read_method_;
     unsigned width_;
     unsigned height_;
@@ -59,10 +78,13 @@ public:
     unsigned width() const;
     unsigned height() const;
     void read(unsigned x,unsigned y,image_data_32& image);
+    unsigned overview_count() const;
+    void select_overview(unsigned level);
 private:
     tiff_reader(const tiff_reader&);
     tiff_reader& operator=(const tiff_reader&);
     void init();
+    void read_level(TIFF* tif, tiff_level & level);
     void read_generic(unsigned x,unsigned y,image_data_32& image);
     void read_stripped(unsigned x,unsigned y,image_data_32& image);
     void read_tiled(unsigned x,unsigned y,image_data_32& image);
@@ -81,6 +103,10 @@ const bool registered = register_image_reader("tiff",create_tiff_reader);
 
 tiff_reader::tiff_reader(const std::string& file_name)
     : file_name_(file_name),
+      file_mtime_(0),
+      file_size_(0),
+      levels_(),
+      directory_(0),
       read_method_(generic),
       width_(0),
       height_(0),
@@ -99,23 +125,44 @@ void tiff_reader::init()
     TIFF* tif = load_if_exists(file_name_);
     if (!tif) throw image_reader_exception ("Can't load tiff file");
 
+    // cached tiles belong to this version of the file only
+    try
+    {
+        boost::filesystem::path path(file_name_);
+        file_mtime_ = boost::filesystem::last_write_time(path);
+        file_size_ = boost::filesystem::file_size(path);
+    }
+    catch (boost::filesystem::filesystem_error const&)
+    {
+        TIFFClose(tif);
+        throw image_reader_exception("Can't stat tiff file");
+    }
+
     char msg[1024];
 
     if (TIFFRGBAImageOK(tif,msg))
     {
-        TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width_);
-        TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height_);
-        if (TIFFIsTiled(tif))
-        {
-            TIFFGetField(tif, TIFFTAG_TILEWIDTH, &tile_width_);
-            TIFFGetField(tif, TIFFTAG_TILELENGTH, &tile_height_);
-            read_method_=tiled;
-        }
-        else if (TIFFGetField(tif,TIFFTAG_ROWSPERSTRIP,&rows_per_strip_)!=0)
+        tiff_level level;
+        level.directory = 0;
+        read_level(tif, level);
+        levels_.push_back(level);
+
+        // reduced resolution images (overviews) follow the main image
+        // in their own directories
+        while (TIFFReadDirectory(tif))
         {
-            read_method_=stripped;
+            uint32 subfile_type = 0;
+            if (TIFFGetField(tif, TIFFTAG_SUBFILETYPE, &subfile_type) &&
+                (subfile_type & FILETYPE_REDUCEDIMAGE) &&
+                TIFFRGBAImageOK(tif, msg))
+            {
+                level.directory = TIFFCurrentDirectory(tif);
+                read_level(tif, level);
+                levels_.push_back(level);
+            }
         }
         TIFFClose(tif);
+        select_overview(0);
     }
     else
     {
@@ -124,6 +171,28 @@ void tiff_reader::init()
     }
 }
 
+void tiff_reader::read_level(TIFF* tif, tiff_level & level)
+{
+    level.read_method = generic;
+    level.width = 0;
+    level.height = 0;
+    level.rows_per_strip = 0;
+    level.tile_width = 0;
+    level.tile_height = 0;
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &level.width);
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &level.height);
+    if (TIFFIsTiled(tif))
+    {
+        TIFFGetField(tif, TIFFTAG_TILEWIDTH, &level.tile_width);
+        TIFFGetField(tif, TIFFTAG_TILELENGTH, &level.tile_height);
+        level.read_method = tiled;
+    }
+    else if (TIFFGetField(tif,TIFFTAG_ROWSPERSTRIP,&level.rows_per_strip)!=0)
+    {
+        level.read_method = stripped;
+    }
+}
+
 
 tiff_reader::~tiff_reader()
 {
@@ -143,6 +212,29 @@ unsigned tiff_reader::height() const
 }
 
 
+unsigned tiff_reader::overview_count() const
+{
+    return levels_.empty() ? 0 : levels_.size() - 1;
+}
+
+
+void tiff_reader::select_overview(unsigned level)
+{
+    if (level >= levels_.size())
+    {
+        throw image_reader_exception("TIFF reader: overview level out of range");
+    }
+    tiff_level const& l = levels_[level];
+    directory_ = l.directory;
+    read_method_ = l.read_method;
+    width_ = l.width;
+    height_ = l.height;
+    rows_per_strip_ = l.rows_per_strip;
+    tile_width_ = l.tile_width;
+    tile_height_ = l.tile_height;
+}
+
+
 void tiff_reader::read(unsigned x,unsigned y,image_data_32& image)
 {
     if (read_method_==stripped)
@@ -173,52 +265,79 @@ void tiff_reader::read_generic(unsigned /*x*/,unsigned /*y*/,image_data_32& /*im
 
 void tiff_reader::read_tiled(unsigned x0,unsigned y0,image_data_32& image)
 {
-    TIFF* tif = load_if_exists(file_name_);
-    if (tif)
-    {
-        uint32* buf = (uint32*)_TIFFmalloc(tile_width_*tile_height_*sizeof(uint32));
-        int width=image.width();
-        int height=image.height();
+    // decoded tiles are shared through the image_tile_cache, the file
+    // is only opened if some of the tiles aren't cached yet
+    TIFF* tif = 0;
+    image_tile_cache & cache = *image_tile_cache::instance();
 
-        int start_y=(y0/tile_height_)*tile_height_;
-        int end_y=((y0+height)/tile_height_+1)*tile_height_;
+    int width=image.width();
+    int height=image.height();
 
-        int start_x=(x0/tile_width_)*tile_width_;
-        int end_x=((x0+width)/tile_width_+1)*tile_width_;
-        int row,tx0,tx1,ty0,ty1;
-
-        for (int y=start_y;y<end_y;y+=tile_height_)
-        {
-            ty0 = max(y0,(unsigned)y) - y;
-            ty1 = min(height+y0,(unsigned)(y+tile_height_)) - y;
+    int start_y=(y0/tile_height_)*tile_height_;
+    int end_y=((y0+height)/tile_height_+1)*tile_height_;
 
-            int n0=tile_height_-ty1;
-            int n1=tile_height_-ty0-1;
+    int start_x=(x0/tile_width_)*tile_width_;
+    int end_x=((x0+width)/tile_width_+1)*tile_width_;
+    int row,tx0,tx1,ty0,ty1;
 
-            for (int x=start_x;x<end_x;x+=tile_width_)
-            {
+    for (int y=start_y;y<end_y;y+=tile_height_)
+    {
+        ty0 = max(y0,(unsigned)y) - y;
+        ty1 = min(height+y0,(unsigned)(y+tile_height_)) - y;
 
-                if (!TIFFReadRGBATile(tif,x,y,buf)) break;
+        int n0=tile_height_-ty1;
+        int n1=tile_height_-ty0-1;
 
-                tx0=max(x0,(unsigned)x);
-                tx1=min(width+x0,(unsigned)(x+tile_width_));
-                row=y+ty0-y0;
-                for (int n=n1;n>=n0;--n)
+        for (int x=start_x;x<end_x;x+=tile_width_)
+        {
+            image_tile_key key(file_name_, file_mtime_, file_size_, directory_,
+                               tile_width_, tile_height_, x, y);
+            boost::optional<image_tile_ptr> tile = cache.find(key);
+            if (tile && ((*tile)->width() != unsigned(tile_width_) ||
+                         (*tile)->height() != unsigned(tile_height_)))
+            {
+                tile.reset();
+            }
+            if (!tile)
+            {
+                if (!tif)
                 {
-                    image.setRow(row,tx0-x0,tx1-x0,(const unsigned*)&buf[n*tile_width_+tx0-x]);
-                    ++row;
+                    tif = load_if_exists(file_name_);
+                    if (!tif) return;
+                    if (directory_ > 0 && !TIFFSetDirectory(tif, directory_))
+                    {
+                        TIFFClose(tif);
+                        return;
+                    }
                 }
+                image_tile_ptr buf(boost::make_shared<image_data_32>(tile_width_, tile_height_));
+                if (!TIFFReadRGBATile(tif,x,y,buf->getData())) break;
+                cache.insert(key, buf);
+                tile.reset(buf);
+            }
+
+            tx0=max(x0,(unsigned)x);
+            tx1=min(width+x0,(unsigned)(x+tile_width_));
+            row=y+ty0-y0;
+            for (int n=n1;n>=n0;--n)
+            {
+                image.setRow(row,tx0-x0,tx1-x0,(*tile)->getRow(n) + tx0 - x);
+                ++row;
             }
         }
-        _TIFFfree(buf);
-        TIFFClose(tif);
     }
+    if (tif) TIFFClose(tif);
 }
 
 
 void tiff_reader::read_stripped(unsigned x0,unsigned y0,image_data_32& image)
 {
     TIFF* tif = load_if_exists(file_name_);
+    if (tif && directory_ > 0 && !TIFFSetDirectory(tif, directory_))
+    {
+        TIFFClose(tif);
+        tif = 0;
+    }
     if (tif)
     {
         uint32* buf = (uint32*)_TIFFmalloc(width_*rows_per_strip_*sizeof(uint32));
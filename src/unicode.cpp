@@ -23,9 +23,20 @@
 //$Id$
 
 #include <cstdlib>
+#include <cstring>
 #include <mapnik/unicode.hpp>
 
+// icu
+#include <unicode/stringpiece.h>
+
+// boost
+#ifdef MAPNIK_THREADSAFE
+#include <boost/thread/mutex.hpp>
+#endif
+
+#include <map>
 #include <string>
+#include <vector>
 
 #ifdef MAPNIK_DEBUG
 #include <iostream>
@@ -33,18 +44,135 @@
 
 namespace mapnik {
 
+namespace {
+
+// Opening a converter looks up the encoding and sets up its tables, which
+// shows when every featureset opens one. Converters keep conversion state
+// so two transcoders can't share one, but a closed transcoder hands its
+// converter back here for the next one asking for the same encoding.
+class converter_pool : private boost::noncopyable
+{
+public:
+    UConverter * acquire(std::string const& encoding, UErrorCode & err)
+    {
+        {
+#ifdef MAPNIK_THREADSAFE
+            boost::mutex::scoped_lock lock(mutex_);
+#endif
+            std::map<std::string, std::vector<UConverter*> >::iterator itr = idle_.find(encoding);
+            if (itr != idle_.end() && !itr->second.empty())
+            {
+                UConverter * conv = itr->second.back();
+                itr->second.pop_back();
+                return conv;
+            }
+        }
+        return ucnv_open(encoding.c_str(), &err);
+    }
+
+    void release(std::string const& encoding, UConverter * conv)
+    {
+        ucnv_reset(conv);
+        {
+#ifdef MAPNIK_THREADSAFE
+            boost::mutex::scoped_lock lock(mutex_);
+#endif
+            std::vector<UConverter*> & idle = idle_[encoding];
+            if (idle.size() < max_idle)
+            {
+                idle.push_back(conv);
+                return;
+            }
+        }
+        ucnv_close(conv);
+    }
+
+private:
+    // about one per rendering thread and datasource encoding
+    static const std::size_t max_idle = 32;
+    std::map<std::string, std::vector<UConverter*> > idle_;
+#ifdef MAPNIK_THREADSAFE
+    boost::mutex mutex_;
+#endif
+};
+
+converter_pool & pool()
+{
+    // never destroyed, transcoders held by other statics may
+    // still give their converters back during exit
+    static converter_pool * instance = new converter_pool;
+    return *instance;
+}
+
+UnicodeString widen(const char* data, boost::int32_t length)
+{
+    UnicodeString ustr;
+    if (length == 0) return ustr;
+    UChar * buf = ustr.getBuffer(length);
+    if (!buf) return ustr;
+    for (boost::int32_t i = 0; i < length; ++i)
+    {
+        buf[i] = static_cast<unsigned char>(data[i]);
+    }
+    ustr.releaseBuffer(length);
+    return ustr;
+}
+
+bool is_ascii(const char* data, boost::int32_t length)
+{
+    for (boost::int32_t i = 0; i < length; ++i)
+    {
+        if (static_cast<unsigned char>(data[i]) & 0x80) return false;
+    }
+    return true;
+}
+
+}
+
 transcoder::transcoder (std::string const& encoding)
     : ok_(false),
-      conv_(0)
+      conv_(0),
+      encoding_(encoding),
+      fast_path_(CONVERTER)
 {
     UErrorCode err = U_ZERO_ERROR;
-    conv_ = ucnv_open(encoding.c_str(),&err);
-    if (U_SUCCESS(err)) ok_ = true;
+    conv_ = pool().acquire(encoding_, err);
+    if (U_SUCCESS(err) && conv_)
+    {
+        ok_ = true;
+        // ascii is a subset of all of these, latin1 maps each byte to
+        // the same code point and utf-8 has a converter free decoder
+        switch (ucnv_getType(conv_))
+        {
+        case UCNV_UTF8: fast_path_ = UTF8; break;
+        case UCNV_LATIN_1: fast_path_ = LATIN1; break;
+        case UCNV_US_ASCII: fast_path_ = ASCII; break;
+        default: break;
+        }
+    }
     // TODO ??
 }
 
 UnicodeString transcoder::transcode(const char* data, boost::int32_t length) const
 {
+    if (fast_path_ != CONVERTER && data)
+    {
+        if (length < 0) length = std::strlen(data);
+        if (fast_path_ == LATIN1 || is_ascii(data, length))
+        {
+            return widen(data, length);
+        }
+        if (fast_path_ == UTF8)
+        {
+            UnicodeString ustr = UnicodeString::fromUTF8(StringPiece(data, length));
+            if (ustr.isBogus())
+            {
+                ustr.remove();
+            }
+            return ustr;
+        }
+    }
+
     UErrorCode err = U_ZERO_ERROR;
 
     UnicodeString ustr(data,length,conv_,err);
@@ -57,6 +185,6 @@ UnicodeString transcoder::transcode(const char* data, boost::int32_t length) con
 
 transcoder::~transcoder()
 {
-    if (conv_) ucnv_close(conv_);
+    if (conv_) pool().release(encoding_, conv_);
 }
 }
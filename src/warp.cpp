@@ -28,6 +28,10 @@
 #include <mapnik/image_util.hpp>
 #include <mapnik/box2d.hpp>
 #include <mapnik/ctrans.hpp>
+#include <mapnik/image_blend.hpp>
+#include <mapnik/raster_colorizer.hpp>
+#include <mapnik/internal/colorizer_accessor.hpp>
+#include <mapnik/worker_pool.hpp>
 
 // agg
 #include "agg_image_filters.h"
@@ -42,130 +46,215 @@
 #include "agg_renderer_scanline.h"
 #include "agg_span_allocator.h"
 #include "agg_image_accessors.h"
-#include "agg_renderer_scanline.h"
+
+// boost
+#include <boost/ref.hpp>
+
+// stl
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if !defined(MAPNIK_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define MAPNIK_WARP_SSE2
+#endif
 
 namespace mapnik {
 
-void reproject_raster(raster &target, raster const& source,
-                      proj_transform const& prj_trans,
-                      double offset_x, double offset_y,
-                      unsigned mesh_size,
-                      double filter_radius,
-                      double scale_factor,
-                      std::string scaling_method_name)
+#ifdef MAPNIK_WARP_SSE2
+
+// Drop-in replacement for agg::span_image_filter_rgba_2x2 over an
+// image_accessor_clone source. The four taps of each output pixel are
+// interleaved into 16 bit lanes and accumulated with pmaddwd; the integer
+// arithmetic is the same as AGG's so the output is identical.
+template <typename PixFmt, typename Interpolator>
+class span_image_filter_rgba_2x2_sse2
 {
-    if (prj_trans.equal()) {
+public:
+    typedef typename PixFmt::color_type color_type;
+    typedef typename PixFmt::order_type order_type;
+    typedef typename color_type::value_type value_type;
 
-        if (scaling_method_name == "bilinear8"){
-            scale_image_bilinear8<image_data_32>(target.data_,source.data_,
-                                                 offset_x, offset_y);
-        } else {
-            scaling_method_e scaling_method = get_scaling_method_by_name(scaling_method_name);
-            scale_image_agg<image_data_32>(target.data_,source.data_, (scaling_method_e)scaling_method, scale_factor, offset_x, offset_y, filter_radius);
-        }
-    } else {
-        CoordTransform ts(source.data_.width(), source.data_.height(),
-                          source.ext_);
-        CoordTransform tt(target.data_.width(), target.data_.height(),
-                          target.ext_, offset_x, offset_y);
-        unsigned i, j;
-        unsigned mesh_nx = ceil(source.data_.width()/double(mesh_size)+1);
-        unsigned mesh_ny = ceil(source.data_.height()/double(mesh_size)+1);
-
-        ImageData<double> xs(mesh_nx, mesh_ny);
-        ImageData<double> ys(mesh_nx, mesh_ny);
-
-        // Precalculate reprojected mesh
-        for(j=0; j<mesh_ny; j++) {
-            for (i=0; i<mesh_nx; i++) {
-                xs(i,j) = i*mesh_size;
-                ys(i,j) = j*mesh_size;
-                ts.backward(&xs(i,j), &ys(i,j));
-            }
-        }
-        prj_trans.backward(xs.getData(), ys.getData(), NULL, mesh_nx*mesh_ny);
+    span_image_filter_rgba_2x2_sse2(PixFmt const& src,
+                                    Interpolator & interpolator,
+                                    agg::image_filter_lut const& filter)
+        : src_(src),
+          interpolator_(interpolator),
+          filter_(filter) {}
 
-        // Initialize AGG objects
-        typedef agg::pixfmt_rgba32 pixfmt;
-        typedef pixfmt::color_type color_type;
-        typedef agg::renderer_base<pixfmt> renderer_base;
-        typedef agg::pixfmt_rgba32_pre pixfmt_pre;
-        typedef agg::renderer_base<pixfmt_pre> renderer_base_pre;
+    void prepare() {}
 
-        agg::rasterizer_scanline_aa<> rasterizer;
-        agg::scanline_u8  scanline;
-        agg::rendering_buffer buf((unsigned char*)target.data_.getData(),
-                                  target.data_.width(),
-                                  target.data_.height(),
-                                  target.data_.width()*4);
-        pixfmt_pre pixf_pre(buf);
-        renderer_base_pre rb_pre(pixf_pre);
-        rasterizer.clip_box(0, 0, target.data_.width(), target.data_.height());
-        agg::rendering_buffer buf_tile(
-            (unsigned char*)source.data_.getData(),
-            source.data_.width(),
-            source.data_.height(),
-            source.data_.width() * 4);
+    void generate(color_type* span, int x, int y, unsigned len)
+    {
+        interpolator_.begin(x + 0.5, y + 0.5, len);
 
-        pixfmt pixf_tile(buf_tile);
+        agg::int16 const* weight_array = filter_.weight_array() +
+            ((filter_.diameter()/2 - 1) << agg::image_subpixel_shift);
+        int max_x = src_.width() - 1;
+        int max_y = src_.height() - 1;
+        __m128i const zero = _mm_setzero_si128();
+        __m128i const round = _mm_set1_epi32(agg::image_filter_scale / 2);
+        agg::int32u fg[4];
 
-        typedef agg::image_accessor_clone<pixfmt> img_accessor_type;
-        img_accessor_type ia(pixf_tile);
+        do
+        {
+            int x_hr;
+            int y_hr;
+            interpolator_.coordinates(&x_hr, &y_hr);
+            x_hr -= agg::image_subpixel_scale / 2;
+            y_hr -= agg::image_subpixel_scale / 2;
 
-        agg::span_allocator<color_type> sa;
+            int x_lr = x_hr >> agg::image_subpixel_shift;
+            int y_lr = y_hr >> agg::image_subpixel_shift;
+            x_hr &= agg::image_subpixel_mask;
+            y_hr &= agg::image_subpixel_mask;
 
-        // Initialize filter
-        agg::image_filter_lut filter;
-        scaling_method_e scaling_method = get_scaling_method_by_name(
-            scaling_method_name);
-        switch(scaling_method)
-        {
-        case SCALING_NEAR: break;
-        case SCALING_BILINEAR:
-            filter.calculate(agg::image_filter_bilinear(), true); break;
-        case SCALING_BICUBIC:
-            filter.calculate(agg::image_filter_bicubic(), true); break;
-        case SCALING_SPLINE16:
-            filter.calculate(agg::image_filter_spline16(), true); break;
-        case SCALING_SPLINE36:
-            filter.calculate(agg::image_filter_spline36(), true); break;
-        case SCALING_HANNING:
-            filter.calculate(agg::image_filter_hanning(), true); break;
-        case SCALING_HAMMING:
-            filter.calculate(agg::image_filter_hamming(), true); break;
-        case SCALING_HERMITE:
-            filter.calculate(agg::image_filter_hermite(), true); break;
-        case SCALING_KAISER:
-            filter.calculate(agg::image_filter_kaiser(), true); break;
-        case SCALING_QUADRIC:
-            filter.calculate(agg::image_filter_quadric(), true); break;
-        case SCALING_CATROM:
-            filter.calculate(agg::image_filter_catrom(), true); break;
-        case SCALING_GAUSSIAN:
-            filter.calculate(agg::image_filter_gaussian(), true); break;
-        case SCALING_BESSEL:
-            filter.calculate(agg::image_filter_bessel(), true); break;
-        case SCALING_MITCHELL:
-            filter.calculate(agg::image_filter_mitchell(), true); break;
-        case SCALING_SINC:
-            filter.calculate(agg::image_filter_sinc(filter_radius), true); break;
-        case SCALING_LANCZOS:
-            filter.calculate(agg::image_filter_lanczos(filter_radius), true); break;
-        case SCALING_BLACKMAN:
-            filter.calculate(agg::image_filter_blackman(filter_radius), true); break;
-        }
+            // clamp to the edges like image_accessor_clone
+            int x0 = clamp(x_lr, max_x);
+            int x1 = clamp(x_lr + 1, max_x);
+            int y0 = clamp(y_lr, max_y);
+            int y1 = clamp(y_lr + 1, max_y);
+
+            int w00 = tap_weight(weight_array[x_hr + agg::image_subpixel_scale],
+                                 weight_array[y_hr + agg::image_subpixel_scale]);
+            int w01 = tap_weight(weight_array[x_hr],
+                                 weight_array[y_hr + agg::image_subpixel_scale]);
+            int w10 = tap_weight(weight_array[x_hr + agg::image_subpixel_scale],
+                                 weight_array[y_hr]);
+            int w11 = tap_weight(weight_array[x_hr], weight_array[y_hr]);
+
+            // r0 r1 g0 g1 b0 b1 a0 a1 as 16 bit lanes for each row
+            __m128i top = _mm_unpacklo_epi8(_mm_unpacklo_epi8(pixel(x0, y0), pixel(x1, y0)), zero);
+            __m128i bottom = _mm_unpacklo_epi8(_mm_unpacklo_epi8(pixel(x0, y1), pixel(x1, y1)), zero);
+            __m128i sum = _mm_add_epi32(_mm_madd_epi16(top, weight_pair(w00, w01)),
+                                        _mm_madd_epi16(bottom, weight_pair(w10, w11)));
+            sum = _mm_srli_epi32(_mm_add_epi32(sum, round), agg::image_filter_shift);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(fg), sum);
+
+            if (fg[order_type::A] > color_type::base_mask) fg[order_type::A] = color_type::base_mask;
+            if (fg[order_type::R] > fg[order_type::A]) fg[order_type::R] = fg[order_type::A];
+            if (fg[order_type::G] > fg[order_type::A]) fg[order_type::G] = fg[order_type::A];
+            if (fg[order_type::B] > fg[order_type::A]) fg[order_type::B] = fg[order_type::A];
+
+            span->r = (value_type)fg[order_type::R];
+            span->g = (value_type)fg[order_type::G];
+            span->b = (value_type)fg[order_type::B];
+            span->a = (value_type)fg[order_type::A];
+            ++span;
+            ++interpolator_;
+        } while (--len);
+    }
+
+private:
+    static inline int clamp(int v, int max_v)
+    {
+        return v < 0 ? 0 : (v > max_v ? max_v : v);
+    }
+
+    static inline int tap_weight(int wx, int wy)
+    {
+        return (wx * wy + agg::image_filter_scale / 2) >> agg::image_filter_shift;
+    }
+
+    static inline __m128i weight_pair(int w0, int w1)
+    {
+        return _mm_set1_epi32(static_cast<int>((static_cast<unsigned>(w1) << 16) |
+                                               (static_cast<unsigned>(w0) & 0xffff)));
+    }
+
+    inline __m128i pixel(int x, int y) const
+    {
+        return _mm_cvtsi32_si128(*reinterpret_cast<int const*>(src_.pix_ptr(x, y)));
+    }
+
+    PixFmt const& src_;
+    Interpolator & interpolator_;
+    agg::image_filter_lut const& filter_;
+};
+
+#endif
+
+namespace {
+
+typedef agg::pixfmt_rgba32 source_pixfmt;
 
+// bands thinner than this are not worth a thread
+const unsigned min_band_rows = 64;
+
+// Same as agg::render_scanlines_aa but only emits the rows in [y0, y1).
+// The coverage of a row only depends on the cells of that row, so every
+// band gets exactly the pixels it would get from rendering the whole cell.
+template <typename Rasterizer, typename Scanline, typename Renderer,
+          typename SpanAllocator, typename SpanGenerator>
+void render_band_scanlines(Rasterizer & ras, Scanline & sl, Renderer & ren,
+                           SpanAllocator & alloc, SpanGenerator & span_gen,
+                           int y0, int y1)
+{
+    if (!ras.rewind_scanlines()) return;
+    int y = std::max(y0, ras.min_y());
+    if (y >= y1 || !ras.navigate_scanline(y)) return;
+    sl.reset(ras.min_x(), ras.max_x());
+    span_gen.prepare();
+    while (ras.sweep_scanline(sl) && sl.y() < y1)
+    {
+        agg::render_scanline_aa(sl, ren, alloc, span_gen);
+    }
+}
+
+// Renders the mesh cells overlapping the rows [y0, y1) of the target. Each
+// band has its own rasterizer and accessor, the mesh, filter and source are
+// only read, so bands can run on separate threads.
+template <typename Accessor>
+struct warp_band
+{
+    typedef source_pixfmt::color_type color_type;
+    typedef agg::pixfmt_rgba32_pre pixfmt_pre;
+    typedef agg::renderer_base<pixfmt_pre> renderer_base_pre;
+    typedef agg::span_interpolator_linear<agg::trans_affine> interpolator_type;
+
+    warp_band(raster & target,
+              ImageData<double> const& xs,
+              ImageData<double> const& ys,
+              std::vector<char> const& cells,
+              unsigned mesh_size,
+              scaling_method_e scaling_method,
+              agg::image_filter_lut const& filter,
+              Accessor const& ia,
+              source_pixfmt const* sse2_source,
+              int y0, int y1)
+        : target_(target), xs_(xs), ys_(ys), cells_(cells),
+          mesh_size_(mesh_size), scaling_method_(scaling_method),
+          filter_(filter), ia_(ia), sse2_source_(sse2_source),
+          y0_(y0), y1_(y1) {}
+
+    void operator() ()
+    {
+        agg::rasterizer_scanline_aa<> rasterizer;
+        agg::scanline_u8 scanline;
+        agg::rendering_buffer buf((unsigned char*)target_.data_.getData(),
+                                  target_.data_.width(),
+                                  target_.data_.height(),
+                                  target_.data_.width()*4);
+        pixfmt_pre pixf_pre(buf);
+        renderer_base_pre rb_pre(pixf_pre);
+        rasterizer.clip_box(0, 0, target_.data_.width(), target_.data_.height());
+        agg::span_allocator<color_type> sa;
+
+        unsigned mesh_nx = xs_.width();
+        unsigned mesh_ny = xs_.height();
         // Project mesh cells into target interpolating raster inside each one
-        for(j=0; j<mesh_ny-1; j++) {
-            for (i=0; i<mesh_nx-1; i++) {
-                double polygon[8] = {xs(i,j), ys(i,j),
-                                     xs(i+1,j), ys(i+1,j),
-                                     xs(i+1,j+1), ys(i+1,j+1),
-                                     xs(i,j+1), ys(i,j+1)};
-                tt.forward(polygon+0, polygon+1);
-                tt.forward(polygon+2, polygon+3);
-                tt.forward(polygon+4, polygon+5);
-                tt.forward(polygon+6, polygon+7);
+        for (unsigned j = 0; j < mesh_ny - 1; j++) {
+            for (unsigned i = 0; i < mesh_nx - 1; i++) {
+                if (!cells_[j * (mesh_nx - 1) + i]) continue;
+                double polygon[8] = {xs_(i,j), ys_(i,j),
+                                     xs_(i+1,j), ys_(i+1,j),
+                                     xs_(i+1,j+1), ys_(i+1,j+1),
+                                     xs_(i,j+1), ys_(i,j+1)};
+                double miny = std::min(std::min(polygon[1], polygon[3]), std::min(polygon[5], polygon[7]));
+                double maxy = std::max(std::max(polygon[1], polygon[3]), std::max(polygon[5], polygon[7]));
+                // comparisons with nan are false, such cells are kept
+                if (maxy + 1 < y0_ || miny - 1 >= y1_) continue;
 
                 rasterizer.reset();
                 rasterizer.move_to_d(polygon[0]-1, polygon[1]-1);
@@ -173,38 +262,288 @@ void reproject_raster(raster &target, raster const& source,
                 rasterizer.line_to_d(polygon[4]+1, polygon[5]+1);
                 rasterizer.line_to_d(polygon[6]-1, polygon[7]+1);
 
-                unsigned x0 = i * mesh_size;
-                unsigned y0 = j * mesh_size;
-                unsigned x1 = (i+1) * mesh_size;
-                unsigned y1 = (j+1) * mesh_size;
+                unsigned x0 = i * mesh_size_;
+                unsigned y0 = j * mesh_size_;
+                unsigned x1 = (i+1) * mesh_size_;
+                unsigned y1 = (j+1) * mesh_size_;
 
                 agg::trans_affine tr(polygon, x0, y0, x1, y1);
                 if (tr.is_valid())
                 {
-                    typedef agg::span_interpolator_linear<agg::trans_affine>
-                        interpolator_type;
                     interpolator_type interpolator(tr);
 
-                    if (scaling_method == SCALING_NEAR) {
+                    if (scaling_method_ == SCALING_NEAR) {
                         typedef agg::span_image_filter_rgba_nn
-                            <img_accessor_type, interpolator_type>
+                            <Accessor, interpolator_type>
                             span_gen_type;
-                        span_gen_type sg(ia, interpolator);
-                        agg::render_scanlines_aa(rasterizer, scanline, rb_pre,
-                                                 sa, sg);
+                        span_gen_type sg(ia_, interpolator);
+                        render_band_scanlines(rasterizer, scanline, rb_pre,
+                                              sa, sg, y0_, y1_);
+#ifdef MAPNIK_WARP_SSE2
+                    } else if (sse2_source_) {
+                        typedef span_image_filter_rgba_2x2_sse2
+                            <source_pixfmt, interpolator_type>
+                            span_gen_type;
+
+                        span_gen_type sg(*sse2_source_, interpolator, filter_);
+                        render_band_scanlines(rasterizer, scanline, rb_pre,
+                                              sa, sg, y0_, y1_);
+#endif
                     } else {
                         typedef agg::span_image_filter_rgba_2x2
-                            <img_accessor_type, interpolator_type>
+                            <Accessor, interpolator_type>
                             span_gen_type;
 
-                        span_gen_type sg(ia, interpolator, filter);
-                        agg::render_scanlines_aa(rasterizer, scanline, rb_pre,
-                                                 sa, sg);
+                        span_gen_type sg(ia_, interpolator, filter_);
+                        render_band_scanlines(rasterizer, scanline, rb_pre,
+                                              sa, sg, y0_, y1_);
                     }
                 }
+            }
+        }
+    }
+
+    raster & target_;
+    ImageData<double> const& xs_;
+    ImageData<double> const& ys_;
+    std::vector<char> const& cells_;
+    unsigned mesh_size_;
+    scaling_method_e scaling_method_;
+    agg::image_filter_lut const& filter_;
+    // accessors keep the position of the last fetch, one per band
+    Accessor ia_;
+    source_pixfmt const* sse2_source_;
+    int y0_;
+    int y1_;
+};
+
+// Reprojects the given mesh nodes (source pixel positions) into target pixel
+// positions in one batch through the projection.
+void project_nodes(std::vector<unsigned> const& nodes,
+                   ImageData<double> & xs, ImageData<double> & ys,
+                   CoordTransform const& ts, CoordTransform const& tt,
+                   proj_transform const& prj_trans,
+                   unsigned mesh_size)
+{
+    if (nodes.empty()) return;
+    unsigned mesh_nx = xs.width();
+    std::vector<double> x(nodes.size());
+    std::vector<double> y(nodes.size());
+    for (unsigned n = 0; n < nodes.size(); ++n)
+    {
+        x[n] = (nodes[n] % mesh_nx) * mesh_size;
+        y[n] = (nodes[n] / mesh_nx) * mesh_size;
+        ts.backward(&x[n], &y[n]);
+    }
+    prj_trans.backward(&x[0], &y[0], NULL, nodes.size());
+    for (unsigned n = 0; n < nodes.size(); ++n)
+    {
+        tt.forward(&x[n], &y[n]);
+        xs.getData()[nodes[n]] = x[n];
+        ys.getData()[nodes[n]] = y[n];
+    }
+}
+
+// Warp the source through the reprojected mesh, sampling it through the
+// given image accessor. sse2_source enables the SSE2 span generator, which
+// reads the pixels directly and so only applies to the plain accessor.
+template <typename Accessor>
+void reproject_mesh(raster &target, raster const& source,
+                    proj_transform const& prj_trans,
+                    double offset_x, double offset_y,
+                    unsigned mesh_size,
+                    double filter_radius,
+                    scaling_method_e scaling_method,
+                    Accessor const& ia,
+                    source_pixfmt const* sse2_source)
+{
+    CoordTransform ts(source.data_.width(), source.data_.height(),
+                      source.ext_);
+    CoordTransform tt(target.data_.width(), target.data_.height(),
+                      target.ext_, offset_x, offset_y);
+    unsigned mesh_nx = ceil(source.data_.width()/double(mesh_size)+1);
+    unsigned mesh_ny = ceil(source.data_.height()/double(mesh_size)+1);
+    if (mesh_nx < 2 || mesh_ny < 2) return;
 
+    // target pixel positions of the mesh nodes, reprojected in one batch
+    ImageData<double> xs(mesh_nx, mesh_ny);
+    ImageData<double> ys(mesh_nx, mesh_ny);
+    std::vector<unsigned> nodes(mesh_nx * mesh_ny);
+    for (unsigned n = 0; n < nodes.size(); ++n)
+    {
+        nodes[n] = n;
+    }
+    project_nodes(nodes, xs, ys, ts, tt, prj_trans, mesh_size);
+
+    // Only cells whose quad, as rasterized below, reaches the target are
+    // drawn. The test is on the same corners the rasterizer gets, so it
+    // leaves out exactly the cells the clip box would empty. Comparisons
+    // with nan are false, such cells are kept.
+    std::vector<char> cells((mesh_nx - 1) * (mesh_ny - 1), 0);
+    std::size_t num_cells = 0;
+    double width = target.data_.width();
+    double height = target.data_.height();
+    for (unsigned j = 0; j < mesh_ny - 1; ++j)
+    {
+        for (unsigned i = 0; i < mesh_nx - 1; ++i)
+        {
+            double cx[4] = { xs(i,j), xs(i+1,j), xs(i+1,j+1), xs(i,j+1) };
+            double cy[4] = { ys(i,j), ys(i+1,j), ys(i+1,j+1), ys(i,j+1) };
+            // rasterized corners are within a pixel of the mesh nodes
+            bool left = true, right = true, above = true, below = true;
+            for (unsigned c = 0; c < 4; ++c)
+            {
+                left = left && cx[c] + 1 < 0;
+                right = right && cx[c] - 1 > width;
+                above = above && cy[c] + 1 < 0;
+                below = below && cy[c] - 1 > height;
+            }
+            bool outside = left || right || above || below;
+            if (!outside)
+            {
+                cells[j * (mesh_nx - 1) + i] = 1;
+                ++num_cells;
             }
         }
     }
+
+    // Initialize filter
+    agg::image_filter_lut filter;
+    switch(scaling_method)
+    {
+    case SCALING_NEAR: break;
+    case SCALING_BILINEAR:
+        filter.calculate(agg::image_filter_bilinear(), true); break;
+    case SCALING_BICUBIC:
+        filter.calculate(agg::image_filter_bicubic(), true); break;
+    case SCALING_SPLINE16:
+        filter.calculate(agg::image_filter_spline16(), true); break;
+    case SCALING_SPLINE36:
+        filter.calculate(agg::image_filter_spline36(), true); break;
+    case SCALING_HANNING:
+        filter.calculate(agg::image_filter_hanning(), true); break;
+    case SCALING_HAMMING:
+        filter.calculate(agg::image_filter_hamming(), true); break;
+    case SCALING_HERMITE:
+        filter.calculate(agg::image_filter_hermite(), true); break;
+    case SCALING_KAISER:
+        filter.calculate(agg::image_filter_kaiser(), true); break;
+    case SCALING_QUADRIC:
+        filter.calculate(agg::image_filter_quadric(), true); break;
+    case SCALING_CATROM:
+        filter.calculate(agg::image_filter_catrom(), true); break;
+    case SCALING_GAUSSIAN:
+        filter.calculate(agg::image_filter_gaussian(), true); break;
+    case SCALING_BESSEL:
+        filter.calculate(agg::image_filter_bessel(), true); break;
+    case SCALING_MITCHELL:
+        filter.calculate(agg::image_filter_mitchell(), true); break;
+    case SCALING_SINC:
+        filter.calculate(agg::image_filter_sinc(filter_radius), true); break;
+    case SCALING_LANCZOS:
+        filter.calculate(agg::image_filter_lanczos(filter_radius), true); break;
+    case SCALING_BLACKMAN:
+        filter.calculate(agg::image_filter_blackman(filter_radius), true); break;
+    }
+
+    // Split the target in horizontal bands rendered side by side on the
+    // worker_pool. A pixel always belongs to one band and sees the cells
+    // in the same order, so the output does not depend on the number of
+    // bands.
+    unsigned num_bands = worker_pool::instance()->threads() + 1;
+    num_bands = std::min(num_bands, std::max(1u, target.data_.height() / min_band_rows));
+    num_bands = std::min<unsigned>(num_bands, std::max<std::size_t>(1, num_cells / 64));
+    int rows_per_band = (target.data_.height() + num_bands - 1) / num_bands;
+    std::vector<warp_band<Accessor> > bands;
+    bands.reserve(num_bands);
+    for (unsigned b = 0; b < num_bands; ++b)
+    {
+        bands.push_back(warp_band<Accessor>(target, xs, ys, cells, mesh_size,
+                                            scaling_method, filter, ia, sse2_source,
+                                            b * rows_per_band, (b + 1) * rows_per_band));
+    }
+    std::vector<worker_pool::task> tasks;
+    for (unsigned b = 0; b < num_bands; ++b)
+    {
+        tasks.push_back(boost::ref(bands[b]));
+    }
+    worker_pool::instance()->run(tasks);
+}
+
+}
+
+void reproject_raster(raster &target, raster const& source,
+                      proj_transform const& prj_trans,
+                      double offset_x, double offset_y,
+                      unsigned mesh_size,
+                      double filter_radius,
+                      double scale_factor,
+                      std::string scaling_method_name)
+{
+    if (prj_trans.equal()) {
+
+        if (scaling_method_name == "bilinear8"){
+            scale_image_bilinear8<image_data_32>(target.data_,source.data_,
+                                                 offset_x, offset_y);
+        } else {
+            scaling_method_e scaling_method = get_scaling_method_by_name(scaling_method_name);
+            scale_image_agg<image_data_32>(target.data_,source.data_, (scaling_method_e)scaling_method, scale_factor, offset_x, offset_y, filter_radius);
+        }
+    } else {
+        agg::rendering_buffer buf_tile(
+            (unsigned char*)source.data_.getData(),
+            source.data_.width(),
+            source.data_.height(),
+            source.data_.width() * 4);
+
+        source_pixfmt pixf_tile(buf_tile);
+
+        typedef agg::image_accessor_clone<source_pixfmt> img_accessor_type;
+        img_accessor_type ia(pixf_tile);
+
+        source_pixfmt const* sse2_source = 0;
+#ifdef MAPNIK_WARP_SSE2
+        if (get_simd_level() >= SIMD_SSE2) sse2_source = &pixf_tile;
+#endif
+        reproject_mesh(target, source, prj_trans, offset_x, offset_y, mesh_size,
+                       filter_radius, get_scaling_method_by_name(scaling_method_name),
+                       ia, sse2_source);
+    }
+}
+
+void reproject_raster(raster &target, raster const& source,
+                      proj_transform const& prj_trans,
+                      double offset_x, double offset_y,
+                      unsigned mesh_size,
+                      double filter_radius,
+                      double scale_factor,
+                      std::string scaling_method_name,
+                      colorizer_lut const& colorizer)
+{
+    if (prj_trans.equal() && scaling_method_name == "bilinear8") {
+        // bilinear8 reads the pixels directly, colorize a copy first
+        image_data_32 colorized(source.data_.width(), source.data_.height());
+        colorizer.colorize(source.data_, colorized);
+        scale_image_bilinear8<image_data_32>(target.data_, colorized,
+                                             offset_x, offset_y);
+    } else if (prj_trans.equal()) {
+        scaling_method_e scaling_method = get_scaling_method_by_name(scaling_method_name);
+        scale_image_agg(target.data_, source.data_, colorizer, scaling_method, scale_factor, offset_x, offset_y, filter_radius);
+    } else {
+        agg::rendering_buffer buf_tile(
+            (unsigned char*)source.data_.getData(),
+            source.data_.width(),
+            source.data_.height(),
+            source.data_.width() * 4);
+
+        source_pixfmt pixf_tile(buf_tile);
+
+        typedef colorizer_accessor<source_pixfmt> img_accessor_type;
+        img_accessor_type ia(pixf_tile, colorizer);
+
+        reproject_mesh(target, source, prj_trans, offset_x, offset_y, mesh_size,
+                       filter_radius, get_scaling_method_by_name(scaling_method_name),
+                       ia, static_cast<source_pixfmt const*>(0));
+    }
 }
 }// namespace mapnik
@@ -0,0 +1,186 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+// mapnik
+#include <mapnik/worker_pool.hpp>
+
+// boost
+#include <boost/bind.hpp>
+
+// stl
+#include <algorithm>
+
+namespace mapnik
+{
+
+#ifdef MAPNIK_THREADSAFE
+
+struct worker_pool::batch
+{
+    explicit batch(std::vector<task> const& tasks_)
+        : tasks(tasks_),
+          next(0),
+          pending(tasks_.size()) {}
+
+    std::vector<task> const& tasks;
+    // first task nobody took yet, and tasks not done
+    std::size_t next;
+    std::size_t pending;
+    boost::condition_variable done;
+};
+
+worker_pool::worker_pool()
+    : threads_(std::max(1u, boost::thread::hardware_concurrency()) - 1),
+      running_(0),
+      started_(false),
+      stopping_(false) {}
+
+worker_pool::~worker_pool()
+{
+    {
+        boost::mutex::scoped_lock lock(queue_mutex_);
+        stopping_ = true;
+    }
+    queue_cond_.notify_all();
+    workers_.join_all();
+}
+
+// with the lock held: takes the next task of b, dropping b from the
+// queue once all its tasks are taken
+bool worker_pool::take(batch & b, std::size_t & index)
+{
+    if (b.next >= b.tasks.size()) return false;
+    index = b.next++;
+    if (b.next == b.tasks.size())
+    {
+        queue_.erase(std::find(queue_.begin(), queue_.end(), &b));
+    }
+    return true;
+}
+
+void worker_pool::work()
+{
+    boost::mutex::scoped_lock lock(queue_mutex_);
+    for (;;)
+    {
+        while (queue_.empty() && !stopping_ && running_ <= threads_)
+        {
+            queue_cond_.wait(lock);
+        }
+        if (stopping_ || running_ > threads_)
+        {
+            --running_;
+            return;
+        }
+        batch & b = *queue_.front();
+        std::size_t index;
+        take(b, index);
+        lock.unlock();
+        b.tasks[index]();
+        lock.lock();
+        if (--b.pending == 0) b.done.notify_all();
+    }
+}
+
+void worker_pool::run(std::vector<task> const& tasks)
+{
+    boost::mutex::scoped_lock lock(queue_mutex_);
+    if (tasks.size() < 2 || threads_ == 0)
+    {
+        lock.unlock();
+        for (std::size_t i = 0; i < tasks.size(); ++i)
+        {
+            tasks[i]();
+        }
+        return;
+    }
+    if (!started_)
+    {
+        started_ = true;
+        for (; running_ < threads_; ++running_)
+        {
+            workers_.create_thread(boost::bind(&worker_pool::work, this));
+        }
+    }
+    batch b(tasks);
+    queue_.push_back(&b);
+    queue_cond_.notify_all();
+    // the caller runs whatever the pool threads do not take
+    std::size_t index;
+    while (take(b, index))
+    {
+        lock.unlock();
+        tasks[index]();
+        lock.lock();
+        --b.pending;
+    }
+    while (b.pending > 0)
+    {
+        b.done.wait(lock);
+    }
+}
+
+void worker_pool::set_threads(unsigned threads)
+{
+    boost::mutex::scoped_lock lock(queue_mutex_);
+    threads_ = threads;
+    if (started_)
+    {
+        for (; running_ < threads_; ++running_)
+        {
+            workers_.create_thread(boost::bind(&worker_pool::work, this));
+        }
+    }
+    queue_cond_.notify_all();
+}
+
+unsigned worker_pool::threads() const
+{
+    boost::mutex::scoped_lock lock(queue_mutex_);
+    return threads_;
+}
+
+#else
+
+worker_pool::worker_pool() {}
+
+worker_pool::~worker_pool() {}
+
+void worker_pool::run(std::vector<task> const& tasks)
+{
+    for (std::size_t i = 0; i < tasks.size(); ++i)
+    {
+        tasks[i]();
+    }
+}
+
+void worker_pool::set_threads(unsigned) {}
+
+unsigned worker_pool::threads() const
+{
+    return 0;
+}
+
+#endif
+
+}
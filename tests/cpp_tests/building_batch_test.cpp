@@ -0,0 +1,103 @@
+#include <boost/detail/lightweight_test.hpp>
+#include <iostream>
+#include <vector>
+#include <mapnik/building_batch.hpp>
+
+#include "agg_basics.h"
+#include "agg_rendering_buffer.h"
+#include "agg_pixfmt_rgba.h"
+#include "agg_rasterizer_scanline_aa.h"
+#include "agg_scanline_u.h"
+#include "agg_renderer_scanline.h"
+
+// Checks that buildings are ordered back to front across features, that
+// only non overlapping buildings of the same colors share passes, and that
+// walls of opposite direction drawn in one pass do not cancel each other.
+
+namespace {
+
+void add_box_building(mapnik::building_batch & batch, mapnik::color const& fill,
+                      double x, double y, double size, double height)
+{
+    batch.start(fill, 1.0);
+    double xs[5] = { x, x + size, x + size, x, x };
+    double ys[5] = { y, y, y + size, y + size, y };
+    for (unsigned i = 1; i < 5; ++i)
+    {
+        batch.add_wall(xs[i-1], ys[i-1], xs[i], ys[i],
+                       xs[i-1], ys[i-1] - height, xs[i], ys[i] - height);
+    }
+    for (unsigned i = 0; i < 5; ++i)
+    {
+        batch.add_roof(xs[i], ys[i] - height, i == 0 ? mapnik::SEG_MOVETO : mapnik::SEG_LINETO);
+    }
+    batch.set_depth(y + size);
+}
+
+}
+
+int main()
+{
+    mapnik::color grey(200, 200, 200);
+    mapnik::color red(255, 0, 0);
+
+    {
+        mapnik::building_batch batch;
+        add_box_building(batch, grey, 0, 50, 10, 5);   // front
+        add_box_building(batch, grey, 40, 10, 10, 5);  // back
+        add_box_building(batch, grey, 20, 30, 10, 5);  // middle
+        batch.sort();
+        BOOST_TEST(batch.size() == 3);
+        BOOST_TEST(batch.at(0).depth == 20);
+        BOOST_TEST(batch.at(1).depth == 40);
+        BOOST_TEST(batch.at(2).depth == 60);
+        // apart and the same colors, one group
+        BOOST_TEST(batch.group_end(0) == 3);
+        BOOST_TEST(batch.group_end(0, 2) == 2);
+        batch.clear();
+        BOOST_TEST(batch.empty());
+    }
+
+    {
+        mapnik::building_batch batch;
+        add_box_building(batch, grey, 0, 0, 10, 5);
+        add_box_building(batch, grey, 5, 2, 10, 5);    // overlaps the first
+        add_box_building(batch, grey, 100, 100, 10, 5);
+        add_box_building(batch, red, 200, 200, 10, 5); // other colors
+        batch.sort();
+        BOOST_TEST(batch.group_end(0) == 1);
+        BOOST_TEST(batch.group_end(1) == 3);
+        BOOST_TEST(batch.group_end(3) == 4);
+    }
+
+    {
+        // front and back walls of a box overlap on screen with opposite
+        // directions, filled together they must still cover the overlap
+        mapnik::building_batch batch;
+        add_box_building(batch, grey, 10, 30, 20, 30);
+        batch.sort();
+        unsigned width = 64, height = 64;
+        std::vector<unsigned> pixels(width * height, 0);
+        agg::rendering_buffer buf(reinterpret_cast<unsigned char*>(&pixels[0]), width, height, width * 4);
+        agg::pixfmt_rgba32_plain pixf(buf);
+        agg::renderer_base<agg::pixfmt_rgba32_plain> renb(pixf);
+        agg::renderer_scanline_aa_solid<agg::renderer_base<agg::pixfmt_rgba32_plain> > ren(renb);
+        agg::rasterizer_scanline_aa<> ras;
+        agg::scanline_u8 sl;
+        mapnik::building_batch::path_range walls = batch.walls(batch.at(0));
+        ras.add_path(walls);
+        ren.color(agg::rgba8(255, 255, 255, 255));
+        agg::render_scanlines(ras, sl, ren);
+        // inside the front wall, inside the back wall, and where they overlap
+        BOOST_TEST(pixels[45 * width + 20] == 0xffffffff);
+        BOOST_TEST(pixels[10 * width + 20] == 0xffffffff);
+        BOOST_TEST(pixels[25 * width + 20] == 0xffffffff);
+        BOOST_TEST(pixels[25 * width + 5] == 0);
+    }
+
+    if (!::boost::detail::test_errors()) {
+        std::clog << "C++ building batch: \x1b[1;32m✓ \x1b[0m\n";
+    } else {
+        return ::boost::report_errors();
+    }
+}
@@ -0,0 +1,131 @@
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/make_shared.hpp>
+#include <iostream>
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/graphics.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/expression.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+
+// Checks that the AGG renderer draws the buildings of a style back to
+// front whatever the order of their features, and that buildings collected
+// so far are drawn before a text symbolizer of the same style, so labels
+// end up on top of them.
+
+namespace {
+
+void add_building(mapnik::memory_datasource & ds, mapnik::context_ptr const& ctx,
+                  std::string const& kind, std::string const& name,
+                  double minx, double miny, double maxx, double maxy)
+{
+    mapnik::feature_ptr feature = boost::make_shared<mapnik::Feature>(ctx, ds.size() + 1);
+    feature->put("kind", UnicodeString::fromUTF8(kind));
+    feature->put("name", UnicodeString::fromUTF8(name));
+    mapnik::geometry_type * geom = new mapnik::geometry_type(mapnik::Polygon);
+    geom->move_to(minx, miny);
+    geom->line_to(maxx, miny);
+    geom->line_to(maxx, maxy);
+    geom->line_to(minx, maxy);
+    geom->line_to(minx, miny);
+    feature->add_geometry(geom);
+    ds.push(feature);
+}
+
+// front buildings red, back buildings blue, both 20 units tall, and the
+// names of back buildings as labels when with_text is set
+mapnik::Map make_map(boost::shared_ptr<mapnik::memory_datasource> const& ds, bool with_text)
+{
+    mapnik::Map m(100, 100);
+    m.set_background(mapnik::color(255, 255, 255));
+
+    mapnik::feature_type_style style;
+    mapnik::rule front;
+    front.set_filter(mapnik::parse_expression("[kind] = 'front'"));
+    front.append(mapnik::building_symbolizer(mapnik::color(200, 0, 0), mapnik::parse_expression("20")));
+    style.add_rule(front);
+    mapnik::rule back;
+    back.set_filter(mapnik::parse_expression("[kind] = 'back'"));
+    back.append(mapnik::building_symbolizer(mapnik::color(0, 0, 200), mapnik::parse_expression("20")));
+    style.add_rule(back);
+    if (with_text)
+    {
+        mapnik::rule label;
+        label.set_filter(mapnik::parse_expression("[kind] = 'back'"));
+        mapnik::text_symbolizer text(mapnik::parse_expression("[name]"), "DejaVu Sans Book", 14,
+                                     mapnik::color(0, 0, 0));
+        text.set_allow_overlap(true);
+        label.append(text);
+        style.add_rule(label);
+    }
+    m.insert_style("buildings", style);
+
+    mapnik::layer lyr("buildings");
+    lyr.set_datasource(ds);
+    lyr.add_style("buildings");
+    m.addLayer(lyr);
+    m.zoom_to_box(mapnik::box2d<double>(0, 0, 100, 100));
+    return m;
+}
+
+mapnik::image_32 render(mapnik::Map const& m)
+{
+    mapnik::image_32 image(m.width(), m.height());
+    mapnik::agg_renderer<mapnik::image_32> ren(m, image);
+    ren.apply();
+    return image;
+}
+
+bool same_pixels(mapnik::image_32 const& a, mapnik::image_32 const& b)
+{
+    for (unsigned y = 0; y < a.height(); ++y)
+    {
+        for (unsigned x = 0; x < a.width(); ++x)
+        {
+            if (a.data()(x, y) != b.data()(x, y)) return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main( int, char** )
+{
+    mapnik::freetype_engine::register_fonts("fonts/dejavu-fonts-ttf-2.33/ttf/");
+
+    // one map unit is one pixel. The front building's roof spans screen
+    // rows 50 to 70 and covers the lower walls of the back building,
+    // which come later in the datasource.
+    mapnik::context_ptr ctx = boost::make_shared<mapnik::context_type>();
+    ctx->push("kind");
+    ctx->push("name");
+    boost::shared_ptr<mapnik::memory_datasource> ds = boost::make_shared<mapnik::memory_datasource>();
+    add_building(*ds, ctx, "front", "", 20, 10, 60, 30);
+    add_building(*ds, ctx, "back", "XX", 30, 40, 70, 60);
+
+    mapnik::image_32 buildings = render(make_map(ds, false));
+    unsigned pixel = buildings.data()(45, 55);
+    unsigned red = pixel & 0xff;
+    unsigned blue = (pixel >> 16) & 0xff;
+    BOOST_TEST(red > 100 && blue < 50);
+    // the back building shows where the front one doesn't cover it
+    pixel = buildings.data()(65, 45);
+    red = pixel & 0xff;
+    blue = (pixel >> 16) & 0xff;
+    BOOST_TEST(blue > 100 && red < 50);
+
+    // the label of the back building is drawn after both buildings, so
+    // it is visible over them, and the front one is still on top
+    mapnik::image_32 labelled = render(make_map(ds, true));
+    BOOST_TEST(!same_pixels(buildings, labelled));
+    BOOST_TEST(labelled.data()(45, 60) == buildings.data()(45, 60));
+
+    if (!::boost::detail::test_errors()) {
+        std::clog << "C++ building rendering: \x1b[1;32m✓ \x1b[0m\n";
+    } else {
+        return ::boost::report_errors();
+    }
+}
@@ -0,0 +1,108 @@
+#include <boost/detail/lightweight_test.hpp>
+#include <iostream>
+#include <cstring>
+#include <mapnik/warp.hpp>
+#include <mapnik/raster_colorizer.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+
+// Checks that colorizing a float32 raster while warping or scaling it gives
+// the same bytes as colorizing each pixel with get_color first and then
+// warping or scaling the colors, and that the source is left untouched.
+
+namespace {
+
+bool same(mapnik::image_data_32 const& a, mapnik::image_data_32 const& b)
+{
+    return std::memcmp(a.getData(), b.getData(), a.width() * a.height() * 4) == 0;
+}
+
+bool painted(mapnik::image_data_32 const& image)
+{
+    for (unsigned i = 0; i < image.width() * image.height(); ++i)
+    {
+        if (image.getData()[i] != 0) return true;
+    }
+    return false;
+}
+
+// what the renderers did before, colorize the whole raster then resample it
+void colorize(mapnik::raster_colorizer const& colorizer, mapnik::image_data_32 & data, float nodata)
+{
+    for (unsigned i = 0; i < data.width() * data.height(); ++i)
+    {
+        float value;
+        std::memcpy(&value, &data.getData()[i], sizeof(float));
+        if (value == nodata)
+            data.getData()[i] = mapnik::color(0,0,0,0).rgba();
+        else
+            data.getData()[i] = colorizer.get_color(value).rgba();
+    }
+}
+
+}
+
+int main( int, char** )
+{
+    // values from -10 to 110 over every stop, with a few nodata holes
+    float const nodata = -9999.0f;
+    mapnik::image_data_32 data(256, 256);
+    for (unsigned y = 0; y < data.height(); ++y)
+    {
+        for (unsigned x = 0; x < data.width(); ++x)
+        {
+            float value = ((x * 3 + y * 5) % 481) / 4.0f - 10.0f;
+            if ((x / 16 + y / 16) % 7 == 0 && x % 16 < 4) value = nodata;
+            std::memcpy(&data(x, y), &value, sizeof(float));
+        }
+    }
+    mapnik::image_data_32 pristine(data);
+
+    mapnik::raster_colorizer colorizer(mapnik::COLORIZER_LINEAR, mapnik::color(10, 20, 30, 255));
+    colorizer.set_epsilon(0.5f);
+    colorizer.add_stop(mapnik::colorizer_stop(0, mapnik::COLORIZER_INHERIT, mapnik::color(255, 0, 0, 255)));
+    colorizer.add_stop(mapnik::colorizer_stop(25, mapnik::COLORIZER_DISCRETE, mapnik::color(0, 255, 0, 128)));
+    colorizer.add_stop(mapnik::colorizer_stop(50, mapnik::COLORIZER_LINEAR, mapnik::color(0, 0, 255, 255)));
+    colorizer.add_stop(mapnik::colorizer_stop(75, mapnik::COLORIZER_EXACT, mapnik::color(255, 255, 0, 255)));
+    colorizer.add_stop(mapnik::colorizer_stop(100, mapnik::COLORIZER_INHERIT, mapnik::color(255, 255, 255, 255)));
+    mapnik::colorizer_lut lut(colorizer, nodata);
+
+    mapnik::image_data_32 colors(data);
+    colorize(colorizer, colors, nodata);
+
+    mapnik::raster source(mapnik::box2d<double>(-20, 20, 20, 60), data);
+    mapnik::raster colored(mapnik::box2d<double>(-20, 20, 20, 60), colors);
+    mapnik::projection longlat("+proj=longlat +ellps=WGS84 +datum=WGS84 +no_defs");
+    mapnik::projection merc("+proj=merc +a=6378137 +b=6378137 +lat_ts=0.0 +lon_0=0.0 +x_0=0.0 +y_0=0 +k=1.0 +units=m +nadgrids=@null +wktext +no_defs");
+    mapnik::proj_transform prj_trans(merc, longlat);
+    mapnik::box2d<double> extent(-1500000, 3000000, 1500000, 7000000);
+
+    const char* methods[] = { "near", "bilinear", "bicubic", "lanczos" };
+    for (unsigned m = 0; m < sizeof(methods) / sizeof(const char*); ++m)
+    {
+        mapnik::raster two_step(extent, mapnik::image_data_32(301, 263));
+        mapnik::raster one_pass(extent, mapnik::image_data_32(301, 263));
+        std::memset(two_step.data_.getData(), 0, 301 * 263 * 4);
+        std::memset(one_pass.data_.getData(), 0, 301 * 263 * 4);
+        mapnik::reproject_raster(two_step, colored, prj_trans, 0, 0, 16, 3.0, 1.0, methods[m]);
+        mapnik::reproject_raster(one_pass, source, prj_trans, 0, 0, 16, 3.0, 1.0, methods[m], lut);
+        BOOST_TEST(painted(two_step.data_));
+        BOOST_TEST(same(two_step.data_, one_pass.data_));
+
+        mapnik::scaling_method_e scaling = mapnik::get_scaling_method_by_name(methods[m]);
+        mapnik::image_data_32 scaled(400, 400);
+        mapnik::image_data_32 scaled_lut(400, 400);
+        mapnik::scale_image_agg(scaled, colors, scaling, 400.0 / 256.0, 0, 0, 3.0);
+        mapnik::scale_image_agg(scaled_lut, data, lut, scaling, 400.0 / 256.0, 0, 0, 3.0);
+        BOOST_TEST(painted(scaled));
+        BOOST_TEST(same(scaled, scaled_lut));
+    }
+    BOOST_TEST(same(source.data_, pristine));
+
+    if (!::boost::detail::test_errors()) {
+        std::clog << "C++ colorized warp: \x1b[1;32m✓ \x1b[0m\n";
+    } else {
+        return ::boost::report_errors();
+    }
+}
@@ -0,0 +1,76 @@
+#include <boost/detail/lightweight_test.hpp>
+#include <iostream>
+#include <string>
+#include <limits>
+#include <cstdio>
+#include <cstdlib>
+#include <mapnik/util/conversions.hpp>
+
+// Checks that append_fixed gives the same digits as printf("%.*f").
+
+namespace {
+
+bool same_as_printf(double val, int precision)
+{
+    char buf[400];
+    std::sprintf(buf, "%.*f", precision, val);
+    std::string out("x");
+    mapnik::util::append_fixed(out, val, precision);
+    if (out.substr(1) != buf)
+    {
+        std::clog << "append_fixed(" << buf << ", " << precision << ") gave " << out.substr(1) << "\n";
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main( int, char** )
+{
+    double const values[] = {
+        0.0, -0.0, 1.0, -1.0, 0.1, -0.1, 123.456, -179.99999999, 89.123456789,
+        // ties and values near them at several precisions
+        0.5, 1.5, 2.5, -0.5, -2.5, 0.125, 0.375, -0.625, 1.005, 2.675, 0.045,
+        0.000000005, 0.000000015, -0.000000025, 1e-9, -1e-9, 4.35, 0.0000000049999999,
+        // around the 2^42 switch to printf and beyond
+        4398.046511104, 4398046.511104, 4398046511104.0, 4398046511103.5, 4398046511104.5,
+        1e15, -1e15, 123456789012345678.0, 1e300, -1e300,
+        std::numeric_limits<double>::max(), std::numeric_limits<double>::min(),
+        std::numeric_limits<double>::denorm_min(),
+        std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()
+    };
+    for (int precision = 0; precision <= 8; ++precision)
+    {
+        for (unsigned i = 0; i < sizeof(values) / sizeof(double); ++i)
+        {
+            BOOST_TEST(same_as_printf(values[i], precision));
+        }
+    }
+
+    // coordinates as the GeoJSON metawriter writes them, and the same
+    // scaled to land exactly on ties
+    std::srand(47);
+    for (unsigned i = 0; i < 200000; ++i)
+    {
+        double lon = (std::rand() / (double)RAND_MAX) * 360.0 - 180.0;
+        int precision = i % 9;
+        BOOST_TEST(same_as_printf(lon, precision));
+        BOOST_TEST(same_as_printf(lon * 1e6, precision));
+        double tie = (std::rand() % 2000001 - 1000000 + 0.5) / 8.0;
+        BOOST_TEST(same_as_printf(tie, precision));
+    }
+
+    // appends to what is there
+    std::string out("[");
+    mapnik::util::append_fixed(out, -0.25, 1);
+    out += ',';
+    mapnik::util::append_fixed(out, 7.0, 0);
+    BOOST_TEST(out == "[-0.2,7");
+
+    if (!::boost::detail::test_errors()) {
+        std::clog << "C++ conversions: \x1b[1;32m✓ \x1b[0m\n";
+    } else {
+        return ::boost::report_errors();
+    }
+}
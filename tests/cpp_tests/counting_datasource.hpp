@@ -0,0 +1,22 @@
+#ifndef MAPNIK_TEST_COUNTING_DATASOURCE_HPP
+#define MAPNIK_TEST_COUNTING_DATASOURCE_HPP
+
+#include <mapnik/memory_datasource.hpp>
+
+// memory datasource counting the queries it answers, for tests checking
+// that a cache spares the datasource
+
+class counting_datasource : public mapnik::memory_datasource
+{
+public:
+    counting_datasource()
+        : queries(0) {}
+    mapnik::featureset_ptr features(mapnik::query const& q) const
+    {
+        ++queries;
+        return mapnik::memory_datasource::features(q);
+    }
+    mutable unsigned queries;
+};
+
+#endif // MAPNIK_TEST_COUNTING_DATASOURCE_HPP
@@ -0,0 +1,282 @@
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/lexical_cast.hpp>
+#include <iostream>
+#include <map>
+#include <mapnik/feature_cache.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature.hpp>
+#include "counting_datasource.hpp"
+
+// Checks that queries served from the feature cache return the features
+// the datasource returns, each once, with their geometries and attributes,
+// also when ids are numbered per query, and that overlapping queries read
+// the shared cells from memory.
+
+namespace {
+
+// returns features near the query too, like rtree boxes rounded outward
+// or whole index nodes
+class padded_datasource : public counting_datasource
+{
+public:
+    mapnik::featureset_ptr features(mapnik::query const& q) const
+    {
+        mapnik::box2d<double> const& bbox = q.get_bbox();
+        mapnik::box2d<double> box(bbox.minx() - 3, bbox.miny() - 3, bbox.maxx() + 3, bbox.maxy() + 3);
+        mapnik::query padded(box, q.resolution(), q.scale_denominator());
+        return counting_datasource::features(padded);
+    }
+};
+
+// tests geometry rather than envelopes: leaves out features with no
+// vertex in the query, like lines only passing its corner
+class vertex_featureset : public mapnik::Featureset
+{
+public:
+    vertex_featureset(mapnik::featureset_ptr features, mapnik::box2d<double> const& box)
+        : features_(features), box_(box) {}
+    mapnik::feature_ptr next()
+    {
+        mapnik::feature_ptr feature;
+        while (features_ && (feature = features_->next()))
+        {
+            mapnik::geometry_type const& geom = feature->get_geometry(0);
+            for (unsigned i = 0; i < geom.num_points(); ++i)
+            {
+                double x, y;
+                geom.get_vertex(i, &x, &y);
+                if (box_.contains(x, y)) return feature;
+            }
+        }
+        return mapnik::feature_ptr();
+    }
+private:
+    mapnik::featureset_ptr features_;
+    mapnik::box2d<double> box_;
+};
+
+class geometry_datasource : public counting_datasource
+{
+public:
+    mapnik::featureset_ptr features(mapnik::query const& q) const
+    {
+        return boost::make_shared<vertex_featureset>(counting_datasource::features(q), q.get_bbox());
+    }
+};
+
+// numbers the features of every query from 1, like postgis without a
+// key_field, and adds a feature without geometry, like a table row with
+// a NULL geometry
+class renumbering_featureset : public mapnik::Featureset
+{
+public:
+    explicit renumbering_featureset(mapnik::featureset_ptr features)
+        : features_(features), id_(0), done_(false) {}
+    mapnik::feature_ptr next()
+    {
+        mapnik::feature_ptr feature;
+        if (features_ && (feature = features_->next()))
+        {
+            mapnik::feature_ptr copy = boost::make_shared<mapnik::Feature>(feature->context(), ++id_);
+            copy->put("name", feature->get("name"));
+            for (unsigned i = 0; i < feature->num_geometries(); ++i)
+            {
+                mapnik::geometry_type const& geom = feature->get_geometry(i);
+                mapnik::geometry_type * geom_copy = new mapnik::geometry_type(geom.type());
+                double x, y;
+                for (unsigned pos = 0; pos < geom.num_points(); ++pos)
+                {
+                    unsigned cmd = geom.get_vertex(pos, &x, &y);
+                    geom_copy->push_vertex(x, y, static_cast<mapnik::CommandType>(cmd));
+                }
+                copy->add_geometry(geom_copy);
+            }
+            return copy;
+        }
+        if (!done_)
+        {
+            done_ = true;
+            mapnik::context_ptr ctx = boost::make_shared<mapnik::context_type>();
+            ctx->push("name");
+            mapnik::feature_ptr row = boost::make_shared<mapnik::Feature>(ctx, ++id_);
+            row->put("name", UnicodeString::fromUTF8("no geometry"));
+            return row;
+        }
+        return mapnik::feature_ptr();
+    }
+private:
+    mapnik::featureset_ptr features_;
+    int id_;
+    bool done_;
+};
+
+class renumbering_datasource : public counting_datasource
+{
+public:
+    mapnik::featureset_ptr features(mapnik::query const& q) const
+    {
+        return boost::make_shared<renumbering_featureset>(counting_datasource::features(q));
+    }
+};
+
+typedef std::map<int, std::pair<std::string, unsigned> > feature_map;
+
+// name -> how many times it came
+typedef std::map<std::string, unsigned> name_map;
+
+void count_names(mapnik::featureset_ptr features, name_map & result)
+{
+    mapnik::feature_ptr feature;
+    while (features && (feature = features->next()))
+    {
+        ++result[feature->get("name").to_string()];
+    }
+}
+
+// id -> (name, number of points), and whether any id came twice
+bool read_all(mapnik::featureset_ptr features, feature_map & result)
+{
+    bool unique = true;
+    mapnik::feature_ptr feature;
+    while (features && (feature = features->next()))
+    {
+        unsigned points = 0;
+        for (unsigned i = 0; i < feature->num_geometries(); ++i)
+        {
+            points += feature->get_geometry(i).num_points();
+        }
+        std::string name = feature->get("name").to_string();
+        unique = result.insert(std::make_pair(feature->id(), std::make_pair(name, points))).second && unique;
+    }
+    return unique;
+}
+
+void fill(mapnik::memory_datasource & ds)
+{
+    mapnik::context_ptr ctx = boost::make_shared<mapnik::context_type>();
+    ctx->push("name");
+    int id = 1;
+    // points on a grid, some right on cell edges, and lines across cells
+    for (int y = -40; y <= 40; y += 4)
+    {
+        for (int x = -40; x <= 40; x += 4)
+        {
+            mapnik::feature_ptr feature = boost::make_shared<mapnik::Feature>(ctx, id);
+            feature->put("name", UnicodeString::fromUTF8("p" + boost::lexical_cast<std::string>(id)));
+            mapnik::geometry_type * pt = new mapnik::geometry_type(mapnik::Point);
+            pt->move_to(x, y);
+            feature->add_geometry(pt);
+            ds.push(feature);
+            ++id;
+        }
+        mapnik::feature_ptr feature = boost::make_shared<mapnik::Feature>(ctx, id);
+        feature->put("name", UnicodeString::fromUTF8("l" + boost::lexical_cast<std::string>(id)));
+        mapnik::geometry_type * line = new mapnik::geometry_type(mapnik::LineString);
+        line->move_to(-50, y + 1);
+        line->line_to(3, y + 2);
+        line->line_to(50, y + 1);
+        feature->add_geometry(line);
+        ds.push(feature);
+        ++id;
+    }
+}
+
+mapnik::query make_query(mapnik::box2d<double> const& box)
+{
+    mapnik::query q(box, mapnik::query::resolution_type(1.0, 1.0), 1000.0);
+    q.add_property_name("name");
+    return q;
+}
+
+}
+
+int main( int, char** )
+{
+    counting_datasource ds;
+    fill(ds);
+
+    mapnik::feature_cache & cache = *mapnik::feature_cache::instance();
+    cache.clear();
+
+    mapnik::box2d<double> boxes[] = {
+        mapnik::box2d<double>(-13, -7, 6, 9),
+        mapnik::box2d<double>(6, -7, 25, 9),    // the neighbour
+        mapnik::box2d<double>(-13, 9, 6, 25),
+        mapnik::box2d<double>(-32, -32, -16, -16),
+        mapnik::box2d<double>(0, 0, 0.5, 0.5)
+    };
+    for (unsigned i = 0; i < sizeof(boxes) / sizeof(boxes[0]); ++i)
+    {
+        feature_map expected, cached;
+        read_all(ds.features(make_query(boxes[i])), expected);
+        BOOST_TEST(read_all(cache.features(ds, make_query(boxes[i])), cached));
+        BOOST_TEST(!expected.empty());
+        BOOST_TEST(cached == expected);
+    }
+
+    // the same query again and its neighbour read nothing new
+    unsigned before = ds.queries;
+    feature_map again;
+    read_all(cache.features(ds, make_query(boxes[0])), again);
+    read_all(cache.features(ds, make_query(mapnik::box2d<double>(7, -6, 24, 8))), again);
+    BOOST_TEST(ds.queries == before);
+    BOOST_TEST(cache.size() > 0);
+
+    // other attributes are other cells
+    mapnik::query q = make_query(boxes[0]);
+    q.add_property_name("other");
+    read_all(cache.features(ds, q), again);
+    BOOST_TEST(ds.queries > before);
+
+    cache.clear();
+    BOOST_TEST(cache.size() == 0);
+
+    // datasources returning more or fewer features than the envelopes
+    // meet: every feature the query should get comes once, nothing else
+    padded_datasource padded;
+    fill(padded);
+    geometry_datasource geometry;
+    fill(geometry);
+    for (unsigned i = 0; i < sizeof(boxes) / sizeof(boxes[0]); ++i)
+    {
+        feature_map exact, cached;
+        read_all(ds.features(make_query(boxes[i])), exact);
+        BOOST_TEST(read_all(cache.features(padded, make_query(boxes[i])), cached));
+        BOOST_TEST(cached == exact);
+
+        feature_map direct;
+        cached.clear();
+        read_all(geometry.features(make_query(boxes[i])), direct);
+        BOOST_TEST(read_all(cache.features(geometry, make_query(boxes[i])), cached));
+        for (feature_map::const_iterator itr = direct.begin(); itr != direct.end(); ++itr)
+        {
+            BOOST_TEST(cached.count(itr->first) == 1);
+        }
+        for (feature_map::const_iterator itr = cached.begin(); itr != cached.end(); ++itr)
+        {
+            BOOST_TEST(exact.count(itr->first) == 1);
+        }
+    }
+    cache.clear();
+
+    // ids numbered per query don't tell features apart, those spanning
+    // several cells still come once, those without geometry are kept
+    renumbering_datasource renumbering;
+    fill(renumbering);
+    for (unsigned i = 0; i < sizeof(boxes) / sizeof(boxes[0]); ++i)
+    {
+        name_map direct, cached;
+        count_names(renumbering.features(make_query(boxes[i])), direct);
+        count_names(cache.features(renumbering, make_query(boxes[i])), cached);
+        BOOST_TEST(direct.count("no geometry") == 1);
+        BOOST_TEST(cached == direct);
+    }
+    cache.clear();
+
+    if (!::boost::detail::test_errors()) {
+        std::clog << "C++ feature cache: \x1b[1;32m✓ \x1b[0m\n";
+    } else {
+        return ::boost::report_errors();
+    }
+}
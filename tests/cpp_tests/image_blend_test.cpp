@@ -0,0 +1,139 @@
+#include <boost/detail/lightweight_test.hpp>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <mapnik/graphics.hpp>
+#include <mapnik/image_blend.hpp>
+#include <mapnik/raster.hpp>
+#include <mapnik/warp.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+
+// Checks the SSE2/AVX2 raster kernels against the scalar code, the timings
+// are in benchmark/ (`mapnik-bench --simd LEVEL blend`).
+
+namespace {
+
+void fill_random(mapnik::image_data_32 & data, unsigned seed)
+{
+    std::srand(seed);
+    for (unsigned y = 0; y < data.height(); ++y)
+    {
+        unsigned * row = data.getRow(y);
+        for (unsigned x = 0; x < data.width(); ++x)
+        {
+            unsigned r = std::rand() & 0xff;
+            unsigned g = std::rand() & 0xff;
+            unsigned b = std::rand() & 0xff;
+            unsigned a = std::rand() & 0xff;
+            // make fully transparent and fully opaque pixels common
+            switch (std::rand() % 8)
+            {
+            case 0: a = 0; break;
+            case 1: a = 255; break;
+            default: break;
+            }
+            row[x] = (a << 24) | (b << 16) | (g << 8) | r;
+        }
+    }
+}
+
+bool same(mapnik::image_data_32 const& a, mapnik::image_data_32 const& b)
+{
+    return a.width() == b.width() && a.height() == b.height() &&
+        std::memcmp(a.getData(), b.getData(), a.width() * a.height() * 4) == 0;
+}
+
+void blend(mapnik::image_32 & im, mapnik::image_data_32 const& src, mapnik::blend_mode_e mode, float opacity)
+{
+    // odd offset so rows start unaligned and leave a scalar tail
+    switch (mode)
+    {
+    case mapnik::BLEND_ALPHA: im.set_rectangle_alpha2(src, 3, 1, opacity); break;
+    case mapnik::BLEND_MULTIPLY: im.merge_rectangle<mapnik::Multiply>(src, 3, 1, opacity); break;
+    case mapnik::BLEND_MULTIPLY2: im.merge_rectangle<mapnik::Multiply2>(src, 3, 1, opacity); break;
+    case mapnik::BLEND_DIVIDE: im.merge_rectangle<mapnik::Divide>(src, 3, 1, opacity); break;
+    case mapnik::BLEND_DIVIDE2: im.merge_rectangle<mapnik::Divide2>(src, 3, 1, opacity); break;
+    case mapnik::BLEND_SCREEN: im.merge_rectangle<mapnik::Screen>(src, 3, 1, opacity); break;
+    case mapnik::BLEND_HARD_LIGHT: im.merge_rectangle<mapnik::HardLight>(src, 3, 1, opacity); break;
+    case mapnik::BLEND_MERGE_GRAIN: im.merge_rectangle<mapnik::MergeGrain>(src, 3, 1, opacity); break;
+    case mapnik::BLEND_MERGE_GRAIN2: im.merge_rectangle<mapnik::MergeGrain2>(src, 3, 1, opacity); break;
+    }
+}
+
+void warp(mapnik::raster & target, mapnik::raster const& source, std::string const& method)
+{
+    mapnik::projection src_prj("+proj=longlat +ellps=WGS84 +datum=WGS84 +no_defs");
+    mapnik::projection dst_prj("+proj=merc +a=6378137 +b=6378137 +lat_ts=0.0 +lon_0=0.0 +x_0=0.0 +y_0=0 +k=1.0 +units=m +nadgrids=@null +no_defs");
+    mapnik::proj_transform prj_trans(dst_prj, src_prj);
+    std::memset(target.data_.getData(), 0, target.data_.width() * target.data_.height() * 4);
+    mapnik::reproject_raster(target, source, prj_trans, 0.0, 0.0, 16, 2.0, 1.0, method);
+}
+
+const char* mode_names[] = { "alpha", "multiply", "multiply2", "divide", "divide2",
+                             "screen", "hard-light", "merge-grain", "merge-grain2" };
+const char* level_names[] = { "scalar", "sse2", "avx2" };
+
+}
+
+int main( int, char** )
+{
+    mapnik::simd_level_e detected = mapnik::get_simd_level();
+    unsigned size = 67;
+
+    mapnik::image_data_32 src(size, size);
+    mapnik::image_data_32 dst(size + 5, size + 3);
+    fill_random(src, 1);
+    fill_random(dst, 2);
+
+    float opacities[] = { 1.0f, 0.5f, 0.03f };
+    for (unsigned m = mapnik::BLEND_ALPHA; m <= mapnik::BLEND_MERGE_GRAIN2; ++m)
+    {
+        mapnik::blend_mode_e mode = static_cast<mapnik::blend_mode_e>(m);
+        for (unsigned o = 0; o < sizeof(opacities) / sizeof(float); ++o)
+        {
+            mapnik::set_simd_level(mapnik::SIMD_NONE);
+            mapnik::image_32 expected(dst.width(), dst.height());
+            expected.set_rectangle(0, 0, dst);
+            blend(expected, src, mode, opacities[o]);
+
+            for (unsigned l = mapnik::SIMD_SSE2; l <= detected; ++l)
+            {
+                mapnik::set_simd_level(static_cast<mapnik::simd_level_e>(l));
+                mapnik::image_32 im(dst.width(), dst.height());
+                im.set_rectangle(0, 0, dst);
+                blend(im, src, mode, opacities[o]);
+                BOOST_TEST(same(expected.data(), im.data()));
+                if (!same(expected.data(), im.data()))
+                {
+                    std::clog << mode_names[m] << " differs at " << level_names[l]
+                              << " opacity " << opacities[o] << "\n";
+                }
+            }
+        }
+    }
+
+    mapnik::box2d<double> src_ext(-20, 20, 20, 60);
+    mapnik::box2d<double> dst_ext(-2226389.8, 2273030.9, 2226389.8, 8399737.9);
+    mapnik::raster source(src_ext, src);
+    const char* methods[] = { "bilinear", "bicubic", "lanczos" };
+    for (unsigned i = 0; i < sizeof(methods) / sizeof(const char*); ++i)
+    {
+        mapnik::set_simd_level(mapnik::SIMD_NONE);
+        mapnik::raster expected(dst_ext, mapnik::image_data_32(size, size));
+        warp(expected, source, methods[i]);
+
+        mapnik::set_simd_level(detected);
+        mapnik::raster target(dst_ext, mapnik::image_data_32(size, size));
+        warp(target, source, methods[i]);
+        BOOST_TEST(same(expected.data_, target.data_));
+    }
+
+    mapnik::set_simd_level(detected);
+
+    if (!::boost::detail::test_errors()) {
+        std::clog << "C++ raster blending: \x1b[1;32m✓ \x1b[0m\n";
+    } else {
+        return ::boost::report_errors();
+    }
+}
@@ -0,0 +1,249 @@
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/make_shared.hpp>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cstdlib>
+#include <mapnik/layer_render_cache.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/graphics.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/expression_node.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include "counting_datasource.hpp"
+
+// Checks that rendered layers come back from the layer render cache, from
+// memory and from its directory, with their pixels and labels, that the
+// collision detector records the labels of a layer, and that maps render
+// the same with the cache off, cold and warm, also when the labels placed
+// before a cached layer change.
+
+namespace {
+
+bool same(mapnik::cached_layer const& a, mapnik::cached_layer const& b)
+{
+    if (a.image.width() != b.image.width() || a.image.height() != b.image.height() ||
+        a.painted != b.painted || a.labels.size() != b.labels.size())
+    {
+        return false;
+    }
+    for (unsigned i = 0; i < a.labels.size(); ++i)
+    {
+        if (a.labels[i].box != b.labels[i].box || a.labels[i].text != b.labels[i].text) return false;
+    }
+    return std::memcmp(a.image.getBytes(), b.image.getBytes(), a.image.width() * a.image.height() * 4) == 0;
+}
+
+void add_feature(mapnik::memory_datasource & ds, int id, std::string const& name,
+                 double x, double y, double size)
+{
+    mapnik::context_ptr ctx = boost::make_shared<mapnik::context_type>();
+    ctx->push("name");
+    mapnik::feature_ptr feature = boost::make_shared<mapnik::Feature>(ctx, id);
+    feature->put("name", UnicodeString::fromUTF8(name));
+    mapnik::geometry_type * geom = new mapnik::geometry_type(size > 0 ? mapnik::Polygon : mapnik::Point);
+    geom->move_to(x, y);
+    if (size > 0)
+    {
+        geom->line_to(x + size, y);
+        geom->line_to(x + size, y + size);
+        geom->line_to(x, y + size);
+        geom->line_to(x, y);
+    }
+    feature->add_geometry(geom);
+    ds.push(feature);
+}
+
+mapnik::feature_type_style label_style(bool fill)
+{
+    mapnik::rule r;
+    if (fill)
+    {
+        mapnik::polygon_symbolizer poly(mapnik::color(200, 100, 50));
+        poly.set_opacity(0.7);
+        r.append(poly);
+    }
+    mapnik::expression_ptr name = boost::make_shared<mapnik::expr_node>(mapnik::attribute("name"));
+    r.append(mapnik::text_symbolizer(name, "DejaVu Sans Book", 14, mapnik::color(0, 0, 0)));
+    mapnik::feature_type_style style;
+    style.add_rule(r);
+    return style;
+}
+
+// Rendering a layer on its own and compositing it rounds translucent
+// pixels a little differently than drawing onto the map directly.
+bool near(std::string const& a, std::string const& b)
+{
+    if (a.size() != b.size()) return false;
+    for (unsigned i = 0; i < a.size(); ++i)
+    {
+        if (std::abs(static_cast<unsigned char>(a[i]) - static_cast<unsigned char>(b[i])) > 2) return false;
+    }
+    return true;
+}
+
+// renders m, returns the pixels and whether the last layer came from the cache
+std::string render(mapnik::Map const& m, bool & cached)
+{
+    mapnik::image_32 image(m.width(), m.height());
+    mapnik::agg_renderer<mapnik::image_32> ren(m, image);
+    mapnik::render_stats stats;
+    ren.set_stats(&stats);
+    ren.apply();
+    cached = !stats.layers.empty() && stats.layers.back().cached;
+    return std::string(reinterpret_cast<char const*>(image.raw_data()), m.width() * m.height() * 4);
+}
+
+}
+
+int main( int, char** )
+{
+    mapnik::layer_render_cache & cache = *mapnik::layer_render_cache::instance();
+
+    mapnik::label_collision_detector4 detector(mapnik::box2d<double>(0, 0, 64, 48));
+    detector.insert(mapnik::box2d<double>(0, 0, 5, 5));
+
+    mapnik::cached_layer_ptr layer = boost::make_shared<mapnik::cached_layer>(64, 48);
+    for (unsigned y = 0; y < 48; ++y)
+    {
+        for (unsigned x = 0; x < 64; ++x)
+        {
+            layer->image(x, y) = (x * 7 + y * 13) | ((x ^ y) << 24);
+        }
+    }
+    layer->painted = true;
+    detector.record(&layer->labels);
+    detector.insert(mapnik::box2d<double>(10, 10, 30, 20), UnicodeString("Ocean"));
+    detector.insert(mapnik::box2d<double>(40, 5, 44, 9));
+    detector.record(0);
+    detector.insert(mapnik::box2d<double>(50, 40, 60, 45));
+    BOOST_TEST(layer->labels.size() == 2);
+    BOOST_TEST(layer->labels.size() == 2 && layer->labels[0].text == UnicodeString("Ocean"));
+
+    // memory only
+    cache.set_directory("");
+    cache.clear();
+    BOOST_TEST(!cache.find("ocean", 64, 48));
+    cache.insert("ocean", layer);
+    boost::optional<mapnik::cached_layer_ptr> found = cache.find("ocean", 64, 48);
+    BOOST_TEST(found && *found == layer);
+    BOOST_TEST(!cache.find("ocean2", 64, 48));
+    BOOST_TEST(!cache.find("ocean", 64, 64));
+
+    // bounded by the pixels
+    cache.set_capacity(64 * 48 * 4);
+    BOOST_TEST(!cache.find("ocean", 64, 48));
+    cache.set_capacity(128 * 1024 * 1024);
+
+    // read back from the directory once dropped from memory
+    boost::filesystem::path dir = boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("mapnik-layer-cache-%%%%-%%%%");
+    boost::filesystem::create_directories(dir);
+    cache.set_directory(dir.string());
+    cache.insert("ocean", layer);
+    cache.clear();
+    found = cache.find("ocean", 64, 48);
+    BOOST_TEST(found && *found != layer && same(**found, *layer));
+    // other keys and sizes miss, in memory and on disk
+    cache.clear();
+    BOOST_TEST(!cache.find("ocean ", 64, 48));
+    BOOST_TEST(!cache.find("ocean", 48, 64));
+
+    // damaged files are ignored rather than sized from: a huge label
+    // count, a huge image, labels running past the end, a truncated file
+    boost::filesystem::path file = boost::filesystem::directory_iterator(dir)->path();
+    std::string good;
+    {
+        std::ifstream in(file.string().c_str(), std::ios::binary);
+        good.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    // magic, key size, "ocean", width, height, painted, label count, and
+    // the first label's box and text length
+    std::size_t const width_at = 13, count_at = 25, text_length_at = 29 + 32;
+    boost::uint32_t const huge = 0xffffffff;
+    std::size_t const offsets[] = { count_at, width_at, width_at + 4, text_length_at };
+    for (unsigned i = 0; i <= sizeof(offsets) / sizeof(offsets[0]); ++i)
+    {
+        std::string damaged = good;
+        if (i < sizeof(offsets) / sizeof(offsets[0]))
+        {
+            damaged.replace(offsets[i], 4, reinterpret_cast<char const*>(&huge), 4);
+        }
+        else
+        {
+            damaged.resize(damaged.size() - 1);
+        }
+        {
+            std::ofstream out(file.string().c_str(), std::ios::binary | std::ios::trunc);
+            out.write(damaged.data(), damaged.size());
+        }
+        cache.clear();
+        BOOST_TEST(!cache.find("ocean", 64, 48));
+    }
+
+    cache.set_directory("");
+    cache.clear();
+    boost::filesystem::remove_all(dir);
+
+    // a labelled layer below a cached one with labels and translucent fills
+    mapnik::freetype_engine::register_font("fonts/dejavu-fonts-ttf-2.33/ttf/DejaVuSans.ttf");
+    mapnik::Map m(256, 256);
+    m.set_background(mapnik::color(240, 240, 255));
+    m.insert_style("labels", label_style(false));
+    m.insert_style("areas", label_style(true));
+    boost::shared_ptr<mapnik::memory_datasource> points = boost::make_shared<mapnik::memory_datasource>();
+    add_feature(*points, 1, "Harbour", 30, 30, 0);
+    add_feature(*points, 2, "Lighthouse", 80, 90, 0);
+    boost::shared_ptr<counting_datasource> areas = boost::make_shared<counting_datasource>();
+    add_feature(*areas, 1, "Bay", 20, 20, 20);
+    add_feature(*areas, 2, "Island", 50, 50, 30);
+    add_feature(*areas, 3, "Reef", 70, 10, 15);
+    mapnik::layer first("points");
+    first.set_datasource(points);
+    first.add_style("labels");
+    m.addLayer(first);
+    mapnik::layer second("areas");
+    second.set_datasource(areas);
+    second.add_style("areas");
+    m.addLayer(second);
+    m.zoom_to_box(mapnik::box2d<double>(0, 0, 100, 100));
+
+    bool hit = true;
+    std::string uncached = render(m, hit);
+    BOOST_TEST(!hit);
+    m.getLayer(1).set_cache_rendering(true);
+    std::string cold = render(m, hit);
+    BOOST_TEST(!hit);
+    BOOST_TEST(near(cold, uncached));
+    unsigned queries = areas->queries;
+    std::string warm = render(m, hit);
+    BOOST_TEST(hit);
+    BOOST_TEST(areas->queries == queries);
+    BOOST_TEST(warm == cold);
+
+    // other labels below: the cached rendering placed its labels against
+    // the old ones and is not reused
+    add_feature(*points, 3, "Island Pier", 65, 65, 0);
+    m.getLayer(1).set_cache_rendering(false);
+    uncached = render(m, hit);
+    BOOST_TEST(!near(uncached, warm));
+    m.getLayer(1).set_cache_rendering(true);
+    cold = render(m, hit);
+    BOOST_TEST(!hit);
+    BOOST_TEST(near(cold, uncached));
+    warm = render(m, hit);
+    BOOST_TEST(hit);
+    BOOST_TEST(warm == cold);
+    cache.clear();
+
+    if (!::boost::detail::test_errors()) {
+        std::clog << "C++ layer render cache: \x1b[1;32m✓ \x1b[0m\n";
+    } else {
+        return ::boost::report_errors();
+    }
+}
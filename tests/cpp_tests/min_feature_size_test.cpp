@@ -0,0 +1,142 @@
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/make_shared.hpp>
+#include <iostream>
+#include <mapnik/map.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/graphics.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature.hpp>
+
+// Checks that with a layer min-feature-size, polygons and lines smaller
+// than it on screen are drawn as their screen bbox, and the stroke around
+// it for lines, while larger ones are drawn as they are.
+
+namespace {
+
+// a feature with one geometry through the n points in xy
+void add_feature(mapnik::memory_datasource & ds, mapnik::eGeomType type,
+                 double const* xy, unsigned n)
+{
+    mapnik::context_ptr ctx = boost::make_shared<mapnik::context_type>();
+    mapnik::feature_ptr feature = boost::make_shared<mapnik::Feature>(ctx, ds.size() + 1);
+    mapnik::geometry_type * geom = new mapnik::geometry_type(type);
+    geom->move_to(xy[0], xy[1]);
+    for (unsigned i = 1; i < n; ++i)
+    {
+        geom->line_to(xy[2 * i], xy[2 * i + 1]);
+    }
+    feature->add_geometry(geom);
+    ds.push(feature);
+}
+
+void add_box(mapnik::memory_datasource & ds, double minx, double miny, double maxx, double maxy)
+{
+    double xy[] = { minx, miny, maxx, miny, maxx, maxy, minx, maxy, minx, miny };
+    add_feature(ds, mapnik::Polygon, xy, 5);
+}
+
+// a map of the polygons filled red and the lines stroked blue, 2px wide
+mapnik::Map make_map(boost::shared_ptr<mapnik::memory_datasource> const& polygons,
+                     boost::shared_ptr<mapnik::memory_datasource> const& lines,
+                     double min_size)
+{
+    mapnik::Map m(100, 100);
+    m.set_background(mapnik::color(255, 255, 255));
+
+    mapnik::rule fill;
+    fill.append(mapnik::polygon_symbolizer(mapnik::color(200, 0, 0)));
+    mapnik::feature_type_style fill_style;
+    fill_style.add_rule(fill);
+    m.insert_style("fill", fill_style);
+
+    mapnik::rule stroke;
+    stroke.append(mapnik::line_symbolizer(mapnik::stroke(mapnik::color(0, 0, 200), 2.0)));
+    mapnik::feature_type_style stroke_style;
+    stroke_style.add_rule(stroke);
+    m.insert_style("stroke", stroke_style);
+
+    mapnik::layer lyr("polygons");
+    lyr.set_datasource(polygons);
+    lyr.add_style("fill");
+    lyr.set_min_feature_size(min_size);
+    m.addLayer(lyr);
+    if (lines)
+    {
+        mapnik::layer line_lyr("lines");
+        line_lyr.set_datasource(lines);
+        line_lyr.add_style("stroke");
+        line_lyr.set_min_feature_size(min_size);
+        m.addLayer(line_lyr);
+    }
+    m.zoom_to_box(mapnik::box2d<double>(0, 0, 100, 100));
+    return m;
+}
+
+std::string render(mapnik::Map const& m)
+{
+    mapnik::image_32 image(m.width(), m.height());
+    mapnik::agg_renderer<mapnik::image_32> ren(m, image);
+    ren.apply();
+    return std::string(reinterpret_cast<char const*>(image.raw_data()), m.width() * m.height() * 4);
+}
+
+}
+
+int main( int, char** )
+{
+    // one map unit is one pixel
+    double small_triangle[] = { 10, 10, 11.5, 10, 10.5, 11.5, 10, 10 };
+    double large_triangle[] = { 40, 40, 90, 45, 60, 90, 40, 40 };
+    double small_line[] = { 20.25, 70.25, 21, 71.5, 21.75, 70.5 };
+    double long_line[] = { 5, 95, 95, 60 };
+    double thin_line[] = { 30, 70, 31, 80 };
+
+    boost::shared_ptr<mapnik::memory_datasource> polygons = boost::make_shared<mapnik::memory_datasource>();
+    add_feature(*polygons, mapnik::Polygon, small_triangle, 4);
+    add_feature(*polygons, mapnik::Polygon, large_triangle, 4);
+    boost::shared_ptr<mapnik::memory_datasource> lines = boost::make_shared<mapnik::memory_datasource>();
+    add_feature(*lines, mapnik::LineString, small_line, 3);
+    add_feature(*lines, mapnik::LineString, long_line, 2);
+
+    std::string off = render(make_map(polygons, lines, 0.0));
+    std::string on = render(make_map(polygons, lines, 3.0));
+    BOOST_TEST(on != off);
+
+    // the small triangle filled as its bbox, the small line as its bbox
+    // grown by half the stroke width, filled with the stroke colour
+    boost::shared_ptr<mapnik::memory_datasource> polygons_as_boxes = boost::make_shared<mapnik::memory_datasource>();
+    add_box(*polygons_as_boxes, 10, 10, 11.5, 11.5);
+    add_feature(*polygons_as_boxes, mapnik::Polygon, large_triangle, 4);
+    boost::shared_ptr<mapnik::memory_datasource> lines_as_boxes = boost::make_shared<mapnik::memory_datasource>();
+    add_feature(*lines_as_boxes, mapnik::LineString, long_line, 2);
+    mapnik::Map expected = make_map(polygons_as_boxes, lines_as_boxes, 0.0);
+    boost::shared_ptr<mapnik::memory_datasource> stroke_box = boost::make_shared<mapnik::memory_datasource>();
+    add_box(*stroke_box, 19.25, 69.25, 22.75, 72.5);
+    mapnik::layer stroke_lyr("stroke box");
+    stroke_lyr.set_datasource(stroke_box);
+    stroke_lyr.add_style("stroke fill");
+    mapnik::rule stroke_fill;
+    stroke_fill.append(mapnik::polygon_symbolizer(mapnik::color(0, 0, 200)));
+    mapnik::feature_type_style stroke_fill_style;
+    stroke_fill_style.add_rule(stroke_fill);
+    expected.insert_style("stroke fill", stroke_fill_style);
+    expected.addLayer(stroke_lyr);
+    BOOST_TEST(on == render(expected));
+
+    // features at least as wide or as tall as the threshold, however thin:
+    // drawn the same either way
+    boost::shared_ptr<mapnik::memory_datasource> large = boost::make_shared<mapnik::memory_datasource>();
+    add_feature(*large, mapnik::Polygon, large_triangle, 4);
+    add_box(*large, 10, 10, 13, 11);
+    boost::shared_ptr<mapnik::memory_datasource> long_lines = boost::make_shared<mapnik::memory_datasource>();
+    add_feature(*long_lines, mapnik::LineString, long_line, 2);
+    add_feature(*long_lines, mapnik::LineString, thin_line, 2);
+    BOOST_TEST(render(make_map(large, long_lines, 0.0)) == render(make_map(large, long_lines, 3.0)));
+
+    if (!::boost::detail::test_errors()) {
+        std::clog << "C++ min feature size: \x1b[1;32m✓ \x1b[0m\n";
+    } else {
+        return ::boost::report_errors();
+    }
+}
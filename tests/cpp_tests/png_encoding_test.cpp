@@ -0,0 +1,226 @@
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <mapnik/graphics.hpp>
+#include <mapnik/image_view.hpp>
+#include <mapnik/png_io.hpp>
+#include <mapnik/image_util.hpp>
+
+// Checks that pngs deflated in parallel strips decode to the same pixels
+// as the libpng writer, that tiles written with a metatile palette match
+// the metatile, and, when run with `--bench [iterations]`, compares sizes
+// and times of both writers across compression levels and strategies.
+
+namespace {
+
+void fill_tile(mapnik::image_data_32 & data, unsigned seed)
+{
+    // flat areas, gradients and some noise, roughly what map tiles hold
+    std::srand(seed);
+    for (unsigned y = 0; y < data.height(); ++y)
+    {
+        unsigned * row = data.getRow(y);
+        for (unsigned x = 0; x < data.width(); ++x)
+        {
+            unsigned r, g, b, a = 255;
+            if (y < data.height() / 3)
+            {
+                r = 0xf2; g = 0xef; b = 0xe9;
+            }
+            else if (y < 2 * data.height() / 3)
+            {
+                r = x & 0xff; g = y & 0xff; b = (x + y) & 0xff;
+                a = (x / 16) % 2 ? 255 : 128;
+            }
+            else
+            {
+                r = std::rand() & 0xff; g = std::rand() & 0xff; b = std::rand() & 0xff;
+                a = std::rand() % 4 ? 255 : 0;
+            }
+            row[x] = (a << 24) | (b << 16) | (g << 8) | r;
+        }
+    }
+}
+
+struct png_memory
+{
+    std::string const& data;
+    std::size_t pos;
+};
+
+void read_data(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+    png_memory * in = static_cast<png_memory*>(png_get_io_ptr(png_ptr));
+    if (in->pos + length > in->data.size()) png_error(png_ptr, "read past end");
+    std::memcpy(data, in->data.data() + in->pos, length);
+    in->pos += length;
+}
+
+// decode to rgba with libpng, empty on any error
+std::vector<unsigned char> decode(std::string const& png)
+{
+    std::vector<unsigned char> pixels;
+    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+    png_infop info_ptr = png_create_info_struct(png_ptr);
+    png_memory in = { png, 0 };
+    if (setjmp(png_jmpbuf(png_ptr)))
+    {
+        png_destroy_read_struct(&png_ptr, &info_ptr, 0);
+        return std::vector<unsigned char>();
+    }
+    png_set_read_fn(png_ptr, &in, read_data);
+    png_read_info(png_ptr, info_ptr);
+    png_set_packing(png_ptr);
+    png_set_palette_to_rgb(png_ptr);
+    if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) png_set_tRNS_to_alpha(png_ptr);
+    png_set_filler(png_ptr, 0xff, PNG_FILLER_AFTER);
+    png_read_update_info(png_ptr, info_ptr);
+    unsigned height = png_get_image_height(png_ptr, info_ptr);
+    unsigned row_bytes = png_get_rowbytes(png_ptr, info_ptr);
+    pixels.resize(height * row_bytes);
+    for (unsigned y = 0; y < height; ++y)
+    {
+        png_read_row(png_ptr, &pixels[y * row_bytes], 0);
+    }
+    png_read_end(png_ptr, 0);
+    png_destroy_read_struct(&png_ptr, &info_ptr, 0);
+    return pixels;
+}
+
+std::string encode(mapnik::image_data_32 const& image, std::string const& format,
+                   int compression, int strategy, unsigned threads)
+{
+    std::ostringstream ss(std::ios::out|std::ios::binary);
+    if (format == "png8")
+        mapnik::save_as_png8_hex(ss, image, 256, compression, strategy, -1, 2.0, threads);
+    else if (format == "png4")
+        mapnik::save_as_png8_oct(ss, image, 16, compression, strategy, -1, threads);
+    else
+        mapnik::save_as_png(ss, image, compression, strategy, threads);
+    return ss.str();
+}
+
+double now()
+{
+    boost::posix_time::ptime t = boost::posix_time::microsec_clock::local_time();
+    return (t - boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1))).total_microseconds() / 1000.0;
+}
+
+const char* formats[] = { "png", "png8", "png4" };
+const int levels[] = { 1, 6, 9 };
+const int strategies[] = { Z_DEFAULT_STRATEGY, Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE };
+const char* strategy_names[] = { "default", "filtered", "huff", "rle" };
+
+}
+
+int main( int argc, char** argv )
+{
+    bool bench = argc > 1 && std::strcmp(argv[1], "--bench") == 0;
+    unsigned iterations = (bench && argc > 2) ? std::atoi(argv[2]) : 20;
+
+    // odd sizes so strips end mid image and 4 bit rows are padded
+    unsigned sizes[][2] = { { 256, 256 }, { 509, 301 }, { 3, 1 } };
+    for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        mapnik::image_data_32 image(sizes[s][0], sizes[s][1]);
+        fill_tile(image, s + 1);
+        for (unsigned f = 0; f < sizeof(formats) / sizeof(const char*); ++f)
+        {
+            for (unsigned l = 0; l < sizeof(levels) / sizeof(int); ++l)
+            {
+                std::string expected = encode(image, formats[f], levels[l], Z_DEFAULT_STRATEGY, 1);
+                std::vector<unsigned char> expected_pixels = decode(expected);
+                BOOST_TEST(!expected_pixels.empty());
+                unsigned thread_counts[] = { 0, 2, 7 };
+                for (unsigned t = 0; t < sizeof(thread_counts) / sizeof(unsigned); ++t)
+                {
+                    std::string png = encode(image, formats[f], levels[l], Z_DEFAULT_STRATEGY, thread_counts[t]);
+                    BOOST_TEST(decode(png) == expected_pixels);
+                    if (decode(png) != expected_pixels)
+                    {
+                        std::clog << formats[f] << " " << sizes[s][0] << "x" << sizes[s][1]
+                                  << " z=" << levels[l] << " p=" << thread_counts[t] << " differs\n";
+                    }
+                }
+            }
+        }
+        // the format string reaches the strip encoder
+        std::string png = mapnik::save_to_string(image, "png:p=3:z=1");
+        BOOST_TEST(decode(png) == decode(encode(image, "png", 1, Z_DEFAULT_STRATEGY, 1)));
+    }
+
+    // every tile of a metatile quantized with one palette looks like the
+    // matching part of the whole metatile
+    {
+        mapnik::image_data_32 metatile(512, 512);
+        fill_tile(metatile, 4);
+        mapnik::rgba_palette pal(mapnik::make_palette_hex(metatile), mapnik::rgba_palette::PALETTE_RGBA);
+        std::ostringstream ss(std::ios::out|std::ios::binary);
+        mapnik::save_as_png8_pal(ss, metatile, pal);
+        std::vector<unsigned char> whole = decode(ss.str());
+        BOOST_TEST(whole.size() == 512 * 512 * 4);
+        for (unsigned y = 0; y < 512 && whole.size() == 512 * 512 * 4; y += 256)
+        {
+            for (unsigned x = 0; x < 512; x += 256)
+            {
+                mapnik::image_view<mapnik::image_data_32> view(x, y, 256, 256, metatile);
+                std::vector<unsigned char> tile = decode(mapnik::save_to_string(view, "png256", pal));
+                bool same = tile.size() == 256 * 256 * 4;
+                for (unsigned row = 0; same && row < 256; ++row)
+                {
+                    same = std::memcmp(&tile[row * 256 * 4], &whole[((y + row) * 512 + x) * 4], 256 * 4) == 0;
+                }
+                BOOST_TEST(same);
+            }
+        }
+    }
+
+    if (bench)
+    {
+        mapnik::image_data_32 image(512, 512);
+        fill_tile(image, 1);
+        std::cout << "png encoding, 512x512 pixels, " << iterations << " iterations (ms, bytes)\n";
+        std::cout << std::setw(8) << "format" << std::setw(4) << "z" << std::setw(10) << "strategy";
+        unsigned thread_counts[] = { 1, 2, 4, 0 };
+        const char* thread_names[] = { "libpng", "p=2", "p=4", "p=0" };
+        for (unsigned t = 0; t < 4; ++t)
+        {
+            std::cout << std::setw(10) << thread_names[t] << std::setw(9) << "size";
+        }
+        std::cout << "\n";
+        for (unsigned f = 0; f < sizeof(formats) / sizeof(const char*); ++f)
+        {
+            for (unsigned l = 0; l < sizeof(levels) / sizeof(int); ++l)
+            {
+                for (unsigned s = 0; s < sizeof(strategies) / sizeof(int); ++s)
+                {
+                    std::cout << std::setw(8) << formats[f] << std::setw(4) << levels[l]
+                              << std::setw(10) << strategy_names[s];
+                    for (unsigned t = 0; t < 4; ++t)
+                    {
+                        std::string png;
+                        double start = now();
+                        for (unsigned i = 0; i < iterations; ++i)
+                        {
+                            png = encode(image, formats[f], levels[l], strategies[s], thread_counts[t]);
+                        }
+                        std::cout << std::setw(10) << std::fixed << std::setprecision(1)
+                                  << (now() - start) << std::setw(9) << png.size();
+                    }
+                    std::cout << "\n";
+                }
+            }
+        }
+    }
+
+    if (!::boost::detail::test_errors()) {
+        std::clog << "C++ png encoding: \x1b[1;32m✓ \x1b[0m\n";
+    } else {
+        return ::boost::report_errors();
+    }
+}
@@ -0,0 +1,63 @@
+#include <boost/detail/lightweight_test.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mapnik/unicode.hpp>
+
+// Checks that the ascii, latin1 and utf-8 shortcuts of the transcoder give
+// the same strings as converting with a fresh ICU converter, and that
+// transcoders reusing pooled converters start from a clean state.
+
+namespace {
+
+UnicodeString icu_convert(std::string const& encoding, std::string const& str)
+{
+    UErrorCode err = U_ZERO_ERROR;
+    UConverter * conv = ucnv_open(encoding.c_str(), &err);
+    UnicodeString ustr(str.data(), str.size(), conv, err);
+    if (ustr.isBogus()) ustr.remove();
+    ucnv_close(conv);
+    return ustr;
+}
+
+}
+
+int main( int, char** )
+{
+    std::vector<std::string> samples;
+    samples.push_back("");
+    samples.push_back("Main Street");
+    samples.push_back("Stra\xc3\x9f" "e");                   // utf-8
+    samples.push_back("\xe6\x9d\xb1\xe4\xba\xac \xf0\x9f\x97\xba"); // cjk and astral
+    samples.push_back("Caf\xe9");                            // latin1
+    samples.push_back("bad \xc3 \xff\xfe tail \xe2\x82");    // invalid utf-8
+    samples.push_back(std::string("nul\0inside", 10));
+
+    const char* encodings[] = { "utf-8", "UTF8", "latin1", "ISO-8859-1", "us-ascii", "windows-1252", "shift_jis" };
+    for (unsigned e = 0; e < sizeof(encodings) / sizeof(const char*); ++e)
+    {
+        // several rounds so later transcoders get pooled converters
+        for (unsigned round = 0; round < 3; ++round)
+        {
+            mapnik::transcoder tr(encodings[e]);
+            for (unsigned i = 0; i < samples.size(); ++i)
+            {
+                UnicodeString expected = icu_convert(encodings[e], samples[i]);
+                BOOST_TEST(tr.transcode(samples[i].data(), samples[i].size()) == expected);
+                if (samples[i].find('\0') == std::string::npos)
+                {
+                    BOOST_TEST(tr.transcode(samples[i].c_str()) == expected);
+                }
+            }
+            // a truncated multibyte sequence must not leak into the next string
+            tr.transcode("\xe3\x81", 2);
+            BOOST_TEST(tr.transcode("abc") == icu_convert(encodings[e], "abc"));
+        }
+    }
+
+    if (!::boost::detail::test_errors()) {
+        std::clog << "C++ unicode: \x1b[1;32m✓ \x1b[0m\n";
+    } else {
+        return ::boost::report_errors();
+    }
+}
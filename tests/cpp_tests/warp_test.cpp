@@ -0,0 +1,79 @@
+#include <boost/detail/lightweight_test.hpp>
+#include <iostream>
+#include <cstring>
+#include <mapnik/warp.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+#include <mapnik/worker_pool.hpp>
+
+// Checks that warping a raster through a projection that bends its rows
+// gives the same bytes on one thread as in bands on the worker pool, also
+// when most of the source mesh is outside the target.
+
+namespace {
+
+bool same(mapnik::raster const& a, mapnik::raster const& b)
+{
+    return std::memcmp(a.data_.getData(), b.data_.getData(),
+                       a.data_.width() * a.data_.height() * 4) == 0;
+}
+
+bool painted(mapnik::raster const& r)
+{
+    for (unsigned i = 0; i < r.data_.width() * r.data_.height(); ++i)
+    {
+        if (r.data_.getData()[i] != 0) return true;
+    }
+    return false;
+}
+
+}
+
+int main( int, char** )
+{
+    mapnik::image_data_32 data(512, 512);
+    for (unsigned y = 0; y < data.height(); ++y)
+    {
+        for (unsigned x = 0; x < data.width(); ++x)
+        {
+            data(x, y) = 0xff000000 | ((x * 7) & 0xff) | (((y * 13) & 0xff) << 8) | (((x ^ y) & 0xff) << 16);
+        }
+    }
+    mapnik::raster source(mapnik::box2d<double>(-20, 20, 20, 60), data);
+    mapnik::projection longlat("+proj=longlat +ellps=WGS84 +datum=WGS84 +no_defs");
+    mapnik::projection merc("+proj=merc +a=6378137 +b=6378137 +lat_ts=0.0 +lon_0=0.0 +x_0=0.0 +y_0=0 +k=1.0 +units=m +nadgrids=@null +wktext +no_defs");
+    mapnik::proj_transform prj_trans(merc, longlat);
+
+    mapnik::box2d<double> extents[] = {
+        mapnik::box2d<double>(-2226389.8, 2273030.9, 2226389.8, 8399737.9), // all of it
+        mapnik::box2d<double>(-500000, 4000000, 300000, 5000000),            // a part
+        mapnik::box2d<double>(-8000000, -3000000, 8000000, 12000000)         // small
+    };
+    const char* methods[] = { "near", "bilinear", "lanczos" };
+
+    mapnik::worker_pool & pool = *mapnik::worker_pool::instance();
+    unsigned threads = pool.threads();
+    for (unsigned e = 0; e < sizeof(extents) / sizeof(extents[0]); ++e)
+    {
+        for (unsigned m = 0; m < sizeof(methods) / sizeof(const char*); ++m)
+        {
+            mapnik::raster serial(extents[e], mapnik::image_data_32(613, 509));
+            mapnik::raster banded(extents[e], mapnik::image_data_32(613, 509));
+            std::memset(serial.data_.getData(), 0, 613 * 509 * 4);
+            std::memset(banded.data_.getData(), 0, 613 * 509 * 4);
+            pool.set_threads(0);
+            mapnik::reproject_raster(serial, source, prj_trans, 0, 0, 16, 3.0, 1.0, methods[m]);
+            pool.set_threads(6);
+            mapnik::reproject_raster(banded, source, prj_trans, 0, 0, 16, 3.0, 1.0, methods[m]);
+            BOOST_TEST(painted(serial));
+            BOOST_TEST(same(serial, banded));
+        }
+    }
+    pool.set_threads(threads);
+
+    if (!::boost::detail::test_errors()) {
+        std::clog << "C++ warp: \x1b[1;32m✓ \x1b[0m\n";
+    } else {
+        return ::boost::report_errors();
+    }
+}
@@ -0,0 +1,81 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+from nose.tools import *
+import os, mapnik
+from utilities import execution_path
+
+def setup():
+    # All of the paths used are relative, if we run the tests
+    # from another directory we need to chdir()
+    os.chdir(execution_path('.'))
+
+map_ = '''<Map srs="+proj=latlon +datum=WGS84">
+    <MetaWriter name="boxes" type="inmem"/>
+    <Style name="points">
+        <Rule>
+            <PointSymbolizer allow-overlap="true" meta-writer="boxes" meta-output="name,kind"/>
+        </Rule>
+    </Style>
+</Map>'''
+
+def add_point(ds, fid, x, y, **props):
+    context = mapnik.Context()
+    for key in sorted(props):
+        context.push(key)
+    f = mapnik.Feature(context, fid)
+    for key in props:
+        f[key] = props[key]
+    f.add_geometries_from_wkt('POINT (%s %s)' % (x, y))
+    ds.add_feature(f)
+
+def points_map(*points):
+    m = mapnik.Map(256, 256)
+    mapnik.load_map_from_string(m, map_)
+    ds = mapnik.MemoryDatasource()
+    for fid, (x, y, props) in enumerate(points):
+        add_point(ds, fid + 1, x, y, **props)
+    lyr = mapnik.Layer('points')
+    lyr.datasource = ds
+    lyr.styles.append('points')
+    m.layers.append(lyr)
+    m.zoom_to_box(mapnik.Box2d(0, 0, 100, 100))
+    return m
+
+def render_instances(m):
+    im = mapnik.Image(m.width, m.height)
+    mapnik.render(m, im)
+    return list(m.find_inmem_metawriter('boxes'))
+
+def test_inmem_metawriter_boxes_and_properties():
+    m = points_map((25, 50, {'name': 'Harbour', 'kind': 'port', 'pop': 12}),
+                   (75, 20, {'name': 'Fort', 'pop': 3}),
+                   (50, 90, {'pop': 7}))
+    # the 4x4 default marker around every point in pixels, with the
+    # meta-output properties the feature has
+    expected = [((62, 126, 66, 130), {'name': 'Harbour', 'kind': 'port'}),
+                ((190, 202.8, 194, 206.8), {'name': 'Fort'}),
+                ((126, 23.6, 130, 27.6), {})]
+    # every render starts over
+    for run in range(2):
+        instances = render_instances(m)
+        eq_(len(instances), len(expected))
+        for inst, (box, props) in zip(instances, expected):
+            assert_almost_equal(inst.box.minx, box[0], places=6)
+            assert_almost_equal(inst.box.miny, box[1], places=6)
+            assert_almost_equal(inst.box.maxx, box[2], places=6)
+            assert_almost_equal(inst.box.maxy, box[3], places=6)
+            eq_(len(inst.properties), len(props))
+            for key in props:
+                eq_(inst.properties[key], props[key])
+
+@raises(KeyError)
+def test_inmem_metawriter_missing_property():
+    m = points_map((50, 50, {'name': 'Harbour'}))
+    instances = render_instances(m)
+    eq_(len(instances), 1)
+    instances[0].properties['kind']
+
+if __name__ == "__main__":
+    setup()
+    [eval(run)() for run in dir() if 'test_' in run]
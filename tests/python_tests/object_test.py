@@ -207,6 +207,8 @@ def test_layer_init():
     eq_(l.envelope(),mapnik.Box2d())
     eq_(l.clear_label_cache,False)
     eq_(l.cache_features,False)
+    eq_(l.cache_rendering,False)
+    eq_(l.min_feature_size,0.0)
     eq_(l.visible(1),True)
     eq_(l.active,True)
     eq_(l.datasource,None)
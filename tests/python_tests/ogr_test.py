@@ -40,6 +40,24 @@ if 'ogr' in mapnik.DatasourceCache.instance().plugin_names():
         eq_(f['Shape_Area'], 1512185733150.0)
         eq_(f['Shape_Leng'], 19218883.724300001)
 
+    def test_query_reads_only_requested_fields():
+        ds = mapnik.Ogr(file='../data/shp/world_merc.shp',layer_by_index=0)
+        query = mapnik.Query(ds.envelope())
+        query.add_property_name('NAME')
+        f = ds.features(query).features[0]
+        eq_(f.attributes.keys(),['NAME'])
+
+    def test_memory_index_matches_scan():
+        indexed = mapnik.Ogr(file='../data/shp/world_merc.shp',layer_by_index=0)
+        scanned = mapnik.Ogr(file='../data/shp/world_merc.shp',layer_by_index=0,build_index=False)
+        box = mapnik.Box2d(-2000000,-2000000,4000000,6000000)
+        for ds in (indexed, scanned):
+            query = mapnik.Query(box)
+            query.add_property_name('NAME')
+            ds.names = [f['NAME'] for f in ds.features(query).features]
+        eq_(len(indexed.names) > 0,True)
+        eq_(indexed.names,scanned.names)
+
     @raises(RuntimeError)
     def test_that_nonexistant_query_field_throws(**kwargs):
         ds = mapnik.Ogr(file='../data/shp/world_merc.shp',layer_by_index=0)
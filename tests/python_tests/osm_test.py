@@ -25,6 +25,27 @@ if 'osm' in mapnik.DatasourceCache.instance().plugin_names():
         eq_(e.maxx <= 180.0,True)
         eq_(e.maxy <= 90,True)
 
+    def test_osm_cache_matches_xml():
+        cache = '/tmp/mapnik-osm-ways.cache'
+        if os.path.exists(cache):
+            os.remove(cache)
+        ds = mapnik.Osm(file='../data/osm/ways.osm')
+        # first load converts and writes the cache, second one maps it
+        converted = mapnik.Osm(file='../data/osm/ways.osm',cache=cache)
+        eq_(os.path.exists(cache),True)
+        mapped = mapnik.Osm(cache=cache)
+        expected = ds.all_features()
+        for cached in (converted, mapped):
+            eq_(cached.envelope(),ds.envelope())
+            eq_(cached.fields(),ds.fields())
+            features = cached.all_features()
+            eq_(len(features),len(expected))
+            for a, b in zip(features,expected):
+                eq_(a.id(),b.id())
+                eq_(a.attributes,b.attributes)
+                eq_(str(a.geometries().to_wkt()),str(b.geometries().to_wkt()))
+        os.remove(cache)
+
     @raises(RuntimeError)
     def test_that_nonexistant_query_field_throws(**kwargs):
         raise Todo("fixme")
@@ -46,5 +46,27 @@ def test_wgs84_inverse_forward():
     assert_almost_equal(e.forward(p).center().y, e.center().y)
     assert_almost_equal(e.forward(p).center().x, e.center().x)
 
+def test_spherical_mercator_shortcut():
+    # well known wgs84 and spherical mercator definitions skip proj4,
+    # +over keeps the same mercator going through proj4
+    longlat = mapnik.Projection('+proj=longlat +ellps=WGS84 +datum=WGS84 +no_defs')
+    fast = mapnik.ProjTransform(longlat, mapnik.Projection('+init=epsg:3857'))
+    slow = mapnik.ProjTransform(longlat, mapnik.Projection('+proj=merc +a=6378137 +b=6378137 +lat_ts=0.0 +lon_0=0.0 +x_0=0.0 +y_0=0 +k=1.0 +units=m +nadgrids=@null +over +no_defs'))
+    for c in [mapnik.Coord(0, 0), mapnik.Coord(-122.4, 37.8), mapnik.Coord(151.2, -33.9), mapnik.Coord(179.9, 84.9)]:
+        f = fast.forward(c)
+        s = slow.forward(c)
+        assert_almost_equal(f.x, s.x, places=3)
+        assert_almost_equal(f.y, s.y, places=3)
+        b = fast.backward(f)
+        assert_almost_equal(b.x, c.x, places=9)
+        assert_almost_equal(b.y, c.y, places=9)
+
+def test_equivalent_definitions():
+    wgs84 = mapnik.ProjTransform(mapnik.Projection('+init=epsg:4326'),
+                                 mapnik.Projection('+proj=longlat +ellps=WGS84 +datum=WGS84 +no_defs'))
+    c = mapnik.Coord(-122.4, 37.8)
+    eq_(wgs84.forward(c).x, c.x)
+    eq_(wgs84.forward(c).y, c.y)
+
 if __name__ == "__main__":
     [eval(run)() for run in dir() if 'test_' in run]
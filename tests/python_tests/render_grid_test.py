@@ -150,6 +150,51 @@ def test_render_grid2():
     eq_(resolve(utf5,38,46),{"Name": "South East"})
 
 
+def test_render_grid_reduced_resolution():
+    """ test rendering straight into a grid at reduced resolution """
+    width,height = 256,256
+    m = create_grid_map(width,height)
+    ul_lonlat = mapnik.Coord(142.30,-38.20)
+    lr_lonlat = mapnik.Coord(143.40,-38.80)
+    m.zoom_to_box(mapnik.Box2d(ul_lonlat,lr_lonlat))
+
+    grid = mapnik.Grid(m.width/4,m.height/4,key='Name',resolution=4)
+    mapnik.render_layer(m,grid,layer=0,fields=['Name'])
+    eq_(grid.width(),64)
+    eq_(grid.height(),64)
+    # nothing left to resample, so encoding at the grid resolution
+    # matches the old method which also renders at reduced size
+    utf1 = grid.encode('utf',resolution=4)
+    eq_(utf1,grid_correct)
+    eq_(resolve(utf1,25,10),{"Name": "North West"})
+    eq_(resolve(utf1,25,46),{"Name": "North East"})
+    eq_(resolve(utf1,38,10),{"Name": "South West"})
+    eq_(resolve(utf1,38,46),{"Name": "South East"})
+
+
+def test_render_grid_encode_json():
+    """ test the native json encoder against the python one """
+    width,height = 256,256
+    m = create_grid_map(width,height)
+    ul_lonlat = mapnik.Coord(142.30,-38.20)
+    lr_lonlat = mapnik.Coord(143.40,-38.80)
+    m.zoom_to_box(mapnik.Box2d(ul_lonlat,lr_lonlat))
+
+    grid = mapnik.Grid(m.width,m.height,key='Name')
+    mapnik.render_layer(m,grid,layer=0,fields=['Name'])
+    for resolution in (1,2,4):
+        utf1 = json.loads(grid.encode_json(resolution=resolution))
+        utf2 = grid.encode('utf',resolution=resolution)
+        eq_(utf1,utf2)
+    eq_(json.loads(grid.encode_json(resolution=4)),grid_correct_new)
+    utf3 = json.loads(grid.encode_json(features=False,resolution=4))
+    eq_(utf3['data'],{})
+    eq_(utf3['keys'],grid_correct_new['keys'])
+
+    grid_view = grid.view(0,0,width,height)
+    eq_(json.loads(grid_view.encode_json(resolution=4)),grid_view.encode('utf',resolution=4))
+
+
 grid_feat_id = {'keys': ['', '3', '4', '2', '1'], 'data': {'1': {'Name': 'South East'}, '3': {'Name': u'North West'}, '2': {'Name': 'South West'}, '4': {'Name': 'North East'}}, 'grid': ['                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '          !!                                  ##                ', '         !!!                                 ###                ', '          !!                                  ##                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '         $$$                                  %%                ', '         $$$                                 %%%                ', '          $$                                  %%                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ', '                                                                ']}
 
 def test_render_grid3():
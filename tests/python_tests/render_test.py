@@ -48,6 +48,14 @@ def test_setting_alpha():
     eq_(len(im1.tostring()), len(im2.tostring()))
 
 
+def test_metatile_palette():
+    im = mapnik.Image(512, 512)
+    im.background = mapnik.Color('steelblue')
+    pal = mapnik.Palette(im, colors=256)
+    tiles = [im.view(x, y, 256, 256).tostring('png256', pal) for x in (0, 256) for y in (0, 256)]
+    eq_(len(set(tiles)), 1)
+    eq_(tiles[0], im.view(0, 0, 256, 256).tostring('png256'))
+
 def test_render_image_to_file():
     i = mapnik.Image(256, 256)
 
@@ -189,6 +197,46 @@ def test_render_grid():
     eq_(resolve(grid,26,10),expected)
     eq_(resolve(grid,26,11),expected)
 
+def test_render_with_stats():
+    ds = mapnik.MemoryDatasource()
+    context = mapnik.Context()
+    context.push('Name')
+    for i, name in enumerate(['a', 'b', 'c']):
+        f = mapnik.Feature(context, i + 1)
+        f['Name'] = name
+        f.add_geometries_from_wkt('POINT (%f -38.5)' % (142.5 + i * 0.2))
+        ds.add_feature(f)
+    s = mapnik.Style()
+    r = mapnik.Rule()
+    r.filter = mapnik.Expression("[Name] = 'a'")
+    symb = mapnik.MarkersSymbolizer()
+    symb.allow_overlap = True
+    r.symbols.append(symb)
+    s.rules.append(r)
+    lyr = mapnik.Layer('Places')
+    lyr.datasource = ds
+    lyr.styles.append('places')
+    m = mapnik.Map(256,256)
+    m.append_style('places',s)
+    m.layers.append(lyr)
+    m.zoom_to_box(mapnik.Box2d(142.30,-38.80,143.40,-38.20))
+    im = mapnik.Image(m.width,m.height)
+    stats = mapnik.RenderStats()
+    mapnik.render_with_stats(m, im, stats)
+    eq_(len(stats.layers), 1)
+    layer = stats.layers[0]
+    eq_(layer.name, 'Places')
+    eq_(layer.features, 3)
+    eq_(len(layer.styles), 1)
+    style = layer.styles[0]
+    eq_(style.name, 'places')
+    eq_(style.features, 3)
+    eq_(style.features_rendered, 1)
+    eq_([(sym.name, sym.count) for sym in style.symbolizers], [('MarkersSymbolizer', 1)])
+    assert stats.time >= layer.time >= style.time
+    stats.bytes_encoded += len(im.tostring('png'))
+    assert 'bytes encoded' in str(stats)
+
 def test_render_points():
 
     if not mapnik.has_cairo(): return
@@ -0,0 +1,81 @@
+#!/usr/bin/env python
+
+from nose.tools import *
+from utilities import execution_path
+
+import os, shutil, sqlite3, struct, tempfile, mapnik
+from subprocess import Popen, PIPE
+
+def setup():
+    # All of the paths used are relative, if we run the tests
+    # from another directory we need to chdir()
+    os.chdir(execution_path('.'))
+
+sqliteindex = os.path.join(execution_path('../../utils/sqliteindex'), 'sqliteindex')
+
+def point(i):
+    return ((i * 7919) % 1000, (i * 104729) % 1000)
+
+def make_points_db(filename, count):
+    # count points spread over 1000x1000, then rows the index leaves out:
+    # a blob that is not wkb and an empty one, the last row of its batch
+    conn = sqlite3.connect(filename)
+    conn.execute('create table points (id integer primary key, geometry blob)')
+    for i in range(count):
+        x, y = point(i)
+        wkb = struct.pack('<BIdd', 1, 1, x, y)
+        conn.execute('insert into points values (?, ?)', (i + 1, sqlite3.Binary(wkb)))
+    conn.execute('insert into points values (?, ?)', (count + 1, sqlite3.Binary('abc')))
+    conn.execute('insert into points values (?, ?)', (count + 2, sqlite3.Binary('')))
+    conn.commit()
+    conn.close()
+
+def build_index(filename, threads):
+    if os.path.exists(filename + '.index'):
+        os.remove(filename + '.index')
+    cmd = [sqliteindex, '-t', 'points', '-g', 'geometry', '-k', 'id', '-j', str(threads), filename]
+    process = Popen(cmd, stdout=PIPE, stderr=PIPE)
+    process.communicate()
+    eq_(process.returncode, 0)
+    conn = sqlite3.connect(filename + '.index')
+    rows = conn.execute('select pkid, xmin, xmax, ymin, ymax from "idx_points_geometry" order by pkid').fetchall()
+    conn.close()
+    return rows
+
+def query_ids(filename, box):
+    ds = mapnik.SQLite(file=filename, table='points', geometry_field='geometry',
+                       key_field='id', auto_index=False)
+    fs = ds.features(mapnik.Query(box))
+    ids = []
+    feature = fs.next()
+    while feature:
+        ids.append(feature.id())
+        feature = fs.next()
+    return sorted(ids)
+
+if 'sqlite' in mapnik.DatasourceCache.instance().plugin_names() and os.path.exists(sqliteindex):
+
+    def test_sqliteindex_threads_build_the_same_index():
+        tmp = tempfile.mkdtemp()
+        try:
+            db = os.path.join(tmp, 'points.sqlite')
+            make_points_db(db, 3000)
+            serial = build_index(db, 1)
+            boxes = [mapnik.Box2d(0, 0, 100, 100), mapnik.Box2d(250, 400, 600, 610),
+                     mapnik.Box2d(-10, -10, 1010, 1010)]
+            serial_ids = [query_ids(db, box) for box in boxes]
+            for box, ids in zip(boxes, serial_ids):
+                inside = [i + 1 for i in range(3000) if box.contains(*point(i))]
+                eq_(ids, inside)
+            parallel = build_index(db, 4)
+            # every point once, the empty and broken rows left out
+            eq_(len(serial), 3000)
+            eq_(parallel, serial)
+            eq_([query_ids(db, box) for box in boxes], serial_ids)
+            eq_(len(serial_ids[2]), 3000)
+        finally:
+            shutil.rmtree(tmp)
+
+if __name__ == "__main__":
+    setup()
+    [eval(run)() for run in dir() if 'test_' in run]
@@ -71,6 +71,35 @@ if 'sqlite' in mapnik.DatasourceCache.instance().plugin_names():
         eq_(os.path.exists(index),True)
         os.unlink(index)
 
+    def test_pooled_connections_across_threads():
+        # max_size=0 disables the pool and queries the datasource's own connection
+        reference = mapnik.SQLite(file=DB,table=TABLE,max_size=0)
+        ds = mapnik.SQLite(file=DB,table=TABLE,max_size=2)
+        boxes = [feat.envelope() for feat in reference.all_features()]
+        expected = [sorted(f.id() for f in reference.features(mapnik.Query(box)).features) for box in boxes]
+        errors = Queue()
+
+        def query_all():
+            # more threads than pooled connections: the rest open their own
+            for box, ids in zip(boxes, expected):
+                found = sorted(f.id() for f in ds.features(mapnik.Query(box)).features)
+                if found != ids:
+                    errors.put((box, found, ids))
+
+        threads = []
+        for i in range(NUM_THREADS):
+            t = threading.Thread(target=query_all)
+            t.start()
+            threads.append(t)
+
+        for i in threads:
+            i.join()
+
+        eq_(errors.empty(),True)
+        index = DB +'.index'
+        if os.path.exists(index):
+            os.unlink(index)
+
 
 if __name__ == "__main__":
     setup()
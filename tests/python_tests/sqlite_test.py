@@ -3,7 +3,7 @@
 from nose.tools import *
 from utilities import execution_path
 
-import os, mapnik
+import os, shutil, tempfile, mapnik
 
 def setup():
     # All of the paths used are relative, if we run the tests
@@ -313,6 +313,43 @@ if 'sqlite' in mapnik.DatasourceCache.instance().plugin_names():
         feature = fs.next()
         eq_(feature,None)
 
+    def test_initdb_runs_once_with_pooled_connections():
+        # initdb writing to the main database runs once, not again on each
+        # pooled connection: every open featureset holds its own connection
+        tmp = tempfile.mkdtemp()
+        try:
+            db = os.path.join(tmp, 'world.sqlite')
+            shutil.copy('../data/sqlite/world.sqlite', db)
+            ds = mapnik.SQLite(file=db,
+                table='(select GEOMETRY, OGC_FID, (select count(*) from extra) as n from world_merc)',
+                initdb='''
+                    create table extra (a);
+                    insert into extra values ('x; y');
+                    ''',
+                max_size=3
+                )
+            featuresets = [ds.featureset() for i in range(4)]
+            for fs in featuresets:
+                eq_(fs.next()['n'], 1)
+        finally:
+            shutil.rmtree(tmp)
+
+    def test_initdb_in_memory_with_pooled_connections():
+        # tables in an attached in-memory database exist only on the
+        # connection that made them, queries still see them
+        ds = mapnik.SQLite(file='../data/sqlite/world.sqlite',
+            table='(select GEOMETRY, OGC_FID, (select v from mem.t) as v from world_merc)',
+            initdb='''
+                attach database ':memory:' as mem;
+                create table mem.t (v);
+                insert into mem.t values (7);
+                ''',
+            max_size=3
+            )
+        featuresets = [ds.featureset() for i in range(4)]
+        for fs in featuresets:
+            eq_(fs.next()['v'], 7)
+
 if __name__ == "__main__":
     setup()
     [eval(run)() for run in dir() if 'test_' in run]
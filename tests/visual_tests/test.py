@@ -4,7 +4,7 @@
 import mapnik
 import sys
 import os.path
-from compare import compare, summary
+from compare import compare, summary, errors
 
 defaults = {
     'sizes': [(500, 100)],
@@ -47,6 +47,13 @@ files = [
         'bbox': mapnik.Box2d(-5.192, 50.189, -5.174, 50.195)}
     ]
 
+# styles with batch-polygons="true", which must render exactly like the
+# same styles filling one feature at a time
+batched = [
+    {'name': "polygons-batched", 'sizes': sizes_few_square,
+        'bbox': mapnik.Box2d(-0.05, -0.05, 0.85, 0.85)}
+    ]
+
 def render(filename, width, height, bbox, quiet=False):
     if not quiet:
         print "Rendering style \"%s\" with size %dx%d ... \x1b[1;32m✓ \x1b[0m" % (filename, width, height)
@@ -67,6 +74,29 @@ def render(filename, width, height, bbox, quiet=False):
 
     return m
 
+def render_batched(filename, width, height, bbox, quiet=False):
+    if not quiet:
+        print "Rendering style \"%s\" with size %dx%d, batched and unbatched ... \x1b[1;32m✓ \x1b[0m" % (filename, width, height)
+        print "-"*80
+    path = os.path.join(dirname, "styles", "%s.xml" % filename)
+    xml = open(path).read()
+    images = []
+    for source in (xml, xml.replace('batch-polygons="true"', 'batch-polygons="false"')):
+        m = mapnik.Map(width, height)
+        mapnik.load_map_from_string(m, source, False, path)
+        m.zoom_to_box(bbox)
+        im = mapnik.Image(width, height)
+        mapnik.render(m, im)
+        images.append(im)
+    images[0].save(os.path.join(dirname, "images", '%s-%d-agg.png' % (filename, width)))
+    batched, single = images[0].tostring(), images[1].tostring()
+    diff = len([i for i in range(0, len(batched), 4) if batched[i:i+4] != single[i:i+4]])
+    if diff > 0:
+        errors.append(('%s-%d batched' % (filename, width), diff))
+        print "-"*80
+        print '\x1b[33mError:\x1b[0m %u pixels differ from the unbatched rendering' % diff
+        print "-"*80
+
 if __name__ == "__main__":
     if '-q' in sys.argv:
        quiet = True
@@ -86,4 +116,9 @@ if __name__ == "__main__":
             m = render(config['name'], size[0], size[1], config['bbox'], quiet=quiet)
         mapnik.save_map(m, os.path.join(dirname, 'xml_output', "%s-out.xml" % config['name']))
 
+    if len(sys.argv) == 1:
+        for f in batched:
+            for size in f['sizes']:
+                render_batched(f['name'], size[0], size[1], f['bbox'], quiet=quiet)
+
     summary()
@@ -148,6 +148,8 @@ int main (int argc,char** argv)
         params["file"] = ogrname;
         //unsigned first = 0;
         params["layer_by_index"] = 0;//ogrlayername;
+        // positions are read back in layer order, not by feature id
+        params["build_index"] = "false";
 
         try
         {
@@ -0,0 +1,189 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2012 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/program_options.hpp>
+#include <boost/timer.hpp>
+
+#include <mapnik/datasource.hpp>
+#include <mapnik/feature_layer_desc.hpp>
+#include <mapnik/wkb.hpp>
+
+#include "sqlite_utils.hpp"
+
+// Builds the rtree the sqlite plugin looks for ('<file>.index', table
+// 'idx_<table>_<geometry field>') ahead of time, so that datasources do not
+// have to auto_index on their first query.
+
+int main (int argc,char** argv)
+{
+    namespace po = boost::program_options;
+    using std::string;
+    using std::vector;
+    using std::clog;
+    using std::endl;
+
+    bool verbose=false;
+    unsigned threads=0;
+    string table;
+    string geometry_field;
+    string key_field;
+    vector<string> sqlite_files;
+
+    try
+    {
+        po::options_description desc("sqliteindex utility");
+        desc.add_options()
+            ("help,h", "produce usage message")
+            ("version,V","print version string")
+            ("verbose,v","verbose output")
+            ("table,t", po::value<string>(), "table to index")
+            ("geometry-field,g", po::value<string>(), "geometry column (default: detected)")
+            ("key-field,k", po::value<string>(), "integer primary key column (default: detected)")
+            ("threads,j", po::value<unsigned>(), "threads decoding geometries (default: one per core)")
+            ("sqlite_files",po::value<vector<string> >(),"sqlite files to index: file1 file2 ...fileN")
+            ;
+
+        po::positional_options_description p;
+        p.add("sqlite_files",-1);
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(p).run(), vm);
+        po::notify(vm);
+
+        if (vm.count("version"))
+        {
+            clog<<"version 0.1.0" <<std::endl;
+            return 1;
+        }
+        if (vm.count("help") || !vm.count("table"))
+        {
+            clog << desc << endl;
+            return 1;
+        }
+        if (vm.count("verbose"))
+        {
+            verbose = true;
+        }
+        table = vm["table"].as<string>();
+        if (vm.count("geometry-field"))
+        {
+            geometry_field = vm["geometry-field"].as<string>();
+        }
+        if (vm.count("key-field"))
+        {
+            key_field = vm["key-field"].as<string>();
+        }
+        if (vm.count("threads"))
+        {
+            threads = vm["threads"].as<unsigned>();
+        }
+        if (vm.count("sqlite_files"))
+        {
+            sqlite_files=vm["sqlite_files"].as< vector<string> >();
+        }
+    }
+    catch (std::exception const& ex)
+    {
+        clog << "Error: " << ex.what() << endl;
+        return -1;
+    }
+
+    vector<string>::const_iterator itr = sqlite_files.begin();
+    if (itr == sqlite_files.end())
+    {
+        clog << "no sqlite files to index" << endl;
+        return 0;
+    }
+
+    int status = 0;
+    for (; itr != sqlite_files.end(); ++itr)
+    {
+        string const& file = *itr;
+        clog << "processing " << file << endl;
+
+        if (! boost::filesystem::exists(file))
+        {
+            clog << "error : file " << file << " doesn't exists" << endl;
+            status = -1;
+            continue;
+        }
+
+        try
+        {
+            boost::shared_ptr<sqlite_connection> ds = boost::make_shared<sqlite_connection>(file);
+
+            string geometry = geometry_field;
+            string key = key_field;
+            string table_name = table;
+            mapnik::layer_descriptor desc(table_name, "utf-8");
+            if (! sqlite_utils::table_info(key, false, geometry, table_name, desc, ds))
+            {
+                clog << "error : table '" << table_name << "' not found in " << file << endl;
+                status = -1;
+                continue;
+            }
+            if (geometry.empty() || key.empty())
+            {
+                clog << "error : could not detect the "
+                     << (geometry.empty() ? "geometry" : "key")
+                     << " field of '" << table_name << "', please pass it explicitly" << endl;
+                status = -1;
+                continue;
+            }
+
+            string index_db = sqlite_utils::index_for_db(file);
+            string index_table = sqlite_utils::index_for_table(table_name, geometry);
+            if (verbose)
+            {
+                clog << "geometry field: " << geometry << endl;
+                clog << "key field: " << key << endl;
+                clog << "writing " << index_table << " to " << index_db << endl;
+            }
+
+            std::ostringstream query;
+            query << "SELECT " << geometry << "," << key << " FROM (" << table_name << ")";
+
+            boost::timer timer;
+            boost::shared_ptr<sqlite_resultset> rs = ds->execute_query(query.str());
+            if (sqlite_utils::create_spatial_index(index_db, index_table, rs, threads))
+            {
+                clog << "indexed " << table_name << " in " << timer.elapsed() << "s" << endl;
+            }
+            else
+            {
+                clog << "no geometries in " << table_name << ", nothing to index" << endl;
+            }
+        }
+        catch (std::exception const& ex)
+        {
+            clog << "error : " << ex.what() << endl;
+            status = -1;
+        }
+    }
+
+    clog << "done!" << endl;
+    return status;
+}